@@ -1,5 +1,11 @@
 #include "ADSREnvelope.h"
 #include <algorithm>
+#include <cmath>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 ADSREnvelope::ADSREnvelope() {
     calculateRates();
@@ -22,6 +28,8 @@ void ADSREnvelope::setDecayTime(float seconds) {
 
 void ADSREnvelope::setSustainLevel(float level) {
     sustainLevel = std::clamp(level, 0.0f, 1.0f);
+    // decayRate e releaseRate dipendono dal sustain
+    calculateRates();
 }
 
 void ADSREnvelope::setReleaseTime(float seconds) {
@@ -29,11 +37,26 @@ void ADSREnvelope::setReleaseTime(float seconds) {
     calculateRates();
 }
 
+void ADSREnvelope::setCurve(Curve newCurve) {
+    curve = newCurve;
+}
+
 void ADSREnvelope::calculateRates() {
+    // Il release parte dal sustain, o dal livello al noteOff se già in corso
+    float releaseFrom = (currentState == State::Release) ? releaseStartLevel : sustainLevel;
+    
     // Calcola quanto incrementare/decrementare per ogni sample
     attackRate = 1.0f / (attackTime * sampleRate);
     decayRate = (1.0f - sustainLevel) / (decayTime * sampleRate);
-    releaseRate = sustainLevel / (releaseTime * sampleRate);
+    releaseRate = releaseFrom / (releaseTime * sampleRate);
+    
+    // Coefficienti esponenziali: ogni stadio arriva al suo livello finale
+    // esattamente nel tempo impostato, puntando a un target oltre la fine
+    float r = DECAY_TARGET_RATIO;
+    attackCoeff = std::exp(std::log(ATTACK_TARGET_RATIO / (1.0f + ATTACK_TARGET_RATIO))
+                           / (attackTime * sampleRate));
+    decayCoeff = std::exp(std::log(r / (1.0f - sustainLevel + r)) / (decayTime * sampleRate));
+    releaseCoeff = std::exp(std::log(r / (releaseFrom + r)) / (releaseTime * sampleRate));
 }
 
 void ADSREnvelope::noteOn() {
@@ -44,10 +67,9 @@ void ADSREnvelope::noteOn() {
 void ADSREnvelope::noteOff() {
     if (currentState != State::Idle) {
         currentState = State::Release;
-        // Ricalcola releaseRate basato sul livello corrente
-        if (currentLevel > 0.001f) {
-            releaseRate = currentLevel / (releaseTime * sampleRate);
-        }
+        // Ricalcola il release basato sul livello corrente
+        releaseStartLevel = currentLevel;
+        calculateRates();
     }
 }
 
@@ -56,44 +78,220 @@ void ADSREnvelope::reset() {
     currentLevel = 0.0f;
 }
 
+// Livello verso cui tende la curva esponenziale dello stadio corrente
+float ADSREnvelope::stageTarget() const {
+    switch (currentState) {
+        case State::Attack:  return 1.0f + ATTACK_TARGET_RATIO;
+        case State::Decay:   return sustainLevel - DECAY_TARGET_RATIO;
+        case State::Release: return -DECAY_TARGET_RATIO;
+        default:             return currentLevel;
+    }
+}
+
+float ADSREnvelope::stageCoefficient() const {
+    switch (currentState) {
+        case State::Attack:  return curve == Curve::Linear ? attackRate : attackCoeff;
+        case State::Decay:   return curve == Curve::Linear ? -decayRate : decayCoeff;
+        case State::Release: return curve == Curve::Linear ? -releaseRate : releaseCoeff;
+        default:             return 0.0f;
+    }
+}
+
+// Livello al quale lo stadio corrente termina
+float ADSREnvelope::stageEndLevel() const {
+    switch (currentState) {
+        case State::Attack: return 1.0f;
+        case State::Decay:  return sustainLevel;
+        default:            return 0.0f;
+    }
+}
+
+bool ADSREnvelope::reachedStageEnd(float level) const {
+    const float end = stageEndLevel();
+    return currentState == State::Attack ? level >= end - STAGE_END_TOLERANCE
+                                         : level <= end + STAGE_END_TOLERANCE;
+}
+
+/**
+ * Numero di sample (>= 1) fino al sample che raggiunge la fine dello stadio,
+ * in forma chiusa: distanza / rate per le rampe lineari, logaritmo del
+ * rapporto delle distanze dal target per quelle esponenziali.
+ */
+int ADSREnvelope::samplesToStageEnd() const {
+    constexpr float MAX_SAMPLES = 1 << 30;
+    
+    if (reachedStageEnd(currentLevel)) {
+        return 1;
+    }
+    const bool rising = currentState == State::Attack;
+    const float end = stageEndLevel() + (rising ? -STAGE_END_TOLERANCE : STAGE_END_TOLERANCE);
+    
+    float samples;
+    if (curve == Curve::Linear) {
+        float rate = std::fabs(stageCoefficient());
+        if (rate <= 0.0f) {
+            return static_cast<int>(MAX_SAMPLES);
+        }
+        samples = std::fabs(end - currentLevel) / rate;
+    } else {
+        float target = stageTarget();
+        float coeff = stageCoefficient();
+        if (coeff >= 1.0f) {
+            return static_cast<int>(MAX_SAMPLES);
+        }
+        samples = std::log(std::fabs(end - target) / std::fabs(currentLevel - target))
+                  / std::log(coeff);
+    }
+    return static_cast<int>(std::clamp(std::ceil(samples), 1.0f, MAX_SAMPLES));
+}
+
+/**
+ * Scrive i prossimi count sample dello stadio corrente partendo da currentLevel
+ * (senza avanzare lo stato). Ogni sample è indipendente dagli altri: quattro
+ * per volta su NEON/SSE2, le stesse quattro corsie in scalare altrove.
+ */
+void ADSREnvelope::fillRamp(float *gain, int count) const {
+    constexpr int LANES = 4;
+    const float start = currentLevel;
+    const float coeff = stageCoefficient();
+    int i = 0;
+    
+    if (curve == Curve::Linear) {
+        // level[i] = start + rate * (i+1); gli indici sono esatti in float fino a 2^24
+#if defined(__aarch64__)
+        static const float FIRST_STEPS[LANES] = {1.0f, 2.0f, 3.0f, 4.0f};
+        const float32x4_t base = vdupq_n_f32(start);
+        const float32x4_t rate = vdupq_n_f32(coeff);
+        const float32x4_t advance = vdupq_n_f32(static_cast<float>(LANES));
+        float32x4_t steps = vld1q_f32(FIRST_STEPS);
+        for (; i + LANES <= count; i += LANES) {
+            vst1q_f32(gain + i, vaddq_f32(base, vmulq_f32(rate, steps)));
+            steps = vaddq_f32(steps, advance);
+        }
+#elif defined(__SSE2__)
+        const __m128 base = _mm_set1_ps(start);
+        const __m128 rate = _mm_set1_ps(coeff);
+        const __m128 advance = _mm_set1_ps(static_cast<float>(LANES));
+        __m128 steps = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+        for (; i + LANES <= count; i += LANES) {
+            _mm_storeu_ps(gain + i, _mm_add_ps(base, _mm_mul_ps(rate, steps)));
+            steps = _mm_add_ps(steps, advance);
+        }
+#endif
+        for (; i < count; ++i) {
+            gain[i] = start + coeff * static_cast<float>(i + 1);
+        }
+        return;
+    }
+    
+    // level[i] = target + (start - target) * coeff^(i+1), su 4 corsie con passo coeff^4
+    const float target = stageTarget();
+    float distance[LANES];
+    distance[0] = (start - target) * coeff;
+    for (int lane = 1; lane < LANES; ++lane) {
+        distance[lane] = distance[lane - 1] * coeff;
+    }
+    const float stride = coeff * coeff * coeff * coeff;
+    
+#if defined(__aarch64__)
+    const float32x4_t level = vdupq_n_f32(target);
+    const float32x4_t step = vdupq_n_f32(stride);
+    float32x4_t d = vld1q_f32(distance);
+    for (; i + LANES <= count; i += LANES) {
+        vst1q_f32(gain + i, vaddq_f32(level, d));
+        d = vmulq_f32(d, step);
+    }
+    vst1q_f32(distance, d);
+#elif defined(__SSE2__)
+    const __m128 level = _mm_set1_ps(target);
+    const __m128 step = _mm_set1_ps(stride);
+    __m128 d = _mm_loadu_ps(distance);
+    for (; i + LANES <= count; i += LANES) {
+        _mm_storeu_ps(gain + i, _mm_add_ps(level, d));
+        d = _mm_mul_ps(d, step);
+    }
+    _mm_storeu_ps(distance, d);
+#else
+    for (; i + LANES <= count; i += LANES) {
+        for (int lane = 0; lane < LANES; ++lane) {
+            gain[i + lane] = target + distance[lane];
+            distance[lane] *= stride;
+        }
+    }
+#endif
+    for (int lane = 0; i < count; ++i, ++lane) {
+        gain[i] = target + distance[lane];
+    }
+}
+
+void ADSREnvelope::enterNextStage() {
+    switch (currentState) {
+        case State::Attack:  currentState = State::Decay; break;
+        case State::Decay:   currentState = State::Sustain; break;
+        case State::Release: currentState = State::Idle; break;
+        default: break;
+    }
+}
+
 float ADSREnvelope::getNextSample() {
     switch (currentState) {
         case State::Idle:
             return 0.0f;
             
-        case State::Attack:
-            currentLevel += attackRate;
-            if (currentLevel >= 1.0f) {
-                currentLevel = 1.0f;
-                currentState = State::Decay;
-            }
-            break;
-            
-        case State::Decay:
-            currentLevel -= decayRate;
-            if (currentLevel <= sustainLevel) {
-                currentLevel = sustainLevel;
-                currentState = State::Sustain;
-            }
-            break;
-            
         case State::Sustain:
             // Mantieni il livello di sustain
             currentLevel = sustainLevel;
-            break;
+            return currentLevel;
             
-        case State::Release:
-            currentLevel -= releaseRate;
-            if (currentLevel <= 0.0f) {
-                currentLevel = 0.0f;
-                currentState = State::Idle;
-            }
+        default:
             break;
     }
     
+    float next;
+    fillRamp(&next, 1);
+    
+    if (reachedStageEnd(next)) {
+        currentLevel = stageEndLevel();
+        enterNextStage();
+    } else {
+        currentLevel = next;
+    }
     return currentLevel;
 }
 
+/**
+ * Versione a blocchi di getNextSample: ogni stadio viene scritto per intero
+ * con fillRamp e il blocco si spezza solo dove uno stadio finisce.
+ */
+int ADSREnvelope::process(float *gain, int numFrames) {
+    int frame = 0;
+    while (frame < numFrames) {
+        if (currentState == State::Idle) {
+            std::fill(gain + frame, gain + numFrames, 0.0f);
+            return frame;
+        }
+        if (currentState == State::Sustain) {
+            currentLevel = sustainLevel;
+            std::fill(gain + frame, gain + numFrames, sustainLevel);
+            return numFrames;
+        }
+        
+        const int stageEnd = samplesToStageEnd();
+        const int count = std::min(stageEnd, numFrames - frame);
+        fillRamp(gain + frame, count);
+        frame += count;
+        
+        if (count == stageEnd) {
+            currentLevel = stageEndLevel();
+            gain[frame - 1] = currentLevel;
+            enterNextStage();
+        } else {
+            currentLevel = gain[frame - 1];
+        }
+    }
+    return numFrames;
+}
+
 bool ADSREnvelope::isActive() const {
     return currentState != State::Idle;
 }
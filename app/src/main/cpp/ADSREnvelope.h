@@ -8,6 +8,10 @@
  * Decay: Tempo per scendere al livello di sustain
  * Sustain: Livello mantenuto finché la nota è premuta
  * Release: Tempo per tornare a zero dopo il rilascio
+ *
+ * Le rampe possono essere lineari o esponenziali. process() calcola interi
+ * segmenti in forma chiusa (4 sample per volta su NEON/SSE2) e spezza il
+ * blocco solo dove finisce uno stadio, negli stessi sample di getNextSample().
  */
 class ADSREnvelope {
 public:
@@ -18,6 +22,11 @@ public:
         Sustain,
         Release
     };
+    
+    enum class Curve {
+        Linear,       // Rampe lineari (default)
+        Exponential   // Attacco "RC" convesso, decay/release esponenziali
+    };
 
     ADSREnvelope();
     
@@ -26,17 +35,29 @@ public:
     void setDecayTime(float seconds);
     void setSustainLevel(float level);
     void setReleaseTime(float seconds);
+    void setCurve(Curve curve);
     
     void noteOn();
     void noteOff();
     void reset();
     
     float getNextSample();
+    
+    // Riempie gain[0..numFrames) e ritorna quanti campioni precedono lo stato Idle
+    // (gli altri sono a zero)
+    int process(float *gain, int numFrames);
     bool isActive() const;
     State getState() const { return currentState; }
 
 private:
     void calculateRates();
+    int samplesToStageEnd() const;
+    float stageTarget() const;
+    float stageCoefficient() const;
+    float stageEndLevel() const;
+    bool reachedStageEnd(float level) const;
+    void fillRamp(float *gain, int count) const;
+    void enterNextStage();
     
     float sampleRate = 48000.0f;
     
@@ -46,10 +67,24 @@ private:
     float sustainLevel = 0.7f;  // 70% del volume
     float releaseTime = 0.1f;   // 100ms
     
-    // Rates (incremento per sample)
+    Curve curve = Curve::Linear;
+    
+    // Rates (incremento per sample, curva lineare)
     float attackRate = 0.0f;
     float decayRate = 0.0f;
     float releaseRate = 0.0f;
+    float releaseStartLevel = 0.7f;  // Livello al noteOff
+    
+    // Coefficienti per sample (curva esponenziale): level = target + (level - target) * coeff
+    static constexpr float ATTACK_TARGET_RATIO = 0.3f;    // Overshoot dell'attacco sopra 1.0
+    static constexpr float DECAY_TARGET_RATIO = 0.0001f;  // Overshoot sotto sustain / zero
+    // Uno stadio finisce entro questa distanza dal suo livello finale: gli stadi
+    // durano spesso un numero intero di sample esatto e senza margine sarebbe
+    // l'arrotondamento a decidere tra quel sample e il successivo
+    static constexpr float STAGE_END_TOLERANCE = 1e-6f;
+    float attackCoeff = 0.0f;
+    float decayCoeff = 0.0f;
+    float releaseCoeff = 0.0f;
     
     // Stato corrente
     State currentState = State::Idle;
@@ -0,0 +1,97 @@
+#include "AnalysisTap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+AnalysisTap::AnalysisTap() {
+    Header &header = shared.header;
+    std::memcpy(header.magic, "ASAT", 4);
+    header.version = VERSION;
+    header.numVoices = MAX_VOICES;
+    header.waveformPoints = WAVEFORM_POINTS;
+    header.numSlots = NUM_SLOTS;
+    header.slotBytes = sizeof(Snapshot);
+    header.slotsOffset = offsetof(SharedBlock, slots);
+    header.latestSlot.store(0, std::memory_order_relaxed);
+
+    for (Snapshot &slot : shared.slots) {
+        slot.sequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+void AnalysisTap::setSampleRate(float sampleRate) {
+    publishIntervalFrames = std::max(1, static_cast<int>(sampleRate / PUBLISH_RATE_HZ));
+}
+
+void AnalysisTap::setEnabled(bool enable) {
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+void AnalysisTap::accumulate(Level &level, const float *samples, int numFrames) {
+    float peak = level.peak;
+    float sumSquares = 0.0f;
+    for (int i = 0; i < numFrames; ++i) {
+        peak = std::max(peak, std::fabs(samples[i]));
+        sumSquares += samples[i] * samples[i];
+    }
+    level.peak = peak;
+    level.sumSquares += sumSquares;
+}
+
+void AnalysisTap::addVoice(int voice, const float *samples, int numFrames) {
+    if (voice >= 0 && voice < MAX_VOICES) {
+        accumulate(voiceLevels[voice], samples, numFrames);
+    }
+}
+
+void AnalysisTap::addMaster(const float *samples, int numFrames, uint64_t endFrame) {
+    accumulate(masterLevel, samples, numFrames);
+
+    // Decimated waveform: keep the largest excursion of each bucket so transients survive
+    for (int i = 0; i < numFrames; ++i) {
+        if (std::fabs(samples[i]) >= std::fabs(bucketExtreme)) {
+            bucketExtreme = samples[i];
+        }
+        if (++bucketCount == WAVEFORM_DECIMATION) {
+            waveformRing[waveformWrite] = bucketExtreme;
+            waveformWrite = (waveformWrite + 1) % WAVEFORM_POINTS;
+            bucketExtreme = 0.0f;
+            bucketCount = 0;
+        }
+    }
+
+    windowFrames += numFrames;
+    if (windowFrames >= publishIntervalFrames) {
+        publish(endFrame);
+    }
+}
+
+void AnalysisTap::publish(uint64_t endFrame) {
+    Snapshot &slot = shared.slots[nextSlot];
+    const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const float inverseFrames = 1.0f / static_cast<float>(windowFrames);
+    slot.frame = endFrame;
+    slot.masterPeak = masterLevel.peak;
+    slot.masterRms = std::sqrt(static_cast<float>(masterLevel.sumSquares) * inverseFrames);
+    for (int voice = 0; voice < MAX_VOICES; ++voice) {
+        slot.voicePeak[voice] = voiceLevels[voice].peak;
+        slot.voiceRms[voice] = std::sqrt(static_cast<float>(voiceLevels[voice].sumSquares) * inverseFrames);
+        voiceLevels[voice] = Level{};
+    }
+
+    // Unroll the ring so the snapshot is oldest-first
+    const int tail = WAVEFORM_POINTS - waveformWrite;
+    std::memcpy(slot.waveform, waveformRing.data() + waveformWrite, tail * sizeof(float));
+    std::memcpy(slot.waveform + tail, waveformRing.data(), waveformWrite * sizeof(float));
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    shared.header.latestSlot.store(nextSlot, std::memory_order_release);
+
+    nextSlot = (nextSlot + 1) % NUM_SLOTS;
+    masterLevel = Level{};
+    windowFrames = 0;
+}
@@ -0,0 +1,101 @@
+#ifndef ANALYSIS_TAP_H
+#define ANALYSIS_TAP_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * AnalysisTap - Lock-free level meters and oscilloscope data for the UI
+ *
+ * The audio thread accumulates peak/RMS for each voice and for the master
+ * output, plus a decimated master waveform. About PUBLISH_RATE_HZ times a
+ * second it publishes a snapshot into one of three slots of a shared block
+ * that Kotlin reads through a direct ByteBuffer (AudioAnalysisReader).
+ *
+ * Each slot carries a sequence counter (odd while it is written) and the
+ * header names the latest complete slot. The writer always fills the
+ * oldest slot, so a reader copying the latest one at UI frame rate is
+ * never overwritten in practice, and the sequence check catches the rare
+ * case where it is. Neither side locks or allocates.
+ */
+class AnalysisTap {
+public:
+    static constexpr int MAX_VOICES = 8;
+    static constexpr int WAVEFORM_POINTS = 256;
+    static constexpr int WAVEFORM_DECIMATION = 4;  // Master samples per waveform point
+    static constexpr int NUM_SLOTS = 3;
+    static constexpr uint32_t VERSION = 1;
+
+    // Shared layout (little-endian, read field by field from Kotlin)
+    struct Header {
+        char magic[4];                      // "ASAT"
+        uint32_t version;
+        uint32_t numVoices;
+        uint32_t waveformPoints;
+        uint32_t numSlots;
+        uint32_t slotBytes;
+        uint32_t slotsOffset;               // Byte offset of slot 0
+        std::atomic<uint32_t> latestSlot;   // Last published slot
+    };
+
+    struct Snapshot {
+        std::atomic<uint32_t> sequence;     // Odd while the slot is being written
+        uint32_t reserved;
+        uint64_t frame;                     // Engine frame at the end of the window
+        float masterPeak;
+        float masterRms;
+        float voicePeak[MAX_VOICES];        // Pre master volume
+        float voiceRms[MAX_VOICES];
+        float waveform[WAVEFORM_POINTS];    // Oldest first
+    };
+
+    AnalysisTap();
+
+    void setSampleRate(float sampleRate);
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Shared block for NewDirectByteBuffer (valid for the tap's lifetime)
+    void *getSharedBuffer() { return &shared; }
+    static constexpr size_t getSharedBufferSize() { return sizeof(SharedBlock); }
+
+    // Audio thread
+    void addVoice(int voice, const float *samples, int numFrames);
+    void addMaster(const float *samples, int numFrames, uint64_t endFrame);
+
+private:
+    static constexpr float PUBLISH_RATE_HZ = 120.0f;
+
+    struct SharedBlock {
+        alignas(64) Header header;
+        alignas(64) std::array<Snapshot, NUM_SLOTS> slots;
+    };
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Shared layout needs plain 32-bit atomics");
+
+    struct Level {
+        float peak = 0.0f;
+        double sumSquares = 0.0;
+    };
+    static void accumulate(Level &level, const float *samples, int numFrames);
+
+    void publish(uint64_t endFrame);
+
+    std::atomic<bool> enabled{false};
+    int publishIntervalFrames = 400;
+
+    // Audio thread only
+    std::array<Level, MAX_VOICES> voiceLevels{};
+    Level masterLevel;
+    int windowFrames = 0;
+    std::array<float, WAVEFORM_POINTS> waveformRing{};
+    int waveformWrite = 0;
+    float bucketExtreme = 0.0f;
+    int bucketCount = 0;
+    uint32_t nextSlot = 0;
+
+    SharedBlock shared;
+};
+
+#endif // ANALYSIS_TAP_H
@@ -1,21 +1,67 @@
 #include "AudioEngine.h"
+#include "DspCache.h"
+#include "WavReader.h"
 #include <android/log.h>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
 
 #define LOG_TAG "AudioEngine"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-AudioEngine::AudioEngine() {
-    LOGI("AudioEngine created");
+// Mappa l'indice JNI (NativeAudioEngine.WAVE_*) sul tipo di oscillatore
+static Oscillator::WaveType toWaveType(int type) {
+    switch (type) {
+        case 0: return Oscillator::WaveType::Sine;      // Hammond B3
+        case 1: return Oscillator::WaveType::Sawtooth;  // Synth Lead
+        case 2: return Oscillator::WaveType::Drums;     // Electronic Drums
+        case 3: return Oscillator::WaveType::Bass;      // Electric Bass
+        case 4: return Oscillator::WaveType::Guitar;    // Electric Guitar
+        default: return Oscillator::WaveType::Sawtooth;
+    }
+}
+
+/**
+ * Costruzione minima: niente allocazioni pesanti sul thread UI. Se c'è una
+ * cache su disco ne riprende il seed (le tabelle salvate valgono solo per
+ * quel seed) e inizia subito a caricarla al rate con cui è stata scritta,
+ * di solito lo stesso che lo stream aprirà.
+ */
+AudioEngine::AudioEngine(const std::string &directory) : cacheDirectory(directory) {
+    DspCache::Key cached;
+    const bool warm = !cacheDirectory.empty() && DspCache::findLatest(cacheDirectory, cached);
+    randomSeed = warm ? cached.seed : std::random_device{}();
+    
+    for (int i = 0; i < NUM_OSCILLATORS; ++i) {
+        voices[i].setRandomSeed(randomSeed + i);
+    }
+    drumKit.setRandomSeed(randomSeed);
+    sequencerBass.setWaveType(Oscillator::WaveType::Bass);
+    sequencerBass.setRandomSeed(randomSeed + NUM_OSCILLATORS);
+    scheduleTableBuild(warm ? static_cast<int>(cached.sampleRate) : 0);
+    streamTaskThread = std::thread(&AudioEngine::streamTaskLoop, this);
+    LOGI("AudioEngine created (seed=%u, %s DSP cache)", randomSeed, warm ? "warm" : "cold");
 }
 
 AudioEngine::~AudioEngine() {
+    realtimeReplayer.stopRealtime();
+    {
+        std::lock_guard<std::mutex> lock(streamTaskMutex);
+        streamTaskExit = true;
+    }
+    streamTaskCondition.notify_one();
+    streamTaskThread.join();
+    waitForTables();
     stop();
+    recorder.stop();
+    eventLogger.stop();
     LOGI("AudioEngine destroyed");
 }
 
 bool AudioEngine::start() {
+    std::lock_guard<std::mutex> lock(streamMutex);
     if (isRunning) {
         return true;
     }
@@ -31,6 +77,7 @@ bool AudioEngine::start() {
 }
 
 void AudioEngine::stop() {
+    std::lock_guard<std::mutex> lock(streamMutex);
     if (!isRunning) {
         return;
     }
@@ -42,25 +89,51 @@ void AudioEngine::stop() {
         stream->close();
         stream.reset();
     }
+    input.closeStream();
+    inputActive = false;
     
     LOGI("AudioEngine stopped");
 }
 
 bool AudioEngine::openStream() {
+    // Un nuovo stream riparte da frame 0: il vecchio timestamp non vale più
+    timestampNs = -1;
+    timestampRefreshNs = 0;
+    
     oboe::AudioStreamBuilder builder;
     
     builder.setDirection(oboe::Direction::Output)
            ->setPerformanceMode(oboe::PerformanceMode::LowLatency)
            ->setSharingMode(oboe::SharingMode::Exclusive)
-           ->setFormat(oboe::AudioFormat::Float)
            ->setChannelCount(oboe::ChannelCount::Mono)
-           ->setSampleRate(sampleRate)
+           ->setSampleRateConversionQuality(oboe::SampleRateConversionQuality::None)
            ->setCallback(this);
     
-    // LowLatency gestisce automaticamente il buffer ottimale
+    // Nessun sample rate richiesto: lo stream si apre al rate nativo del
+    // dispositivo senza resampling, e il DSP si adatta in configureForSampleRate().
+    // LowLatency gestisce automaticamente il buffer ottimale.
+    // Formato non richiesto (auto): AAudio apre quello nativo del mixer, così
+    // sul percorso MMAP non serve una conversione di formato fuori dal callback.
+    const int format = requestedOutputFormat.load();
+    if (format == OUTPUT_FORMAT_FLOAT) {
+        builder.setFormat(oboe::AudioFormat::Float);
+    } else if (format == OUTPUT_FORMAT_PCM16) {
+        builder.setFormat(oboe::AudioFormat::I16);
+    }
     
     oboe::Result result = builder.openStream(stream);
     
+    // Formati che il callback non scrive (I24/I32 di alcuni DAC USB): di nuovo in float
+    if (result == oboe::Result::OK && stream->getFormat() != oboe::AudioFormat::Float &&
+        stream->getFormat() != oboe::AudioFormat::I16) {
+        LOGI("Stream format %s not supported, reopening as float",
+             oboe::convertToText(stream->getFormat()));
+        stream->close();
+        stream.reset();
+        builder.setFormat(oboe::AudioFormat::Float);
+        result = builder.openStream(stream);
+    }
+    
     if (result != oboe::Result::OK) {
         LOGE("Failed to open stream: %s", oboe::convertToText(result));
         return false;
@@ -70,15 +143,22 @@ bool AudioEngine::openStream() {
     sampleRate = stream->getSampleRate();
     framesPerBuffer = stream->getFramesPerBurst();
     
-    LOGI("Stream opened: sampleRate=%d, framesPerBurst=%d, latency=%d ms",
+    // Lo scratch copre qualunque numFrames del callback: mai allocare dal thread audio
+    pcm16Output = stream->getFormat() == oboe::AudioFormat::I16;
+    if (pcm16Output) {
+        pcmScratch.resize(std::max(stream->getBufferCapacityInFrames(), MIN_PCM_SCRATCH_FRAMES));
+    }
+    
+    LOGI("Stream opened: sampleRate=%d, framesPerBurst=%d, latency=%d ms, format=%s",
          sampleRate, framesPerBuffer,
-         (framesPerBuffer * 1000) / sampleRate);
+         (framesPerBuffer * 1000) / sampleRate, pcm16Output ? "pcm16" : "float");
     
-    // Configura gli oscillatori con il sample rate effettivo
-    for (auto& voice : voices) {
-        voice.setSampleRate(static_cast<float>(sampleRate));
-        voice.setWaveType(Oscillator::WaveType::Sawtooth);
-    }
+    configureForSampleRate();
+    idleFrames = 0;
+    streamSuspended = false;
+    
+    // Ingresso allo stesso rate, avviato prima dell'uscita
+    openInput();
     
     // Avvia lo stream
     result = stream->requestStart();
@@ -87,150 +167,1702 @@ bool AudioEngine::openStream() {
         LOGE("Failed to start stream: %s", oboe::convertToText(result));
         stream->close();
         stream.reset();
+        input.closeStream();
+        inputActive = false;
         return false;
     }
     
     return true;
 }
 
-void AudioEngine::noteOn(int voiceIndex, float frequency) {
-    if (voiceIndex < 0 || voiceIndex >= MAX_VOICES) {
-        LOGE("Invalid voice index: %d", voiceIndex);
+/**
+ * Apre l'ingresso richiesto (dispositivo o file) per lo stream che sta per
+ * partire. Se il dispositivo non si apre (permesso negato, nessun ingresso)
+ * l'uscita parte comunque, senza ingresso.
+ */
+void AudioEngine::openInput() {
+    inputActive = false;
+    if (!inputRequested.load()) {
+        return;
+    }
+    if (!input.hasFile() && !input.openStream(sampleRate)) {
+        LOGE("Input unavailable, output only");
         return;
     }
+    input.prepare(sampleRate);
+    inputActive = true;
+}
+
+/**
+ * Riserva l'arena e ci ritaglia le delay line, voce dopo voce e poi il bus,
+ * nell'ordine in cui il callback le usa. Solo a stream fermo, con
+ * drumCacheMutex acquisito (getDspMemoryBytes legge l'arena sotto lo stesso lock).
+ */
+bool AudioEngine::allocateDspState(float maxRate) {
+    size_t bytes = NUM_OSCILLATORS * Oscillator::storageBytes(maxRate, delayFormat)
+                   + InsertChain::storageBytes(maxRate, delayFormat);
+    if (!arena.reserve(bytes)) {
+        LOGE("Failed to reserve %zu bytes of DSP memory", bytes);
+        return false;
+    }
     
     std::lock_guard<std::mutex> lock(voiceMutex);
-    voices[voiceIndex].noteOn(frequency);
-    LOGI("Note ON: voice=%d, freq=%.2f Hz", voiceIndex, frequency);
+    arena.reset();
+    for (auto& voice : voices) {
+        voice.attachStorage(arena, maxRate, delayFormat);
+    }
+    insertChain.attachStorage(arena, maxRate, delayFormat);
+    arenaRate = maxRate;
+    
+    LOGI("DSP arena: %zu/%zu bytes for up to %.0f Hz",
+         arena.getUsedBytes(), arena.getCapacityBytes(), maxRate);
+    return true;
 }
 
-void AudioEngine::noteOff(int voiceIndex) {
-    if (voiceIndex < 0 || voiceIndex >= MAX_VOICES) {
-        LOGE("Invalid voice index: %d", voiceIndex);
+/**
+ * Avvia il thread che costruisce le tabelle per un sample rate (0 = solo
+ * l'arena). Un solo build alla volta: quello precedente viene atteso, e se
+ * rate e seed sono già quelli richiesti non si rifà nulla.
+ */
+void AudioEngine::scheduleTableBuild(int rate) {
+    std::lock_guard<std::mutex> lock(tableThreadMutex);
+    if (rate != 0 && rate == tableRate && randomSeed == tableSeed) {
         return;
     }
-    
-    std::lock_guard<std::mutex> lock(voiceMutex);
-    voices[voiceIndex].noteOff();
-    LOGI("Note OFF: voice=%d", voiceIndex);
+    if (tableThread.joinable()) {
+        tableThread.join();
+    }
+    tablesReady.store(false, std::memory_order_relaxed);
+    tableRate = rate;
+    tableSeed = randomSeed;
+    tableThread = std::thread(&AudioEngine::buildTables, this, rate);
 }
 
-void AudioEngine::allNotesOff() {
-    std::lock_guard<std::mutex> lock(voiceMutex);
-    for (auto& voice : voices) {
-        voice.noteOff();
+void AudioEngine::waitForTables() {
+    std::lock_guard<std::mutex> lock(tableThreadMutex);
+    if (tableThread.joinable()) {
+        tableThread.join();
     }
-    LOGI("All notes OFF");
 }
 
-void AudioEngine::setPitchBend(int voiceIndex, float semitones) {
-    if (voiceIndex < 0 || voiceIndex >= MAX_VOICES) {
+/**
+ * Thread delle tabelle: riserva l'arena la prima volta, poi carica i one-shot
+ * dalla cache su disco (mmap) o li renderizza e li salva per il prossimo
+ * avvio. La pubblicazione è lo stesso swap sotto voiceMutex di commitCache.
+ */
+void AudioEngine::buildTables(int rate) {
+    const auto begin = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> cacheLock(drumCacheMutex);
+    
+    if (arenaRate == 0.0f) {
+        allocateDspState(std::max(ARENA_SAMPLE_RATE, static_cast<float>(rate)));
+    }
+    if (rate <= 0) {
         return;
     }
     
-    std::lock_guard<std::mutex> lock(voiceMutex);
-    voices[voiceIndex].setPitchBend(semitones);
+    bool fromDisk = false;
+    if (!cacheDirectory.empty()) {
+        DspCache file;
+        fromDisk = file.open(DspCache::pathFor(cacheDirectory, rate)) &&
+                   drumKit.loadCache(file, static_cast<float>(rate));
+    }
+    if (!fromDisk) {
+        drumKit.prepareCache(drumKit.getVelocityLayers(), static_cast<float>(rate));
+    }
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        drumKit.commitCache();
+    }
+    tablesReady.store(true, std::memory_order_release);
+    
+    const double elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - begin).count();
+    LOGI("DSP tables for %d Hz ready in %.1f ms (%s)", rate, elapsedMs,
+         fromDisk ? "disk cache" : "rendered");
+    if (!fromDisk) {
+        saveTablesLocked();
+    }
 }
 
-void AudioEngine::setMasterVolume(float volume) {
-    masterVolume = std::clamp(volume, 0.0f, 1.0f);
-    LOGI("Master volume set to: %.2f", masterVolume);
+// Chiamare con drumCacheMutex acquisito
+void AudioEngine::saveTablesLocked() {
+    if (!cacheDirectory.empty()) {
+        const int rate = static_cast<int>(drumKit.getSampleRate());
+        drumKit.saveCache(DspCache::pathFor(cacheDirectory, rate));
+    }
 }
 
-void AudioEngine::setWaveType(int type) {
-    Oscillator::WaveType waveType;
+// Configura oscillatori, effetti e batteria con il sample rate effettivo
+void AudioEngine::configureForSampleRate() {
+    // L'arena del costruttore dev'essere pronta (richiede pochi ms)
+    waitForTables();
     
-    switch (type) {
-        case 0: waveType = Oscillator::WaveType::Sine; break;     // Hammond B3
-        case 1: waveType = Oscillator::WaveType::Sawtooth; break; // Synth Lead
-        case 2: waveType = Oscillator::WaveType::Drums; break;    // Electronic Drums
-        case 3: waveType = Oscillator::WaveType::Bass; break;     // Electric Bass
-        case 4: waveType = Oscillator::WaveType::Guitar; break;   // Electric Guitar
-        default: waveType = Oscillator::WaveType::Sawtooth; break;
+    // Rate oltre quello previsto: l'arena cresce una sola volta, prima dello start
+    if (sampleRate > arenaRate) {
+        std::lock_guard<std::mutex> cacheLock(drumCacheMutex);
+        allocateDspState(static_cast<float>(sampleRate));
     }
     
-    std::lock_guard<std::mutex> lock(voiceMutex);
     for (auto& voice : voices) {
-        voice.setWaveType(waveType);
+        voice.setSampleRate(static_cast<float>(sampleRate));
     }
+    sequencerBass.setSampleRate(static_cast<float>(sampleRate));
+    sampler.setSampleRate(static_cast<float>(sampleRate));
+    sequencer.setSampleRate(static_cast<float>(sampleRate));
+    insertChain.setSampleRate(static_cast<float>(sampleRate));
+    analysisTap.setSampleRate(static_cast<float>(sampleRate));
     
-    LOGI("Wave type set to: %d", type);
+    // Le IR vanno ricampionate al nuovo rate
+    for (int slot = 0; slot < InsertChain::NUM_SLOTS; ++slot) {
+        if (!impulseSources[slot].empty()) {
+            installImpulseResponse(slot);
+        }
+    }
+    
+    // One-shot di batteria al sample rate dello stream, in background
+    scheduleTableBuild(sampleRate);
 }
 
-void AudioEngine::setGuitarParams(float sustain, float gain, float distortion, float reverb) {
-    std::lock_guard<std::mutex> lock(voiceMutex);
-    for (auto& voice : voices) {
-        voice.setGuitarSustain(sustain);
-        voice.setGuitarGain(gain);
-        voice.setGuitarDistortion(distortion);
-        voice.setGuitarReverb(reverb);
+void AudioEngine::noteOn(int voiceIndex, float frequency) {
+    // Primo timbro del tracing: appena entrati dal JNI
+    const uint32_t traceId = latencyTracer.stampEntry(voiceIndex);
+    
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        
+        const bool validVoice = voiceIndex >= 0 && voiceIndex < MAX_VOICES;
+        if (melodicZones && !validVoice) {
+            LOGE("Invalid voice index: %d", voiceIndex);
+            return;
+        }
+        
+        // Tier CappedPolyphony: fa posto rilasciando le note tenute più vecchie
+        if (melodicZones && polyphonyCap < MAX_VOICES) {
+            releaseOldestHeldLocked(voiceIndex, polyphonyCap - 1);
+        }
+        
+        // Un oscillatore per ogni zona melodica che contiene la nota, nell'ordine delle zone
+        int layer = 0;
+        bool drumHit = false;
+        bool samplerHit = false;
+        bool routingChanged = false;
+        for (int z = 0; z < zoneCount; ++z) {
+            const InstrumentZone &zone = zones[z];
+            if (frequency < zone.lowHz || frequency >= zone.highHz) {
+                continue;
+            }
+            const Oscillator::WaveType type = toWaveType(zone.type);
+            if (type == Oscillator::WaveType::Drums) {
+                // Le batterie non occupano voci melodiche: ogni pad è un one-shot
+                if (!drumHit) {
+                    drumKit.trigger(frequency, zone.level);
+                    drumHit = true;
+                }
+                continue;
+            }
+            if (zone.type == SAMPLER_TYPE) {
+                // Il campionatore ha una voce per dito, fuori dal conto dei layer
+                if (!samplerHit) {
+                    sampler.noteOn(voiceIndex, frequency, DEFAULT_AMPLITUDE * zone.level);
+                    samplerHit = sampler.isLoaded();
+                }
+                continue;
+            }
+            if (layer == MAX_LAYERS) {
+                continue;
+            }
+            Oscillator &voice = voices[layer * MAX_VOICES + voiceIndex];
+            routingChanged |= voice.getWaveType() != type;
+            voice.setWaveType(type);
+            voice.setAmplitude(DEFAULT_AMPLITUDE * zone.level);
+            voice.noteOn(frequency);
+            ++layer;
+        }
+        if (routingChanged) {
+            updateVoiceRouting();
+        }
+        
+        if (layer > 0 || samplerHit) {
+            noteStamps[voiceIndex] = ++noteCounter;
+            fingerMidi[voiceIndex] = ScaleQuantizer::frequencyToMidi(frequency);
+            fingerBend[voiceIndex] = 0.0f;
+            if (traceId != 0) {
+                voiceTraceIds[voiceIndex] = traceId;
+                voiceTraceDequeued[voiceIndex] = false;
+            }
+            LOGI("Note ON: voice=%d, freq=%.2f Hz, layers=%d%s", voiceIndex, frequency, layer,
+                 samplerHit ? " + sampler" : "");
+        } else if (drumHit) {
+            if (traceId != 0) {
+                drumTraceId = traceId;
+                drumTraceDequeued = false;
+            }
+            LOGI("Drum hit: freq=%.2f Hz", frequency);
+        }
     }
-    LOGI("Guitar params: sustain=%.2f, gain=%.2f, dist=%.2f, reverb=%.2f", 
-         sustain, gain, distortion, reverb);
+    wakeFromIdle();
+    logEvent(stamp, EventType::NoteOn, voiceIndex, frequency);
 }
 
-void AudioEngine::setWahEnabled(bool enabled) {
+void AudioEngine::noteOff(int voiceIndex) {
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        
+        // I one-shot di batteria suonano fino alla fine del campione
+        if (!melodicZones) {
+            return;
+        }
+        
+        if (voiceIndex < 0 || voiceIndex >= MAX_VOICES) {
+            LOGE("Invalid voice index: %d", voiceIndex);
+            return;
+        }
+        
+        noteOffLocked(voiceIndex);
+        LOGI("Note OFF: voice=%d", voiceIndex);
+    }
+    logEvent(stamp, EventType::NoteOff, voiceIndex);
+}
+
+// Rilascia tutti i layer di una voce. Chiamare con voiceMutex acquisito.
+void AudioEngine::noteOffLocked(int voiceIndex) {
+    for (int layer = 0; layer < MAX_LAYERS; ++layer) {
+        voices[layer * MAX_VOICES + voiceIndex].noteOff();
+    }
+    sampler.noteOff(voiceIndex);
+}
+
+void AudioEngine::allNotesOff() {
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        for (auto& voice : voices) {
+            voice.noteOff();
+        }
+        sampler.allOff();
+        drumKit.allOff();
+    }
+    logEvent(stamp, EventType::AllNotesOff);
+    LOGI("All notes OFF");
+}
+
+void AudioEngine::setPitchBend(int voiceIndex, float semitones) {
+    if (voiceIndex < 0 || voiceIndex >= MAX_VOICES) {
+        return;
+    }
+    
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        for (int layer = 0; layer < MAX_LAYERS; ++layer) {
+            voices[layer * MAX_VOICES + voiceIndex].setPitchBend(semitones);
+        }
+        sampler.setPitchBend(voiceIndex, semitones);
+    }
+    logEvent(stamp, EventType::PitchBend, voiceIndex, semitones);
+}
+
+bool AudioEngine::setScale(int root, const int *intervals, int count, int baseOctave) {
     std::lock_guard<std::mutex> lock(voiceMutex);
-    for (auto& voice : voices) {
-        voice.setWahEnabled(enabled);
+    if (!scale.setScale(root, intervals, count, baseOctave)) {
+        LOGE("Invalid scale: root=%d, %d intervals", root, count);
+        return false;
     }
-    LOGI("Wah pedal: %s", enabled ? "ON" : "OFF");
+    LOGI("Scale set: root=%d, %d notes per octave from octave %d", root, count, baseOctave);
+    return true;
 }
 
-void AudioEngine::setWahPosition(float position) {
+// Il log registra la frequenza risultante, quindi il replay non dipende dalla scala
+void AudioEngine::noteOnDegree(int voiceIndex, int degree) {
+    float frequency;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        frequency = scale.getFrequency(degree);
+    }
+    noteOn(voiceIndex, frequency);
+}
+
+void AudioEngine::setBendMode(bool snapToScale, float glideMs) {
     std::lock_guard<std::mutex> lock(voiceMutex);
-    for (auto& voice : voices) {
-        voice.setWahPosition(position);
+    bendSnap = snapToScale;
+    bendGlideMs = std::clamp(glideMs, 0.0f, MAX_BEND_GLIDE_MS);
+    LOGI("Bend mode: snap=%d, glide=%.1f ms", bendSnap, bendGlideMs);
+}
+
+void AudioEngine::bendBy(int voiceIndex, float deltaSemitones) {
+    if (voiceIndex < 0 || voiceIndex >= MAX_VOICES) {
+        return;
     }
+    EventStamp stamp;
+    float target;
+    float glideMs;
+    {
+        // Lettura, somma e applicazione nella stessa sezione critica:
+        // due gesti concorrenti sulla stessa voce non perdono delta
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = bendToLocked(voiceIndex, fingerBend[voiceIndex] + deltaSemitones, target, glideMs);
+    }
+    logEvent(stamp, EventType::BendTarget, voiceIndex, target, glideMs);
 }
 
-oboe::DataCallbackResult AudioEngine::onAudioReady(
-        oboe::AudioStream *audioStream,
-        void *audioData,
-        int32_t numFrames) {
+void AudioEngine::bendTo(int voiceIndex, float semitones) {
+    if (voiceIndex < 0 || voiceIndex >= MAX_VOICES) {
+        return;
+    }
+    EventStamp stamp;
+    float target;
+    float glideMs;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = bendToLocked(voiceIndex, semitones, target, glideMs);
+    }
+    logEvent(stamp, EventType::BendTarget, voiceIndex, target, glideMs);
+}
+
+/**
+ * Il bend grezzo del dito diventa un bersaglio: con lo snap attivo è la nota
+ * della scala più vicina alla nota di partenza più il bend, quindi il suono
+ * resta fermo finché il gesto non supera metà strada e poi scivola sulla
+ * nota successiva. Chiamare con voiceMutex acquisito.
+ */
+AudioEngine::EventStamp AudioEngine::bendToLocked(int voiceIndex, float semitones,
+                                                  float &target, float &glideMs) {
+    fingerBend[voiceIndex] = std::clamp(semitones, -12.0f, 12.0f);
+    target = fingerBend[voiceIndex];
+    if (bendSnap) {
+        const float start = fingerMidi[voiceIndex];
+        target = scale.snap(start + target) - start;
+    }
+    glideMs = bendGlideMs;
+    return setBendTargetLocked(voiceIndex, target, glideMs);
+}
+
+void AudioEngine::setBendTarget(int voiceIndex, float semitones, float glideMs) {
+    if (voiceIndex < 0 || voiceIndex >= MAX_VOICES) {
+        return;
+    }
     
-    auto *outputBuffer = static_cast<float *>(audioData);
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = setBendTargetLocked(voiceIndex, semitones, glideMs);
+    }
+    logEvent(stamp, EventType::BendTarget, voiceIndex, semitones, glideMs);
+}
+
+// Chiamare con voiceMutex acquisito
+AudioEngine::EventStamp AudioEngine::setBendTargetLocked(int voiceIndex, float semitones, float glideMs) {
+    const EventStamp stamp = stampEventLocked();
+    for (int layer = 0; layer < MAX_LAYERS; ++layer) {
+        voices[layer * MAX_VOICES + voiceIndex].glidePitchBend(semitones, glideMs * 0.001f);
+    }
+    sampler.glidePitchBend(voiceIndex, semitones, glideMs * 0.001f);
+    return stamp;
+}
+
+void AudioEngine::triggerDrum(float frequency, float velocity) {
+    const uint32_t traceId = latencyTracer.stampEntry(-1);
     
-    // Azzera il buffer
-    std::fill(outputBuffer, outputBuffer + numFrames, 0.0f);
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        drumKit.trigger(frequency, velocity);
+        if (traceId != 0) {
+            drumTraceId = traceId;
+            drumTraceDequeued = false;
+        }
+    }
+    wakeFromIdle();
+    logEvent(stamp, EventType::DrumTrigger, -1, frequency, velocity);
+    LOGI("Drum hit: freq=%.2f Hz, velocity=%.2f", frequency, velocity);
+}
+
+/**
+ * Mappa i file e decodifica gli attacchi senza lock, poi sostituisce la
+ * libreria: prima si ferma il thread di prefetch, poi le voci.
+ * La vecchia libreria viene smappata fuori da entrambi i lock.
+ */
+bool AudioEngine::loadSampler(const Sampler::ZoneSpec *zones, int count) {
+    std::unique_ptr<Sampler::Library> library;
+    if (count > 0) {
+        library = Sampler::loadLibrary(zones, count);
+        if (!library) {
+            return false;
+        }
+    }
+    {
+        auto streamLock = sampler.lockStreams();
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        sampler.swapLibraryLocked(library);
+    }
+    LOGI("Sampler %s (%d zones)", count > 0 ? "loaded" : "unloaded", count);
+    return true;
+}
+
+/**
+ * Pattern nuovo per il sequencer: passa al thread audio con un triple buffer,
+ * senza voiceMutex, e viene preso al prossimo callback senza perdere il passo.
+ */
+bool AudioEngine::setSequencerPattern(const StepSequencer::Pattern &pattern) {
+    if (!sequencer.setPattern(pattern)) {
+        LOGE("Invalid sequencer pattern: %d steps, %d tracks", pattern.stepCount, pattern.trackCount);
+        return false;
+    }
+    LOGI("Sequencer pattern: %d steps, %d tracks, swing %.2f",
+         pattern.stepCount, pattern.trackCount, pattern.swing);
+    return true;
+}
+
+void AudioEngine::setSequencerTempo(float bpm) {
+    sequencer.setTempo(bpm);
+    LOGI("Sequencer tempo: %.1f BPM", sequencer.getTempo());
+}
+
+void AudioEngine::startSequencer() {
+    sequencer.start();
+    wakeFromIdle();
+    LOGI("Sequencer started");
+}
+
+void AudioEngine::stopSequencer() {
+    sequencer.stop();
+    LOGI("Sequencer stopped");
+}
+
+void AudioEngine::setSequencerTrackLock(bool enabled, float offsetMs) {
+    sequencer.setTrackLock(enabled, offsetMs);
+    LOGI("Sequencer track lock: %s (offset %.1f ms)", enabled ? "on" : "off", offsetMs);
+}
+
+/**
+ * Posizione della base e istante (CLOCK_MONOTONIC) a cui è stata letta;
+ * il callback la proietta sul proprio tempo di presentazione.
+ */
+void AudioEngine::syncSequencerToTrack(double trackPositionMs, int64_t sampleTimeNs) {
+    sequencer.syncToTrack(trackPositionMs, sampleTimeNs);
+}
+
+// Dal thread audio, con voiceMutex acquisito
+void AudioEngine::applySequencerEvent(const StepSequencer::Event &event) {
+    if (event.target == StepSequencer::Target::Drum) {
+        drumKit.trigger(event.frequency, event.velocity);
+    } else if (event.velocity > 0.0f) {
+        sequencerBass.setAmplitude(DEFAULT_AMPLITUDE * event.velocity);
+        sequencerBass.noteOn(event.frequency);
+    } else {
+        sequencerBass.noteOff();
+    }
+}
+
+void AudioEngine::setDrumVelocityLayers(int layers) {
+    std::lock_guard<std::mutex> cacheLock(drumCacheMutex);
     
-    // Mix di tutte le voci attive
+    // Render fuori dal lock delle voci, poi swap veloce
+    drumKit.prepareCache(layers);
     {
         std::lock_guard<std::mutex> lock(voiceMutex);
-        
+        drumKit.commitCache();
+    }
+    saveTablesLocked();
+    LOGI("Drum velocity layers set to: %d", drumKit.getVelocityLayers());
+}
+
+void AudioEngine::setDrumPitchTracking(bool enabled) {
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        drumKit.setPitchTracking(enabled);
+    }
+    logEvent(stamp, EventType::DrumPitchTracking, -1, enabled ? 1.0f : 0.0f);
+    LOGI("Drum pitch tracking: %s", enabled ? "on" : "off");
+}
+
+void AudioEngine::setMasterVolume(float volume) {
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        masterVolume = std::clamp(volume, 0.0f, 1.0f);
+    }
+    logEvent(stamp, EventType::MasterVolume, -1, masterVolume);
+    LOGI("Master volume set to: %.2f", masterVolume);
+}
+
+void AudioEngine::setWaveType(int type) {
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        waveTypeIndex = type;
         for (auto& voice : voices) {
-            if (voice.isActive()) {
-                for (int i = 0; i < numFrames; ++i) {
-                    outputBuffer[i] += voice.getNextSample();
-                }
-            }
+            voice.setWaveType(toWaveType(type));
         }
+        applyZoneLocked(0, type, 0.0f, std::numeric_limits<float>::infinity(), 1.0f);
+        updateVoiceRouting();
     }
+    logEvent(stamp, EventType::WaveType, -1, static_cast<float>(type));
     
-    // Applica master volume con attenuazione base (synth troppo forte rispetto alle basi)
-    const float synthAttenuation = 0.25f;  // Riduce il volume massimo del synth
-    for (int i = 0; i < numFrames; ++i) {
-        outputBuffer[i] *= masterVolume * synthAttenuation;
-        // Soft clipping per evitare distorsione
-        outputBuffer[i] = std::clamp(outputBuffer[i], -1.0f, 1.0f);
+    LOGI("Wave type set to: %d", type);
+}
+
+bool AudioEngine::setInstrumentZones(const int *types, const float *lowHz, const float *highHz,
+                                     const float *levels, int count) {
+    if (count < 1 || count > MAX_ZONES) {
+        LOGE("Invalid instrument zone count: %d", count);
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (types[i] < 0 || (types[i] >= NUM_WAVE_TYPES && types[i] != SAMPLER_TYPE) ||
+            !(lowHz[i] < highHz[i]) || levels[i] < 0.0f) {
+            LOGE("Invalid instrument zone %d", i);
+            return false;
+        }
     }
     
-    return oboe::DataCallbackResult::Continue;
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        for (int i = 0; i < count; ++i) {
+            applyZoneLocked(i, types[i], lowHz[i], highHz[i], levels[i]);
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        logEvent(stamp, EventType::InstrumentZone, i, static_cast<float>(types[i]),
+                 lowHz[i], highHz[i], levels[i]);
+    }
+    LOGI("Instrument zones: %d", count);
+    return true;
 }
 
-void AudioEngine::onErrorBeforeClose(oboe::AudioStream *audioStream, oboe::Result error) {
-    LOGE("Error before close: %s", oboe::convertToText(error));
+/**
+ * Imposta la zona index e scarta quelle successive: le zone si scrivono
+ * (e si rileggono dal log eventi) in ordine. Chiamare con voiceMutex acquisito.
+ */
+void AudioEngine::applyZoneLocked(int index, int type, float lowHz, float highHz, float level) {
+    if (index < 0 || index >= MAX_ZONES) {
+        return;
+    }
+    zones[index] = InstrumentZone{type, lowHz, highHz, std::clamp(level, 0.0f, 1.0f)};
+    zoneCount = index + 1;
+    melodicZones = false;
+    for (int i = 0; i < zoneCount; ++i) {
+        melodicZones |= toWaveType(zones[i].type) != Oscillator::WaveType::Drums;
+    }
 }
 
-void AudioEngine::onErrorAfterClose(oboe::AudioStream *audioStream, oboe::Result error) {
-    LOGE("Error after close: %s", oboe::convertToText(error));
-    
-    // Prova a riavviare lo stream
-    if (isRunning) {
-        restartStream();
-    }
+void AudioEngine::setGuitarParams(float sustain, float gain, float distortion, float reverb) {
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        for (auto& voice : voices) {
+            voice.setGuitarSustain(sustain);
+            voice.setGuitarGain(gain);
+            voice.setGuitarDistortion(distortion);
+            voice.setGuitarReverb(reverb);
+        }
+        insertChain.getAmp().setGain(gain);
+        insertChain.getAmp().setDistortion(distortion);
+        insertChain.getReverb().setAmount(reverb);
+        guitarParams = {sustain, gain, distortion, reverb};
+    }
+    logEvent(stamp, EventType::GuitarParams, -1, sustain, gain, distortion, reverb);
+    LOGI("Guitar params: sustain=%.2f, gain=%.2f, dist=%.2f, reverb=%.2f", 
+         sustain, gain, distortion, reverb);
+}
+
+void AudioEngine::setEnvelopeCurve(bool exponential) {
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        auto curve = exponential ? ADSREnvelope::Curve::Exponential
+                                 : ADSREnvelope::Curve::Linear;
+        for (auto& voice : voices) {
+            voice.getEnvelope().setCurve(curve);
+        }
+        sequencerBass.getEnvelope().setCurve(curve);
+        sampler.setCurve(curve);
+        exponentialEnvelope = exponential;
+    }
+    logEvent(stamp, EventType::EnvelopeCurve, -1, exponential ? 1.0f : 0.0f);
+    LOGI("Envelope curve: %s", exponential ? "exponential" : "linear");
+}
+
+void AudioEngine::setUnison(int unisonVoices, float detuneCents, float mix) {
+    unisonVoices = std::clamp(unisonVoices, 1, UnisonSaw::MAX_VOICES);
+    detuneCents = std::clamp(detuneCents, 0.0f, UnisonSaw::MAX_DETUNE_CENTS);
+    mix = std::clamp(mix, 0.0f, 1.0f);
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        // Tutti gli oscillatori: vale per i layer synth lead di qualunque zona
+        for (auto& voice : voices) {
+            voice.setUnison(unisonVoices, detuneCents, mix);
+        }
+        unisonParams = {static_cast<float>(unisonVoices), detuneCents, mix};
+    }
+    logEvent(stamp, EventType::Unison, -1, static_cast<float>(unisonVoices), detuneCents, mix);
+    LOGI("Unison: %d voices, detune=%.1f cents, mix=%.2f", unisonVoices, detuneCents, mix);
+}
+
+void AudioEngine::setWahEnabled(bool enabled) {
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        for (auto& voice : voices) {
+            voice.setWahEnabled(enabled);
+        }
+        insertChain.getWah().setEnabled(enabled);
+        insertChain.setBypass(InsertChain::Slot::Wah, !enabled);
+        wahEnabled = enabled;
+        wahManual = false;
+    }
+    logEvent(stamp, EventType::WahEnabled, -1, enabled ? 1.0f : 0.0f);
+    LOGI("Wah pedal: %s", enabled ? "ON" : "OFF");
+}
+
+void AudioEngine::setWahPosition(float position) {
+    EventStamp stamp;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        stamp = stampEventLocked();
+        for (auto& voice : voices) {
+            voice.setWahPosition(position);
+        }
+        insertChain.getWah().setPosition(position);
+        wahPosition = position;
+        wahManual = true;
+    }
+    logEvent(stamp, EventType::WahPosition, -1, position);
+}
+
+void AudioEngine::logEvent(EventStamp stamp, EventType type, int voice,
+                           float value0, float value1, float value2, float value3) {
+    if (!eventLogger.isActive()) {
+        return;
+    }
+    
+    PerformanceEvent event{};
+    event.frame = stamp.frame;
+    event.sequence = stamp.sequence;
+    event.type = type;
+    event.voice = static_cast<int16_t>(voice);
+    event.values[0] = value0;
+    event.values[1] = value1;
+    event.values[2] = value2;
+    event.values[3] = value3;
+    eventLogger.record(event);
+}
+
+/**
+ * Avvia il log degli eventi. Le voci vengono azzerate e riseminate, e lo
+ * stato dei controlli viene scritto come primi eventi: il replay riparte
+ * così dallo stesso identico stato.
+ */
+bool AudioEngine::startEventLog(const char *path) {
+    EventStamp stamp;
+    QualityGovernor::Tier tier;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        int blockFrames = lastCallbackFrames > 0 ? lastCallbackFrames : framesPerBuffer;
+        if (!eventLogger.start(path, static_cast<uint32_t>(sampleRate), randomSeed,
+                               static_cast<uint32_t>(blockFrames))) {
+            return false;
+        }
+        resetVoicesLocked();
+        framesRendered = 0;
+        eventSequence = 0;
+        stamp = stampEventLocked();
+        tier = appliedTier;
+    }
+    wakeFromIdle();  // Il log ha bisogno del tempo che scorre
+    
+    logEvent(stamp, EventType::MasterVolume, -1, masterVolume);
+    logEvent(stamp, EventType::WaveType, -1, static_cast<float>(waveTypeIndex));
+    for (int i = 0; i < zoneCount; ++i) {
+        const InstrumentZone &zone = zones[i];
+        logEvent(stamp, EventType::InstrumentZone, i, static_cast<float>(zone.type),
+                 zone.lowHz, zone.highHz, zone.level);
+    }
+    logEvent(stamp, EventType::EnvelopeCurve, -1, exponentialEnvelope ? 1.0f : 0.0f);
+    logEvent(stamp, EventType::Unison, -1, unisonParams[0], unisonParams[1], unisonParams[2]);
+    logEvent(stamp, EventType::DrumPitchTracking, -1, drumKit.isPitchTracking() ? 1.0f : 0.0f);
+    logEvent(stamp, EventType::QualityTier, -1, static_cast<float>(tier));
+    logEvent(stamp, EventType::GuitarParams, -1,
+             guitarParams[0], guitarParams[1], guitarParams[2], guitarParams[3]);
+    logEvent(stamp, EventType::WahEnabled, -1, wahEnabled ? 1.0f : 0.0f);
+    if (wahManual) {
+        logEvent(stamp, EventType::WahPosition, -1, wahPosition);
+    }
+    return true;
+}
+
+void AudioEngine::stopEventLog() {
+    eventLogger.stop();
+}
+
+bool AudioEngine::renderEventLog(const char *logPath, const char *wavPath) {
+    if (isRunning) {
+        LOGE("Offline replay requires the stream to be stopped");
+        return false;
+    }
+    
+    EventReplayer replayer;
+    return replayer.open(logPath) && replayer.renderOffline(*this, wavPath);
+}
+
+bool AudioEngine::startEventReplay(const char *logPath) {
+    realtimeReplayer.stopRealtime();
+    return realtimeReplayer.open(logPath) && realtimeReplayer.startRealtime(*this);
+}
+
+void AudioEngine::stopEventReplay() {
+    realtimeReplayer.stopRealtime();
+}
+
+void AudioEngine::applyEvent(const PerformanceEvent &event) {
+    const float *v = event.values;
+    switch (event.type) {
+        case EventType::NoteOn:       noteOn(event.voice, v[0]); break;
+        case EventType::NoteOff:      noteOff(event.voice); break;
+        case EventType::AllNotesOff:  allNotesOff(); break;
+        case EventType::PitchBend:    setPitchBend(event.voice, v[0]); break;
+        case EventType::BendTarget:   setBendTarget(event.voice, v[0], v[1]); break;
+        case EventType::WaveType:     setWaveType(static_cast<int>(v[0])); break;
+        case EventType::GuitarParams: setGuitarParams(v[0], v[1], v[2], v[3]); break;
+        case EventType::WahEnabled:   setWahEnabled(v[0] != 0.0f); break;
+        case EventType::WahPosition:  setWahPosition(v[0]); break;
+        case EventType::MasterVolume: setMasterVolume(v[0]); break;
+        case EventType::DrumTrigger:  triggerDrum(v[0], v[1]); break;
+        case EventType::EnvelopeCurve: setEnvelopeCurve(v[0] != 0.0f); break;
+        case EventType::Unison:       setUnison(static_cast<int>(v[0]), v[1], v[2]); break;
+        case EventType::DrumPitchTracking: setDrumPitchTracking(v[0] != 0.0f); break;
+        case EventType::InstrumentZone: {
+            std::lock_guard<std::mutex> lock(voiceMutex);
+            applyZoneLocked(event.voice, static_cast<int>(v[0]), v[1], v[2], v[3]);
+            break;
+        }
+        case EventType::QualityTier:
+            // Usato dal replay offline; dal vivo il governor riprende il controllo
+            requestedTier = std::clamp(static_cast<int>(v[0]), 0, QualityGovernor::NUM_TIERS - 1);
+            break;
+        default:
+            LOGE("Unknown event type: %d", static_cast<int>(event.type));
+            break;
+    }
+}
+
+bool AudioEngine::prepareForReplay(int rate, uint32_t seed) {
+    if (isRunning) {
+        return false;
+    }
+    
+    // Il render offline parte solo con le tabelle pubblicate
+    waitForTables();
+    sampleRate = rate;
+    randomSeed = seed;
+    drumKit.setRandomSeed(seed);
+    configureForSampleRate();
+    waitForTables();
+    requestedTier = static_cast<int>(QualityGovernor::Tier::Full);
+    
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    resetVoicesLocked();
+    framesRendered = 0;
+    return true;
+}
+
+void AudioEngine::renderOffline(float *output, int numFrames) {
+    renderingOffline = true;
+    renderAudio(output, numFrames);
+    renderingOffline = false;
+}
+
+void AudioEngine::setRandomSeed(uint32_t seed) {
+    {
+        std::lock_guard<std::mutex> cacheLock(drumCacheMutex);
+        drumKit.setRandomSeed(seed);
+        drumKit.prepareCache(drumKit.getVelocityLayers());
+        
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        randomSeed = seed;
+        drumKit.commitCache();
+        for (int i = 0; i < NUM_OSCILLATORS; ++i) {
+            voices[i].setRandomSeed(seed + i);
+        }
+        sequencerBass.setRandomSeed(seed + NUM_OSCILLATORS);
+        saveTablesLocked();
+    }
+    {
+        std::lock_guard<std::mutex> lock(tableThreadMutex);
+        tableSeed = seed;
+    }
+    LOGI("Random seed set to: %u", seed);
+}
+
+// Chiamare con voiceMutex acquisito
+void AudioEngine::resetVoicesLocked() {
+    for (int i = 0; i < NUM_OSCILLATORS; ++i) {
+        voices[i].reset();
+        voices[i].setRandomSeed(randomSeed + i);
+    }
+    sequencerBass.reset();
+    sequencerBass.setRandomSeed(randomSeed + NUM_OSCILLATORS);
+    sampler.reset();
+    drumKit.allOff();
+    insertChain.reset();
+    voiceTraceIds.fill(0);
+    drumTraceId = 0;
+}
+
+bool AudioEngine::startRecording(const char *path, int format) {
+    auto sampleFormat = format == 1 ? WavWriter::SampleFormat::Float32
+                                    : WavWriter::SampleFormat::Pcm16;
+    if (!recorder.start(path, sampleRate, sampleFormat)) {
+        return false;
+    }
+    wakeFromIdle();
+    return true;
+}
+
+void AudioEngine::stopRecording() {
+    recorder.stop();
+}
+
+bool AudioEngine::isRecording() const {
+    return recorder.isRecording();
+}
+
+uint64_t AudioEngine::getRecordingDroppedBlocks() const {
+    return recorder.getDroppedBlocks();
+}
+
+void AudioEngine::setInsertPlacement(int type, int placement) {
+    // Solo i tipi sintetizzati: toWaveType() porterebbe SAMPLER_TYPE e i tipi sconosciuti sul Sawtooth
+    if (type < 0 || type >= NUM_WAVE_TYPES) {
+        LOGE("Invalid insert placement type: %d", type);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    insertPlacement[static_cast<int>(toWaveType(type))] =
+            placement == 1 ? InsertPlacement::Bus : InsertPlacement::PerVoice;
+    updateVoiceRouting();
+    LOGI("Insert placement: type=%d -> %s", type, placement == 1 ? "bus" : "per-voice");
+}
+
+bool AudioEngine::setInsertOrder(const int *slots, int count) {
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    if (!insertChain.setOrder(slots, count)) {
+        LOGE("Invalid insert order");
+        return false;
+    }
+    return true;
+}
+
+void AudioEngine::setInsertBypass(int slot, bool bypass) {
+    if (slot < 0 || slot >= InsertChain::NUM_SLOTS) {
+        LOGE("Invalid insert slot: %d", slot);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    insertChain.setBypass(static_cast<InsertChain::Slot>(slot), bypass);
+}
+
+// Chiamare con voiceMutex acquisito
+void AudioEngine::updateVoiceRouting() {
+    for (auto& voice : voices) {
+        int type = static_cast<int>(voice.getWaveType());
+        voice.setBusInserts(insertPlacement[type] == InsertPlacement::Bus);
+    }
+}
+
+oboe::DataCallbackResult AudioEngine::onAudioReady(
+        oboe::AudioStream *audioStream,
+        void *audioData,
+        int32_t numFrames) {
+    
+    // PCM 16 bit: si mixa in float nello scratch, lo stadio master scrive gli int16
+    int16_t *pcmOutput = pcm16Output ? static_cast<int16_t *>(audioData) : nullptr;
+    float *outputBuffer = pcmOutput ? pcmScratch.data() : static_cast<float *>(audioData);
+    if (pcmOutput && numFrames > static_cast<int32_t>(pcmScratch.size())) {
+        std::memset(pcmOutput, 0, sizeof(int16_t) * numFrames);  // Non previsto dalla capacità
+        return oboe::DataCallbackResult::Continue;
+    }
+    
+    // Riconosce il thread del callback e applica la politica di affinità
+    threadTuner.beginCallback();
+    
+    // Il tempo di presentazione serve al tracing e all'aggancio sequencer-base
+    const bool tracing = latencyTracer.isEnabled();
+    const bool timing = tracing || sequencer.isTrackLocked();
+    const int64_t callbackBeginNs = timing ? LatencyTracer::nowNanos() : 0;
+    if (timing && audioStream) {
+        updatePresentationTime(audioStream, callbackBeginNs);
+    }
+    
+    auto renderStart = std::chrono::steady_clock::now();
+    
+    // Ingresso full-duplex: tanti frame quanti ne chiede l'uscita, poi il pitch tracker
+    if (inputActive.load(std::memory_order_relaxed)) {
+        input.pull(numFrames);
+    }
+    
+    renderAudio(outputBuffer, numFrames, pcmOutput);
+    std::chrono::duration<double> renderTime = std::chrono::steady_clock::now() - renderStart;
+    
+    // Durante il log eventi il tier resta fisso, così il replay offline è identico
+    if (!eventLogger.isActive()) {
+        auto tier = qualityGovernor.update(renderTime.count(),
+                                           static_cast<double>(numFrames) / sampleRate);
+        requestedTier.store(static_cast<int>(tier), std::memory_order_relaxed);
+    }
+    
+    // Tap di registrazione dopo lo stadio master (solo copia nel ring, niente I/O)
+    recorder.push(outputBuffer, numFrames);
+    
+    // Meter e forma d'onda per la UI (framesRendered è scritto solo da questo thread)
+    if (analysisTap.isEnabled()) {
+        analysisTap.addMaster(outputBuffer, numFrames, framesRendered);
+    }
+    
+    // Durata del lavoro di tutto il callback rispetto alla scadenza del buffer
+    auto workTime = std::chrono::steady_clock::now() - renderStart;
+    threadTuner.endCallback(std::chrono::duration_cast<std::chrono::nanoseconds>(workTime).count(),
+                            static_cast<int64_t>(numFrames) * 1000000000LL / sampleRate);
+    
+    if (tracing) {
+        latencyTracer.stampCallback(callbackBeginNs, LatencyTracer::nowNanos(), numFrames);
+    }
+    if (timing) {
+        callbackPresentationNs = -1;
+    }
+    
+    // Silenzio da abbastanza tempo: ferma lo stream e lascia dormire il dispositivo
+    if (shouldSuspend() && suspendIfSilent()) {
+        return oboe::DataCallbackResult::Stop;
+    }
+    
+    return oboe::DataCallbackResult::Continue;
+}
+
+// Chiamare con voiceMutex acquisito
+bool AudioEngine::hasActiveSoundLocked() const {
+    if (drumKit.isActive() || insertChain.isTailActive() || sequencerBass.isActive() ||
+        sequencer.isPlaying() || sampler.isActive()) {
+        return true;
+    }
+    return std::any_of(voices.begin(), voices.end(),
+                       [](const Oscillator &voice) { return voice.isActive(); });
+}
+
+// Solo dal thread audio. Registrazione, log eventi e ingresso hanno bisogno del tempo che scorre.
+bool AudioEngine::shouldSuspend() const {
+    const int timeoutMs = idleTimeoutMs.load();
+    if (timeoutMs <= 0 || recorder.isRecording() || eventLogger.isActive() ||
+        sequencer.isRunning() || inputActive.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    return idleFrames >= static_cast<int64_t>(timeoutMs) * sampleRate / 1000;
+}
+
+/**
+ * Decide la sospensione sotto voiceMutex: una nota applicata prima trova
+ * il suono attivo, una applicata dopo trova streamSuspended e risveglia lo
+ * stream. Registrazione, log e sequencer non passano da voiceMutex: chi li
+ * avvia scrive il proprio flag e poi legge streamSuspended, qui si fa
+ * l'inverso, quindi almeno uno dei due vede l'altro.
+ */
+bool AudioEngine::suspendIfSilent() {
+    std::lock_guard<std::mutex> lock(voiceMutex);
+    if (hasActiveSoundLocked()) {
+        return false;
+    }
+    streamSuspended = true;
+    if (!shouldSuspend()) {
+        streamSuspended = false;
+        return false;
+    }
+    return true;
+}
+
+// Dalla UI o dal JNI: non blocca, il riavvio lo fa il thread dei task dello stream
+void AudioEngine::wakeFromIdle() {
+    if (streamSuspended.load() && isRunning.load()) {
+        requestStreamTask(false);
+    }
+}
+
+void AudioEngine::requestStreamTask(bool restart) {
+    {
+        std::lock_guard<std::mutex> lock(streamTaskMutex);
+        if (restart) {
+            restartPending = true;
+        } else {
+            wakePending = true;
+        }
+    }
+    streamTaskCondition.notify_one();
+}
+
+void AudioEngine::streamTaskLoop() {
+    std::unique_lock<std::mutex> lock(streamTaskMutex);
+    while (true) {
+        streamTaskCondition.wait(lock, [this] {
+            return wakePending || restartPending || streamTaskExit;
+        });
+        if (streamTaskExit) {
+            return;
+        }
+        const bool restart = restartPending;
+        wakePending = false;
+        restartPending = false;
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> streamLock(streamMutex);
+            if (restart && isRunning) {
+                restartStream();
+            } else {
+                resumeStreamLocked();
+            }
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * Riavvia lo stream sospeso per inattività. stop() attende che il callback
+ * abbia davvero fermato lo stream, poi si riparte con un requestStart.
+ * Chiamare con streamMutex acquisito.
+ */
+void AudioEngine::resumeStreamLocked() {
+    if (!isRunning || !stream || !streamSuspended) {
+        return;
+    }
+    
+    stream->stop();
+    idleFrames = 0;
+    streamSuspended = false;
+    if (stream->requestStart() != oboe::Result::OK) {
+        LOGE("Failed to resume idle stream, reopening");
+        restartStream();
+        return;
+    }
+    LOGI("Stream resumed from idle");
+}
+
+/**
+ * Applica un tier di qualità (cumulativo). Chiamare con voiceMutex acquisito.
+ */
+void AudioEngine::applyQualityTierLocked(QualityGovernor::Tier tier) {
+    const bool reducedHarmonics = tier >= QualityGovernor::Tier::ReducedHarmonics;
+    const int reverbCombs = tier >= QualityGovernor::Tier::ReducedReverb ? 1 : 3;
+    
+    for (auto& voice : voices) {
+        voice.setReducedHarmonics(reducedHarmonics);
+        voice.setReverbDensity(reverbCombs);
+    }
+    insertChain.getReverb().setDensity(reverbCombs);
+    
+    polyphonyCap = tier >= QualityGovernor::Tier::CappedPolyphony ? REDUCED_POLYPHONY : MAX_VOICES;
+    if (polyphonyCap < MAX_VOICES) {
+        releaseOldestHeldLocked(-1, polyphonyCap);
+    }
+    appliedTier = tier;
+}
+
+// Manda in release le note tenute più vecchie finché ne restano al massimo maxHeld
+void AudioEngine::releaseOldestHeldLocked(int keepVoice, int maxHeld) {
+    // Una voce è tenuta se almeno uno dei suoi layer non è in release
+    auto isHeld = [this](int i) {
+        for (int layer = 0; layer < MAX_LAYERS; ++layer) {
+            Oscillator &voice = voices[layer * MAX_VOICES + i];
+            if (voice.isActive() && voice.getEnvelope().getState() != ADSREnvelope::State::Release) {
+                return true;
+            }
+        }
+        return false;
+    };
+    
+    int held = 0;
+    for (int i = 0; i < MAX_VOICES; ++i) {
+        if (i != keepVoice && isHeld(i)) {
+            ++held;
+        }
+    }
+    
+    while (held > maxHeld) {
+        int oldest = -1;
+        for (int i = 0; i < MAX_VOICES; ++i) {
+            if (i != keepVoice && isHeld(i) && (oldest < 0 || noteStamps[i] < noteStamps[oldest])) {
+                oldest = i;
+            }
+        }
+        noteOffLocked(oldest);
+        --held;
+    }
+}
+
+void AudioEngine::setQualityGovernorEnabled(bool enabled) {
+    qualityGovernor.setEnabled(enabled);
+    if (!enabled) {
+        requestedTier = static_cast<int>(QualityGovernor::Tier::Full);
+    }
+    LOGI("Quality governor: %s", enabled ? "ON" : "OFF");
+}
+
+void AudioEngine::setSyntheticLoad(float load) {
+    qualityGovernor.setSyntheticLoad(load);
+}
+
+int AudioEngine::getQualityTier() const {
+    return requestedTier.load(std::memory_order_relaxed);
+}
+
+void AudioEngine::setAnalysisEnabled(bool enabled) {
+    analysisTap.setEnabled(enabled);
+    LOGI("Analysis tap: %s", enabled ? "ON" : "OFF");
+}
+
+void AudioEngine::setLatencyTracingEnabled(bool enabled) {
+    latencyTracer.setEnabled(enabled);
+    LOGI("Latency tracing: %s", enabled ? "ON" : "OFF");
+}
+
+bool AudioEngine::exportLatencyTrace(const char *path) {
+    return latencyTracer.exportJson(path);
+}
+
+void AudioEngine::setAffinityPolicy(int policy, uint64_t customMask) {
+    if (policy < 0 || policy > static_cast<int>(AudioThreadTuner::AffinityPolicy::Custom)) {
+        LOGE("Invalid affinity policy: %d", policy);
+        return;
+    }
+    threadTuner.setAffinityPolicy(static_cast<AudioThreadTuner::AffinityPolicy>(policy), customMask);
+}
+
+void AudioEngine::setPerformanceHintEnabled(bool enabled) {
+    threadTuner.setPerformanceHintEnabled(enabled);
+    LOGI("Performance hint: %s", enabled ? "ON" : "OFF");
+}
+
+bool AudioEngine::loadImpulseResponse(int slot, const char *path) {
+    if (slot != static_cast<int>(InsertChain::Slot::Cabinet) &&
+        slot != static_cast<int>(InsertChain::Slot::Reverb)) {
+        LOGE("Impulse responses are only supported on the cabinet and reverb slots: %d", slot);
+        return false;
+    }
+    
+    if (path == nullptr) {
+        impulseSources[slot].clear();
+        std::unique_ptr<ConvolutionEngine> previous;
+        {
+            std::lock_guard<std::mutex> lock(voiceMutex);
+            previous = insertChain.setImpulse(static_cast<InsertChain::Slot>(slot), nullptr);
+        }
+        LOGI("Impulse response cleared for slot %d", slot);
+        return true;
+    }
+    
+    std::vector<float> samples;
+    int rate = 0;
+    if (!WavReader::readMono(path, samples, rate)) {
+        return false;
+    }
+    impulseSources[slot] = std::move(samples);
+    impulseSourceRates[slot] = rate;
+    return installImpulseResponse(slot);
+}
+
+/**
+ * Ricampiona l'IR sorgente al rate corrente e la installa nella catena.
+ * La costruzione (FFT delle partizioni, thread della coda) avviene fuori dal
+ * lock; il vecchio motore viene distrutto dopo averlo rilasciato.
+ */
+bool AudioEngine::installImpulseResponse(int slot) {
+    // La cassa resta tutta nel callback; la stanza può avere una coda lunga sul worker
+    const bool cabinetSlot = slot == static_cast<int>(InsertChain::Slot::Cabinet);
+    const int maxLength = cabinetSlot ? ConvolutionEngine::HEAD_LENGTH
+                                      : static_cast<int>(MAX_ROOM_IR_SECONDS * sampleRate);
+    
+    std::vector<float> ir = ConvolutionEngine::prepareImpulse(
+            impulseSources[slot], static_cast<float>(impulseSourceRates[slot]),
+            static_cast<float>(sampleRate), maxLength);
+    auto engine = std::make_unique<ConvolutionEngine>();
+    if (ir.empty() || !engine->init(ir, &threadTuner)) {
+        LOGE("Invalid impulse response for slot %d", slot);
+        return false;
+    }
+    
+    std::unique_ptr<ConvolutionEngine> previous;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        previous = insertChain.setImpulse(static_cast<InsertChain::Slot>(slot), std::move(engine));
+    }
+    LOGI("Impulse response for slot %d: %zu taps at %d Hz (source %d Hz)",
+         slot, ir.size(), sampleRate, impulseSourceRates[slot]);
+    return true;
+}
+
+size_t AudioEngine::getDspMemoryBytes() {
+    // Il thread delle tabelle scrive arena e cache sotto lo stesso lock
+    std::lock_guard<std::mutex> cacheLock(drumCacheMutex);
+    size_t samplerBytes;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        samplerBytes = sampler.getResidentBytes();
+    }
+    return sizeof(AudioEngine) + arena.getCapacityBytes() + drumKit.getCacheBytes() + samplerBytes;
+}
+
+/**
+ * Cambia il formato delle delay line e ritaglia di nuovo l'arena. Le code
+ * del riverbero ripartono da zero; a stream avviato il callback userebbe
+ * i buffer mentre vengono spostati, quindi viene rifiutato.
+ */
+bool AudioEngine::setDelayStorage(int format) {
+    if (format < 0 || format > static_cast<int>(dsp::DelayFormat::Fixed16)) {
+        LOGE("Invalid delay storage format %d", format);
+        return false;
+    }
+    // Lo stream non può partire a metà; l'arena si sposta sotto il lock della cache,
+    // come nel thread delle tabelle, così getDspMemoryBytes non la legge a metà
+    std::lock_guard<std::mutex> streamLock(streamMutex);
+    if (isRunning) {
+        LOGE("Delay storage can only change while the stream is stopped");
+        return false;
+    }
+    waitForTables();
+    std::lock_guard<std::mutex> cacheLock(drumCacheMutex);
+    const auto previous = delayFormat;
+    delayFormat = static_cast<dsp::DelayFormat>(format);
+    if (!allocateDspState(arenaRate)) {
+        delayFormat = previous;
+        allocateDspState(arenaRate);
+        return false;
+    }
+    LOGI("Delay storage: %d (%zu bytes per sample)", format, dsp::delaySampleBytes(delayFormat));
+    return true;
+}
+
+void AudioEngine::setIdleTimeout(int milliseconds) {
+    idleTimeoutMs = std::max(0, milliseconds);
+    LOGI("Idle timeout: %d ms", idleTimeoutMs.load());
+}
+
+/**
+ * Corpo del callback: mix delle voci e stadio master.
+ * Usato anche dal replay offline, così l'uscita è identica.
+ * pcm non nullo: lo stadio master scrive anche l'uscita a 16 bit (con dither)
+ */
+void AudioEngine::renderAudio(float *outputBuffer, int numFrames, int16_t *pcm) {
+    // Azzera il buffer
+    std::memset(outputBuffer, 0, sizeof(float) * numFrames);
+    
+    // Mix di tutte le voci attive, a blocchi della dimensione del bus insert
+    float volume;
+    bool idle;
+    {
+        std::lock_guard<std::mutex> lock(voiceMutex);
+        volume = masterVolume;
+        
+        auto tier = static_cast<QualityGovernor::Tier>(requestedTier.load(std::memory_order_relaxed));
+        if (tier != appliedTier) {
+            applyQualityTierLocked(tier);
+        }
+        
+        // Offline la coda delle IR lunghe non può dipendere dal worker
+        if (renderingOffline != synchronousTail) {
+            synchronousTail = renderingOffline;
+            insertChain.setSynchronousTail(synchronousTail);
+            sampler.setSynchronous(synchronousTail);
+        }
+        
+        // Transport, pattern nuovo e aggancio alla base del sequencer (mai nel replay)
+        if (!renderingOffline) {
+            sequencer.beginCallback(callbackPresentationNs >= 0 ? callbackPresentationNs
+                                                                : LatencyTracer::nowNanos());
+        }
+        
+        idle = !hasActiveSoundLocked();
+        
+        // Tracing: le note arrivate dall'ultimo callback vengono prese in carico ora
+        if (latencyTracer.isEnabled()) {
+            const int64_t now = LatencyTracer::nowNanos();
+            for (int i = 0; i < MAX_VOICES; ++i) {
+                if (voiceTraceIds[i] != 0 && !voiceTraceDequeued[i]) {
+                    latencyTracer.stamp(LatencyTracer::Stage::Dequeue, voiceTraceIds[i], i, now);
+                    voiceTraceDequeued[i] = true;
+                }
+            }
+            if (drumTraceId != 0 && !drumTraceDequeued) {
+                latencyTracer.stamp(LatencyTracer::Stage::Dequeue, drumTraceId, -1, now);
+                drumTraceDequeued = true;
+            }
+        }
+        
+        if (!idle) {
+            // I blocchi si spezzano al frame esatto degli eventi del sequencer
+            const bool sequencing = !renderingOffline;
+            StepSequencer::Event events[StepSequencer::MAX_EVENTS];
+            int offset = 0;
+            while (offset < numFrames) {
+                int frames = std::min(RENDER_BLOCK_FRAMES, numFrames - offset);
+                if (sequencing) {
+                    const int count = sequencer.poll(events, frames);
+                    for (int e = 0; e < count; ++e) {
+                        applySequencerEvent(events[e]);
+                    }
+                }
+                renderBlock(outputBuffer + offset, frames, offset);
+                if (sequencing) {
+                    sequencer.advance(frames);
+                }
+                offset += frames;
+            }
+        }
+        
+        // Gli eventi ricevuti da qui in poi vengono applicati al prossimo callback
+        framesRendered += static_cast<uint64_t>(numFrames);
+        lastCallbackFrames = numFrames;
+    }
+    
+    // Niente voci né code di effetti: il memset basta, salta lo stadio master
+    if (idle) {
+        idleFrames += numFrames;
+        if (pcm) {
+            std::memset(pcm, 0, sizeof(int16_t) * numFrames);
+        }
+        return;
+    }
+    idleFrames = 0;
+    
+    // Applica master volume con attenuazione base (synth troppo forte rispetto alle basi)
+    const float synthAttenuation = 0.25f;  // Riduce il volume massimo del synth
+    if (pcm) {
+        // Volume, clip e conversione in un solo passaggio SIMD
+        pcmConverter.process(outputBuffer, pcm, numFrames, volume * synthAttenuation);
+        return;
+    }
+    for (int i = 0; i < numFrames; ++i) {
+        outputBuffer[i] *= volume * synthAttenuation;
+        // Soft clipping per evitare distorsione
+        outputBuffer[i] = std::clamp(outputBuffer[i], -1.0f, 1.0f);
+    }
+}
+
+/**
+ * Mixa un blocco (<= RENDER_BLOCK_FRAMES) di voci, batteria e bus insert.
+ * callbackOffset è la posizione del blocco nel buffer del callback.
+ * Chiamare con voiceMutex acquisito.
+ */
+void AudioEngine::renderBlock(float *output, int numFrames, int callbackOffset) {
+    float *bus = busBuffer.data();
+    float *guitarBus = guitarBusBuffer.data();  // Solo le chitarre passano dall'amp
+    const Oscillator::AmpSends guitarSends{guitarGainBuffer.data(), guitarCleanBuffer.data()};
+    bool busHasInput = false;
+    bool busCleared = false;
+    auto clearBus = [&]() {
+        std::fill(bus, bus + numFrames, 0.0f);
+        std::fill(guitarBus, guitarBus + numFrames, 0.0f);
+        std::fill(guitarSends.gain, guitarSends.gain + numFrames, 0.0f);
+        std::fill(guitarSends.clean, guitarSends.clean + numFrames, 0.0f);
+        busCleared = true;
+    };
+    
+    auto routeToBus = [&](Oscillator::WaveType type) {
+        if (insertPlacement[static_cast<int>(type)] != InsertPlacement::Bus) {
+            return false;
+        }
+        if (!busCleared) {
+            clearBus();
+        }
+        busHasInput = true;
+        return true;
+    };
+    
+    // Voci attive raggruppate per strumento: ogni gruppo gira con il suo kernel
+    // specializzato (niente switch per campione) e una sola decisione di routing
+    std::array<std::array<uint8_t, NUM_OSCILLATORS>, NUM_WAVE_TYPES> groups;
+    std::array<int, NUM_WAVE_TYPES> groupSizes{};
+    for (int i = 0; i < NUM_OSCILLATORS; ++i) {
+        if (voices[i].isActive()) {
+            const int type = static_cast<int>(voices[i].getWaveType());
+            groups[type][groupSizes[type]++] = static_cast<uint8_t>(i);
+        }
+    }
+    
+    const bool metering = analysisTap.isEnabled();
+    for (int type = 0; type < NUM_WAVE_TYPES; ++type) {
+        const int count = groupSizes[type];
+        if (count == 0) {
+            continue;
+        }
+        const auto waveType = static_cast<Oscillator::WaveType>(type);
+        float *target = output;
+        const Oscillator::AmpSends *sends = nullptr;  // Per l'amp del bus, vedi InsertChain
+        if (routeToBus(waveType)) {
+            const bool guitar = waveType == Oscillator::WaveType::Guitar;
+            target = guitar ? guitarBus : bus;
+            sends = guitar ? &guitarSends : nullptr;
+        }
+        const uint8_t *indices = groups[type].data();
+        switch (waveType) {
+            case Oscillator::WaveType::Sine:
+                mixVoiceGroup<Oscillator::WaveType::Sine>(indices, count, target, sends, numFrames, callbackOffset, metering);
+                break;
+            case Oscillator::WaveType::Sawtooth:
+                mixVoiceGroup<Oscillator::WaveType::Sawtooth>(indices, count, target, sends, numFrames, callbackOffset, metering);
+                break;
+            case Oscillator::WaveType::Drums:
+                mixVoiceGroup<Oscillator::WaveType::Drums>(indices, count, target, sends, numFrames, callbackOffset, metering);
+                break;
+            case Oscillator::WaveType::Bass:
+                mixVoiceGroup<Oscillator::WaveType::Bass>(indices, count, target, sends, numFrames, callbackOffset, metering);
+                break;
+            case Oscillator::WaveType::Guitar:
+                mixVoiceGroup<Oscillator::WaveType::Guitar>(indices, count, target, sends, numFrames, callbackOffset, metering);
+                break;
+        }
+    }
+    
+    // Voci campionate, direttamente sull'uscita (niente catena insert). Una nota
+    // tracciata passa da un buffer suo, come gli oscillatori, per il primo campione
+    if (sampler.isActive()) {
+        uint32_t traced = 0;
+        for (int i = 0; i < MAX_VOICES; ++i) {
+            traced |= voiceTraceIds[i] != 0 ? 1u << i : 0u;
+        }
+        sampler.mixInto(output, numFrames, Sampler::ALL_VOICES & ~traced);
+        for (int i = 0; traced != 0 && i < MAX_VOICES; ++i) {
+            if ((traced & (1u << i)) == 0) {
+                continue;
+            }
+            float *single = voiceBuffer.data();
+            std::fill(single, single + numFrames, 0.0f);
+            sampler.mixInto(single, numFrames, 1u << i);
+            stampFirstSample(voiceTraceIds[i], single, numFrames, callbackOffset, i);
+            for (int j = 0; j < numFrames; ++j) {
+                output[j] += single[j];
+            }
+        }
+    }
+    
+    // Voce di basso del sequencer
+    if (sequencerBass.isActive()) {
+        float *target = routeToBus(Oscillator::WaveType::Bass) ? bus : output;
+        sequencerBass.mixIntoAs<Oscillator::WaveType::Bass>(target, numFrames);
+    }
+    
+    // One-shot di batteria dal pool dedicato
+    if (drumKit.isActive()) {
+        float *target = routeToBus(Oscillator::WaveType::Drums) ? bus : output;
+        if (drumTraceId == 0) {
+            drumKit.mixInto(target, numFrames);
+        } else {
+            float *drums = voiceBuffer.data();
+            std::fill(drums, drums + numFrames, 0.0f);
+            drumKit.mixInto(drums, numFrames);
+            stampFirstSample(drumTraceId, drums, numFrames, callbackOffset, -1);
+            for (int i = 0; i < numFrames; ++i) {
+                target[i] += drums[i];
+            }
+        }
+    }
+    
+    // Una sola catena effetti per tutte le voci sul bus (anche per le code del riverbero)
+    if (!busCleared && insertChain.isTailActive()) {
+        clearBus();
+    }
+    if (busCleared && insertChain.process(bus, guitarBus, guitarSends.gain, guitarSends.clean,
+                                          numFrames, busHasInput)) {
+        for (int i = 0; i < numFrames; ++i) {
+            output[i] += bus[i];
+        }
+    }
+}
+
+/**
+ * Mixa un gruppo di oscillatori dello stesso strumento in target.
+ * Chiamare con voiceMutex acquisito.
+ */
+template <Oscillator::WaveType Type>
+void AudioEngine::mixVoiceGroup(const uint8_t *indices, int count, float *target,
+                                const Oscillator::AmpSends *sends, int numFrames, int callbackOffset,
+                                bool metering) {
+    for (int n = 0; n < count; ++n) {
+        Oscillator &voice = voices[indices[n]];
+        const int voiceIndex = indices[n] % MAX_VOICES;  // Il dito, per meter e tracing
+        const bool traced = voiceTraceIds[voiceIndex] != 0;
+        if (!metering && !traced) {
+            voice.mixIntoAs<Type>(target, numFrames, sends);
+            continue;
+        }
+        
+        // Con il tap attivo (o una nota tracciata) la voce passa da un buffer suo
+        float *single = voiceBuffer.data();
+        std::fill(single, single + numFrames, 0.0f);
+        voice.mixIntoAs<Type>(single, numFrames, sends);
+        if (metering) {
+            analysisTap.addVoice(voiceIndex, single, numFrames);
+        }
+        if (traced) {
+            stampFirstSample(voiceTraceIds[voiceIndex], single, numFrames, callbackOffset, voiceIndex);
+        }
+        for (int j = 0; j < numFrames; ++j) {
+            target[j] += single[j];
+        }
+    }
+}
+
+/**
+ * Cerca il primo campione non nullo di una nota tracciata e ne registra il
+ * tempo di scrittura e di presentazione. Chiamare con voiceMutex acquisito.
+ */
+void AudioEngine::stampFirstSample(uint32_t &traceId, const float *samples, int numFrames,
+                                   int callbackOffset, int voice) {
+    for (int i = 0; i < numFrames; ++i) {
+        if (samples[i] == 0.0f) {
+            continue;
+        }
+        int64_t presentationNs = -1;
+        if (callbackPresentationNs >= 0) {
+            presentationNs = callbackPresentationNs +
+                    static_cast<int64_t>(callbackOffset + i) * 1000000000LL / sampleRate;
+        }
+        latencyTracer.stamp(LatencyTracer::Stage::FirstSample, traceId, voice,
+                            LatencyTracer::nowNanos(), presentationNs);
+        traceId = 0;
+        return;
+    }
+}
+
+/**
+ * Tempo di presentazione del primo frame di questo callback. getTimestamp
+ * viene interrogato solo ogni TIMESTAMP_REFRESH_NS; in mezzo si estrapola
+ * dal numero di frame scritti, che avanza esattamente come il DAC.
+ */
+void AudioEngine::updatePresentationTime(oboe::AudioStream *audioStream, int64_t nowNs) {
+    if (nowNs - timestampRefreshNs >= TIMESTAMP_REFRESH_NS) {
+        timestampRefreshNs = nowNs;
+        auto result = audioStream->getTimestamp(CLOCK_MONOTONIC);
+        if (result) {
+            timestampFrame = result.value().position;
+            timestampNs = result.value().timestamp;
+        }
+    }
+    if (timestampNs < 0) {
+        callbackPresentationNs = -1;
+        return;
+    }
+    const int64_t framesAhead = audioStream->getFramesWritten() - timestampFrame;
+    callbackPresentationNs = timestampNs + framesAhead * 1000000000LL / sampleRate;
+}
+
+void AudioEngine::onErrorBeforeClose(oboe::AudioStream *audioStream, oboe::Result error) {
+    LOGE("Error before close: %s", oboe::convertToText(error));
+}
+
+void AudioEngine::onErrorAfterClose(oboe::AudioStream *audioStream, oboe::Result error) {
+    LOGE("Error after close: %s", oboe::convertToText(error));
+    
+    // Prova a riavviare lo stream, dal thread dei task e non da quello di Oboe
+    if (isRunning) {
+        requestStreamTask(true);
+    }
+}
+
+bool AudioEngine::setOutputFormat(int format) {
+    if (format < OUTPUT_FORMAT_AUTO || format > OUTPUT_FORMAT_PCM16) {
+        LOGE("Invalid output format: %d", format);
+        return false;
+    }
+    if (requestedOutputFormat.exchange(format) == format) {
+        return true;
+    }
+    LOGI("Output format: %d", format);
+    
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (isRunning && stream) {
+        restartStream();
+    }
+    return true;
+}
+
+int AudioEngine::getOutputFormat() const {
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (!isRunning || !stream) {
+        return 0;
+    }
+    return pcm16Output ? OUTPUT_FORMAT_PCM16 : OUTPUT_FORMAT_FLOAT;
+}
+
+/**
+ * Latenza di uscita stimata da Oboe (frame scritti contro l'ultimo timestamp
+ * dell'hardware): include il buffer e la pipeline del mixer, quindi mostra
+ * anche il guadagno del percorso MMAP. Serve lo stream in riproduzione.
+ */
+double AudioEngine::getOutputLatencyMs() {
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (!isRunning || !stream || streamSuspended) {
+        return -1.0;
+    }
+    auto latency = stream->calculateLatencyMillis();
+    return latency ? latency.value() : -1.0;
+}
+
+/**
+ * Lo stream di ingresso vive insieme a quello di uscita: a stream avviato si
+ * riaprono entrambi, così il callback non legge mai uno stream che si sta
+ * chiudendo. A stream fermo con un file come sorgente il callback del backend
+ * nullo (test su desktop) lo legge subito.
+ */
+bool AudioEngine::setInputEnabled(bool enabled) {
+    inputRequested = enabled;
+    LOGI("Input %s", enabled ? "enabled" : "disabled");
+    
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (isRunning && stream) {
+        restartStream();
+        return inputActive.load() == enabled;
+    }
+    
+    inputActive = enabled && input.hasFile();
+    if (inputActive) {
+        input.prepare(sampleRate);
+    }
+    return true;
+}
+
+bool AudioEngine::setInputFile(const char *path) {
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (isRunning) {
+        LOGE("Input file can only change while the stream is stopped");
+        return false;
+    }
+    if (!input.setFile(path)) {
+        return false;
+    }
+    inputActive = inputRequested.load() && input.hasFile();
+    if (inputActive) {
+        input.prepare(sampleRate);
+    }
+    return true;
 }
 
+// Chiamare con streamMutex acquisito
 void AudioEngine::restartStream() {
     LOGI("Restarting audio stream...");
     
@@ -238,6 +1870,7 @@ void AudioEngine::restartStream() {
         stream->close();
         stream.reset();
     }
+    input.closeStream();
     
     if (openStream()) {
         LOGI("Stream restarted successfully");
@@ -2,23 +2,66 @@
 #define AUDIO_ENGINE_H
 
 #include <oboe/Oboe.h>
+#include "AnalysisTap.h"
+#include "AudioThreadTuner.h"
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include "Oscillator.h"
+#include "DrumKit.h"
+#include "DspArena.h"
+#include "DuplexInput.h"
+#include "InsertChain.h"
+#include "LatencyTracer.h"
+#include "PcmConverter.h"
+#include "QualityGovernor.h"
+#include "Sampler.h"
+#include "ScaleQuantizer.h"
+#include "StepSequencer.h"
+#include "PerformanceRecorder.h"
+#include "EventLog.h"
+#include "EventReplayer.h"
 
 /**
  * AudioEngine - Engine audio a bassa latenza usando Oboe
  * 
  * Gestisce multiple voci per supporto multitouch (polifonia).
- * Ogni voce è un oscillatore indipendente con il proprio envelope ADSR.
+ * Ogni voce (dito) suona fino a MAX_LAYERS oscillatori indipendenti, ognuno
+ * con il proprio strumento ed envelope ADSR: le zone strumento decidono
+ * quali, per layer sovrapposti o split della tastiera per frequenza.
+ * Le batterie usano un pool separato di one-shot pre-renderizzati (DrumKit).
+ * Gli effetti (wah, ampli, cassa, riverbero) possono girare per voce oppure
+ * una sola volta sul bus insert (InsertChain), scelto per strumento.
  */
 class AudioEngine : public oboe::AudioStreamCallback {
 public:
     static constexpr int MAX_VOICES = 8; // Supporta fino a 8 note simultanee
+    static constexpr int NUM_WAVE_TYPES = 5;
+    static constexpr int MAX_LAYERS = 2;  // Oscillatori per voce (strumenti sovrapposti)
+    static constexpr int NUM_OSCILLATORS = MAX_VOICES * MAX_LAYERS;
+    static constexpr int MAX_ZONES = 4;
+    static constexpr int SAMPLER_TYPE = 5;  // Tipo JNI della zona campionata (vedi loadSampler)
+    
+    // Dove girano gli effetti insert di uno strumento
+    enum class InsertPlacement {
+        PerVoice,  // Ogni voce ha la sua catena (comportamento classico della chitarra)
+        Bus        // Una sola catena sul mix delle voci instradate
+    };
 
-    AudioEngine();
+    // cacheDirectory: dove salvare le tabelle DSP (vuoto = nessuna cache su disco)
+    explicit AudioEngine(const std::string &cacheDirectory = "");
     ~AudioEngine();
     
+    // Avvio in due fasi: il costruttore ritorna subito e arena e one-shot di
+    // batteria vengono costruiti in background. Fino ad allora le note suonano
+    // senza riverbero e le batterie sono mute.
+    bool areTablesReady() const { return tablesReady.load(std::memory_order_acquire); }
+    
     // Controllo engine
     bool start();
     void stop();
@@ -29,9 +72,52 @@ public:
     void allNotesOff();
     void setPitchBend(int voiceIndex, float semitones);  // Pitch bend per una voce
     
+    // Scala nativa: tabella di frequenze per tonalità/scala, note per grado e
+    // bend a velocità audio (glide esponenziale, opzionalmente agganciato
+    // alla nota della scala più vicina, come i bend "a bersaglio" del blues)
+    bool setScale(int root, const int *intervals, int count, int baseOctave);
+    void noteOnDegree(int voiceIndex, int degree);
+    void setBendMode(bool snapToScale, float glideMs);
+    void bendBy(int voiceIndex, float deltaSemitones);  // Delta del gesto
+    void bendTo(int voiceIndex, float semitones);       // Bend assoluto (vibrato)
+    void setBendTarget(int voiceIndex, float semitones, float glideMs);
+    void triggerDrum(float frequency, float velocity);    // One-shot dal DrumKit
+    
+    // Step sequencer nativo (batteria e basso): gli step partono al frame
+    // esatto dentro il callback, il pattern si sostituisce senza lock
+    bool setSequencerPattern(const StepSequencer::Pattern &pattern);
+    void setSequencerTempo(float bpm);
+    void startSequencer();
+    void stopSequencer();
+    bool isSequencerRunning() const { return sequencer.isRunning(); }
+    // Aggancio alla base: offsetMs = posizione della base sul primo step
+    void setSequencerTrackLock(bool enabled, float offsetMs);
+    void syncSequencerToTrack(double trackPositionMs, int64_t sampleTimeNs);
+    
     // Configurazione
     void setMasterVolume(float volume);
-    void setWaveType(int type); // 0=Sine, 1=Sawtooth, 2=Square, 3=Triangle
+    void setWaveType(int type); // 0=Sine, 1=Sawtooth, 2=Square, 3=Triangle (una zona su tutta la tastiera)
+    
+    // Zone strumento: ogni nota suona gli strumenti delle zone che contengono
+    // la sua frequenza [lowHz, highHz). Zone sovrapposte = layer, disgiunte = split.
+    // Al massimo MAX_LAYERS zone melodiche per nota; una zona batteria suona il DrumKit.
+    bool setInstrumentZones(const int *types, const float *lowHz, const float *highHz,
+                            const float *levels, int count);
+    void setEnvelopeCurve(bool exponential);  // Curve ADSR lineari o esponenziali
+    
+    // Unison del synth lead: voices seghe (1-8) desintonizzate fino a
+    // ±detuneCents, mix = livello delle voci laterali rispetto alla centrale
+    void setUnison(int voices, float detuneCents, float mix);
+    
+    void setDrumVelocityLayers(int layers);  // 1-4 layer per classe di batteria
+    // Batteria intonata sul colpo: il one-shot del pad più vicino viene ricampionato
+    // (cambiano anche decadimento e colore del rumore). Disattivato = pad come renderizzato
+    void setDrumPitchTracking(bool enabled);
+    
+    // Strumento campionato (zone di tipo SAMPLER_TYPE): WAV mappati in memoria,
+    // solo l'attacco resta in RAM, il resto arriva in streaming. count 0 = scarica
+    bool loadSampler(const Sampler::ZoneSpec *zones, int count);
+    uint64_t getSamplerUnderruns() const { return sampler.getUnderruns(); }
     
     // Guitar parameters
     void setGuitarParams(float sustain, float gain, float distortion, float reverb);
@@ -40,6 +126,88 @@ public:
     void setWahEnabled(bool enabled);
     void setWahPosition(float position);  // 0.0 = heel, 1.0 = toe
     
+    // Catena insert sul bus
+    void setInsertPlacement(int waveType, int placement);  // 0=PerVoice, 1=Bus
+    bool setInsertOrder(const int *slots, int count);     // Permutazione di InsertChain::Slot
+    void setInsertBypass(int slot, bool bypass);
+    
+    // Risposte all'impulso (WAV) per gli slot Cabinet e Reverb del bus insert;
+    // vengono ricampionate al rate dello stream. path nullo = effetto interno
+    bool loadImpulseResponse(int slot, const char *path);
+    
+    // Risparmio energetico: dopo il timeout di silenzio lo stream si ferma
+    // e riparte al prossimo noteOn (0 = sempre attivo)
+    void setIdleTimeout(int milliseconds);
+    bool isStreamSuspended() const { return streamSuspended.load(); }
+    
+    // Qualità adattiva al carico CPU (vedi QualityGovernor)
+    void setQualityGovernorEnabled(bool enabled);
+    void setSyntheticLoad(float load);  // Modalità test deterministica, < 0 = carico misurato
+    int getQualityTier() const;
+    
+    // Meter e oscilloscopio per la UI (blocco condiviso letto senza lock)
+    void setAnalysisEnabled(bool enabled);
+    void *getAnalysisBuffer() { return analysisTap.getSharedBuffer(); }
+    static constexpr size_t getAnalysisBufferSize() { return AnalysisTap::getSharedBufferSize(); }
+    
+    // Thread audio: core su cui gira e hint di performance (vedi AudioThreadTuner)
+    void setAffinityPolicy(int policy, uint64_t customMask);  // 0=nessuna, 1=core veloci, 2=maschera
+    void setPerformanceHintEnabled(bool enabled);
+    int getAudioThreadCpu() const { return threadTuner.getCurrentCpu(); }
+    bool isPerformanceHintActive() const { return threadTuner.isHintSessionActive(); }
+    
+    // Tracing della latenza tocco-suono (timeline JSON per Perfetto / chrome://tracing)
+    void setLatencyTracingEnabled(bool enabled);
+    bool exportLatencyTrace(const char *path);
+    
+    // Formato dello stream: 0=quello preferito dal dispositivo, 1=float, 2=PCM 16 bit.
+    // Il mix resta in float; con PCM 16 bit la conversione (con dither) è fusa
+    // nello stadio master. Se lo stream è aperto viene riaperto.
+    static constexpr int OUTPUT_FORMAT_AUTO = 0;
+    static constexpr int OUTPUT_FORMAT_FLOAT = 1;
+    static constexpr int OUTPUT_FORMAT_PCM16 = 2;
+    bool setOutputFormat(int format);
+    int getOutputFormat() const;   // Formato effettivo (1 o 2), 0 = stream chiuso
+    double getOutputLatencyMs();   // Stima di Oboe dal timestamp, < 0 = non disponibile
+    
+    // Ingresso full-duplex (chitarra o voce) letto dentro il callback di uscita,
+    // con un pitch tracker in streaming: accordatore, tonalità di quello che si
+    // suona, armonizzazione. A stream avviato lo stream viene riaperto; per il
+    // microfono serve il permesso RECORD_AUDIO
+    bool setInputEnabled(bool enabled);
+    bool isInputActive() const { return inputActive.load(); }
+    // File WAV al posto del dispositivo, letto dallo stesso percorso del callback
+    // (test su desktop senza ingresso audio). nullptr = dispositivo. Solo a stream fermo
+    bool setInputFile(const char *path);
+    PitchTracker::Estimate getInputPitch() const { return input.getPitch(); }
+    uint64_t getInputUnderruns() const { return input.getUnderruns(); }
+    
+    // Memoria DSP totale: arena, stato dell'engine e cache della batteria
+    size_t getDspMemoryBytes();
+    
+    // Formato dei campioni nelle delay line del riverbero (vedi DelayStorage):
+    // 0=float, 1=half (fp16), 2=fisso 16 bit. Solo a stream fermo
+    bool setDelayStorage(int format);
+    
+    // Registrazione della performance (uscita master su file WAV)
+    bool startRecording(const char *path, int format);  // 0=PCM 16 bit, 1=float
+    void stopRecording();
+    bool isRecording() const;
+    uint64_t getRecordingDroppedBlocks() const;
+    
+    // Log degli eventi di controllo e replay deterministico
+    bool startEventLog(const char *path);
+    void stopEventLog();
+    bool renderEventLog(const char *logPath, const char *wavPath);  // Offline, stream fermo
+    bool startEventReplay(const char *logPath);                     // Tempo reale
+    void stopEventReplay();
+    void setRandomSeed(uint32_t seed);
+    
+    // Usati da EventReplayer
+    void applyEvent(const PerformanceEvent &event);
+    bool prepareForReplay(int sampleRate, uint32_t seed);
+    void renderOffline(float *output, int numFrames);
+    
     // Callback Oboe
     oboe::DataCallbackResult onAudioReady(
         oboe::AudioStream *audioStream,
@@ -51,17 +219,207 @@ public:
 
 private:
     bool openStream();
+    void openInput();
     void restartStream();
+    void configureForSampleRate();
+    bool allocateDspState(float maxRate);
+    void scheduleTableBuild(int rate);
+    void buildTables(int rate);
+    void waitForTables();
+    void saveTablesLocked();
+    void renderAudio(float *output, int numFrames, int16_t *pcm = nullptr);
+    void renderBlock(float *output, int numFrames, int callbackOffset);
+    void applySequencerEvent(const StepSequencer::Event &event);
+    void resetVoicesLocked();
+    void applyZoneLocked(int index, int type, float lowHz, float highHz, float level);
+    void noteOffLocked(int voiceIndex);
+    template <Oscillator::WaveType Type>
+    void mixVoiceGroup(const uint8_t *indices, int count, float *target,
+                       const Oscillator::AmpSends *sends, int numFrames, int callbackOffset,
+                       bool metering);
+    bool installImpulseResponse(int slot);
+    // Frame e ordine con cui un evento è stato applicato, presi sotto voiceMutex
+    struct EventStamp {
+        uint64_t frame;
+        uint32_t sequence;
+    };
+    EventStamp stampEventLocked() { return {framesRendered, ++eventSequence}; }
+    void logEvent(EventStamp stamp, EventType type, int voice = -1, float value0 = 0.0f,
+                  float value1 = 0.0f, float value2 = 0.0f, float value3 = 0.0f);
+    EventStamp bendToLocked(int voiceIndex, float semitones, float &target, float &glideMs);
+    EventStamp setBendTargetLocked(int voiceIndex, float semitones, float glideMs);
+    void updateVoiceRouting();
+    bool hasActiveSoundLocked() const;
+    void applyQualityTierLocked(QualityGovernor::Tier tier);
+    void releaseOldestHeldLocked(int keepVoice, int maxHeld);
+    bool shouldSuspend() const;
+    bool suspendIfSilent();
+    void wakeFromIdle();
+    void requestStreamTask(bool restart);
+    void streamTaskLoop();
+    void resumeStreamLocked();
+    void updatePresentationTime(oboe::AudioStream *audioStream, int64_t nowNs);
+    void stampFirstSample(uint32_t &traceId, const float *samples, int numFrames,
+                          int callbackOffset, int voice);
+    
+    static constexpr int RENDER_BLOCK_FRAMES = 256;
+    static constexpr float ARENA_SAMPLE_RATE = 96000.0f;  // Rate massimo previsto per l'arena
+    static constexpr int DEFAULT_IDLE_TIMEOUT_MS = 10000;
+    static constexpr int REDUCED_POLYPHONY = 4;  // Note tenute nel tier CappedPolyphony
+    static constexpr float MAX_ROOM_IR_SECONDS = 10.0f;
+    static constexpr int64_t TIMESTAMP_REFRESH_NS = 100000000;  // getTimestamp al massimo ogni 100 ms
     
     std::shared_ptr<oboe::AudioStream> stream;
-    std::array<Oscillator, MAX_VOICES> voices;
+    
+    // Uscita PCM 16 bit: il callback renderizza nello scratch (dimensionato alla
+    // capacità del buffer all'apertura) e PcmConverter scrive gli int16
+    static constexpr int MIN_PCM_SCRATCH_FRAMES = 4096;
+    std::atomic<int> requestedOutputFormat{OUTPUT_FORMAT_AUTO};
+    bool pcm16Output = false;
+    std::vector<float> pcmScratch;
+    PcmConverter pcmConverter;
+    
+    // Ingresso full-duplex: aperto e chiuso insieme allo stream di uscita e letto
+    // solo dal callback; inputActive cambia soltanto a callback fermo
+    DuplexInput input;
+    std::atomic<bool> inputRequested{false};
+    std::atomic<bool> inputActive{false};
+    
+    // Tutte le delay line (riverbero per voce e del bus) in un unico blocco
+    // allineato, dimensionato una volta per ARENA_SAMPLE_RATE e MAX_VOICES
+    DspArena arena;
+    float arenaRate = 0.0f;
+    dsp::DelayFormat delayFormat = dsp::DelayFormat::Float32;
+    // Oscillatori contigui, allineati alla cache line: il layer l della voce v
+    // è voices[l * MAX_VOICES + v] (il layer 0 coincide con le voci classiche)
+    std::array<Oscillator, NUM_OSCILLATORS> voices;
+    DrumKit drumKit;
+    Sampler sampler;  // Una voce per dito, come layer in più accanto agli oscillatori
     std::mutex voiceMutex;
+    std::mutex drumCacheMutex;  // Serializza i rebuild della cache (mai nel callback)
+    
+    // Tabelle costruite dal thread in background e pubblicate sotto voiceMutex.
+    // tableRate/tableSeed: ultima richiesta (sotto tableThreadMutex, perché
+    // anche il restart dello stream può riconfigurare il rate)
+    std::string cacheDirectory;
+    std::mutex tableThreadMutex;
+    std::thread tableThread;
+    std::atomic<bool> tablesReady{false};
+    int tableRate = 0;
+    uint32_t tableSeed = 0;
+    
+    // Zone strumento (sotto voiceMutex)
+    struct InstrumentZone {
+        int type = 1;  // Tipo JNI
+        float lowHz = 0.0f;
+        float highHz = std::numeric_limits<float>::infinity();
+        float level = 1.0f;
+    };
+    std::array<InstrumentZone, MAX_ZONES> zones{};
+    int zoneCount = 1;
+    bool melodicZones = true;  // Almeno una zona non batteria
+    
+    static constexpr float DEFAULT_AMPLITUDE = 0.8f;
+    
+    // Prima della catena insert: i worker della convoluzione lo usano finché non vengono distrutti
+    AudioThreadTuner threadTuner;
+    
+    // Bus insert
+    InsertChain insertChain;
+    std::array<InsertPlacement, NUM_WAVE_TYPES> insertPlacement{};
+    std::array<float, RENDER_BLOCK_FRAMES> busBuffer{};
+    std::array<float, RENDER_BLOCK_FRAMES> guitarBusBuffer{};  // Chitarre sul bus, prima dell'amp
+    std::array<float, RENDER_BLOCK_FRAMES> guitarGainBuffer{};   // Mandate delle chitarre sul bus
+    std::array<float, RENDER_BLOCK_FRAMES> guitarCleanBuffer{};  // (Oscillator::AmpSends)
+    std::array<float, RENDER_BLOCK_FRAMES> voiceBuffer{};  // Singola voce, quando il tap misura
+    
+    // IR caricate, al rate del file: si ricalcolano se cambia il rate dello stream
+    std::array<std::vector<float>, InsertChain::NUM_SLOTS> impulseSources;
+    std::array<int, InsertChain::NUM_SLOTS> impulseSourceRates{};
+    bool renderingOffline = false;  // Coda della convoluzione calcolata inline (replay)
+    bool synchronousTail = false;
+    
+    AnalysisTap analysisTap;
+    
+    // Tracing della latenza: id della nota in attesa del primo campione, per voce
+    // e per la batteria (sotto voiceMutex). Il tempo di presentazione del primo
+    // frame del callback è estrapolato dall'ultimo getTimestamp (-1 = ignoto).
+    LatencyTracer latencyTracer;
+    std::array<uint32_t, MAX_VOICES> voiceTraceIds{};
+    std::array<bool, MAX_VOICES> voiceTraceDequeued{};
+    uint32_t drumTraceId = 0;
+    bool drumTraceDequeued = false;
+    int64_t callbackPresentationNs = -1;
+    int64_t timestampFrame = 0;
+    int64_t timestampNs = -1;
+    int64_t timestampRefreshNs = 0;
+    
+    PerformanceRecorder recorder;
+    
+    // Stato idle: frame consecutivi di silenzio (scritti solo dal thread audio,
+    // o dalla UI quando lo stream è fermo)
+    int64_t idleFrames = 0;
+    std::atomic<int> idleTimeoutMs{DEFAULT_IDLE_TIMEOUT_MS};
+    std::atomic<bool> streamSuspended{false};
+    
+    // Quality governor: il tier richiesto viene applicato all'inizio del callback
+    QualityGovernor qualityGovernor;
+    std::atomic<int> requestedTier{0};
+    QualityGovernor::Tier appliedTier = QualityGovernor::Tier::Full;
+    int polyphonyCap = MAX_VOICES;
+    // Scala e bend per dito (sotto voiceMutex): nota di partenza in MIDI
+    // frazionario e bend grezzo accumulato dai delta del gesto
+    ScaleQuantizer scale;
+    bool bendSnap = false;
+    float bendGlideMs = DEFAULT_BEND_GLIDE_MS;
+    std::array<float, MAX_VOICES> fingerMidi{};
+    std::array<float, MAX_VOICES> fingerBend{};
+    static constexpr float DEFAULT_BEND_GLIDE_MS = 0.0f;  // Come il bend storico; > 0 leviga i passi del gesto
+    static constexpr float MAX_BEND_GLIDE_MS = 500.0f;
+    
+    // Step sequencer: clock e pattern sul thread audio, con una voce di basso
+    // propria (non ruba le voci delle dita, non entra nel log eventi)
+    StepSequencer sequencer;
+    Oscillator sequencerBass;
+    
+    std::array<uint64_t, MAX_VOICES> noteStamps{};  // Ordine dei noteOn, per rilasciare le più vecchie
+    uint64_t noteCounter = 0;
+    
+    // Log eventi: i frame sono contati sotto voiceMutex, quindi ogni evento
+    // cade esattamente all'inizio di un callback. Il numero d'ordine (anch'esso
+    // sotto voiceMutex) rimette in fila gli eventi scritti da thread diversi.
+    EventLogger eventLogger;
+    EventReplayer realtimeReplayer;
+    uint64_t framesRendered = 0;
+    uint32_t eventSequence = 0;
+    int lastCallbackFrames = 0;
+    uint32_t randomSeed;
+    
+    // Ultimo stato dei controlli, scritto all'inizio di ogni log
+    int waveTypeIndex = 1;
+    bool exponentialEnvelope = false;
+    std::array<float, 3> unisonParams = {1.0f, 0.0f, 0.0f};  // Voci, detune, mix
+    std::array<float, 4> guitarParams = {0.7f, 0.7f, 0.7f, 0.3f};
+    bool wahEnabled = false;
+    bool wahManual = false;
+    float wahPosition = 0.5f;
     
     float masterVolume = 0.8f;
-    int sampleRate = 48000;
+    int sampleRate = 48000;  // Sostituito dal rate nativo all'apertura dello stream
     int framesPerBuffer = 0;
     
-    bool isRunning = false;
+    // Ciclo di vita dello stream: start/stop, riaperture e risveglio dall'idle
+    // passano tutti da streamMutex (mai preso dal callback). Risveglio e
+    // riavvio dopo un errore girano sul thread dei task dello stream, così né
+    // la UI né il thread degli errori di Oboe aspettano un'apertura.
+    std::atomic<bool> isRunning{false};
+    mutable std::mutex streamMutex;
+    std::mutex streamTaskMutex;
+    std::condition_variable streamTaskCondition;
+    std::thread streamTaskThread;
+    bool wakePending = false;     // Sotto streamTaskMutex
+    bool restartPending = false;
+    bool streamTaskExit = false;
 };
 
 #endif // AUDIO_ENGINE_H
@@ -0,0 +1,231 @@
+#include "AudioThreadTuner.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstdio>
+#include <dlfcn.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define LOG_TAG "AudioThreadTuner"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// NDK performance-hint entry points (android/performance_hint.h, API 33)
+struct AudioThreadTuner::HintApi {
+    void *(*getManager)();
+    void *(*createSession)(void *manager, const int32_t *threadIds, size_t size,
+                           int64_t initialTargetWorkDurationNanos);
+    int (*updateTargetWorkDuration)(void *session, int64_t targetDurationNanos);
+    int (*reportActualWorkDuration)(void *session, int64_t actualDurationNanos);
+    void (*closeSession)(void *session);
+};
+
+const AudioThreadTuner::HintApi *AudioThreadTuner::loadHintApi() {
+    static const HintApi *api = []() -> const HintApi * {
+        void *library = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+        if (!library) {
+            return nullptr;
+        }
+        static HintApi loaded;
+        loaded.getManager = reinterpret_cast<void *(*)()>(
+                dlsym(library, "APerformanceHint_getManager"));
+        loaded.createSession = reinterpret_cast<void *(*)(void *, const int32_t *, size_t, int64_t)>(
+                dlsym(library, "APerformanceHint_createSession"));
+        loaded.updateTargetWorkDuration = reinterpret_cast<int (*)(void *, int64_t)>(
+                dlsym(library, "APerformanceHint_updateTargetWorkDuration"));
+        loaded.reportActualWorkDuration = reinterpret_cast<int (*)(void *, int64_t)>(
+                dlsym(library, "APerformanceHint_reportActualWorkDuration"));
+        loaded.closeSession = reinterpret_cast<void (*)(void *)>(
+                dlsym(library, "APerformanceHint_closeSession"));
+
+        if (!loaded.getManager || !loaded.createSession || !loaded.updateTargetWorkDuration ||
+            !loaded.reportActualWorkDuration || !loaded.closeSession) {
+            LOGI("Performance hints not available, affinity only");
+            return nullptr;
+        }
+        return &loaded;
+    }();
+    return api;
+}
+
+AudioThreadTuner::AudioThreadTuner() {
+    CPU_ZERO(&originalAffinity);
+    hintApi = loadHintApi();
+}
+
+AudioThreadTuner::~AudioThreadTuner() {
+    // The stream is closed by now, so the audio thread no longer touches the session
+    closeHintSession();
+}
+
+/**
+ * Cores whose maximum frequency is above the slowest cluster's. On a
+ * homogeneous CPU, or when sysfs is unreadable, every online core is kept.
+ */
+uint64_t AudioThreadTuner::findPerformanceCores() {
+    const int numCpus = std::min(static_cast<int>(sysconf(_SC_NPROCESSORS_CONF)), MAX_CPUS);
+    long maxFrequency[MAX_CPUS] = {};
+    long slowest = 0;
+    uint64_t online = 0;
+
+    for (int cpu = 0; cpu < numCpus; ++cpu) {
+        char path[96];
+        std::snprintf(path, sizeof(path),
+                      "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+        FILE *file = std::fopen(path, "r");
+        if (!file) {
+            continue;
+        }
+        if (std::fscanf(file, "%ld", &maxFrequency[cpu]) == 1 && maxFrequency[cpu] > 0) {
+            online |= uint64_t{1} << cpu;
+            slowest = slowest == 0 ? maxFrequency[cpu] : std::min(slowest, maxFrequency[cpu]);
+        }
+        std::fclose(file);
+    }
+
+    uint64_t fast = 0;
+    for (int cpu = 0; cpu < numCpus; ++cpu) {
+        if ((online >> cpu & 1) && maxFrequency[cpu] > slowest) {
+            fast |= uint64_t{1} << cpu;
+        }
+    }
+    if (fast == 0) {
+        fast = online;
+    }
+    if (fast == 0 && numCpus > 0) {
+        fast = numCpus == MAX_CPUS ? ~uint64_t{0} : (uint64_t{1} << numCpus) - 1;
+    }
+    return fast;
+}
+
+void AudioThreadTuner::setAffinityPolicy(AffinityPolicy policy, uint64_t customMask) {
+    uint64_t mask = 0;
+    switch (policy) {
+        case AffinityPolicy::None:
+            break;
+        case AffinityPolicy::PerformanceCores:
+            mask = findPerformanceCores();
+            break;
+        case AffinityPolicy::Custom:
+            mask = customMask;
+            break;
+    }
+    affinityMask.store(mask, std::memory_order_relaxed);
+    policyGeneration.fetch_add(1, std::memory_order_release);
+    LOGI("Affinity policy %d, mask 0x%llx", static_cast<int>(policy),
+         static_cast<unsigned long long>(mask));
+}
+
+void AudioThreadTuner::setPerformanceHintEnabled(bool enabled) {
+    hintEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * Pins the calling thread to the current mask (policy None leaves it alone).
+ * Returns false if the kernel refused the mask.
+ */
+bool AudioThreadTuner::pinCurrentThread() {
+    const uint64_t mask = affinityMask.load(std::memory_order_relaxed);
+    if (mask == 0) {
+        return true;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < MAX_CPUS; ++cpu) {
+        if (mask >> cpu & 1) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        LOGE("sched_setaffinity(0x%llx) failed", static_cast<unsigned long long>(mask));
+        return false;
+    }
+    return true;
+}
+
+// Audio thread
+bool AudioThreadTuner::applyAffinity() {
+    if (!originalSaved) {
+        originalSaved = sched_getaffinity(0, sizeof(originalAffinity), &originalAffinity) == 0;
+    }
+
+    if (affinityMask.load(std::memory_order_relaxed) != 0) {
+        pinned = pinCurrentThread();
+        return pinned;
+    }
+    if (pinned && originalSaved) {
+        sched_setaffinity(0, sizeof(originalAffinity), &originalAffinity);
+    }
+    pinned = false;
+    return true;
+}
+
+void AudioThreadTuner::beginCallback() {
+    const int tid = static_cast<int>(syscall(SYS_gettid));
+    const uint32_t generation = policyGeneration.load(std::memory_order_acquire);
+
+    if (tid != threadId.load(std::memory_order_relaxed)) {
+        // New callback thread: its affinity and hint session start from scratch
+        closeHintSession();
+        threadId.store(tid, std::memory_order_relaxed);
+        originalSaved = false;
+        pinned = false;
+        appliedGeneration = generation - 1;
+    }
+    if (generation != appliedGeneration) {
+        applyAffinity();
+        appliedGeneration = generation;
+    }
+    currentCpu.store(sched_getcpu(), std::memory_order_relaxed);
+}
+
+void AudioThreadTuner::endCallback(int64_t workNanos, int64_t deadlineNanos) {
+    if (!hintApi) {
+        return;
+    }
+    if (!hintEnabled.load(std::memory_order_relaxed)) {
+        closeHintSession();
+        return;
+    }
+    if (!hintSession) {
+        openHintSession(deadlineNanos);
+        if (!hintSession) {
+            return;
+        }
+    }
+    if (deadlineNanos != hintTargetNanos) {
+        hintApi->updateTargetWorkDuration(hintSession, deadlineNanos);
+        hintTargetNanos = deadlineNanos;
+    }
+    hintApi->reportActualWorkDuration(hintSession, std::max<int64_t>(1, workNanos));
+}
+
+/**
+ * Opened from the callback itself because the session is bound to the
+ * calling thread's id. It is a one-off binder call per thread, like the
+ * stream's own first callback setup.
+ */
+void AudioThreadTuner::openHintSession(int64_t deadlineNanos) {
+    void *manager = hintApi->getManager();
+    if (!manager) {
+        hintApi = nullptr;
+        return;
+    }
+    const int32_t tid = threadId.load(std::memory_order_relaxed);
+    hintSession = hintApi->createSession(manager, &tid, 1, deadlineNanos);
+    if (!hintSession) {
+        // Not supported on this device (the HAL may refuse sessions)
+        hintApi = nullptr;
+        return;
+    }
+    hintTargetNanos = deadlineNanos;
+    hintActive.store(true, std::memory_order_relaxed);
+}
+
+void AudioThreadTuner::closeHintSession() {
+    if (hintSession) {
+        hintApi->closeSession(hintSession);
+        hintSession = nullptr;
+        hintActive.store(false, std::memory_order_relaxed);
+    }
+}
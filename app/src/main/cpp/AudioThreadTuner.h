@@ -0,0 +1,80 @@
+#ifndef AUDIO_THREAD_TUNER_H
+#define AUDIO_THREAD_TUNER_H
+
+#include <atomic>
+#include <cstdint>
+#include <sched.h>
+#include <sys/types.h>
+
+/**
+ * AudioThreadTuner - CPU placement and performance hints for the audio thread
+ *
+ * The callback thread is identified on its first callback (and again whenever
+ * Oboe hands the stream to a new thread, e.g. after an idle restart). It can
+ * then be pinned to a core set chosen by policy: the performance cores, found
+ * from the per-core maximum frequencies in sysfs, or an explicit CPU mask.
+ *
+ * Where the platform performance-hint API exists (APerformanceHint, API 33+)
+ * it is loaded with dlsym, since minSdk is lower, and every callback reports
+ * its work duration against the buffer deadline so the kernel can raise
+ * clocks before deadlines are missed. Without it only sched_setaffinity is
+ * used, which also works on a Linux host.
+ */
+class AudioThreadTuner {
+public:
+    enum class AffinityPolicy {
+        None = 0,          // Leave placement to the scheduler
+        PerformanceCores,  // Every core outside the slowest cluster
+        Custom             // Explicit mask, bit n = CPU n
+    };
+    static constexpr int MAX_CPUS = 64;
+
+    AudioThreadTuner();
+    ~AudioThreadTuner();
+
+    // Control thread (reads sysfs, takes effect on the next callback)
+    void setAffinityPolicy(AffinityPolicy policy, uint64_t customMask = 0);
+    void setPerformanceHintEnabled(bool enabled);
+    static uint64_t findPerformanceCores();
+
+    // Audio thread: once at the start and once at the end of each callback
+    void beginCallback();
+    void endCallback(int64_t workNanos, int64_t deadlineNanos);
+
+    // Any other real-time worker: applies the current policy to the calling thread
+    bool pinCurrentThread();
+
+    // Status, readable from any thread
+    int getThreadId() const { return threadId.load(std::memory_order_relaxed); }
+    int getCurrentCpu() const { return currentCpu.load(std::memory_order_relaxed); }
+    uint64_t getAffinityMask() const { return affinityMask.load(std::memory_order_relaxed); }
+    // Bumped by every setAffinityPolicy(), so workers can tell when to re-pin
+    uint32_t getPolicyGeneration() const { return policyGeneration.load(std::memory_order_acquire); }
+    bool isHintSessionActive() const { return hintActive.load(std::memory_order_relaxed); }
+
+private:
+    struct HintApi;
+    static const HintApi *loadHintApi();
+
+    bool applyAffinity();
+    void openHintSession(int64_t deadlineNanos);
+    void closeHintSession();
+
+    std::atomic<uint64_t> affinityMask{0};  // 0 = no pinning
+    std::atomic<uint32_t> policyGeneration{0};
+    std::atomic<bool> hintEnabled{true};
+    std::atomic<int> threadId{0};
+    std::atomic<int> currentCpu{-1};
+    std::atomic<bool> hintActive{false};
+
+    // Audio thread only
+    const HintApi *hintApi = nullptr;
+    void *hintSession = nullptr;
+    int64_t hintTargetNanos = 0;
+    uint32_t appliedGeneration = 0;
+    bool pinned = false;
+    bool originalSaved = false;
+    cpu_set_t originalAffinity;
+};
+
+#endif // AUDIO_THREAD_TUNER_H
@@ -0,0 +1,355 @@
+#include "ConvolutionEngine.h"
+#include "AudioThreadTuner.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "ConvolutionEngine"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr int SINC_ZERO_CROSSINGS = 16;
+
+} // namespace
+
+// ===========================================
+// PartitionedConvolver
+// ===========================================
+
+void PartitionedConvolver::init(const float *ir, int irLength, int block) {
+    blockSize = block;
+    fft.init(2 * block);
+    bins = fft.getBins();
+    partitions = irLength > 0 ? (irLength + block - 1) / block : 0;
+
+    irRe.assign(static_cast<size_t>(partitions) * bins, 0.0f);
+    irIm.assign(static_cast<size_t>(partitions) * bins, 0.0f);
+    fdlRe.assign(static_cast<size_t>(partitions) * bins, 0.0f);
+    fdlIm.assign(static_cast<size_t>(partitions) * bins, 0.0f);
+    window.assign(2 * block, 0.0f);
+    accRe.assign(bins, 0.0f);
+    accIm.assign(bins, 0.0f);
+    timeOut.assign(2 * block, 0.0f);
+
+    // Each partition zero-padded to the FFT size, scaled for the unnormalized inverse
+    std::vector<float> padded(2 * block);
+    const float scale = 1.0f / static_cast<float>(2 * block);
+    for (int p = 0; p < partitions; ++p) {
+        std::fill(padded.begin(), padded.end(), 0.0f);
+        const int count = std::min(block, irLength - p * block);
+        for (int i = 0; i < count; ++i) {
+            padded[i] = ir[p * block + i] * scale;
+        }
+        fft.forward(padded.data(), &irRe[p * bins], &irIm[p * bins]);
+    }
+    current = 0;
+}
+
+void PartitionedConvolver::reset() {
+    std::fill(fdlRe.begin(), fdlRe.end(), 0.0f);
+    std::fill(fdlIm.begin(), fdlIm.end(), 0.0f);
+    std::fill(window.begin(), window.end(), 0.0f);
+    current = 0;
+}
+
+void PartitionedConvolver::processBlock(const float *input, float *output) {
+    if (partitions == 0) {
+        std::fill(output, output + blockSize, 0.0f);
+        return;
+    }
+
+    // Overlap-save window: previous block followed by the new one
+    std::copy(window.begin() + blockSize, window.end(), window.begin());
+    std::copy(input, input + blockSize, window.begin() + blockSize);
+
+    current = current == 0 ? partitions - 1 : current - 1;
+    fft.forward(window.data(), &fdlRe[current * bins], &fdlIm[current * bins]);
+
+    // Sum of input spectrum k blocks ago times partition k
+    std::fill(accRe.begin(), accRe.end(), 0.0f);
+    std::fill(accIm.begin(), accIm.end(), 0.0f);
+    for (int p = 0; p < partitions; ++p) {
+        const int slot = (current + p) % partitions;
+        const float *xr = &fdlRe[slot * bins];
+        const float *xi = &fdlIm[slot * bins];
+        const float *hr = &irRe[p * bins];
+        const float *hi = &irIm[p * bins];
+        float *ar = accRe.data();
+        float *ai = accIm.data();
+        for (int k = 0; k < bins; ++k) {
+            ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+            ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+        }
+    }
+
+    // The first half is circular wrap-around; the second half is the linear result
+    fft.inverse(accRe.data(), accIm.data(), timeOut.data());
+    std::copy(timeOut.begin() + blockSize, timeOut.end(), output);
+}
+
+// ===========================================
+// ConvolutionEngine
+// ===========================================
+
+ConvolutionEngine::~ConvolutionEngine() {
+    if (worker.joinable()) {
+        workerRunning.store(false);
+        sem_post(&tailReady);
+        worker.join();
+        sem_destroy(&tailReady);
+    }
+}
+
+bool ConvolutionEngine::init(const std::vector<float> &ir, AudioThreadTuner *threadTuner) {
+    if (ir.empty() || worker.joinable()) {
+        return false;
+    }
+    tuner = threadTuner;
+    length = static_cast<int>(ir.size());
+
+    const int firLength = std::min(length, HEAD_BLOCK);
+    firTaps.assign(HEAD_BLOCK, 0.0f);
+    for (int i = 0; i < firLength; ++i) {
+        firTaps[HEAD_BLOCK - 1 - i] = ir[i];
+    }
+    firHistory.assign(2 * HEAD_BLOCK, 0.0f);
+
+    hasHead = length > HEAD_BLOCK;
+    head.init(ir.data() + std::min(length, HEAD_BLOCK),
+              std::clamp(length, HEAD_BLOCK, HEAD_LENGTH) - HEAD_BLOCK, HEAD_BLOCK);
+    headInput.assign(HEAD_BLOCK, 0.0f);
+    headOutput.assign(HEAD_BLOCK, 0.0f);
+
+    hasTail = length > HEAD_LENGTH;
+    if (hasTail) {
+        tail.init(ir.data() + HEAD_LENGTH, length - HEAD_LENGTH, TAIL_BLOCK);
+        inputRing.assign(INPUT_RING_BLOCKS * TAIL_BLOCK, 0.0f);
+        outputRing.assign(OUTPUT_RING_BLOCKS * TAIL_BLOCK, 0.0f);
+        outputTags = std::vector<std::atomic<int64_t>>(OUTPUT_RING_BLOCKS);
+        tailInput.assign(TAIL_BLOCK, 0.0f);
+        tailOutput.assign(TAIL_BLOCK, 0.0f);
+    }
+    reset();
+
+    if (hasTail) {
+        sem_init(&tailReady, 0, 0);
+        workerRunning.store(true);
+        worker = std::thread(&ConvolutionEngine::workerLoop, this);
+    }
+    LOGI("IR of %d taps: %d head partitions, %d tail partitions", length,
+         head.getPartitions(), hasTail ? tail.getPartitions() : 0);
+    return true;
+}
+
+bool ConvolutionEngine::tryLockTail() {
+    bool expected = false;
+    return tailBusy.compare_exchange_strong(expected, true, std::memory_order_acquire);
+}
+
+void ConvolutionEngine::reset() {
+    std::fill(firHistory.begin(), firHistory.end(), 0.0f);
+    firPosition = 0;
+    head.reset();
+    std::fill(headOutput.begin(), headOutput.end(), 0.0f);
+    headPosition = 0;
+    frame = 0;
+
+    if (!hasTail) {
+        return;
+    }
+    // The worker finishes its current block first (a few hundred microseconds at most)
+    while (!tryLockTail()) {
+        std::this_thread::yield();
+    }
+    tail.reset();
+    for (auto &tag : outputTags) {
+        tag.store(-1, std::memory_order_relaxed);
+    }
+    nextTailBlock = 0;
+    lastMissedBlock = -1;
+    inputFrames.store(0, std::memory_order_release);
+    unlockTail();
+}
+
+void ConvolutionEngine::process(const float *input, float *output, int numFrames) {
+    const int64_t tailDelay = HEAD_LENGTH;
+    const int inputMask = INPUT_RING_BLOCKS * TAIL_BLOCK - 1;
+
+    for (int i = 0; i < numFrames; ++i) {
+        const float x = input[i];
+
+        // Direct-form FIR over the newest HEAD_BLOCK inputs
+        firHistory[firPosition] = x;
+        firHistory[firPosition + HEAD_BLOCK] = x;
+        firPosition = firPosition + 1 == HEAD_BLOCK ? 0 : firPosition + 1;
+        const float *history = &firHistory[firPosition];
+        float y = 0.0f;
+        for (int k = 0; k < HEAD_BLOCK; ++k) {
+            y += firTaps[k] * history[k];
+        }
+
+        y += headOutput[headPosition];
+        headInput[headPosition] = x;
+
+        if (hasTail) {
+            inputRing[frame & inputMask] = x;
+
+            // Tail block computed from input that is HEAD_LENGTH frames old
+            const int64_t tailFrame = frame - tailDelay;
+            if (tailFrame >= 0) {
+                const int64_t block = tailFrame / TAIL_BLOCK;
+                const int slot = static_cast<int>(block % OUTPUT_RING_BLOCKS);
+                if (outputTags[slot].load(std::memory_order_acquire) == block) {
+                    y += outputRing[slot * TAIL_BLOCK + tailFrame % TAIL_BLOCK];
+                } else if (block != lastMissedBlock) {
+                    lastMissedBlock = block;
+                    tailMisses.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        output[i] = y;
+        ++frame;
+
+        if (++headPosition == HEAD_BLOCK) {
+            headPosition = 0;
+            if (hasHead) {
+                head.processBlock(headInput.data(), headOutput.data());
+            }
+            if (hasTail) {
+                inputFrames.store(frame, std::memory_order_release);
+                if (frame % TAIL_BLOCK == 0) {
+                    if (!synchronousTail.load(std::memory_order_relaxed)) {
+                        sem_post(&tailReady);  // Wait-free, unlike notifying a condition variable
+                    } else if (tryLockTail()) {
+                        runTail();
+                        unlockTail();
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ConvolutionEngine::runTail() {
+    const int64_t available = inputFrames.load(std::memory_order_acquire);
+    const int64_t ringFrames = static_cast<int64_t>(inputRing.size());
+    const int inputMask = static_cast<int>(ringFrames - 1);
+
+    while ((nextTailBlock + 1) * TAIL_BLOCK <= available) {
+        const int64_t start = nextTailBlock * TAIL_BLOCK;
+        if (available - start > ringFrames - TAIL_BLOCK) {
+            // Fell too far behind: the ring has been overwritten, restart at the newest block
+            nextTailBlock = available / TAIL_BLOCK - 1;
+            tail.reset();
+            continue;
+        }
+        for (int i = 0; i < TAIL_BLOCK; ++i) {
+            tailInput[i] = inputRing[(start + i) & inputMask];
+        }
+        tail.processBlock(tailInput.data(), tailOutput.data());
+
+        const int slot = static_cast<int>(nextTailBlock % OUTPUT_RING_BLOCKS);
+        outputTags[slot].store(-1, std::memory_order_relaxed);
+        std::copy(tailOutput.begin(), tailOutput.end(), outputRing.begin() + slot * TAIL_BLOCK);
+        outputTags[slot].store(nextTailBlock, std::memory_order_release);
+        ++nextTailBlock;
+    }
+}
+
+// Sleeps until process() completes a tail input block, so an idle engine costs nothing
+void ConvolutionEngine::workerLoop() {
+    followAffinityPolicy();
+    while (true) {
+        while (sem_wait(&tailReady) != 0) {
+            // EINTR: a signal interrupted the wait
+        }
+        if (!workerRunning.load()) {
+            break;
+        }
+        followAffinityPolicy();
+        if (!synchronousTail.load(std::memory_order_relaxed) && tryLockTail()) {
+            runTail();
+            unlockTail();
+        }
+    }
+}
+
+/**
+ * Pins the worker to the tuner's current mask, or gives it back the affinity
+ * it started with once the policy is None. Only runs when the generation
+ * moved, so the common case is one atomic load per tail block.
+ */
+void ConvolutionEngine::followAffinityPolicy() {
+    if (tuner == nullptr) {
+        return;
+    }
+    const uint32_t generation = tuner->getPolicyGeneration();
+    if (generation == workerGeneration.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (!originalSaved) {
+        originalSaved = sched_getaffinity(0, sizeof(originalAffinity), &originalAffinity) == 0;
+    }
+    if (tuner->getAffinityMask() != 0) {
+        workerPinned = tuner->pinCurrentThread();
+    } else if (workerPinned && originalSaved) {
+        sched_setaffinity(0, sizeof(originalAffinity), &originalAffinity);
+        workerPinned = false;
+    }
+    workerGeneration.store(generation, std::memory_order_relaxed);
+}
+
+/**
+ * Windowed-sinc (Blackman) sample-rate conversion, run once per IR load.
+ * When downsampling the cutoff follows the target Nyquist frequency.
+ */
+std::vector<float> ConvolutionEngine::prepareImpulse(const std::vector<float> &ir, float irRate,
+                                                     float targetRate, int maxLength) {
+    std::vector<float> result;
+    if (ir.empty() || irRate <= 0.0f || targetRate <= 0.0f) {
+        return result;
+    }
+
+    if (irRate == targetRate) {
+        result.assign(ir.begin(), ir.begin() + std::min<size_t>(ir.size(), maxLength));
+    } else {
+        const double ratio = static_cast<double>(irRate) / targetRate;  // Input samples per output sample
+        const double cutoff = std::min(1.0, 1.0 / ratio);
+        const double halfWidth = SINC_ZERO_CROSSINGS / cutoff;
+        const int outLength = std::min(static_cast<int>(std::ceil(ir.size() / ratio)), maxLength);
+        const int inLength = static_cast<int>(ir.size());
+        result.resize(outLength);
+
+        for (int n = 0; n < outLength; ++n) {
+            const double center = n * ratio;
+            const int first = std::max(0, static_cast<int>(std::ceil(center - halfWidth)));
+            const int last = std::min(inLength - 1, static_cast<int>(std::floor(center + halfWidth)));
+            double sum = 0.0;
+            for (int k = first; k <= last; ++k) {
+                const double t = k - center;
+                const double x = M_PI * cutoff * t;
+                const double sinc = std::fabs(x) < 1e-9 ? 1.0 : std::sin(x) / x;
+                const double phase = M_PI * (t / halfWidth + 1.0);  // 0..2 pi across the window
+                const double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+                sum += ir[k] * cutoff * sinc * window;
+            }
+            result[n] = static_cast<float>(sum);
+        }
+    }
+
+    // Unit energy, so loading an IR doesn't change the loudness of white noise
+    double energy = 0.0;
+    for (float sample : result) {
+        energy += static_cast<double>(sample) * sample;
+    }
+    if (energy <= 1e-12) {
+        result.clear();
+        return result;
+    }
+    const auto scale = static_cast<float>(1.0 / std::sqrt(energy));
+    for (float &sample : result) {
+        sample *= scale;
+    }
+    return result;
+}
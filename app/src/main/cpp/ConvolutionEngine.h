@@ -0,0 +1,150 @@
+#ifndef CONVOLUTION_ENGINE_H
+#define CONVOLUTION_ENGINE_H
+
+#include "RealFFT.h"
+#include <sched.h>
+#include <semaphore.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+class AudioThreadTuner;
+
+/**
+ * PartitionedConvolver - Uniformly partitioned overlap-save convolution
+ *
+ * The impulse response is split into partitions of blockSize taps, each
+ * pre-transformed with a 2 * blockSize real FFT. Every input block costs one
+ * forward FFT, one complex multiply-accumulate per partition and one inverse
+ * FFT, regardless of where the energy of the IR sits.
+ */
+class PartitionedConvolver {
+public:
+    void init(const float *ir, int length, int blockSize);  // Allocates (control thread)
+    void reset();
+
+    // Consumes blockSize input samples and returns the next blockSize samples
+    // of (input * ir), aligned with the input block
+    void processBlock(const float *input, float *output);
+
+    int getPartitions() const { return partitions; }
+
+private:
+    RealFFT fft;
+    int blockSize = 0;
+    int bins = 0;
+    int partitions = 0;
+    int current = 0;                  // Newest slot of the frequency-domain delay line
+    std::vector<float> irRe, irIm;    // partitions x bins, pre-scaled by 1 / FFT size
+    std::vector<float> fdlRe, fdlIm;  // partitions x bins input spectra
+    std::vector<float> window;        // Previous block + current block
+    std::vector<float> accRe, accIm;
+    std::vector<float> timeOut;
+};
+
+/**
+ * ConvolutionEngine - Streaming convolution for cabinet and room IRs
+ *
+ * Non-uniform partitioning with zero added latency:
+ *   taps [0, HEAD_BLOCK)                direct-form FIR, per sample
+ *   taps [HEAD_BLOCK, HEAD_LENGTH)      partitioned, HEAD_BLOCK blocks, in the callback
+ *   taps [HEAD_LENGTH, end)             partitioned, TAIL_BLOCK blocks, on a worker thread
+ * The callback cost is therefore fixed by the two constants, however long
+ * the IR is. The tail result for an input block is only needed
+ * HEAD_LENGTH - TAIL_BLOCK samples after that block is complete, which is
+ * the worker's deadline. The worker sleeps on a semaphore that process()
+ * posts whenever a tail input block is complete (sem_post never blocks the
+ * audio thread). Input and output travel through lock-free rings indexed
+ * by absolute frame, and every output block carries a tag, so a late
+ * worker costs a missing tail block (counted) but never a stall.
+ *
+ * For offline rendering setSynchronousTail(true) runs the tail inline on
+ * the calling thread, so the result doesn't depend on scheduling.
+ *
+ * Given the engine's AudioThreadTuner, the worker takes the audio thread's
+ * CPU policy when it starts and again on the first block after the policy
+ * changes, so its deadline is met on the same cores as the callback's.
+ */
+class ConvolutionEngine {
+public:
+    static constexpr int HEAD_BLOCK = 64;
+    static constexpr int TAIL_BLOCK = 1024;
+    static constexpr int HEAD_LENGTH = 2 * TAIL_BLOCK;
+
+    ConvolutionEngine() = default;
+    ~ConvolutionEngine();
+
+    ConvolutionEngine(const ConvolutionEngine &) = delete;
+    ConvolutionEngine &operator=(const ConvolutionEngine &) = delete;
+
+    // Control thread: builds every partition and starts the tail worker if needed.
+    // The tuner (optional) must outlive the engine.
+    bool init(const std::vector<float> &ir, AudioThreadTuner *tuner = nullptr);
+    int getLength() const { return length; }
+
+    // Engine lock held (the callback is not processing)
+    void reset();
+    void setSynchronousTail(bool synchronous) { synchronousTail.store(synchronous); }
+
+    // Audio thread; output may alias input
+    void process(const float *input, float *output, int numFrames);
+
+    uint64_t getTailMisses() const { return tailMisses.load(std::memory_order_relaxed); }
+    // Tuner policy generation the worker last applied (0 without a tuner)
+    uint32_t getWorkerPolicyGeneration() const { return workerGeneration.load(std::memory_order_relaxed); }
+
+    // Resamples with a windowed sinc and scales the IR to unit energy
+    static std::vector<float> prepareImpulse(const std::vector<float> &ir, float irRate,
+                                             float targetRate, int maxLength);
+
+private:
+    static constexpr int INPUT_RING_BLOCKS = 8;
+    static constexpr int OUTPUT_RING_BLOCKS = 4;
+
+    void workerLoop();
+    void followAffinityPolicy();  // Worker: applies the tuner's policy if it changed
+    void runTail();  // Processes every complete input block (tail lock held)
+    bool tryLockTail();
+    void unlockTail() { tailBusy.store(false, std::memory_order_release); }
+
+    int length = 0;
+
+    // Head (audio thread)
+    std::vector<float> firTaps;     // Reversed, for a forward dot product
+    std::vector<float> firHistory;  // Mirrored ring: the last HEAD_BLOCK inputs are always contiguous
+    int firPosition = 0;
+    PartitionedConvolver head;
+    bool hasHead = false;
+    std::vector<float> headInput;
+    std::vector<float> headOutput;  // Contribution to the current block
+    int headPosition = 0;
+    int64_t frame = 0;              // Absolute input/output frame
+
+    // Tail (worker, or inline when synchronous)
+    PartitionedConvolver tail;
+    bool hasTail = false;
+    std::atomic<bool> synchronousTail{false};
+    std::vector<float> inputRing;   // INPUT_RING_BLOCKS * TAIL_BLOCK, indexed by frame
+    std::atomic<int64_t> inputFrames{0};
+    std::vector<float> outputRing;  // OUTPUT_RING_BLOCKS * TAIL_BLOCK
+    std::vector<std::atomic<int64_t>> outputTags;  // Tail block stored in each slot
+    int64_t nextTailBlock = 0;
+    std::vector<float> tailInput, tailOutput;
+    std::atomic<bool> tailBusy{false};
+    std::atomic<uint64_t> tailMisses{0};
+    int64_t lastMissedBlock = -1;
+
+    std::thread worker;
+    std::atomic<bool> workerRunning{false};
+    sem_t tailReady;  // Posted once per complete tail input block
+
+    // Worker CPU placement
+    AudioThreadTuner *tuner = nullptr;
+    std::atomic<uint32_t> workerGeneration{0};
+    bool workerPinned = false;
+    bool originalSaved = false;
+    cpu_set_t originalAffinity;
+};
+
+#endif // CONVOLUTION_ENGINE_H
@@ -0,0 +1,135 @@
+#ifndef DELAY_STORAGE_H
+#define DELAY_STORAGE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if !defined(__aarch64__) && defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+/**
+ * DelayStorage - Sample formats for long delay lines
+ *
+ * Delay lines are written once and read once per sample, so their memory
+ * traffic scales with the element size rather than with the arithmetic.
+ * Halving it keeps 8 voices' worth of reverb combs from evicting the
+ * oscillator state on phones with small L2 caches. Processing stays in
+ * float; only the stored samples are narrowed:
+ *
+ *  - Float32: the reference format.
+ *  - Half: IEEE fp16 (fcvt on arm64, F16C on x86 when available, bit
+ *    manipulation otherwise). Relative precision, so quiet tails keep
+ *    their resolution: one round trip adds noise about 73-75 dB below the
+ *    signal at any level, and in a recirculating reverb tail the error
+ *    settles around 67 dB below it (delay_storage_test).
+ *  - Fixed16: int16 with FIXED_HEADROOM of range. Absolute precision
+ *    (74 dB at full scale, 20 dB less per 20 dB of level), so it only
+ *    suits feedback-tolerant paths where the noise floor is masked (comb
+ *    reverbs).
+ *
+ * Each format is a codec struct with a Storage type and load()/store(),
+ * so kernels are templated on the codec instead of branching per access.
+ */
+namespace dsp {
+
+enum class DelayFormat {
+    Float32,
+    Half,
+    Fixed16
+};
+
+struct FloatStorage {
+    using Storage = float;
+    static inline float load(Storage sample) { return sample; }
+    static inline Storage store(float value) { return value; }
+};
+
+#if defined(__aarch64__)
+
+struct HalfStorage {
+    using Storage = __fp16;
+    static inline float load(Storage sample) { return static_cast<float>(sample); }
+    static inline Storage store(float value) { return static_cast<__fp16>(value); }
+};
+
+#else
+
+struct HalfStorage {
+    using Storage = uint16_t;
+
+#if defined(__F16C__)
+    static inline float load(Storage sample) { return _cvtsh_ss(sample); }
+    static inline Storage store(float value) {
+        return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+    }
+#else
+    static inline float load(Storage sample) {
+        const uint32_t sign = static_cast<uint32_t>(sample & 0x8000u) << 16;
+        const uint32_t exponent = (sample >> 10) & 0x1fu;
+        const uint32_t mantissa = sample & 0x3ffu;
+        if (exponent == 0) {
+            // Zero or subnormal: mantissa * 2^-24
+            const float magnitude = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+            return sign ? -magnitude : magnitude;
+        }
+        uint32_t bits = sign | (mantissa << 13);
+        bits |= exponent == 31 ? 0x7f800000u : (exponent + 112) << 23;
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    // Round to nearest even, like the hardware conversions
+    static inline Storage store(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+        const uint32_t magnitude = bits & 0x7fffffffu;
+        if (magnitude >= 0x47800000u) {
+            // Out of range: infinity, or a quiet NaN
+            return sign | (magnitude > 0x7f800000u ? 0x7e00u : 0x7c00u);
+        }
+        if (magnitude < 0x38800000u) {
+            // Below the smallest normal half: count units of 2^-24
+            return sign | static_cast<uint16_t>(std::lrint(std::fabs(value) * 16777216.0f));
+        }
+        uint32_t half = magnitude - 0x38000000u;  // Rebias the exponent (127 -> 15)
+        half = (half + 0xfffu + ((half >> 13) & 1u)) >> 13;
+        return sign | static_cast<uint16_t>(half);
+    }
+#endif
+};
+
+#endif
+
+struct Fixed16Storage {
+    using Storage = int16_t;
+    static constexpr float FIXED_HEADROOM = 16.0f;  // Comb feedback can build up to ~5x the input
+
+    static inline float load(Storage sample) {
+        return static_cast<float>(sample) * (FIXED_HEADROOM / 32767.0f);
+    }
+    static inline Storage store(float value) {
+        const float scaled = std::clamp(value * (32767.0f / FIXED_HEADROOM), -32767.0f, 32767.0f);
+        // Round half away from zero with a truncating convert (lrint is a libcall on some targets)
+        return static_cast<Storage>(scaled + std::copysign(0.5f, scaled));
+    }
+};
+
+inline size_t delaySampleBytes(DelayFormat format) {
+    switch (format) {
+        case DelayFormat::Half:
+            return sizeof(HalfStorage::Storage);
+        case DelayFormat::Fixed16:
+            return sizeof(Fixed16Storage::Storage);
+        default:
+            return sizeof(FloatStorage::Storage);
+    }
+}
+
+} // namespace dsp
+
+#endif // DELAY_STORAGE_H
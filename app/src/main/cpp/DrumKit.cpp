@@ -0,0 +1,257 @@
+#include "DrumKit.h"
+#include "Oscillator.h"
+#include <algorithm>
+#include <cmath>
+
+DrumKit::DrumKit() = default;
+
+void DrumKit::setSampleRate(float rate) {
+    sampleRate = rate;
+    prepareCache(velocityLayers);
+    commitCache();
+}
+
+/**
+ * Synthesizes every pad at its own pitch, once per velocity layer.
+ * Layer k of N is rendered at velocity (k + 1) / N.
+ */
+void DrumKit::prepareCache(int layers, float rate) {
+    pendingLayers = std::clamp(layers, 1, MAX_VELOCITY_LAYERS);
+    pendingRate = rate;
+
+    for (int pad = 0; pad < NUM_PADS; ++pad) {
+        for (int layer = 0; layer < MAX_VELOCITY_LAYERS; ++layer) {
+            std::vector<float> &target = pendingCache[pad][layer];
+            if (layer < pendingLayers) {
+                float velocity = static_cast<float>(layer + 1) / pendingLayers;
+                uint32_t seed = randomSeed + static_cast<uint32_t>(pad * MAX_VELOCITY_LAYERS + layer);
+                renderHit(target, rate, PAD_FREQUENCIES[pad], velocity, seed);
+            } else {
+                target.clear();
+            }
+        }
+    }
+}
+
+void DrumKit::commitCache() {
+    if (pendingLayers == 0) {
+        return;
+    }
+
+    // Playing voices point into the old cache, which is about to be reused
+    allOff();
+    std::swap(cache, pendingCache);
+    velocityLayers = pendingLayers;
+    sampleRate = pendingRate;
+    pendingLayers = 0;
+}
+
+/**
+ * Tables are stored pad by pad, MAX_VELOCITY_LAYERS per pad, with
+ * unused layers left empty: the same layout as the in-memory cache.
+ */
+bool DrumKit::loadCache(const DspCache &file, float rate) {
+    const DspCache::Key &key = file.getKey();
+    if (!file.isOpen() || key.sampleRate != static_cast<uint32_t>(rate) || key.seed != randomSeed ||
+        key.layers < 1 || key.layers > static_cast<uint32_t>(MAX_VELOCITY_LAYERS) ||
+        file.getTableCount() != NUM_PADS * MAX_VELOCITY_LAYERS) {
+        return false;
+    }
+
+    for (int pad = 0; pad < NUM_PADS; ++pad) {
+        for (int layer = 0; layer < MAX_VELOCITY_LAYERS; ++layer) {
+            const DspCache::Table table = file.getTable(pad * MAX_VELOCITY_LAYERS + layer);
+            pendingCache[pad][layer].assign(table.data, table.data + table.length);
+        }
+    }
+    pendingLayers = static_cast<int>(key.layers);
+    pendingRate = rate;
+    return true;
+}
+
+bool DrumKit::saveCache(const std::string &path) const {
+    std::vector<DspCache::Table> tables;
+    for (const LayerCache &layers : cache) {
+        for (const std::vector<float> &sample : layers) {
+            tables.push_back({sample.data(), sample.size()});
+        }
+    }
+    DspCache::Key key;
+    key.sampleRate = static_cast<uint32_t>(sampleRate);
+    key.seed = randomSeed;
+    key.layers = static_cast<uint32_t>(velocityLayers);
+    return DspCache::write(path, key, tables);
+}
+
+void DrumKit::renderHit(std::vector<float> &target, float rate,
+                        float frequency, float velocity, uint32_t seed) {
+    Oscillator drum;
+    drum.setRandomSeed(seed);
+    drum.setSampleRate(rate);
+    drum.setWaveType(Oscillator::WaveType::Drums);
+    drum.setDrumVelocity(velocity);
+    drum.noteOn(frequency);
+
+    const int maxLength = static_cast<int>(MAX_HIT_SECONDS * rate);
+    target.resize(maxLength);
+    int lastAudible = 0;
+    for (int i = 0; i < maxLength; ++i) {
+        target[i] = drum.getNextSample();
+        if (std::fabs(target[i]) > SILENCE_THRESHOLD) {
+            lastAudible = i;
+        }
+    }
+
+    // Trim the inaudible tail and fade out to avoid a click at the cut
+    const int fadeLength = std::max(1, static_cast<int>(FADE_OUT_SECONDS * rate));
+    const int length = std::min(maxLength, lastAudible + fadeLength);
+    target.resize(length);
+    const int fadeStart = std::max(0, length - fadeLength);
+    for (int i = fadeStart; i < length; ++i) {
+        target[i] *= static_cast<float>(length - i) / (length - fadeStart);
+    }
+}
+
+DrumKit::DrumClass DrumKit::classify(float frequency) {
+    // Same frequency ranges as Oscillator::generateDrum
+    if (frequency < 100.0f) return DrumClass::Kick;
+    if (frequency < 250.0f) return DrumClass::Tom;
+    if (frequency < 350.0f) return DrumClass::Snare;
+    if (frequency < 700.0f) return DrumClass::Cymbal;
+    return DrumClass::HiHat;
+}
+
+/**
+ * Closest pad (in pitch ratio) of the same drum class, so a hit between two
+ * pads never changes drum class.
+ */
+int DrumKit::nearestPad(float frequency) {
+    const DrumClass drum = classify(frequency);
+    int nearest = -1;
+    float nearestDistance = 0.0f;
+    for (int pad = 0; pad < NUM_PADS; ++pad) {
+        if (classify(PAD_FREQUENCIES[pad]) != drum) {
+            continue;
+        }
+        const float distance = std::fabs(std::log(frequency / PAD_FREQUENCIES[pad]));
+        if (nearest < 0 || distance < nearestDistance) {
+            nearest = pad;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+void DrumKit::trigger(float frequency, float velocity) {
+    velocity = std::clamp(velocity, 0.0f, 1.0f);
+    if (velocity <= 0.0f) {
+        return;
+    }
+
+    if (!(frequency > 0.0f)) {
+        return;
+    }
+    const int pad = nearestPad(frequency);
+
+    // Pick the closest layer at or above the requested velocity
+    int layer = static_cast<int>(std::ceil(velocity * velocityLayers)) - 1;
+    layer = std::clamp(layer, 0, velocityLayers - 1);
+    const std::vector<float> &sample = cache[pad][layer];
+    if (sample.empty()) {
+        return;
+    }
+    const float layerVelocity = static_cast<float>(layer + 1) / velocityLayers;
+
+    Voice &voice = allocateVoice();
+    voice.data = sample.data();
+    voice.length = static_cast<int>(sample.size());
+    voice.position = 0.0f;
+    voice.increment = pitchTracking ? std::clamp(frequency / PAD_FREQUENCIES[pad], 0.25f, 4.0f)
+                                    : 1.0f;
+    voice.gain = velocity / layerVelocity;
+    voice.active = true;
+}
+
+/**
+ * Free voice if there is one, otherwise steal the one that has played
+ * the longest (closest to the end of its one-shot).
+ */
+DrumKit::Voice &DrumKit::allocateVoice() {
+    Voice *candidate = &voices[0];
+    float candidateProgress = -1.0f;
+
+    for (auto &voice : voices) {
+        if (!voice.active) {
+            return voice;
+        }
+        float progress = voice.position / voice.length;
+        if (progress > candidateProgress) {
+            candidateProgress = progress;
+            candidate = &voice;
+        }
+    }
+    return *candidate;
+}
+
+void DrumKit::allOff() {
+    for (auto &voice : voices) {
+        voice.active = false;
+    }
+}
+
+void DrumKit::mixInto(float *output, int numFrames) {
+    for (auto &voice : voices) {
+        if (!voice.active) {
+            continue;
+        }
+
+        const float *data = voice.data;
+        const int lastIndex = voice.length - 1;
+        float position = voice.position;
+
+        int i = 0;
+        if (voice.increment == 1.0f) {
+            // Straight copy at the rendered pitch
+            int start = static_cast<int>(position);
+            int count = std::min(numFrames, voice.length - start);
+            for (; i < count; ++i) {
+                output[i] += data[start + i] * voice.gain;
+            }
+            position += static_cast<float>(count);
+        } else {
+            // Linear interpolation for retuned pads
+            for (; i < numFrames; ++i) {
+                int index = static_cast<int>(position);
+                if (index >= lastIndex) {
+                    break;
+                }
+                float frac = position - static_cast<float>(index);
+                float sample = data[index] + frac * (data[index + 1] - data[index]);
+                output[i] += sample * voice.gain;
+                position += voice.increment;
+            }
+        }
+
+        voice.position = position;
+        if (static_cast<int>(position) >= lastIndex) {
+            voice.active = false;
+        }
+    }
+}
+
+size_t DrumKit::getCacheBytes() const {
+    size_t bytes = 0;
+    for (const SampleCache *samples : {&cache, &pendingCache}) {
+        for (const LayerCache &layers : *samples) {
+            for (const std::vector<float> &sample : layers) {
+                bytes += sample.capacity() * sizeof(float);
+            }
+        }
+    }
+    return bytes;
+}
+
+bool DrumKit::isActive() const {
+    return std::any_of(voices.begin(), voices.end(),
+                       [](const Voice &voice) { return voice.active; });
+}
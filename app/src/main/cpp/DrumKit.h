@@ -0,0 +1,123 @@
+#ifndef DRUM_KIT_H
+#define DRUM_KIT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "DspCache.h"
+
+/**
+ * DrumKit - Pre-rendered electronic drum one-shots
+ *
+ * Every pad of the kit (the DrumSound pitches of DrumPad.kt) is synthesized
+ * with the Oscillator drum model at its own frequency when the sample rate
+ * is known, optionally at several velocity layers. Hits are then played
+ * back from the cache by a dedicated pool of one-shot voices, so drums never
+ * steal melodic voices and fast rolls can overlap.
+ *
+ * A hit at any other frequency plays the nearest pad of its drum class as
+ * rendered. With pitch tracking enabled it is resampled by hit / pad pitch
+ * instead, which also stretches its decay and shifts the noise colour, so
+ * it is opt-in.
+ */
+class DrumKit {
+public:
+    static constexpr int MAX_DRUM_VOICES = 16;     // Overlapping one-shots
+    static constexpr int MAX_VELOCITY_LAYERS = 4;
+
+    enum class DrumClass {
+        Kick,
+        Tom,
+        Snare,
+        Cymbal,
+        HiHat
+    };
+    static constexpr int NUM_DRUM_CLASSES = 5;
+    static constexpr int NUM_PADS = 9;
+
+    DrumKit();
+
+    // Renders and publishes the sample cache (stream must not be running)
+    void setSampleRate(float sampleRate);
+
+    // Two-phase rebuild while the stream is running: prepareCache renders
+    // off the audio thread, commitCache swaps it in (hold the engine lock)
+    void prepareCache(int layers) { prepareCache(layers, sampleRate); }
+    void prepareCache(int layers, float rate);
+    void commitCache();
+
+    float getSampleRate() const { return sampleRate; }
+
+    // On-disk copy of the rendered hits: loadCache fills the pending cache
+    // (commit as above) when the file matches the rate and seed, and takes
+    // its layer count along
+    bool loadCache(const DspCache &file, float rate);
+    bool saveCache(const std::string &path) const;
+    int getVelocityLayers() const { return velocityLayers; }
+    size_t getCacheBytes() const;  // Both cache generations (hold the cache lock)
+
+    // Seed for the noise in rendered hits (takes effect on the next prepareCache)
+    void setRandomSeed(uint32_t seed) { randomSeed = seed; }
+
+    // Starts a one-shot from the nearest pad of the frequency's drum class
+    void trigger(float frequency, float velocity = 1.0f);
+    // Resample hits by pad pitch (takes effect on the next trigger)
+    void setPitchTracking(bool enabled) { pitchTracking = enabled; }
+    bool isPitchTracking() const { return pitchTracking; }
+    void allOff();
+
+    // Adds all playing one-shots to the output buffer
+    void mixInto(float *output, int numFrames);
+    bool isActive() const;
+
+    static DrumClass classify(float frequency);
+    static int nearestPad(float frequency);
+
+private:
+    using LayerCache = std::array<std::vector<float>, MAX_VELOCITY_LAYERS>;
+    using SampleCache = std::array<LayerCache, NUM_PADS>;
+
+    struct Voice {
+        const float *data = nullptr;
+        int length = 0;
+        float position = 0.0f;   // Fractional read position
+        float increment = 1.0f;  // Playback rate (hit / pad pitch with pitch tracking)
+        float gain = 1.0f;
+        bool active = false;
+    };
+
+    static void renderHit(std::vector<float> &target, float sampleRate,
+                          float frequency, float velocity, uint32_t seed);
+    Voice &allocateVoice();
+
+    // Same pitches as DrumSound.baseFreq, ascending
+    static constexpr std::array<float, NUM_PADS> PAD_FREQUENCIES = {
+        60.0f,   // Kick
+        100.0f,  // Low tom
+        150.0f,  // Mid tom
+        180.0f,  // Hi tom
+        280.0f,  // Snare
+        500.0f,  // Crash
+        600.0f,  // Ride
+        750.0f,  // Open hi-hat
+        900.0f   // Closed hi-hat
+    };
+    static constexpr float MAX_HIT_SECONDS = 0.75f;
+    static constexpr float FADE_OUT_SECONDS = 0.005f;
+    static constexpr float SILENCE_THRESHOLD = 0.001f;
+
+    float sampleRate = 48000.0f;
+    int velocityLayers = 3;
+    bool pitchTracking = false;
+    int pendingLayers = 0;
+    float pendingRate = 48000.0f;
+    uint32_t randomSeed = 0;
+
+    SampleCache cache;
+    SampleCache pendingCache;
+    std::array<Voice, MAX_DRUM_VOICES> voices;
+};
+
+#endif // DRUM_KIT_H
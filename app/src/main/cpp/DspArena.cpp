@@ -0,0 +1,35 @@
+#include "DspArena.h"
+#include <cstring>
+#include <new>
+
+DspArena::~DspArena() {
+    ::operator delete(memory, std::align_val_t{ALIGNMENT});
+}
+
+bool DspArena::reserve(size_t bytes) {
+    bytes = alignUp(bytes);
+    if (bytes <= capacity) {
+        return true;
+    }
+
+    void *block = ::operator new(bytes, std::align_val_t{ALIGNMENT}, std::nothrow);
+    if (!block) {
+        return false;
+    }
+    ::operator delete(memory, std::align_val_t{ALIGNMENT});
+    memory = static_cast<uint8_t *>(block);
+    capacity = bytes;
+    used = 0;
+    return true;
+}
+
+void *DspArena::allocateBytes(size_t bytes) {
+    bytes = alignUp(bytes);
+    if (used + bytes > capacity) {
+        return nullptr;
+    }
+    void *block = memory + used;
+    std::memset(block, 0, bytes);
+    used += bytes;
+    return block;
+}
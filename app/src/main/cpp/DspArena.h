@@ -0,0 +1,58 @@
+#ifndef DSP_ARENA_H
+#define DSP_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * DspArena - One aligned block for all engine DSP buffers
+ *
+ * The engine reserves the arena once, sized for the highest supported
+ * sample rate and full polyphony, then carves every delay line out of it
+ * with a bump allocator. Each allocation starts on a cache line (which is
+ * also enough for any SIMD load), and consecutive allocations are laid
+ * out back to back in the order the voices are processed.
+ *
+ * reserve() and reset() invalidate earlier allocations, so they may only
+ * be called while the audio callback isn't running.
+ */
+class DspArena {
+public:
+    static constexpr size_t ALIGNMENT = 64;  // Cache line
+
+    DspArena() = default;
+    ~DspArena();
+    DspArena(const DspArena &) = delete;
+    DspArena &operator=(const DspArena &) = delete;
+
+    // Makes sure at least `bytes` are available; only grows. Returns false on OOM.
+    bool reserve(size_t bytes);
+    void reset() { used = 0; }
+
+    // Zeroed, ALIGNMENT-aligned storage for count elements (nullptr if exhausted)
+    template <typename T>
+    T *allocate(size_t count) {
+        return static_cast<T *>(allocateBytes(count * sizeof(T)));
+    }
+
+    // Bytes needed for count elements of T, including alignment padding
+    template <typename T>
+    static constexpr size_t bytesFor(size_t count) {
+        return alignUp(count * sizeof(T));
+    }
+
+    size_t getUsedBytes() const { return used; }
+    size_t getCapacityBytes() const { return capacity; }
+
+private:
+    static constexpr size_t alignUp(size_t bytes) {
+        return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+    void *allocateBytes(size_t bytes);
+
+    uint8_t *memory = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+};
+
+#endif // DSP_ARENA_H
@@ -0,0 +1,237 @@
+#include "DspCache.h"
+#include <android/log.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+
+#define LOG_TAG "DspCache"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr char MAGIC[4] = {'A', 'D', 'S', 'P'};
+constexpr size_t DATA_ALIGNMENT = 64;
+constexpr const char *FILE_PREFIX = "dsp-tables-";
+constexpr const char *FILE_SUFFIX = ".bin";
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t sampleRate;
+    uint32_t seed;
+    uint32_t layers;
+    uint32_t tableCount;
+};
+
+struct FileEntry {
+    uint64_t offset;  // Bytes from the start of the file
+    uint64_t length;  // Samples
+};
+
+size_t alignData(size_t bytes) {
+    return (bytes + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+}
+
+bool isCurrent(const FileHeader &header) {
+    return std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+           header.version == DspCache::VERSION &&
+           header.tableCount <= static_cast<uint32_t>(DspCache::MAX_TABLES);
+}
+
+bool writeAll(int fd, const void *data, size_t bytes) {
+    const auto *cursor = static_cast<const uint8_t *>(data);
+    while (bytes > 0) {
+        ssize_t written = ::write(fd, cursor, bytes);
+        if (written <= 0) {
+            return false;
+        }
+        cursor += written;
+        bytes -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+DspCache::~DspCache() {
+    close();
+}
+
+bool DspCache::open(const std::string &path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    const auto bytes = static_cast<size_t>(info.st_size);
+    void *memory = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        LOGE("Cannot map %s", path.c_str());
+        return false;
+    }
+    mapping = memory;
+    mappedBytes = bytes;
+
+    const auto *base = static_cast<const uint8_t *>(memory);
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    const size_t directoryEnd = sizeof(FileHeader) + header.tableCount * sizeof(FileEntry);
+    if (!isCurrent(header) || directoryEnd > bytes) {
+        LOGI("Ignoring stale DSP cache %s", path.c_str());
+        close();
+        return false;
+    }
+
+    tables.resize(header.tableCount);
+    for (uint32_t i = 0; i < header.tableCount; ++i) {
+        FileEntry entry;
+        std::memcpy(&entry, base + sizeof(FileHeader) + i * sizeof(FileEntry), sizeof(entry));
+        if (entry.offset % DATA_ALIGNMENT != 0 || entry.offset > bytes ||
+            entry.length > (bytes - entry.offset) / sizeof(float)) {
+            LOGE("Corrupt DSP cache %s (table %u)", path.c_str(), i);
+            close();
+            return false;
+        }
+        tables[i].data = reinterpret_cast<const float *>(base + entry.offset);
+        tables[i].length = static_cast<size_t>(entry.length);
+    }
+
+    key.sampleRate = header.sampleRate;
+    key.seed = header.seed;
+    key.layers = header.layers;
+
+    // The whole file is read right away by the caller
+    madvise(memory, bytes, MADV_WILLNEED);
+    return true;
+}
+
+void DspCache::close() {
+    if (mapping) {
+        munmap(mapping, mappedBytes);
+    }
+    mapping = nullptr;
+    mappedBytes = 0;
+    key = Key{};
+    tables.clear();
+}
+
+DspCache::Table DspCache::getTable(int index) const {
+    if (index < 0 || index >= getTableCount()) {
+        return {};
+    }
+    return tables[index];
+}
+
+bool DspCache::write(const std::string &path, const Key &key, const std::vector<Table> &tables) {
+    if (tables.size() > static_cast<size_t>(MAX_TABLES)) {
+        return false;
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.sampleRate = key.sampleRate;
+    header.seed = key.seed;
+    header.layers = key.layers;
+    header.tableCount = static_cast<uint32_t>(tables.size());
+
+    std::vector<FileEntry> entries(tables.size());
+    size_t offset = alignData(sizeof(FileHeader) + entries.size() * sizeof(FileEntry));
+    for (size_t i = 0; i < tables.size(); ++i) {
+        entries[i].offset = offset;
+        entries[i].length = tables[i].length;
+        offset = alignData(offset + tables[i].length * sizeof(float));
+    }
+
+    // Written next to the target and renamed over it once complete
+    const std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE("Cannot create %s", temporary.c_str());
+        return false;
+    }
+
+    static const uint8_t padding[DATA_ALIGNMENT] = {};
+    size_t position = sizeof(FileHeader) + entries.size() * sizeof(FileEntry);
+    bool ok = writeAll(fd, &header, sizeof(header)) &&
+              writeAll(fd, entries.data(), entries.size() * sizeof(FileEntry));
+    for (size_t i = 0; ok && i < tables.size(); ++i) {
+        ok = writeAll(fd, padding, entries[i].offset - position) &&
+             writeAll(fd, tables[i].data, tables[i].length * sizeof(float));
+        position = entries[i].offset + tables[i].length * sizeof(float);
+    }
+    ok = ok && fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to write DSP cache %s", path.c_str());
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string DspCache::pathFor(const std::string &directory, int sampleRate) {
+    return directory + "/" + FILE_PREFIX + std::to_string(sampleRate) + FILE_SUFFIX;
+}
+
+bool DspCache::readKey(const std::string &path, Key &key) {
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    FileHeader header;
+    const bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && isCurrent(header);
+    std::fclose(file);
+    if (!ok) {
+        return false;
+    }
+    key.sampleRate = header.sampleRate;
+    key.seed = header.seed;
+    key.layers = header.layers;
+    return true;
+}
+
+bool DspCache::findLatest(const std::string &directory, Key &key) {
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+
+    const size_t prefixLength = std::strlen(FILE_PREFIX);
+    const size_t suffixLength = std::strlen(FILE_SUFFIX);
+    bool found = false;
+    time_t newest = 0;
+    while (dirent *entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name.size() <= prefixLength + suffixLength ||
+            name.compare(0, prefixLength, FILE_PREFIX) != 0 ||
+            name.compare(name.size() - suffixLength, suffixLength, FILE_SUFFIX) != 0) {
+            continue;
+        }
+        const std::string path = directory + "/" + name;
+        struct stat info {};
+        Key candidate;
+        if (stat(path.c_str(), &info) != 0 || (found && info.st_mtime < newest) ||
+            !readKey(path, candidate)) {
+            continue;
+        }
+        key = candidate;
+        newest = info.st_mtime;
+        found = true;
+    }
+    closedir(dir);
+    return found;
+}
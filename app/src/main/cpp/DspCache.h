@@ -0,0 +1,72 @@
+#ifndef DSP_CACHE_H
+#define DSP_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * DspCache - Versioned on-disk cache of pre-computed DSP tables
+ *
+ * Tables that take tens of milliseconds to synthesize (the drum one-shots
+ * today) are written once per sample rate and memory-mapped on the next
+ * launch, so they are paged in instead of being rendered again. The file
+ * is a fixed header, a table directory and 64-byte-aligned float data:
+ *
+ *   Header | Entry[tableCount] | padding | table 0 | table 1 | ...
+ *
+ * A file is only used when its magic, VERSION and size check out; the key
+ * (sample rate, seed, layers) tells the caller what it was rendered with.
+ * Bump VERSION whenever the synthesis behind a table changes, otherwise old
+ * caches would keep playing the previous sound. Files are replaced with an
+ * atomic rename, so a crash while writing never leaves a torn cache behind.
+ */
+class DspCache {
+public:
+    static constexpr uint32_t VERSION = 2;
+    static constexpr int MAX_TABLES = 64;
+
+    struct Key {
+        uint32_t sampleRate = 0;
+        uint32_t seed = 0;
+        uint32_t layers = 0;
+    };
+
+    struct Table {
+        const float *data = nullptr;
+        size_t length = 0;  // Samples
+    };
+
+    DspCache() = default;
+    ~DspCache();
+    DspCache(const DspCache &) = delete;
+    DspCache &operator=(const DspCache &) = delete;
+
+    // Maps the file read-only and validates it; the tables stay valid until close()
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return mapping != nullptr; }
+
+    const Key &getKey() const { return key; }
+    int getTableCount() const { return static_cast<int>(tables.size()); }
+    Table getTable(int index) const;
+
+    static bool write(const std::string &path, const Key &key, const std::vector<Table> &tables);
+
+    // One file per sample rate in the cache directory
+    static std::string pathFor(const std::string &directory, int sampleRate);
+
+    // Key of the most recently written cache in the directory (header only)
+    static bool findLatest(const std::string &directory, Key &key);
+
+private:
+    static bool readKey(const std::string &path, Key &key);
+
+    void *mapping = nullptr;
+    size_t mappedBytes = 0;
+    Key key;
+    std::vector<Table> tables;
+};
+
+#endif // DSP_CACHE_H
@@ -0,0 +1,69 @@
+#ifndef DSP_UTILS_H
+#define DSP_UTILS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * DspUtils - Physical units to per-sample coefficients
+ *
+ * DSP code states its time constants in ms, Hz or dB/s and converts them
+ * here whenever the sample rate changes, so a voice sounds the same at
+ * 44.1, 48 or 96 kHz.
+ */
+namespace dsp {
+
+constexpr float PI = 3.14159265358979f;
+
+// Per-sample gain of an exponential decay falling dbPerSecond each second
+inline float decayGain(float dbPerSecond, float sampleRate) {
+    return std::pow(10.0f, -dbPerSecond / (20.0f * sampleRate));
+}
+
+// Per-sample factor that falls to 1/e after timeConstant seconds
+inline float timeConstantGain(float timeConstant, float sampleRate) {
+    return std::exp(-1.0f / (timeConstant * sampleRate));
+}
+
+// One-pole low-pass coefficient for state += coeff * (input - state)
+inline float onePoleCoefficient(float cutoffHz, float sampleRate) {
+    return 1.0f - std::exp(-2.0f * PI * cutoffHz / sampleRate);
+}
+
+inline int msToSamples(float milliseconds, float sampleRate) {
+    return std::max(1, static_cast<int>(std::lround(milliseconds * 0.001f * sampleRate)));
+}
+
+/**
+ * Uniform white noise in [-1, 1) from a 32-bit xorshift generator.
+ * 4 bytes of state (std::mt19937 needs 5 KB), so the voices stay compact.
+ */
+class NoiseGenerator {
+public:
+    explicit NoiseGenerator(uint32_t seed = 1u) { setSeed(seed); }
+
+    void setSeed(uint32_t seed) {
+        // Murmur3 finalizer: neighbouring seeds (seed + voice) give unrelated streams
+        seed ^= seed >> 16;
+        seed *= 0x85ebca6bu;
+        seed ^= seed >> 13;
+        seed *= 0xc2b2ae35u;
+        seed ^= seed >> 16;
+        state = seed != 0 ? seed : 0x9e3779b9u;  // xorshift must not start at 0
+    }
+
+    float next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<float>(static_cast<int32_t>(state)) * (1.0f / 2147483648.0f);
+    }
+
+private:
+    uint32_t state = 1u;
+};
+
+} // namespace dsp
+
+#endif // DSP_UTILS_H
@@ -0,0 +1,173 @@
+#include "DuplexInput.h"
+#include "WavReader.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "DuplexInput"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+DuplexInput::DuplexInput()
+        : block(CHUNK_FRAMES, 0.0f), interleaved(CHUNK_FRAMES * MAX_CHANNELS, 0.0f) {
+}
+
+bool DuplexInput::openStream(int sampleRate) {
+    closeStream();
+
+    // Unprocessed: no AGC or noise suppression bending the waveform the tracker reads
+    oboe::AudioStreamBuilder builder;
+    builder.setDirection(oboe::Direction::Input)
+           ->setPerformanceMode(oboe::PerformanceMode::LowLatency)
+           ->setSharingMode(oboe::SharingMode::Exclusive)
+           ->setFormat(oboe::AudioFormat::Float)
+           ->setChannelCount(oboe::ChannelCount::Mono)
+           ->setSampleRate(sampleRate)
+           ->setFormatConversionAllowed(true)
+           ->setChannelConversionAllowed(true)
+           ->setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Medium)
+           ->setInputPreset(oboe::InputPreset::Unprocessed);
+
+    oboe::Result result = builder.openStream(stream);
+    if (result != oboe::Result::OK) {
+        LOGE("Failed to open input stream: %s", oboe::convertToText(result));
+        stream.reset();
+        return false;
+    }
+
+    channels = stream->getChannelCount();
+    if (stream->getSampleRate() != sampleRate || channels < 1 || channels > MAX_CHANNELS) {
+        LOGE("Input stream mismatch: sampleRate=%d, channels=%d", stream->getSampleRate(), channels);
+        closeStream();
+        return false;
+    }
+
+    // Started before the output, so the first callbacks find data to drain
+    result = stream->requestStart();
+    if (result != oboe::Result::OK) {
+        LOGE("Failed to start input stream: %s", oboe::convertToText(result));
+        closeStream();
+        return false;
+    }
+    drainCallbacks = DRAIN_CALLBACKS;
+
+    LOGI("Input stream opened: sampleRate=%d, channels=%d, framesPerBurst=%d",
+         sampleRate, channels, stream->getFramesPerBurst());
+    return true;
+}
+
+void DuplexInput::closeStream() {
+    if (stream) {
+        stream->stop();
+        stream->close();
+        stream.reset();
+    }
+}
+
+bool DuplexInput::setFile(const char *path) {
+    if (path == nullptr) {
+        fileSource.clear();
+        fileSamples.clear();
+        fileRate = 0;
+        LOGI("Input file cleared");
+        return true;
+    }
+
+    std::vector<float> samples;
+    int rate = 0;
+    if (!WavReader::readMono(path, samples, rate) || samples.empty()) {
+        LOGE("Failed to load input file: %s", path);
+        return false;
+    }
+    fileSource = std::move(samples);
+    fileSourceRate = rate;
+    fileSamples.clear();
+    fileRate = 0;  // Resampled by prepare() at the stream rate
+    LOGI("Input file: %zu frames at %d Hz", fileSource.size(), rate);
+    return true;
+}
+
+void DuplexInput::prepare(int sampleRate) {
+    if (hasFile() && fileRate != sampleRate) {
+        resampleFile(sampleRate);
+    }
+    filePosition = 0;
+    tracker.setSampleRate(sampleRate);
+}
+
+// Linear interpolation is enough here: only the pitch has to survive, and it does exactly
+void DuplexInput::resampleFile(int sampleRate) {
+    const double step = static_cast<double>(fileSourceRate) / sampleRate;
+    const auto length = static_cast<size_t>(static_cast<double>(fileSource.size() - 1) / step) + 1;
+    fileSamples.resize(length);
+    for (size_t i = 0; i < length; ++i) {
+        const double position = static_cast<double>(i) * step;
+        const auto index = static_cast<size_t>(position);
+        const auto t = static_cast<float>(position - static_cast<double>(index));
+        const float next = index + 1 < fileSource.size() ? fileSource[index + 1] : fileSource[index];
+        fileSamples[i] = fileSource[index] + t * (next - fileSource[index]);
+    }
+    fileRate = sampleRate;
+}
+
+void DuplexInput::pull(int numFrames) {
+    // Start-up: throw away the backlog, the tracker hears silence meanwhile
+    bool draining = false;
+    if (!hasFile() && drainCallbacks > 0) {
+        --drainCallbacks;
+        draining = true;
+        for (int i = 0; i < MAX_DRAIN_READS; ++i) {
+            if (readDevice(block.data(), CHUNK_FRAMES) == 0) {
+                break;
+            }
+        }
+    }
+
+    int offset = 0;
+    while (offset < numFrames) {
+        const int frames = std::min(CHUNK_FRAMES, numFrames - offset);
+        int read = 0;
+        if (hasFile()) {
+            read = readFile(block.data(), frames);
+        } else if (!draining) {
+            read = readDevice(block.data(), frames);
+            if (read < frames) {
+                underruns.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        std::fill(block.begin() + read, block.begin() + frames, 0.0f);
+        tracker.process(block.data(), frames);
+        offset += frames;
+    }
+}
+
+int DuplexInput::readDevice(float *mono, int numFrames) {
+    if (!stream) {
+        return 0;
+    }
+    auto result = stream->read(channels == 1 ? mono : interleaved.data(), numFrames, 0);
+    if (!result) {
+        return 0;
+    }
+    const int frames = result.value();
+    if (channels > 1) {
+        const float scale = 1.0f / static_cast<float>(channels);
+        for (int i = 0; i < frames; ++i) {
+            float sum = 0.0f;
+            for (int c = 0; c < channels; ++c) {
+                sum += interleaved[i * channels + c];
+            }
+            mono[i] = sum * scale;
+        }
+    }
+    return frames;
+}
+
+// After the end of the file the input is silent
+int DuplexInput::readFile(float *mono, int numFrames) {
+    const size_t available = fileSamples.size() - std::min(filePosition, fileSamples.size());
+    const int frames = static_cast<int>(std::min(available, static_cast<size_t>(numFrames)));
+    std::copy_n(fileSamples.begin() + static_cast<std::ptrdiff_t>(filePosition), frames, mono);
+    filePosition += static_cast<size_t>(frames);
+    return frames;
+}
@@ -0,0 +1,77 @@
+#ifndef DUPLEX_INPUT_H
+#define DUPLEX_INPUT_H
+
+#include <oboe/Oboe.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "PitchTracker.h"
+
+/**
+ * DuplexInput - Instrument or microphone input read alongside the output
+ *
+ * The input stream is opened without a callback, at the output's sample
+ * rate, and read from inside the output callback with a zero timeout, the
+ * way Oboe's FullDuplexStream does it: the output callback is the only
+ * clock, so the two directions cannot drift apart. During the first
+ * DRAIN_CALLBACKS callbacks everything the input has buffered is
+ * discarded, so it starts with the smallest backlog the device allows.
+ * After that each callback reads exactly its own frame count; a short read
+ * (input glitch or disconnect) is padded with silence and counted.
+ *
+ * A WAV file can stand in for the device (setFile). It is resampled to the
+ * stream rate once, off the audio thread, and pulled through the same
+ * path one callback at a time - which is how the tracker is driven on a
+ * desktop build, with no input device at all.
+ *
+ * Every pulled block goes to a PitchTracker, whose estimate any thread
+ * can read without locking.
+ */
+class DuplexInput {
+public:
+    DuplexInput();
+
+    // Control thread, while the output callback is not running
+    bool openStream(int sampleRate);  // Opens and starts the device input
+    void closeStream();
+    bool setFile(const char *path);   // nullptr = back to the device
+    bool hasFile() const { return !fileSource.empty(); }
+    void prepare(int sampleRate);     // Resets the tracker (and rewinds the file) for a new stream
+
+    // Audio thread: reads numFrames of input and feeds the tracker
+    void pull(int numFrames);
+
+    // Any thread
+    PitchTracker::Estimate getPitch() const { return tracker.getEstimate(); }
+    uint64_t getUnderruns() const { return underruns.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int CHUNK_FRAMES = 1024;  // Read granularity, any callback size works
+    static constexpr int MAX_CHANNELS = 2;     // In case the device refuses mono
+    static constexpr int DRAIN_CALLBACKS = 20;
+    static constexpr int MAX_DRAIN_READS = 16;  // Chunks per drain, more than any input buffer
+
+    int readDevice(float *mono, int numFrames);
+    int readFile(float *mono, int numFrames);
+    void resampleFile(int sampleRate);
+
+    std::shared_ptr<oboe::AudioStream> stream;
+    int channels = 1;
+    int drainCallbacks = 0;
+
+    // File source at its own rate, and resampled to the stream rate
+    std::vector<float> fileSource;
+    int fileSourceRate = 0;
+    std::vector<float> fileSamples;
+    int fileRate = 0;
+    size_t filePosition = 0;
+
+    std::vector<float> block;       // CHUNK_FRAMES mono
+    std::vector<float> interleaved; // CHUNK_FRAMES * MAX_CHANNELS
+    std::atomic<uint64_t> underruns{0};
+
+    PitchTracker tracker;
+};
+
+#endif // DUPLEX_INPUT_H
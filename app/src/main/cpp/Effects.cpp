@@ -0,0 +1,196 @@
+#include "Effects.h"
+#include "DspUtils.h"
+#include <algorithm>
+#include <cstring>
+
+// ===========================================
+// WAH
+// ===========================================
+
+void WahEffect::setEnabled(bool enable) {
+    enabled = enable;
+    autoMode = true;  // Default to auto when enabling
+    if (!enable) {
+        bandpass1 = 0.0f;
+        bandpass2 = 0.0f;
+    }
+}
+
+void WahEffect::setPosition(float newPosition) {
+    position = std::clamp(newPosition, 0.0f, 1.0f);
+    autoMode = false;  // Switch to manual mode when position is set
+}
+
+void WahEffect::reset() {
+    lfoPhase = 0.0f;
+    bandpass1 = 0.0f;
+    bandpass2 = 0.0f;
+}
+
+void WahEffect::process(float *buffer, int numFrames) {
+    for (int i = 0; i < numFrames; ++i) {
+        buffer[i] = processSample(buffer[i]);
+    }
+}
+
+// ===========================================
+// AMP
+// ===========================================
+
+AmpEffect::AmpEffect() {
+    updateDrive();
+}
+
+void AmpEffect::setGain(float newGain) {
+    gain = std::clamp(newGain, 0.0f, 1.0f);
+    updateDrive();
+}
+
+void AmpEffect::setDistortion(float newDistortion) {
+    distortion = std::clamp(newDistortion, 0.0f, 1.0f);
+    updateDrive();
+}
+
+void AmpEffect::updateDrive() {
+    // Drive 15-30 scaled by the distortion knob
+    float drive = 15.0f + distortion * 15.0f;
+    effectiveDrive = drive * (0.5f + distortion * 1.5f);
+    secondStageGain = 2.0f + distortion * 2.0f;
+    outputLevel = 1.3f + gain * 0.7f;
+}
+
+void AmpEffect::process(float *buffer, int numFrames) const {
+    for (int i = 0; i < numFrames; ++i) {
+        buffer[i] = processSample(buffer[i]);
+    }
+}
+
+// ===========================================
+// CABINET
+// ===========================================
+
+void CabinetEffect::setSampleRate(float rate) {
+    highPassCoeff = dsp::onePoleCoefficient(HIGH_PASS_HZ, rate);
+
+    // RBJ low-pass, Q = 0.707 (Butterworth)
+    float w0 = 2.0f * static_cast<float>(M_PI) * LOW_PASS_HZ / rate;
+    float alpha = std::sin(w0) / (2.0f * 0.7071f);
+    float cosW0 = std::cos(w0);
+    float a0 = 1.0f + alpha;
+    b0 = (1.0f - cosW0) * 0.5f / a0;
+    b1 = (1.0f - cosW0) / a0;
+    b2 = b0;
+    a1 = -2.0f * cosW0 / a0;
+    a2 = (1.0f - alpha) / a0;
+
+    reset();
+}
+
+void CabinetEffect::reset() {
+    highPassState = 0.0f;
+    z1 = 0.0f;
+    z2 = 0.0f;
+}
+
+void CabinetEffect::process(float *buffer, int numFrames) {
+    for (int i = 0; i < numFrames; ++i) {
+        buffer[i] = processSample(buffer[i]);
+    }
+}
+
+// ===========================================
+// REVERB
+// ===========================================
+
+size_t ReverbEffect::storageBytes(float maxSampleRate, dsp::DelayFormat format) {
+    const size_t sampleBytes = dsp::delaySampleBytes(format);
+    size_t bytes = 0;
+    for (float delayMs : COMB_DELAYS_MS) {
+        bytes += DspArena::bytesFor<uint8_t>(dsp::msToSamples(delayMs, maxSampleRate) * sampleBytes);
+    }
+    return bytes;
+}
+
+void ReverbEffect::attachStorage(DspArena &arena, float maxSampleRate, dsp::DelayFormat storageFormat) {
+    const size_t sampleBytes = dsp::delaySampleBytes(storageFormat);
+    buffer1 = arena.allocate<uint8_t>(dsp::msToSamples(COMB_DELAYS_MS[0], maxSampleRate) * sampleBytes);
+    buffer2 = arena.allocate<uint8_t>(dsp::msToSamples(COMB_DELAYS_MS[1], maxSampleRate) * sampleBytes);
+    buffer3 = arena.allocate<uint8_t>(dsp::msToSamples(COMB_DELAYS_MS[2], maxSampleRate) * sampleBytes);
+    if (!buffer1 || !buffer2 || !buffer3) {
+        buffer1 = buffer2 = buffer3 = nullptr;
+        storageRate = 0.0f;
+        return;
+    }
+    format = storageFormat;
+    storageRate = maxSampleRate;
+    setSampleRate(sampleRate);
+}
+
+void ReverbEffect::setSampleRate(float rate) {
+    sampleRate = rate;
+    const float combRate = std::min(rate, storageRate);
+    length1 = dsp::msToSamples(COMB_DELAYS_MS[0], combRate);
+    length2 = dsp::msToSamples(COMB_DELAYS_MS[1], combRate);
+    length3 = dsp::msToSamples(COMB_DELAYS_MS[2], combRate);
+    reset();
+}
+
+void ReverbEffect::setAmount(float newAmount) {
+    amount = std::clamp(newAmount, 0.0f, 1.0f);
+}
+
+void ReverbEffect::setDensity(int combs) {
+    combs = std::clamp(combs, 1, MAX_COMBS);
+    // Re-enabled combs start empty instead of replaying a stale tail
+    if (combs > 1 && density <= 1) {
+        clearComb(buffer2, length2);
+    }
+    if (combs > 2 && density <= 2) {
+        clearComb(buffer3, length3);
+    }
+    density = combs;
+}
+
+void ReverbEffect::reset() {
+    if (!buffer1) {
+        return;
+    }
+    clearComb(buffer1, length1);
+    clearComb(buffer2, length2);
+    clearComb(buffer3, length3);
+    index1 = 0;
+    index2 = 0;
+    index3 = 0;
+}
+
+// All-zero bits are 0.0 in every delay format
+void ReverbEffect::clearComb(void *buffer, int length) {
+    if (buffer) {
+        std::memset(buffer, 0, static_cast<size_t>(length) * dsp::delaySampleBytes(format));
+    }
+}
+
+void ReverbEffect::process(float *buffer, int numFrames) {
+    if (!isEnabled()) {
+        return;
+    }
+    // Format dispatch once per block rather than per sample
+    switch (format) {
+        case dsp::DelayFormat::Half:
+            processBlock<dsp::HalfStorage>(buffer, numFrames);
+            break;
+        case dsp::DelayFormat::Fixed16:
+            processBlock<dsp::Fixed16Storage>(buffer, numFrames);
+            break;
+        default:
+            processBlock<dsp::FloatStorage>(buffer, numFrames);
+            break;
+    }
+}
+
+template <typename Codec>
+void ReverbEffect::processBlock(float *buffer, int numFrames) {
+    for (int i = 0; i < numFrames; ++i) {
+        buffer[i] = processCombs<Codec>(buffer[i]);
+    }
+}
@@ -0,0 +1,278 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include "DelayStorage.h"
+#include "DspArena.h"
+#include <array>
+#include <cmath>
+
+/**
+ * Effects - Guitar effect units shared by the voices and the insert bus
+ *
+ * Each unit keeps its own state and offers a per-sample processSample()
+ * (used inside Oscillator for per-voice placement) and a block process()
+ * (used by InsertChain on the engine bus).
+ */
+
+/**
+ * Wah Pedal Simulation (Dunlop Cry Baby)
+ * Classic wah is a bandpass filter with sweeping center frequency
+ * Q ~= 5-8, frequency range ~400Hz to ~2.2kHz
+ * Supports both auto-wah (LFO) and manual pedal control
+ */
+class WahEffect {
+public:
+    void setSampleRate(float rate) { sampleRate = rate; }
+    void setEnabled(bool enabled);
+    void setPosition(float position);  // 0.0 = heel down, 1.0 = toe down
+    bool isEnabled() const { return enabled; }
+    void reset();
+
+    inline float processSample(float input);
+    void process(float *buffer, int numFrames);
+
+private:
+    static constexpr float TWO_PI = 6.283185307179586f;
+
+    float sampleRate = 48000.0f;
+    bool enabled = false;
+    bool autoMode = true;       // true = auto-wah LFO, false = manual
+    float position = 0.5f;      // 0.0 heel, 1.0 toe (manual mode)
+    float lfoPhase = 0.0f;      // For auto-wah LFO
+    float bandpass1 = 0.0f;     // Bandpass filter state
+    float bandpass2 = 0.0f;     // Second stage
+};
+
+/**
+ * Heavy Distortion - Marshall/Mesa Boogie style tube amp simulation
+ * Drive and output level follow the guitar gain/distortion parameters.
+ */
+class AmpEffect {
+public:
+    AmpEffect();
+
+    void setGain(float gain);              // 0.0 to 1.0
+    void setDistortion(float distortion);  // 0.0 to 1.0
+
+    // Tube stages only (per-voice path adds presence/feedback afterwards)
+    inline float saturate(float input) const;
+    float getOutputLevel() const { return outputLevel; }
+
+    inline float processSample(float input) const { return saturate(input) * outputLevel; }
+    void process(float *buffer, int numFrames) const;
+
+private:
+    void updateDrive();
+
+    float gain = 0.7f;
+    float distortion = 0.7f;
+    float effectiveDrive = 0.0f;
+    float secondStageGain = 0.0f;
+    float outputLevel = 0.0f;
+};
+
+/**
+ * Speaker cabinet simulation: 4x12 style band limiting
+ * (high-pass for the closed-back low end, 2-pole low-pass for the cone roll-off)
+ */
+class CabinetEffect {
+public:
+    void setSampleRate(float rate);
+    void reset();
+
+    inline float processSample(float input);
+    void process(float *buffer, int numFrames);
+
+private:
+    static constexpr float HIGH_PASS_HZ = 90.0f;
+    static constexpr float LOW_PASS_HZ = 4500.0f;
+
+    float highPassCoeff = 0.0f;
+    float highPassState = 0.0f;
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;  // Biquad low-pass
+    float z1 = 0.0f, z2 = 0.0f;
+};
+
+/**
+ * Simple plate-style reverb using multiple comb filters
+ * The comb delay lines live in the engine's DspArena; until storage is
+ * attached the reverb passes its input through. The combs can be stored
+ * in a 16-bit format (see DelayStorage) to halve their memory traffic.
+ */
+class ReverbEffect {
+public:
+    static size_t storageBytes(float maxSampleRate, dsp::DelayFormat format = dsp::DelayFormat::Float32);
+    void attachStorage(DspArena &arena, float maxSampleRate,
+                       dsp::DelayFormat format = dsp::DelayFormat::Float32);
+
+    void setSampleRate(float sampleRate);  // Picks comb lengths, up to the attached capacity
+    void setAmount(float amount);  // 0.0 to 1.0
+    void setDensity(int combs);    // 1 to MAX_COMBS comb filters (quality tiers)
+    bool isEnabled() const { return amount >= 0.01f && buffer1 != nullptr; }
+    float getAmount() const { return amount; }
+    void reset();
+
+    inline float processSample(float input);
+    void process(float *buffer, int numFrames);
+
+private:
+    template <typename Codec>
+    inline float processCombs(float input);
+    template <typename Codec>
+    void processBlock(float *buffer, int numFrames);
+    void clearComb(void *buffer, int length);
+
+    static constexpr int MAX_COMBS = 3;
+    static constexpr std::array<float, MAX_COMBS> COMB_DELAYS_MS = {100.0f, 77.0f, 63.0f};
+
+    float sampleRate = 48000.0f;
+    float storageRate = 0.0f;   // Highest rate the attached buffers can hold
+    float amount = 0.3f;
+    int density = MAX_COMBS;
+    dsp::DelayFormat format = dsp::DelayFormat::Float32;
+    void *buffer1 = nullptr;  // Elements of the format's Storage type
+    void *buffer2 = nullptr;
+    void *buffer3 = nullptr;
+    int length1 = 0;
+    int length2 = 0;
+    int length3 = 0;
+    int index1 = 0;
+    int index2 = 0;
+    int index3 = 0;
+};
+
+// ===========================================
+// Inline per-sample kernels
+// ===========================================
+
+inline float WahEffect::processSample(float input) {
+    if (!enabled) return input;
+
+    float currentPosition;
+
+    if (autoMode) {
+        // Auto-wah: LFO sweeps the pedal position automatically
+        // Speed: about 3-4 Hz for classic wah-wah sound
+        lfoPhase += (TWO_PI * 3.5f) / sampleRate;
+        if (lfoPhase >= TWO_PI) lfoPhase -= TWO_PI;
+
+        // Sweep between heel (0) and toe (1) using sine LFO
+        currentPosition = 0.5f + 0.5f * std::sin(lfoPhase);
+    } else {
+        // Manual mode: use position directly (controlled by UI)
+        currentPosition = position;
+    }
+
+    // Wah frequency range: ~400 Hz (heel) to ~2200 Hz (toe)
+    // Using normalized frequency (0-1 range relative to sample rate)
+    float minFreq = 400.0f / sampleRate;
+    float maxFreq = 2200.0f / sampleRate;
+    float centerFreq = minFreq + currentPosition * (maxFreq - minFreq);
+
+    // Bandpass filter coefficients (state variable filter)
+    // High Q for that vocal "wah" character
+    float Q = 6.0f;  // High Q for narrow, vocal-like sweep
+    float f = 2.0f * std::sin(3.14159f * centerFreq);  // Filter frequency
+    float q = 1.0f / Q;
+
+    // State variable filter (bandpass output)
+    float hp = input - bandpass2 - q * bandpass1;
+    bandpass1 += f * hp;
+    bandpass2 += f * bandpass1;
+
+    // Bandpass output with resonance boost
+    float bandpass = bandpass1 * Q * 0.5f;
+
+    // Mix: mostly wah effect with some dry signal for clarity
+    float wet = 0.75f * bandpass + 0.25f * input;
+
+    // Slight saturation for warmth
+    wet = std::tanh(wet * 1.5f);
+
+    return wet;
+}
+
+inline float AmpEffect::saturate(float input) const {
+    // STAGE 1: Pre-amp gain
+    float x = input * effectiveDrive;
+
+    // STAGE 2: Tube-style asymmetric soft clipping
+    float stage1;
+    if (x > 0) {
+        stage1 = 1.0f - std::exp(-x * 1.5f);
+    } else {
+        stage1 = -1.0f + std::exp(x * 1.2f);
+    }
+
+    // STAGE 3: Second gain stage (cranked amp)
+    float stage2 = std::tanh(stage1 * secondStageGain);
+
+    // STAGE 4: Add odd harmonics for aggressive bite
+    float harmonics = stage2 + 0.3f * std::tanh(stage2 * 3.0f);
+
+    // Final saturation
+    return std::tanh(harmonics * 1.2f);
+}
+
+inline float CabinetEffect::processSample(float input) {
+    // One-pole high-pass
+    highPassState += highPassCoeff * (input - highPassState);
+    float x = input - highPassState;
+
+    // Biquad low-pass (transposed direct form II)
+    float y = b0 * x + z1;
+    z1 = b1 * x - a1 * y + z2;
+    z2 = b2 * x - a2 * y;
+    return y;
+}
+
+inline float ReverbEffect::processSample(float input) {
+    if (!isEnabled()) return input;
+
+    switch (format) {
+        case dsp::DelayFormat::Half:
+            return processCombs<dsp::HalfStorage>(input);
+        case dsp::DelayFormat::Fixed16:
+            return processCombs<dsp::Fixed16Storage>(input);
+        default:
+            return processCombs<dsp::FloatStorage>(input);
+    }
+}
+
+template <typename Codec>
+inline float ReverbEffect::processCombs(float input) {
+    auto *comb1 = static_cast<typename Codec::Storage *>(buffer1);
+    auto *comb2 = static_cast<typename Codec::Storage *>(buffer2);
+    auto *comb3 = static_cast<typename Codec::Storage *>(buffer3);
+
+    // Decay factor based on reverb amount
+    float decay = 0.3f + amount * 0.5f;
+
+    // Read from delay lines, write back with feedback and advance
+    float rev1 = Codec::load(comb1[index1]);
+    comb1[index1] = Codec::store(input + rev1 * decay);
+    if (++index1 == length1) index1 = 0;
+    float reverbSum = rev1;
+
+    // Lower quality tiers run fewer combs
+    if (density > 1) {
+        float rev2 = Codec::load(comb2[index2]);
+        comb2[index2] = Codec::store(input + rev2 * decay * 0.9f);
+        if (++index2 == length2) index2 = 0;
+        reverbSum += rev2;
+    }
+    if (density > 2) {
+        float rev3 = Codec::load(comb3[index3]);
+        comb3[index3] = Codec::store(input + rev3 * decay * 0.8f);
+        if (++index3 == length3) index3 = 0;
+        reverbSum += rev3;
+    }
+
+    // Mix reverb tails
+    float reverbMix = reverbSum / static_cast<float>(density);
+
+    // Mix dry/wet based on reverb amount
+    return input * (1.0f - amount * 0.5f) + reverbMix * amount;
+}
+
+#endif // EFFECTS_H
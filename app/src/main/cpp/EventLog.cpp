@@ -0,0 +1,78 @@
+#include "EventLog.h"
+#include <android/log.h>
+#include <cstring>
+
+#define LOG_TAG "EventLog"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+EventLogger::~EventLogger() {
+    stop();
+}
+
+bool EventLogger::start(const char *path, uint32_t sampleRate, uint32_t randomSeed,
+                        uint32_t blockFrames) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file != nullptr) {
+        return false;
+    }
+
+    file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        LOGE("Cannot open event log: %s", path);
+        return false;
+    }
+
+    EventLogHeader header{};
+    std::memcpy(header.magic, EVENT_LOG_MAGIC, sizeof(header.magic));
+    header.version = EVENT_LOG_VERSION;
+    header.sampleRate = sampleRate;
+    header.randomSeed = randomSeed;
+    header.blockFrames = blockFrames;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        LOGE("Cannot write event log header");
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    pending.clear();
+    pending.reserve(FLUSH_EVENTS);
+    eventCount = 0;
+    active.store(true, std::memory_order_relaxed);
+    LOGI("Event log started: %s (seed=%u)", path, randomSeed);
+    return true;
+}
+
+void EventLogger::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file == nullptr) {
+        return;
+    }
+
+    active.store(false, std::memory_order_relaxed);
+    flushLocked();
+    std::fclose(file);
+    file = nullptr;
+    LOGI("Event log stopped: %llu events", static_cast<unsigned long long>(eventCount));
+}
+
+void EventLogger::record(const PerformanceEvent &event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file == nullptr) {
+        return;
+    }
+
+    pending.push_back(event);
+    ++eventCount;
+    if (pending.size() >= FLUSH_EVENTS) {
+        flushLocked();
+    }
+}
+
+void EventLogger::flushLocked() {
+    if (!pending.empty()) {
+        std::fwrite(pending.data(), sizeof(PerformanceEvent), pending.size(), file);
+        pending.clear();
+    }
+}
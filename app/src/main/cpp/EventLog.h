@@ -0,0 +1,94 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+/**
+ * EventLog - Compact binary log of every control event sent to the engine
+ *
+ * File layout (little-endian, fixed-size records so the file can be
+ * memory-mapped and indexed directly):
+ *   EventLogHeader                 32 bytes
+ *   PerformanceEvent[eventCount]   32 bytes each
+ *
+ * Each event carries the sample frame at which the engine applied it,
+ * which is always the first frame of an audio callback, and a sequence
+ * number taken under the same lock. Control threads append to the file
+ * in whatever order they reach the logger, so readers order events by
+ * (frame, sequence), not by position.
+ */
+
+enum class EventType : uint16_t {
+    NoteOn = 1,        // voice, values[0] = frequency
+    NoteOff,           // voice
+    AllNotesOff,
+    PitchBend,         // voice, values[0] = semitones
+    WaveType,          // values[0] = JNI wave type
+    GuitarParams,      // values = sustain, gain, distortion, reverb
+    WahEnabled,        // values[0] = 0/1
+    WahPosition,       // values[0] = position
+    MasterVolume,      // values[0] = volume
+    DrumTrigger,       // values[0] = frequency, values[1] = velocity
+    EnvelopeCurve,     // values[0] = 0 lineare / 1 esponenziale
+    QualityTier,       // values[0] = QualityGovernor::Tier
+    InstrumentZone,    // voice = indice della zona (le successive vengono scartate),
+                       // values = tipo JNI, lowHz, highHz, livello
+    BendTarget,        // voice, values[0] = semitoni, values[1] = glide in ms
+    Unison,            // values = voci, detune in cent, mix
+    DrumPitchTracking  // values[0] = 0/1
+};
+
+struct EventLogHeader {
+    char magic[4];          // "ASEV"
+    uint32_t version;
+    uint32_t sampleRate;
+    uint32_t randomSeed;    // Seed of the voice/drum noise generators
+    uint32_t blockFrames;   // Callback size while logging (replay block size)
+    uint32_t reserved[3];
+};
+
+struct PerformanceEvent {
+    uint64_t frame;
+    EventType type;
+    int16_t voice;
+    uint32_t sequence;  // Application order from 1 per log (0 in older logs)
+    float values[4];
+};
+
+static_assert(sizeof(EventLogHeader) == 32, "EventLogHeader must stay 32 bytes");
+static_assert(sizeof(PerformanceEvent) == 32, "PerformanceEvent must stay 32 bytes");
+
+constexpr char EVENT_LOG_MAGIC[4] = {'A', 'S', 'E', 'V'};
+constexpr uint32_t EVENT_LOG_VERSION = 1;
+
+/**
+ * EventLogger - Appends events to a log file.
+ * Called from the control (UI) threads only, never from the audio callback.
+ */
+class EventLogger {
+public:
+    ~EventLogger();
+
+    bool start(const char *path, uint32_t sampleRate, uint32_t randomSeed, uint32_t blockFrames);
+    void stop();
+    bool isActive() const { return active.load(std::memory_order_relaxed); }
+
+    void record(const PerformanceEvent &event);
+
+private:
+    void flushLocked();
+
+    static constexpr size_t FLUSH_EVENTS = 2048;  // 64 KB per write
+
+    std::atomic<bool> active{false};
+    std::mutex mutex;
+    FILE *file = nullptr;
+    std::vector<PerformanceEvent> pending;
+    uint64_t eventCount = 0;
+};
+
+#endif // EVENT_LOG_H
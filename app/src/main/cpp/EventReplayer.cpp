@@ -0,0 +1,175 @@
+#include "EventReplayer.h"
+#include "AudioEngine.h"
+#include "WavWriter.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define LOG_TAG "EventReplayer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+EventReplayer::~EventReplayer() {
+    stopRealtime();
+    close();
+}
+
+bool EventReplayer::open(const char *path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        LOGE("Cannot open event log: %s", path);
+        return false;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(EventLogHeader))) {
+        LOGE("Event log too short: %s", path);
+        ::close(fd);
+        return false;
+    }
+
+    mappingSize = static_cast<size_t>(info.st_size);
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        LOGE("Cannot map event log: %s", path);
+        return false;
+    }
+
+    header = static_cast<const EventLogHeader *>(mapping);
+    if (std::memcmp(header->magic, EVENT_LOG_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != EVENT_LOG_VERSION || header->sampleRate == 0) {
+        LOGE("Not a valid event log: %s", path);
+        close();
+        return false;
+    }
+
+    events = reinterpret_cast<const PerformanceEvent *>(header + 1);
+    eventCount = (mappingSize - sizeof(EventLogHeader)) / sizeof(PerformanceEvent);
+
+    // Usually already in order, then the mapping is used as is
+    auto applied = [](const PerformanceEvent &a, const PerformanceEvent &b) {
+        return a.frame != b.frame ? a.frame < b.frame : a.sequence < b.sequence;
+    };
+    if (!std::is_sorted(events, events + eventCount, applied)) {
+        sortedEvents.assign(events, events + eventCount);
+        std::stable_sort(sortedEvents.begin(), sortedEvents.end(), applied);
+        events = sortedEvents.data();
+        LOGI("Event log reordered by application order");
+    }
+    LOGI("Event log opened: %zu events, %u Hz, seed=%u", eventCount,
+         header->sampleRate, header->randomSeed);
+    return true;
+}
+
+void EventReplayer::close() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    events = nullptr;
+    eventCount = 0;
+    sortedEvents.clear();
+}
+
+/**
+ * Events are applied before the block whose first frame they were logged
+ * at, exactly as the live callback saw them.
+ */
+bool EventReplayer::renderOffline(AudioEngine &engine, const char *wavPath, float tailSeconds) {
+    if (header == nullptr) {
+        return false;
+    }
+    if (!engine.prepareForReplay(static_cast<int>(header->sampleRate), header->randomSeed)) {
+        return false;
+    }
+
+    WavWriter writer;
+    if (!writer.open(wavPath, static_cast<int>(header->sampleRate), 1,
+                     WavWriter::SampleFormat::Float32)) {
+        LOGE("Cannot open replay output: %s", wavPath);
+        return false;
+    }
+
+    const int blockFrames = header->blockFrames > 0 ? static_cast<int>(header->blockFrames) : 256;
+    const uint64_t lastEventFrame = eventCount > 0 ? events[eventCount - 1].frame : 0;
+    const uint64_t endFrame = lastEventFrame +
+            static_cast<uint64_t>(tailSeconds * static_cast<float>(header->sampleRate));
+
+    std::vector<float> block(blockFrames);
+    size_t next = 0;
+    uint64_t frame = 0;
+    while (frame < endFrame) {
+        while (next < eventCount && events[next].frame <= frame) {
+            engine.applyEvent(events[next++]);
+        }
+
+        // Blocks also end at the next event, in case the live callback size varied
+        uint64_t blockEnd = std::min(frame + blockFrames, endFrame);
+        if (next < eventCount && events[next].frame < blockEnd) {
+            blockEnd = events[next].frame;
+        }
+        const int frames = static_cast<int>(blockEnd - frame);
+        engine.renderOffline(block.data(), frames);
+        writer.write(block.data(), frames);
+        frame = blockEnd;
+    }
+
+    bool ok = writer.close();
+    LOGI("Offline replay rendered %llu frames to %s",
+         static_cast<unsigned long long>(endFrame), wavPath);
+    return ok;
+}
+
+bool EventReplayer::startRealtime(AudioEngine &engine) {
+    if (header == nullptr || realtimeRunning.load()) {
+        return false;
+    }
+    if (realtimeThread.joinable()) {
+        realtimeThread.join();  // Previous replay ran to completion
+    }
+
+    realtimeRunning.store(true);
+    realtimeThread = std::thread(&EventReplayer::realtimeLoop, this, &engine);
+    return true;
+}
+
+void EventReplayer::stopRealtime() {
+    realtimeRunning.store(false);
+    if (realtimeThread.joinable()) {
+        realtimeThread.join();
+    }
+}
+
+void EventReplayer::realtimeLoop(AudioEngine *engine) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const double secondsPerFrame = 1.0 / header->sampleRate;
+
+    for (size_t i = 0; i < eventCount && realtimeRunning.load(); ++i) {
+        const auto due = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(events[i].frame * secondsPerFrame));
+
+        // Sleep in short slices so stopRealtime() stays responsive
+        while (realtimeRunning.load() && Clock::now() < due) {
+            auto remaining = due - Clock::now();
+            std::this_thread::sleep_for(std::min<Clock::duration>(
+                    remaining, std::chrono::milliseconds(20)));
+        }
+        if (realtimeRunning.load()) {
+            engine->applyEvent(events[i]);
+        }
+    }
+    realtimeRunning.store(false);
+}
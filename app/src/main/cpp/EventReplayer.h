@@ -0,0 +1,59 @@
+#ifndef EVENT_REPLAYER_H
+#define EVENT_REPLAYER_H
+
+#include "EventLog.h"
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+class AudioEngine;
+
+/**
+ * EventReplayer - Feeds a recorded event log back into the engine
+ *
+ * The log is memory-mapped read-only. Events from concurrent control
+ * threads can sit in the file out of order; if they do, a copy sorted by
+ * (frame, sequence) is replayed instead. Offline replay resets the engine to
+ * the logged sample rate and seed and renders the performance block by
+ * block with the logged callback size, reproducing the live output
+ * sample for sample. Real-time replay calls the engine API from a
+ * background thread at the logged times while the stream is running.
+ */
+class EventReplayer {
+public:
+    EventReplayer() = default;
+    ~EventReplayer();
+
+    EventReplayer(const EventReplayer &) = delete;
+    EventReplayer &operator=(const EventReplayer &) = delete;
+
+    bool open(const char *path);
+    void close();
+
+    const EventLogHeader *getHeader() const { return header; }
+    const PerformanceEvent *getEvents() const { return events; }
+    size_t getEventCount() const { return eventCount; }
+
+    // Renders the whole log (plus tailSeconds of release) to a WAV file
+    bool renderOffline(AudioEngine &engine, const char *wavPath, float tailSeconds = 2.0f);
+
+    // Plays the log against the running engine in real time
+    bool startRealtime(AudioEngine &engine);
+    void stopRealtime();
+
+private:
+    void realtimeLoop(AudioEngine *engine);
+
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+    const EventLogHeader *header = nullptr;
+    const PerformanceEvent *events = nullptr;  // Into the mapping, or into sortedEvents
+    size_t eventCount = 0;
+    std::vector<PerformanceEvent> sortedEvents;
+
+    std::thread realtimeThread;
+    std::atomic<bool> realtimeRunning{false};
+};
+
+#endif // EVENT_REPLAYER_H
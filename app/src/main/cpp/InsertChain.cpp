@@ -0,0 +1,184 @@
+#include "InsertChain.h"
+#include <algorithm>
+#include <cmath>
+
+InsertChain::InsertChain() {
+    cabinet.setSampleRate(sampleRate);
+    rebuildActiveList();
+}
+
+size_t InsertChain::storageBytes(float maxSampleRate, dsp::DelayFormat format) {
+    return ReverbEffect::storageBytes(maxSampleRate, format);
+}
+
+void InsertChain::attachStorage(DspArena &arena, float maxSampleRate, dsp::DelayFormat format) {
+    reverb.attachStorage(arena, maxSampleRate, format);
+}
+
+void InsertChain::setSampleRate(float rate) {
+    sampleRate = rate;
+    wah.setSampleRate(rate);
+    cabinet.setSampleRate(rate);
+    reverb.setSampleRate(rate);
+    reset();
+}
+
+void InsertChain::reset() {
+    wah.reset();
+    cabinet.reset();
+    reverb.reset();
+    if (cabinetImpulse) cabinetImpulse->reset();
+    if (roomImpulse) roomImpulse->reset();
+    tailFramesRemaining = 0;
+}
+
+bool InsertChain::setOrder(const int *slots, int count) {
+    if (count != NUM_SLOTS) {
+        return false;
+    }
+
+    std::array<bool, NUM_SLOTS> seen{};
+    std::array<Slot, NUM_SLOTS> newOrder{};
+    for (int i = 0; i < count; ++i) {
+        if (slots[i] < 0 || slots[i] >= NUM_SLOTS || seen[slots[i]]) {
+            return false;
+        }
+        seen[slots[i]] = true;
+        newOrder[i] = static_cast<Slot>(slots[i]);
+    }
+
+    order = newOrder;
+    rebuildActiveList();
+    return true;
+}
+
+void InsertChain::setBypass(Slot slot, bool bypass) {
+    bypassed[static_cast<int>(slot)] = bypass;
+    rebuildActiveList();
+}
+
+void InsertChain::rebuildActiveList() {
+    activeCount = 0;
+    preAmpCount = 0;
+    bool beforeAmp = true;
+    for (Slot slot : order) {
+        if (slot == Slot::Amp) {
+            beforeAmp = false;
+        } else if (!bypassed[static_cast<int>(slot)]) {
+            activeSlots[activeCount++] = slot;
+            preAmpCount += beforeAmp ? 1 : 0;
+        }
+    }
+    ampActive = !isBypassed(Slot::Amp);
+}
+
+std::unique_ptr<ConvolutionEngine> InsertChain::setImpulse(Slot slot, std::unique_ptr<ConvolutionEngine> engine) {
+    if (engine) {
+        engine->reset();
+        engine->setSynchronousTail(synchronousTail);
+    }
+    if (slot == Slot::Cabinet) {
+        std::swap(cabinetImpulse, engine);
+    } else if (slot == Slot::Reverb) {
+        std::swap(roomImpulse, engine);
+    }
+    return engine;
+}
+
+void InsertChain::setSynchronousTail(bool synchronous) {
+    synchronousTail = synchronous;
+    if (cabinetImpulse) cabinetImpulse->setSynchronousTail(synchronous);
+    if (roomImpulse) roomImpulse->setSynchronousTail(synchronous);
+}
+
+int InsertChain::tailLengthFrames() const {
+    int frames = static_cast<int>(FILTER_TAIL_SECONDS * sampleRate);
+    if (cabinetImpulse && !isBypassed(Slot::Cabinet)) {
+        frames = std::max(frames, cabinetImpulse->getLength());
+    }
+    bool reverbActive = !isBypassed(Slot::Reverb) && reverb.getAmount() >= 0.01f;
+    if (reverbActive && roomImpulse) {
+        frames = std::max(frames, roomImpulse->getLength());
+    } else if (reverbActive && reverb.isEnabled()) {
+        frames = std::max(frames, static_cast<int>(REVERB_TAIL_SECONDS * sampleRate));
+    }
+    return frames;
+}
+
+bool InsertChain::process(float *buffer, float *guitar, const float *guitarGain, const float *guitarClean,
+                          int numFrames, bool hasInput) {
+    if (hasInput) {
+        tailFramesRemaining = tailLengthFrames();
+    } else if (tailFramesRemaining > 0) {
+        tailFramesRemaining -= numFrames;
+    } else {
+        return false;
+    }
+
+    for (int i = 0; i < preAmpCount; ++i) {
+        processSlot(activeSlots[i], guitar, numFrames);
+    }
+    joinGuitar(buffer, guitar, guitarGain, guitarClean, numFrames);
+    for (int i = preAmpCount; i < activeCount; ++i) {
+        processSlot(activeSlots[i], buffer, numFrames);
+    }
+    return true;
+}
+
+void InsertChain::processSlot(Slot slot, float *buffer, int numFrames) {
+    switch (slot) {
+        case Slot::Wah:
+            wah.process(buffer, numFrames);
+            break;
+        case Slot::Amp:
+            break;  // Guitar only, see joinGuitar
+        case Slot::Cabinet:
+            if (cabinetImpulse) {
+                cabinetImpulse->process(buffer, buffer, numFrames);
+            } else {
+                cabinet.process(buffer, numFrames);
+            }
+            break;
+        case Slot::Reverb:
+            if (roomImpulse) {
+                processRoom(buffer, numFrames);
+            } else {
+                reverb.process(buffer, numFrames);
+            }
+            break;
+    }
+}
+
+// Amp with its output level, then the same final soft limiter as a per-voice
+// guitar, on the gain-normalised mix (see the class comment)
+void InsertChain::joinGuitar(float *buffer, const float *guitar, const float *guitarGain,
+                             const float *guitarClean, int numFrames) const {
+    const float outputLevel = amp.getOutputLevel();
+    for (int i = 0; i < numFrames; ++i) {
+        const float gain = guitarGain[i];
+        if (gain < MIN_GUITAR_GAIN) {
+            continue;
+        }
+        const float input = guitar[i] / gain;
+        const float clean = guitarClean[i] / gain;
+        const float amped = ampActive ? (amp.saturate(input) + clean) * outputLevel : input + clean;
+        buffer[i] += gain * std::tanh(amped);
+    }
+}
+
+// Same dry/wet law as ReverbEffect, with the room IR as the wet signal
+void InsertChain::processRoom(float *buffer, int numFrames) {
+    const float amount = reverb.getAmount();
+    if (amount < 0.01f) {
+        return;
+    }
+    const float dryGain = 1.0f - amount * 0.5f;
+    for (int offset = 0; offset < numFrames; offset += SCRATCH_FRAMES) {
+        const int count = std::min(SCRATCH_FRAMES, numFrames - offset);
+        float *block = buffer + offset;
+        roomImpulse->process(block, wetBuffer.data(), count);
+        for (int i = 0; i < count; ++i) {
+            block[i] = block[i] * dryGain + wetBuffer[i] * amount;
+        }
+    }
+}
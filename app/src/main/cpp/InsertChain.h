@@ -0,0 +1,117 @@
+#ifndef INSERT_CHAIN_H
+#define INSERT_CHAIN_H
+
+#include "ConvolutionEngine.h"
+#include "Effects.h"
+#include <array>
+#include <memory>
+
+/**
+ * InsertChain - Block-processed insert effects on the engine bus
+ *
+ * Runs a single wah -> amp -> cabinet -> reverb chain (order configurable)
+ * over the summed output of every voice routed to the bus, instead of one
+ * copy of each effect per voice. Bypassed slots are dropped from the
+ * active list, so they cost nothing in the callback.
+ *
+ * Only guitar voices go through the amp. They reach the chain in a buffer of
+ * their own: slots ordered before the amp run on it alone (pedals in front of
+ * the amp), then the amp output is level-matched, soft-limited as in the
+ * per-voice kernel and joined with the rest of the bus, and the slots after
+ * the amp run on the whole mix.
+ *
+ * A per-voice guitar applies its envelope and amplitude after the amp, so a
+ * note fades out instead of being held up by the distortion, and adds its
+ * presence and feedback after the tubes. On the bus the voices send those
+ * gains and clean parts (weighted by gain) in two more buffers: the amp is
+ * driven by the guitar mix divided by the summed gain and its output is
+ * scaled by it, which for a single line is the per-voice amp exactly.
+ *
+ * The cabinet slot starts bypassed: per-voice guitars have no cabinet, so a
+ * guitar moved to the bus keeps its tone until the cabinet is switched on.
+ *
+ * The cabinet and reverb slots can instead run a convolution with a loaded
+ * impulse response (speaker cabinet, room). The reverb keeps its dry/wet
+ * law and amount; the cabinet IR replaces the filter entirely.
+ */
+class InsertChain {
+public:
+    enum class Slot {
+        Wah,
+        Amp,
+        Cabinet,
+        Reverb
+    };
+    static constexpr int NUM_SLOTS = 4;
+
+    InsertChain();
+
+    // Reverb delay lines come from the engine arena
+    static size_t storageBytes(float maxSampleRate, dsp::DelayFormat format);
+    void attachStorage(DspArena &arena, float maxSampleRate, dsp::DelayFormat format);
+
+    void setSampleRate(float sampleRate);
+    void reset();
+
+    // Reorders the slots; every slot must appear exactly once
+    bool setOrder(const int *slots, int count);
+    void setBypass(Slot slot, bool bypass);
+    bool isBypassed(Slot slot) const { return bypassed[static_cast<int>(slot)]; }
+
+    WahEffect &getWah() { return wah; }
+    AmpEffect &getAmp() { return amp; }
+    ReverbEffect &getReverb() { return reverb; }
+
+    // Installs an IR engine for Slot::Cabinet or Slot::Reverb (nullptr = built-in
+    // effect). Returns the previous engine so it can be destroyed outside the lock.
+    std::unique_ptr<ConvolutionEngine> setImpulse(Slot slot, std::unique_ptr<ConvolutionEngine> engine);
+    void setSynchronousTail(bool synchronous);  // Offline rendering
+
+    /**
+     * Processes the bus in place.
+     * @param guitar guitar voices on the bus (pre-amp signal), consumed
+     * @param guitarGain summed envelope x amplitude of those voices
+     * @param guitarClean their presence and feedback (Oscillator::AmpSends)
+     * @param hasInput true if any voice wrote into the bus this block
+     * @return false if the chain was idle (no input and no tail) and the
+     *         buffer was left untouched
+     */
+    bool process(float *buffer, float *guitar, const float *guitarGain, const float *guitarClean,
+                 int numFrames, bool hasInput);
+    bool isTailActive() const { return tailFramesRemaining > 0; }
+
+private:
+    void rebuildActiveList();
+    void processSlot(Slot slot, float *buffer, int numFrames);
+    void joinGuitar(float *buffer, const float *guitar, const float *guitarGain, const float *guitarClean,
+                    int numFrames) const;
+    void processRoom(float *buffer, int numFrames);
+    int tailLengthFrames() const;
+
+    static constexpr float REVERB_TAIL_SECONDS = 3.5f;  // Comb feedback down ~60 dB
+    static constexpr float FILTER_TAIL_SECONDS = 0.05f;
+    static constexpr int SCRATCH_FRAMES = 256;
+    static constexpr float MIN_GUITAR_GAIN = 1e-6f;  // Below this the guitars are silent
+
+    WahEffect wah;
+    AmpEffect amp;
+    CabinetEffect cabinet;
+    ReverbEffect reverb;
+    std::unique_ptr<ConvolutionEngine> cabinetImpulse;
+    std::unique_ptr<ConvolutionEngine> roomImpulse;
+    std::array<float, SCRATCH_FRAMES> wetBuffer{};
+    bool synchronousTail = false;
+
+    std::array<Slot, NUM_SLOTS> order = {Slot::Wah, Slot::Amp, Slot::Cabinet, Slot::Reverb};
+    // Wah follows the pedal switch, the cabinet is opt-in (see above)
+    std::array<bool, NUM_SLOTS> bypassed = {true, false, true, false};
+    std::array<Slot, NUM_SLOTS> activeSlots{};  // Without the amp, see joinGuitar
+    int activeCount = 0;
+    int preAmpCount = 0;  // Leading active slots that run on the guitar alone
+    bool ampActive = true;
+
+    float sampleRate = 48000.0f;
+    int tailFramesRemaining = 0;
+};
+
+#endif // INSERT_CHAIN_H
@@ -0,0 +1,214 @@
+#include "LatencyTracer.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+#define LOG_TAG "LatencyTracer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// Same clock as oboe::AudioStream::getTimestamp(CLOCK_MONOTONIC)
+int64_t LatencyTracer::nowNanos() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * Enabling clears the previous trace. Writers that were still appending
+ * when tracing was turned off may leave a stale record or two at the start.
+ */
+void LatencyTracer::setEnabled(bool enable) {
+    if (!enable) {
+        enabled.store(false, std::memory_order_release);
+        return;
+    }
+    if (!records) {
+        records = std::make_unique<Record[]>(CAPACITY);
+    } else {
+        for (uint32_t i = 0; i < CAPACITY; ++i) {
+            records[i].committed.store(0, std::memory_order_relaxed);
+        }
+    }
+    writeIndex.store(0, std::memory_order_relaxed);
+    nextEventId.store(1, std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_release);
+}
+
+uint32_t LatencyTracer::stampEntry(int voice) {
+    if (!isEnabled()) {
+        return 0;
+    }
+    const uint32_t id = nextEventId.fetch_add(1, std::memory_order_relaxed);
+    stamp(Stage::Entry, id, voice, nowNanos());
+    return id;
+}
+
+void LatencyTracer::stamp(Stage stage, uint32_t eventId, int voice, int64_t timeNs, int64_t valueNs) {
+    if (!isEnabled()) {
+        return;
+    }
+    const uint32_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    if (index >= CAPACITY) {
+        return;  // Full: the excess shows up in getDroppedRecords()
+    }
+    Record &record = records[index];
+    record.stage = stage;
+    record.voice = static_cast<int8_t>(voice);
+    record.frames = 0;
+    record.eventId = eventId;
+    record.timeNs = timeNs;
+    record.valueNs = valueNs;
+    record.committed.store(index + 1, std::memory_order_release);
+}
+
+void LatencyTracer::stampCallback(int64_t beginNs, int64_t endNs, int numFrames) {
+    if (!isEnabled()) {
+        return;
+    }
+    const uint32_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    if (index >= CAPACITY) {
+        return;
+    }
+    Record &record = records[index];
+    record.stage = Stage::Callback;
+    record.voice = -1;
+    record.frames = static_cast<uint16_t>(std::min(numFrames, 0xFFFF));
+    record.eventId = 0;
+    record.timeNs = beginNs;
+    record.valueNs = endNs - beginNs;
+    record.committed.store(index + 1, std::memory_order_release);
+}
+
+uint32_t LatencyTracer::getDroppedRecords() const {
+    const uint32_t written = writeIndex.load(std::memory_order_relaxed);
+    return written > CAPACITY ? written - CAPACITY : 0;
+}
+
+/**
+ * Callbacks become complete ("X") events on an "Audio callback" track.
+ * Each note becomes a nestable async span from API entry to presentation
+ * (or to its first sample when the presentation time is unknown), with
+ * instant markers at dequeue and first sample and the stage deltas in args.
+ */
+bool LatencyTracer::exportJson(const char *path) const {
+    if (!records) {
+        LOGE("No trace recorded");
+        return false;
+    }
+
+    struct Note {
+        int voice = -1;
+        int64_t entry = -1;
+        int64_t dequeue = -1;
+        int64_t firstSample = -1;
+        int64_t presentation = -1;
+    };
+    const uint32_t count = std::min(writeIndex.load(std::memory_order_acquire), CAPACITY);
+    std::vector<Note> notes(nextEventId.load(std::memory_order_relaxed));
+
+    int64_t base = INT64_MAX;
+    for (uint32_t i = 0; i < count; ++i) {
+        const Record &record = records[i];
+        if (record.committed.load(std::memory_order_acquire) != i + 1) {
+            continue;
+        }
+        base = std::min(base, record.timeNs);
+        if (record.stage == Stage::Callback || record.eventId >= notes.size()) {
+            continue;
+        }
+        Note &note = notes[record.eventId];
+        note.voice = record.voice;
+        switch (record.stage) {
+            case Stage::Entry:       note.entry = record.timeNs; break;
+            case Stage::Dequeue:     note.dequeue = record.timeNs; break;
+            case Stage::FirstSample:
+                note.firstSample = record.timeNs;
+                note.presentation = record.valueNs;
+                break;
+            default: break;
+        }
+    }
+    if (base == INT64_MAX) {
+        LOGE("Trace is empty");
+        return false;
+    }
+
+    FILE *file = std::fopen(path, "w");
+    if (!file) {
+        LOGE("Cannot open trace output: %s", path);
+        return false;
+    }
+    auto micros = [base](int64_t ns) { return static_cast<double>(ns - base) / 1000.0; };
+    auto millis = [](int64_t ns) { return static_cast<double>(ns) / 1e6; };
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"AudioEngine\"}},\n");
+    std::fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Audio callback\"}},\n");
+    std::fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"Touch to sound\"}}");
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const Record &record = records[i];
+        if (record.committed.load(std::memory_order_acquire) == i + 1 &&
+            record.stage == Stage::Callback) {
+            std::fprintf(file, ",\n{\"ph\":\"X\",\"name\":\"callback\",\"pid\":1,\"tid\":1,"
+                               "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frames\":%d}}",
+                         micros(record.timeNs), static_cast<double>(record.valueNs) / 1000.0,
+                         record.frames);
+        }
+    }
+
+    int complete = 0;
+    double totalMs = 0.0;
+    double worstMs = 0.0;
+    for (uint32_t id = 1; id < notes.size(); ++id) {
+        const Note &note = notes[id];
+        if (note.entry < 0) {
+            continue;
+        }
+        char name[16];
+        if (note.voice < 0) {
+            std::snprintf(name, sizeof(name), "drum");
+        } else {
+            std::snprintf(name, sizeof(name), "note %d", note.voice);
+        }
+        const int64_t end = note.presentation >= 0 ? note.presentation : note.firstSample;
+        std::fprintf(file, ",\n{\"ph\":\"b\",\"cat\":\"latency\",\"name\":\"%s\",\"id\":%u,"
+                           "\"pid\":1,\"tid\":2,\"ts\":%.3f,\"args\":{\"voice\":%d}}",
+                     name, id, micros(note.entry), note.voice);
+        if (note.dequeue >= 0) {
+            std::fprintf(file, ",\n{\"ph\":\"n\",\"cat\":\"latency\",\"name\":\"dequeue\",\"id\":%u,"
+                               "\"pid\":1,\"tid\":2,\"ts\":%.3f}", id, micros(note.dequeue));
+        }
+        if (note.firstSample >= 0) {
+            std::fprintf(file, ",\n{\"ph\":\"n\",\"cat\":\"latency\",\"name\":\"first sample\",\"id\":%u,"
+                               "\"pid\":1,\"tid\":2,\"ts\":%.3f}", id, micros(note.firstSample));
+        }
+        if (end >= 0) {
+            const double entryToDequeue = note.dequeue >= 0 ? millis(note.dequeue - note.entry) : -1.0;
+            const double entryToSample = note.firstSample >= 0 ? millis(note.firstSample - note.entry) : -1.0;
+            const double entryToPresentation = note.presentation >= 0 ? millis(note.presentation - note.entry) : -1.0;
+            std::fprintf(file, ",\n{\"ph\":\"e\",\"cat\":\"latency\",\"name\":\"%s\",\"id\":%u,"
+                               "\"pid\":1,\"tid\":2,\"ts\":%.3f,\"args\":{\"entry_to_dequeue_ms\":%.3f,"
+                               "\"entry_to_first_sample_ms\":%.3f,\"entry_to_presentation_ms\":%.3f}}",
+                         name, id, micros(end),
+                         entryToDequeue, entryToSample, entryToPresentation);
+            if (note.presentation >= 0) {
+                ++complete;
+                totalMs += entryToPresentation;
+                worstMs = std::max(worstMs, entryToPresentation);
+            }
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+
+    const bool ok = std::fclose(file) == 0;
+    if (complete > 0) {
+        LOGI("Touch-to-sound: %d notes, mean %.2f ms, worst %.2f ms",
+             complete, totalMs / complete, worstMs);
+    }
+    LOGI("Trace exported to %s (%u records, %u dropped)", path, count, getDroppedRecords());
+    return ok;
+}
@@ -0,0 +1,67 @@
+#ifndef LATENCY_TRACER_H
+#define LATENCY_TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * LatencyTracer - Touch-to-sound latency stamps and callback spans
+ *
+ * Every traced note gets an id and up to four stamps on CLOCK_MONOTONIC:
+ * entry into the engine API (right after JNI), the callback that first sees
+ * it, the wall time at which its first non-zero sample was written, and the
+ * presentation time of that sample, extrapolated from the stream's
+ * getTimestamp. Callback begin/end are recorded as spans.
+ *
+ * Records are appended to a preallocated buffer by any thread with a single
+ * fetch_add (no locks, no allocation). When the buffer is full, new records
+ * are dropped and counted. exportJson writes the Chrome trace-event format,
+ * which chrome://tracing and ui.perfetto.dev open directly.
+ */
+class LatencyTracer {
+public:
+    static constexpr uint32_t CAPACITY = 1 << 17;  // ~8 minutes of 4 ms callbacks
+
+    enum class Stage : uint8_t {
+        Callback,     // timeNs = begin, valueNs = duration
+        Entry,        // Engine API entry
+        Dequeue,      // Start of the first callback that renders the event
+        FirstSample   // timeNs = write time, valueNs = presentation (-1 = unknown)
+    };
+
+    LatencyTracer() = default;
+    LatencyTracer(const LatencyTracer &) = delete;
+    LatencyTracer &operator=(const LatencyTracer &) = delete;
+
+    // Control thread. Enabling starts a new trace (allocated on first use).
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled.load(std::memory_order_acquire); }
+    bool exportJson(const char *path) const;
+
+    // Any thread; return/accept 0 when tracing is off
+    uint32_t stampEntry(int voice);
+    void stamp(Stage stage, uint32_t eventId, int voice, int64_t timeNs, int64_t valueNs = 0);
+    void stampCallback(int64_t beginNs, int64_t endNs, int numFrames);
+
+    uint32_t getDroppedRecords() const;
+    static int64_t nowNanos();
+
+private:
+    struct Record {
+        std::atomic<uint32_t> committed{0};  // index + 1 once the fields are written
+        Stage stage = Stage::Callback;
+        int8_t voice = -1;                   // -1 = drum pad
+        uint16_t frames = 0;
+        uint32_t eventId = 0;
+        int64_t timeNs = 0;
+        int64_t valueNs = 0;
+    };
+
+    std::unique_ptr<Record[]> records;
+    std::atomic<uint32_t> writeIndex{0};
+    std::atomic<uint32_t> nextEventId{1};
+    std::atomic<bool> enabled{false};
+};
+
+#endif // LATENCY_TRACER_H
@@ -1,34 +1,79 @@
 #include "Oscillator.h"
+#include "DspUtils.h"
+#include "PolyBlep.h"
 #include <cmath>
 #include <algorithm>
 
-Oscillator::Oscillator() : rng(std::random_device{}()) {
+Oscillator::Oscillator() {
     envelope.setSampleRate(sampleRate);
-    
-    // Initialize reverb buffers
-    reverbBuffer1.resize(REVERB_BUFFER_SIZE, 0.0f);
-    reverbBuffer2.resize(static_cast<int>(REVERB_BUFFER_SIZE * 0.77f), 0.0f);
-    reverbBuffer3.resize(static_cast<int>(REVERB_BUFFER_SIZE * 0.63f), 0.0f);
+    updateCoefficients();
+}
+
+size_t Oscillator::storageBytes(float maxSampleRate, dsp::DelayFormat format) {
+    return ReverbEffect::storageBytes(maxSampleRate, format);
+}
+
+void Oscillator::attachStorage(DspArena &arena, float maxSampleRate, dsp::DelayFormat format) {
+    reverb.attachStorage(arena, maxSampleRate, format);
 }
 
 void Oscillator::setSampleRate(float rate) {
     sampleRate = rate;
+    gliding = false;
     envelope.setSampleRate(rate);
+    wah.setSampleRate(rate);
+    reverb.setSampleRate(rate);
     phaseIncrement = (TWO_PI * frequency) / sampleRate;
+    updateCoefficients();
+}
+
+void Oscillator::updateCoefficients() {
+    float cutoff = GUITAR_CUTOFF_MIN_HZ + guitarGain * (GUITAR_CUTOFF_MAX_HZ - GUITAR_CUTOFF_MIN_HZ);
+    guitarCutoffCoeff = dsp::onePoleCoefficient(cutoff, sampleRate);
+    float decay = GUITAR_DECAY_MAX_DB_S + guitarSustain * (GUITAR_DECAY_MIN_DB_S - GUITAR_DECAY_MAX_DB_S);
+    guitarEnergyDecay = dsp::decayGain(decay, sampleRate);
+    
+    bassCutoffCoeff = dsp::onePoleCoefficient(BASS_CUTOFF_HZ, sampleRate);
+    bassSmoothCoeff = dsp::onePoleCoefficient(BASS_SMOOTH_HZ, sampleRate);
+    bassEnergyDecay = dsp::decayGain(BASS_DECAY_DB_S, sampleRate);
+    
+    cymbalNoiseCoeff = dsp::onePoleCoefficient(CYMBAL_NOISE_CUTOFF_HZ, NOISE_REFERENCE_RATE);
+    noiseHoldStep = NOISE_REFERENCE_RATE / sampleRate;
+    for (int i = 0; i < NUM_DRUM_MODELS; ++i) {
+        drumDecayGain[i] = dsp::decayGain(DRUM_DECAY_DB_S[i], sampleRate);
+        drumPitchGain[i] = DRUM_PITCH_DROP_SECONDS[i] > 0.0f
+                ? dsp::timeConstantGain(DRUM_PITCH_DROP_SECONDS[i], sampleRate)
+                : 1.0f;
+    }
 }
 
 void Oscillator::setFrequency(float freq) {
+    gliding = false;
     baseFrequency = std::clamp(freq, 20.0f, 20000.0f);
     frequency = baseFrequency * std::pow(2.0f, pitchBendSemitones / 12.0f);
     phaseIncrement = (TWO_PI * frequency) / sampleRate;
 }
 
 void Oscillator::setPitchBend(float semitones) {
+    gliding = false;
     pitchBendSemitones = std::clamp(semitones, -12.0f, 12.0f);
     frequency = baseFrequency * std::pow(2.0f, pitchBendSemitones / 12.0f);
     phaseIncrement = (TWO_PI * frequency) / sampleRate;
 }
 
+void Oscillator::glidePitchBend(float semitones, float glideSeconds) {
+    const float startIncrement = phaseIncrement;
+    setPitchBend(semitones);
+    if (glideSeconds <= 0.0f || waveType == WaveType::Drums || !envelope.isActive()) {
+        return;
+    }
+    // frequency/pitchBendSemitones already hold the target; the increment catches up
+    targetIncrement = phaseIncrement;
+    phaseIncrement = startIncrement;
+    glideGain = dsp::timeConstantGain(glideSeconds, sampleRate);
+    gliding = true;
+}
+
 void Oscillator::setWaveType(WaveType type) {
     waveType = type;
 }
@@ -40,67 +85,73 @@ void Oscillator::setAmplitude(float amp) {
 // Guitar parameter setters
 void Oscillator::setGuitarSustain(float sustain) {
     guitarSustain = std::clamp(sustain, 0.0f, 1.0f);
+    updateCoefficients();
 }
 
 void Oscillator::setGuitarGain(float gain) {
     guitarGain = std::clamp(gain, 0.0f, 1.0f);
+    amp.setGain(guitarGain);
+    updateCoefficients();
 }
 
 void Oscillator::setGuitarDistortion(float distortion) {
-    guitarDistortion = std::clamp(distortion, 0.0f, 1.0f);
+    amp.setDistortion(distortion);
 }
 
-void Oscillator::setGuitarReverb(float reverb) {
-    guitarReverb = std::clamp(reverb, 0.0f, 1.0f);
+void Oscillator::setGuitarReverb(float amount) {
+    reverb.setAmount(amount);
 }
 
 // Wah pedal setters
 void Oscillator::setWahEnabled(bool enabled) {
-    wahEnabled = enabled;
-    wahAutoMode = true;  // Default to auto when enabling
-    if (!enabled) {
-        wahBandpass1 = 0.0f;
-        wahBandpass2 = 0.0f;
-    }
+    wah.setEnabled(enabled);
 }
 
 void Oscillator::setWahPosition(float position) {
-    wahPosition = std::clamp(position, 0.0f, 1.0f);
-    wahAutoMode = false;  // Switch to manual mode when position is set
+    wah.setPosition(position);
 }
 
-void Oscillator::initStringModel() {
-    // Only used for bass now (keeping for compatibility)
-    int delaySize = static_cast<int>(sampleRate / frequency);
-    if (delaySize < 2) delaySize = 2;
-    
-    delayLine.resize(delaySize);
-    
-    for (int i = 0; i < delaySize; i++) {
-        float env = std::sin(static_cast<float>(i) / delaySize * M_PI);
-        delayLine[i] = noiseDist(rng) * env;
-    }
-    
-    delayIndex = 0;
-    filterState = 0.0f;
-    filterState2 = 0.0f;
-    stringInitialized = true;
-    stringEnergy = 1.0f;
+void Oscillator::setBusInserts(bool enabled) {
+    busInserts = enabled;
+}
+
+void Oscillator::setReducedHarmonics(bool reduced) {
+    reducedHarmonics = reduced;
+}
+
+void Oscillator::setReverbDensity(int combs) {
+    reverb.setDensity(combs);
+}
+
+void Oscillator::setUnison(int voices, float detuneCents, float mix) {
+    unison.configure(voices, detuneCents, mix);
+}
+
+void Oscillator::setDrumVelocity(float velocity) {
+    drumVelocity = std::clamp(velocity, 0.0f, 1.0f);
+}
+
+void Oscillator::setRandomSeed(uint32_t seed) {
+    noiseSource.setSeed(seed);
 }
 
 void Oscillator::noteOn(float freq) {
-    setFrequency(freq);
     pitchBendSemitones = 0.0f;
+    setFrequency(freq);
     phase = 0.0f;
     filterState = 0.0f;
     filterState2 = 0.0f;
     stringEnergy = 1.0f;
-    stringInitialized = true;
     
     // Reset drum synthesis state
     drumPhase2 = 0.0f;
     drumDecay = 1.0f;
     drumNoiseLevel = 0.0f;
+    noiseHoldPhase = 1.0f;
+    
+    if (waveType == WaveType::Sawtooth && unison.getVoices() > 1) {
+        unison.randomizePhases(noiseSource);
+    }
     
     envelope.noteOn();
 }
@@ -111,8 +162,9 @@ void Oscillator::noteOff() {
 
 void Oscillator::reset() {
     phase = 0.0f;
+    gliding = false;
+    pitchBendSemitones = 0.0f;
     envelope.reset();
-    stringInitialized = false;
     stringEnergy = 1.0f;
     filterState = 0.0f;
     filterState2 = 0.0f;
@@ -121,127 +173,11 @@ void Oscillator::reset() {
     drumPhase2 = 0.0f;
     drumDecay = 1.0f;
     drumNoiseLevel = 0.0f;
+    noiseHoldPhase = 1.0f;
     
-    // Clear reverb buffers
-    std::fill(reverbBuffer1.begin(), reverbBuffer1.end(), 0.0f);
-    std::fill(reverbBuffer2.begin(), reverbBuffer2.end(), 0.0f);
-    std::fill(reverbBuffer3.begin(), reverbBuffer3.end(), 0.0f);
-}
-
-/**
- * Simple plate-style reverb using multiple comb filters
- */
-float Oscillator::applyReverb(float input) {
-    if (guitarReverb < 0.01f) return input;
-    
-    // Read from delay lines
-    float rev1 = reverbBuffer1[reverbIndex1];
-    float rev2 = reverbBuffer2[reverbIndex2];
-    float rev3 = reverbBuffer3[reverbIndex3];
-    
-    // Mix reverb tails
-    float reverbMix = (rev1 + rev2 + rev3) / 3.0f;
-    
-    // Decay factor based on reverb amount
-    float decay = 0.3f + guitarReverb * 0.5f;
-    
-    // Write to delay lines with feedback
-    reverbBuffer1[reverbIndex1] = input + rev1 * decay;
-    reverbBuffer2[reverbIndex2] = input + rev2 * decay * 0.9f;
-    reverbBuffer3[reverbIndex3] = input + rev3 * decay * 0.8f;
-    
-    // Advance indices
-    reverbIndex1 = (reverbIndex1 + 1) % reverbBuffer1.size();
-    reverbIndex2 = (reverbIndex2 + 1) % reverbBuffer2.size();
-    reverbIndex3 = (reverbIndex3 + 1) % reverbBuffer3.size();
-    
-    // Mix dry/wet based on reverb amount
-    return input * (1.0f - guitarReverb * 0.5f) + reverbMix * guitarReverb;
-}
-
-/**
- * Heavy Distortion - Marshall/Mesa Boogie style tube amp simulation
- * Now with configurable drive!
- */
-float Oscillator::applyDistortion(float input, float drive) {
-    // Scale drive by user parameter
-    float effectiveDrive = drive * (0.5f + guitarDistortion * 1.5f);
-    
-    // STAGE 1: Pre-amp gain
-    float x = input * effectiveDrive;
-    
-    // STAGE 2: Tube-style asymmetric soft clipping
-    float stage1;
-    if (x > 0) {
-        stage1 = 1.0f - std::exp(-x * 1.5f);
-    } else {
-        stage1 = -1.0f + std::exp(x * 1.2f);
-    }
-    
-    // STAGE 3: Second gain stage (cranked amp)
-    float stage2 = stage1 * (2.0f + guitarDistortion * 2.0f);
-    stage2 = std::tanh(stage2);
-    
-    // STAGE 4: Add odd harmonics for aggressive bite
-    float harmonics = stage2 + 0.3f * std::tanh(stage2 * 3.0f);
-    
-    // Final saturation
-    float output = std::tanh(harmonics * 1.2f);
-    
-    return output;
-}
-
-/**
- * Wah Pedal Simulation
- * Classic wah is a bandpass filter with sweeping center frequency
- * Q ~= 5-8, frequency range ~400Hz to ~2.2kHz
- * Supports both auto-wah (LFO) and manual pedal control
- */
-float Oscillator::applyWah(float input) {
-    if (!wahEnabled) return input;
-    
-    float currentPosition;
-    
-    if (wahAutoMode) {
-        // Auto-wah: LFO sweeps the pedal position automatically
-        // Speed: about 3-4 Hz for classic wah-wah sound
-        wahPhase += (TWO_PI * 3.5f) / sampleRate;
-        if (wahPhase >= TWO_PI) wahPhase -= TWO_PI;
-        
-        // Sweep between heel (0) and toe (1) using sine LFO
-        currentPosition = 0.5f + 0.5f * std::sin(wahPhase);
-    } else {
-        // Manual mode: use wahPosition directly (controlled by UI)
-        currentPosition = wahPosition;
-    }
-    
-    // Wah frequency range: ~400 Hz (heel) to ~2200 Hz (toe)
-    // Using normalized frequency (0-1 range relative to sample rate)
-    float minFreq = 400.0f / sampleRate;
-    float maxFreq = 2200.0f / sampleRate;
-    float centerFreq = minFreq + currentPosition * (maxFreq - minFreq);
-    
-    // Bandpass filter coefficients (state variable filter)
-    // High Q for that vocal "wah" character
-    float Q = 6.0f;  // High Q for narrow, vocal-like sweep
-    float f = 2.0f * std::sin(3.14159f * centerFreq);  // Filter frequency
-    float q = 1.0f / Q;
-    
-    // State variable filter (bandpass output)
-    float hp = input - wahBandpass2 - q * wahBandpass1;
-    wahBandpass1 += f * hp;
-    wahBandpass2 += f * wahBandpass1;
-    
-    // Bandpass output with resonance boost
-    float bandpass = wahBandpass1 * Q * 0.5f;
-    
-    // Mix: mostly wah effect with some dry signal for clarity
-    float wet = 0.75f * bandpass + 0.25f * input;
-    
-    // Slight saturation for warmth
-    wet = std::tanh(wet * 1.5f);
-    
-    return wet;
+    // Clear effect state
+    wah.reset();
+    reverb.reset();
 }
 
 /**
@@ -257,9 +193,11 @@ float Oscillator::generateHammondB3() const {
     sample += 1.0f * std::sin(phase * 2.0f);    // 4' - octave
     sample += 0.6f * std::sin(phase * 3.0f);    // 2⅔' - fifth above octave
     sample += 0.6f * std::sin(phase * 4.0f);    // 2' - 2 octaves
-    sample += 0.3f * std::sin(phase * 5.0f);    // 1⅗' - major 3rd
-    sample += 0.3f * std::sin(phase * 6.0f);    // 1⅓' - fifth
-    sample += 0.2f * std::sin(phase * 8.0f);    // 1' - 3 octaves
+    if (!reducedHarmonics) {
+        sample += 0.3f * std::sin(phase * 5.0f);    // 1⅗' - major 3rd
+        sample += 0.3f * std::sin(phase * 6.0f);    // 1⅓' - fifth
+        sample += 0.2f * std::sin(phase * 8.0f);    // 1' - 3 octaves
+    }
     
     // Normalize but keep LOUD
     sample /= 3.0f;
@@ -279,12 +217,16 @@ float Oscillator::generateElectricGuitar() {
     // OSCILLATOR BASE: Rich harmonics like pickups capture
     // ===========================================
     
+    // Band-limited: the distortion below would amplify any aliasing
+    const float cycle = phase * (1.0f / TWO_PI);
+    const float cycleIncrement = phaseIncrement * (1.0f / TWO_PI);
+    
     // Sawtooth base (humbucker character)
-    float saw = (phase / static_cast<float>(M_PI)) - 1.0f;
+    float saw = dsp::blepSaw(cycle, cycleIncrement);
     
     // Pulse for single-coil character
     float pulseWidth = 0.65f + 0.1f * std::sin(phase * 0.01f);  // Slight PWM
-    float pulse = phase < (M_PI * pulseWidth) ? 1.0f : -1.0f;
+    float pulse = dsp::blepPulse(cycle, cycleIncrement, 0.5f * pulseWidth);
     
     // Mix for rich harmonic content
     float oscillator = 0.6f * saw + 0.4f * pulse;
@@ -296,16 +238,18 @@ float Oscillator::generateElectricGuitar() {
     harmonics += 0.5f * std::sin(phase * 2.0f);   // Octave
     harmonics += 0.35f * std::sin(phase * 3.0f);  // Fifth
     harmonics += 0.25f * std::sin(phase * 4.0f);  // 2 octaves
-    harmonics += 0.15f * std::sin(phase * 5.0f);  // Major 3rd
-    harmonics += 0.1f * std::sin(phase * 6.0f);   // Added brightness
+    if (!reducedHarmonics) {
+        harmonics += 0.15f * std::sin(phase * 5.0f);  // Major 3rd
+        harmonics += 0.1f * std::sin(phase * 6.0f);   // Added brightness
+    }
     
     float raw = 0.65f * oscillator + 0.35f * harmonics;
     
     // ===========================================
     // PICKUP + FILTER
     // ===========================================
-    float cutoff = 0.6f + guitarGain * 0.2f;  // Brighter with more gain
-    filterState = filterState + cutoff * (raw - filterState);
+    // Brighter with more gain (cutoff follows guitarGain)
+    filterState = filterState + guitarCutoffCoeff * (raw - filterState);
     float pickupSignal = filterState;
     
     // Sub-harmonic warmth
@@ -318,9 +262,8 @@ float Oscillator::generateElectricGuitar() {
     // Pre-amp boost based on gain setting
     float preamp = pickupSignal * (2.0f + guitarGain * 3.0f);
     
-    // Distortion with user-controlled drive
-    float drive = 15.0f + guitarDistortion * 15.0f;  // 15-30 range
-    float distorted = applyDistortion(preamp, drive);
+    // Distortion with user-controlled drive (on the bus the amp runs after the mix)
+    float distorted = busInserts ? 0.0f : amp.saturate(preamp);
     
     // Presence/bite
     float presence = (0.15f + guitarGain * 0.15f) * (pickupSignal - filterState);
@@ -335,24 +278,30 @@ float Oscillator::generateElectricGuitar() {
     distorted += feedback;
     
     // Energy decay based on sustain setting (higher = slower decay)
-    float decayRate = 0.9995f + guitarSustain * 0.00045f;  // 0.9995 to 0.99995
     if (stringEnergy > (0.3f + guitarSustain * 0.4f)) {
-        stringEnergy *= decayRate;
+        stringEnergy *= guitarEnergyDecay;
     }
     // Minimum energy for sustain
     float minEnergy = 0.3f + guitarSustain * 0.5f;
     if (stringEnergy < minEnergy) stringEnergy = minEnergy;
     
+    // On the insert bus the amp (level and limiter included), wah and reverb run after the
+    // mix: the tubes get the pre-amp signal, presence and feedback join after them (AmpSends)
+    if (busInserts) {
+        ampClean = distorted;
+        return preamp;
+    }
+    
     // ===========================================
     // OUTPUT + WAH + REVERB
     // ===========================================
-    float output = distorted * (1.3f + guitarGain * 0.7f);
+    float output = distorted * amp.getOutputLevel();
     
     // Apply Wah effect (before reverb for classic sound)
-    output = applyWah(output);
+    output = wah.processSample(output);
     
     // Apply reverb
-    output = applyReverb(output);
+    output = reverb.processSample(output);
     
     // Final soft limiter
     output = std::tanh(output);
@@ -376,11 +325,14 @@ float Oscillator::generateElectricBass() {
     // Sub-octave for that chest-thumping low end
     float subOctave = 0.4f * std::sin(phase * 0.5f);
     
+    const float cycle = phase * (1.0f / TWO_PI);
+    const float cycleIncrement = phaseIncrement * (1.0f / TWO_PI);
+    
     // Slight sawtooth content for growl (like roundwound strings)
-    float saw = 0.3f * ((phase / static_cast<float>(M_PI)) - 1.0f);
+    float saw = 0.3f * dsp::blepSaw(cycle, cycleIncrement);
     
     // Square-ish component for punch (P-bass character)
-    float square = 0.2f * (phase < static_cast<float>(M_PI) ? 1.0f : -1.0f);
+    float square = 0.2f * dsp::blepPulse(cycle, cycleIncrement, 0.5f);
     
     // Mix - heavy on fundamental
     float oscillator = fundamental + subOctave + saw + square;
@@ -397,11 +349,11 @@ float Oscillator::generateElectricBass() {
     // ===========================================
     // TONE CONTROL: Deep low-pass for bass thump
     // ===========================================
-    float cutoff = 0.2f;  // Low cutoff = deep bass
-    filterState = filterState + cutoff * (raw - filterState);
+    // Low cutoff = deep bass
+    filterState = filterState + bassCutoffCoeff * (raw - filterState);
     
     // Second filter for extra smoothness
-    filterState2 = filterState2 + 0.15f * (filterState - filterState2);
+    filterState2 = filterState2 + bassSmoothCoeff * (filterState - filterState2);
     
     float bassSignal = filterState2;
     
@@ -424,7 +376,7 @@ float Oscillator::generateElectricBass() {
     amped *= (1.0f + attack);
     
     // Slow decay for sustained bass
-    stringEnergy *= 0.9998f;
+    stringEnergy *= bassEnergyDecay;
     if (stringEnergy < 0.7f) stringEnergy = 0.7f;  // High sustain minimum
     
     // ===========================================
@@ -449,48 +401,45 @@ float Oscillator::generateElectricBass() {
  */
 float Oscillator::generateDrum() {
     // Determine drum type based on frequency
+    // Pitch and amplitude decays come from DRUM_PITCH_DROP_SECONDS / DRUM_DECAY_DB_S
+    int model = 0;
     float drumType = 0.0f;  // 0 = kick, 1 = tom, 2 = snare, 3 = hihat
-    float pitchDecay = 0.0f;
     float noiseAmount = 0.0f;
     float fmAmount = 0.0f;
-    float decayRate = 0.0f;
     
     if (baseFrequency < 100.0f) {
-        // KICK DRUM
+        // KICK DRUM: pitch drops quickly, long decay
+        model = 0;
         drumType = 0.0f;
-        pitchDecay = 0.995f;     // Pitch drops quickly
         noiseAmount = 0.05f;     // Little noise
         fmAmount = 4.0f;         // Strong FM for punch
-        decayRate = 0.9995f;     // Long decay
     } else if (baseFrequency < 250.0f) {
         // TOM
+        model = 1;
         drumType = 1.0f;
-        pitchDecay = 0.998f;
         noiseAmount = 0.1f;
         fmAmount = 2.0f;
-        decayRate = 0.999f;
     } else if (baseFrequency < 350.0f) {
         // SNARE
+        model = 2;
         drumType = 2.0f;
-        pitchDecay = 0.99f;
         noiseAmount = 0.6f;      // Lots of noise (snare wires)
         fmAmount = 1.5f;
-        decayRate = 0.9985f;
     } else if (baseFrequency < 700.0f) {
-        // CRASH / RIDE CYMBALS (400-700 Hz range)
+        // CRASH / RIDE CYMBALS (400-700 Hz range): no pitch decay, long sustain
+        model = 3;
         drumType = 3.5f;
-        pitchDecay = 1.0f;       // No pitch decay
         noiseAmount = 0.85f;     // Mostly noise
         fmAmount = 0.8f;
-        decayRate = 0.9997f;     // Long sustain for cymbals
     } else {
-        // HI-HAT / OPEN HI-HAT (>700 Hz)
+        // HI-HAT / OPEN HI-HAT (>700 Hz): no pitch decay, medium decay
+        model = 4;
         drumType = 4.0f;
-        pitchDecay = 1.0f;       // No pitch decay
         noiseAmount = 0.9f;      // Mostly noise
         fmAmount = 0.5f;
-        decayRate = 0.9992f;     // Medium decay for hi-hat
     }
+    float pitchDecay = drumPitchGain[model];
+    float decayRate = drumDecayGain[model];
     
     // Apply amplitude decay
     drumDecay *= decayRate;
@@ -510,17 +459,21 @@ float Oscillator::generateDrum() {
         phaseIncrement *= pitchDecay;
     }
     
-    // Noise component
-    float noise = noiseDist(rng);
-    
-    // High-pass filter for hi-hat and cymbals
-    if (drumType > 3.0f) {
-        // Metallic hi-hat/cymbal with high-pass filtered noise
-        float prevNoise = drumNoiseLevel;
-        drumNoiseLevel = noise * 0.5f + prevNoise * 0.5f;
-        noise = noise - drumNoiseLevel;  // High-pass
-        noise *= 2.5f;  // Boost for audibility
+    // Noise component, drawn at NOISE_REFERENCE_RATE and held in between so
+    // its level and spectrum (and the soft clip below) don't depend on the rate
+    noiseHoldPhase += noiseHoldStep;
+    if (noiseHoldPhase >= 1.0f) {
+        noiseHoldPhase -= std::floor(noiseHoldPhase);
+        heldNoise = noiseSource.next();
+        
+        // High-pass filter for hi-hat and cymbals (runs on the noise clock)
+        if (drumType > 3.0f) {
+            // Metallic hi-hat/cymbal with high-pass filtered noise
+            drumNoiseLevel += cymbalNoiseCoeff * (heldNoise - drumNoiseLevel);
+            heldNoise = (heldNoise - drumNoiseLevel) * 2.5f;  // High-pass + boost for audibility
+        }
     }
+    float noise = heldNoise;
     
     // Mix FM and noise
     float output = carrier * (1.0f - noiseAmount) + noise * noiseAmount;
@@ -533,8 +486,8 @@ float Oscillator::generateDrum() {
         output *= 1.8f;  // Initial transient boost
     }
     
-    // Volume boost for drums - make them LOUD
-    output *= 2.5f;
+    // Volume boost for drums - make them LOUD (softer hits clip less)
+    output *= 2.5f * drumVelocity;
     
     // Soft clip
     output = std::tanh(output * 1.5f);
@@ -542,22 +495,40 @@ float Oscillator::generateDrum() {
     return output;
 }
 
+template <Oscillator::WaveType Type>
+inline float Oscillator::generate() {
+    if constexpr (Type == WaveType::Sine) {
+        return generateHammondB3();
+    } else if constexpr (Type == WaveType::Sawtooth) {
+        if (unison.getVoices() > 1) {
+            return unison.next(phaseIncrement * (1.0f / TWO_PI));
+        }
+        return dsp::blepSaw(phase * (1.0f / TWO_PI), phaseIncrement * (1.0f / TWO_PI));
+    } else if constexpr (Type == WaveType::Drums) {
+        return generateDrum();
+    } else if constexpr (Type == WaveType::Bass) {
+        return generateElectricBass();
+    } else {
+        return generateElectricGuitar();
+    }
+}
+
 float Oscillator::generateWave() {
     switch (waveType) {
         case WaveType::Sine:
-            return generateHammondB3();
+            return generate<WaveType::Sine>();
             
         case WaveType::Sawtooth:
-            return (phase / static_cast<float>(M_PI)) - 1.0f;
+            return generate<WaveType::Sawtooth>();
             
         case WaveType::Drums:
-            return generateDrum();
+            return generate<WaveType::Drums>();
             
         case WaveType::Bass:
-            return generateElectricBass();
+            return generate<WaveType::Bass>();
             
         case WaveType::Guitar:
-            return generateElectricGuitar();
+            return generate<WaveType::Guitar>();
             
         default:
             return 0.0f;
@@ -572,9 +543,12 @@ float Oscillator::getNextSample() {
     float sample = generateWave();
     
     // Apply ADSR envelope
-    float envelopeValue = envelope.getNextSample();
-    
-    if (waveType == WaveType::Guitar || waveType == WaveType::Bass) {
+    return renderSample(sample, envelope.getNextSample());
+}
+
+template <Oscillator::WaveType Type>
+inline float Oscillator::renderSampleAs(float sample, float envelopeValue) {
+    if constexpr (Type == WaveType::Guitar || Type == WaveType::Bass) {
         // String instruments have natural sustain, envelope mainly for note-off
         sample *= std::min(1.0f, envelopeValue * 1.5f);
     } else {
@@ -583,7 +557,16 @@ float Oscillator::getNextSample() {
     
     sample *= amplitude;
     
-    // Advance phase
+    // Advance phase (audio-rate glide toward a bend target)
+    if constexpr (Type != WaveType::Drums) {
+        if (gliding) {
+            phaseIncrement = targetIncrement + (phaseIncrement - targetIncrement) * glideGain;
+            if (std::fabs(phaseIncrement - targetIncrement) <= targetIncrement * GLIDE_SETTLE) {
+                phaseIncrement = targetIncrement;
+                gliding = false;
+            }
+        }
+    }
     phase += phaseIncrement;
     if (phase >= TWO_PI) {
         phase -= TWO_PI;
@@ -592,6 +575,77 @@ float Oscillator::getNextSample() {
     return sample;
 }
 
+template <Oscillator::WaveType Type>
+inline float Oscillator::gainAs(float envelopeValue) const {
+    if constexpr (Type == WaveType::Guitar || Type == WaveType::Bass) {
+        return std::min(1.0f, envelopeValue * 1.5f) * amplitude;
+    } else {
+        return envelopeValue * amplitude;
+    }
+}
+
+float Oscillator::renderSample(float sample, float envelopeValue) {
+    if (waveType == WaveType::Guitar || waveType == WaveType::Bass) {
+        return renderSampleAs<WaveType::Guitar>(sample, envelopeValue);
+    }
+    return renderSampleAs<WaveType::Sine>(sample, envelopeValue);
+}
+
+void Oscillator::mixInto(float *output, int numFrames) {
+    switch (waveType) {
+        case WaveType::Sine:     mixIntoAs<WaveType::Sine>(output, numFrames); break;
+        case WaveType::Sawtooth: mixIntoAs<WaveType::Sawtooth>(output, numFrames); break;
+        case WaveType::Drums:    mixIntoAs<WaveType::Drums>(output, numFrames); break;
+        case WaveType::Bass:     mixIntoAs<WaveType::Bass>(output, numFrames); break;
+        case WaveType::Guitar:   mixIntoAs<WaveType::Guitar>(output, numFrames); break;
+    }
+}
+
+template <Oscillator::WaveType Type>
+void Oscillator::mixIntoAs(float *output, int numFrames, const AmpSends *sends) {
+    float gain[MAX_BLOCK_FRAMES];
+    
+    for (int offset = 0; offset < numFrames && envelope.isActive(); offset += MAX_BLOCK_FRAMES) {
+        // Envelope for the whole chunk first; stop at the sample where it goes idle
+        int count = envelope.process(gain, std::min(MAX_BLOCK_FRAMES, numFrames - offset));
+        float *out = output + offset;
+        if constexpr (Type == WaveType::Guitar) {
+            if (sends != nullptr) {
+                float *sendGain = sends->gain + offset;
+                float *sendClean = sends->clean + offset;
+                for (int i = 0; i < count; ++i) {
+                    out[i] += renderSampleAs<Type>(generate<Type>(), gain[i]);
+                    const float voiceGain = gainAs<Type>(gain[i]);
+                    sendGain[i] += voiceGain;
+                    sendClean[i] += ampClean * voiceGain;
+                }
+                continue;
+            }
+        }
+        if constexpr (Type == WaveType::Sawtooth) {
+            // Unison at a steady pitch: the whole chunk in one pass over the lanes
+            if (unison.getVoices() > 1 && !gliding) {
+                float wave[MAX_BLOCK_FRAMES];
+                unison.render(wave, count, phaseIncrement * (1.0f / TWO_PI));
+                for (int i = 0; i < count; ++i) {
+                    out[i] += renderSampleAs<Type>(wave[i], gain[i]);
+                }
+                continue;
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            out[i] += renderSampleAs<Type>(generate<Type>(), gain[i]);
+        }
+    }
+}
+
+// One kernel per instrument, called by the engine's type-batched mixer
+template void Oscillator::mixIntoAs<Oscillator::WaveType::Sine>(float *, int, const Oscillator::AmpSends *);
+template void Oscillator::mixIntoAs<Oscillator::WaveType::Sawtooth>(float *, int, const Oscillator::AmpSends *);
+template void Oscillator::mixIntoAs<Oscillator::WaveType::Drums>(float *, int, const Oscillator::AmpSends *);
+template void Oscillator::mixIntoAs<Oscillator::WaveType::Bass>(float *, int, const Oscillator::AmpSends *);
+template void Oscillator::mixIntoAs<Oscillator::WaveType::Guitar>(float *, int, const Oscillator::AmpSends *);
+
 bool Oscillator::isActive() const {
     return envelope.isActive();
 }
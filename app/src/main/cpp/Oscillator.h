@@ -2,14 +2,17 @@
 #define OSCILLATOR_H
 
 #include "ADSREnvelope.h"
-#include <vector>
-#include <random>
+#include "DspUtils.h"
+#include "Effects.h"
+#include "UnisonSaw.h"
+#include <array>
+#include <cstdint>
 
 /**
  * Oscillator - Generatore di forme d'onda
  * Supporta: Hammond B3, Synth Lead, Drums, Electric Bass, Electric Guitar (Distorted)
  */
-class Oscillator {
+class alignas(DspArena::ALIGNMENT) Oscillator {
 public:
     enum class WaveType {
         Sine,      // Hammond B3 style (additive synthesis with drawbars)
@@ -21,11 +24,18 @@ public:
 
     Oscillator();
     
+    // Delay-line memory from the engine arena (see DspArena)
+    static size_t storageBytes(float maxSampleRate, dsp::DelayFormat format);
+    void attachStorage(DspArena &arena, float maxSampleRate, dsp::DelayFormat format);
+    
     void setSampleRate(float sampleRate);
     void setFrequency(float frequency);
     void setWaveType(WaveType type);
     void setAmplitude(float amplitude);
     void setPitchBend(float semitones);  // Pitch bend in semitones (-2 to +2)
+    // Bend reached through an exponential glide, updated every sample
+    // (glideSeconds = time constant, 0 = jump like setPitchBend)
+    void glidePitchBend(float semitones, float glideSeconds);
     
     // Guitar parameters (0.0 to 1.0)
     void setGuitarSustain(float sustain);
@@ -37,28 +47,65 @@ public:
     void setWahEnabled(bool enabled);
     void setWahPosition(float position);  // 0.0 = heel down, 1.0 = toe down
     
+    // When true, amp/wah/reverb are skipped here and run once on the engine insert bus
+    void setBusInserts(bool enabled);
+    
+    // Guitars on the insert bus write their pre-amp signal to the output and
+    // send what the shared amp needs to treat each voice as the per-voice
+    // kernel would (see InsertChain::process), accumulated per sample
+    struct AmpSends {
+        float *gain = nullptr;   // Envelope x amplitude
+        float *clean = nullptr;  // Presence and feedback (after the tubes), times gain
+    };
+    
+    // Quality tiers (QualityGovernor): skip the upper organ drawbars / guitar
+    // overtones, and thin out the per-voice reverb
+    void setReducedHarmonics(bool reduced);
+    void setReverbDensity(int combs);
+    
+    // Synth lead unison (see UnisonSaw): 1-8 detuned saws per note
+    void setUnison(int voices, float detuneCents, float mix);
+    
+    // Drum hit strength (0.0 to 1.0), drives the pre-clip gain of generateDrum
+    void setDrumVelocity(float velocity);
+    
+    // Seeds the noise generator (deterministic rendering / replay)
+    void setRandomSeed(uint32_t seed);
+    
     void noteOn(float frequency);
     void noteOff();
     void reset();
     
     float getNextSample();
+    void mixInto(float *output, int numFrames);  // Adds numFrames samples to output
+    
+    // Same as mixInto with the instrument fixed at compile time (Type must be
+    // the current wave type): no per-sample dispatch, the generator inlines.
+    // The engine batches active voices by type and calls one kernel per group.
+    template <WaveType Type>
+    void mixIntoAs(float *output, int numFrames, const AmpSends *sends = nullptr);
     bool isActive() const;
+    WaveType getWaveType() const { return waveType; }
     
     // Accesso all'envelope per configurazione
     ADSREnvelope& getEnvelope() { return envelope; }
 
 private:
     float generateWave();
+    template <WaveType Type>
+    inline float generate();
+    float renderSample(float sample, float envelopeValue);  // Envelope, amplitude, phase advance
+    template <WaveType Type>
+    inline float renderSampleAs(float sample, float envelopeValue);
+    template <WaveType Type>
+    inline float gainAs(float envelopeValue) const;  // What renderSampleAs scales by
     float generateHammondB3() const;
     float generateElectricGuitar();
     float generateElectricBass();
     float generateDrum();  // Electronic drum synthesis
-    void initStringModel();
+    void updateCoefficients();  // Physical constants -> per-sample values
     
-    // Effects
-    float applyDistortion(float input, float drive);
-    float applyReverb(float input);
-    float applyWah(float input);  // Wah pedal effect
+    static constexpr int MAX_BLOCK_FRAMES = 256;  // Envelope gain chunk in mixInto
     
     float sampleRate = 48000.0f;
     float frequency = 440.0f;
@@ -68,48 +115,77 @@ private:
     float phaseIncrement = 0.0f;
     float amplitude = 0.8f;
     
+    // Bend glide: phaseIncrement approaches targetIncrement by glideGain per sample
+    static constexpr float GLIDE_SETTLE = 1.0e-4f;  // Relative error at which the glide ends (0.17 cent)
+    bool gliding = false;
+    float targetIncrement = 0.0f;
+    float glideGain = 0.0f;
+    
     WaveType waveType = WaveType::Sawtooth;
     ADSREnvelope envelope;
     
     // Guitar parameters (0.0 to 1.0, will be scaled internally)
     float guitarSustain = 0.7f;
     float guitarGain = 0.7f;
-    float guitarDistortion = 0.7f;
-    float guitarReverb = 0.3f;
-    
-    // Wah pedal state
-    bool wahEnabled = false;
-    bool wahAutoMode = true;       // true = auto-wah LFO, false = manual
-    float wahPosition = 0.5f;      // 0.0 heel, 1.0 toe (manual mode)
-    float wahPhase = 0.0f;         // For auto-wah LFO
-    float wahBandpass1 = 0.0f;     // Bandpass filter state
-    float wahBandpass2 = 0.0f;     // Second stage
-    
-    // Reverb delay lines (simple comb filter reverb)
-    static constexpr int REVERB_BUFFER_SIZE = 4800;  // 100ms at 48kHz
-    std::vector<float> reverbBuffer1;
-    std::vector<float> reverbBuffer2;
-    std::vector<float> reverbBuffer3;
-    int reverbIndex1 = 0;
-    int reverbIndex2 = 0;
-    int reverbIndex3 = 0;
-    
-    // String model delay line (for bass)
-    std::vector<float> delayLine;
-    int delayIndex = 0;
+    
+    // Time constants in physical units, converted by updateCoefficients()
+    static constexpr float GUITAR_CUTOFF_MIN_HZ = 7000.0f;     // Pickup low-pass at gain 0
+    static constexpr float GUITAR_CUTOFF_MAX_HZ = 12300.0f;    // ...at gain 1
+    static constexpr float GUITAR_DECAY_MAX_DB_S = 208.5f;     // String energy decay at sustain 0
+    static constexpr float GUITAR_DECAY_MIN_DB_S = 20.85f;     // ...at sustain 1
+    static constexpr float BASS_CUTOFF_HZ = 1705.0f;           // Tone low-pass
+    static constexpr float BASS_SMOOTH_HZ = 1240.0f;           // Second smoothing pole
+    static constexpr float BASS_DECAY_DB_S = 83.4f;            // Attack emphasis decay
+    static constexpr float CYMBAL_NOISE_CUTOFF_HZ = 5295.0f;   // Hi-hat/cymbal noise high-pass (noise clock)
+    static constexpr float NOISE_REFERENCE_RATE = 48000.0f;    // Rate the drum noise was voiced at
+    
+    // Per drum class: kick, tom, snare, cymbal, hi-hat
+    static constexpr int NUM_DRUM_MODELS = 5;
+    static constexpr std::array<float, NUM_DRUM_MODELS> DRUM_DECAY_DB_S = {
+        208.5f, 417.1f, 625.9f, 125.1f, 333.7f
+    };
+    static constexpr std::array<float, NUM_DRUM_MODELS> DRUM_PITCH_DROP_SECONDS = {
+        0.00416f, 0.0104f, 0.00207f, 0.0f, 0.0f  // Pitch time constant, 0 = fixed pitch
+    };
+    
+    // Per-sample values for the current sample rate
+    float guitarCutoffCoeff = 0.0f;
+    float guitarEnergyDecay = 1.0f;
+    float bassCutoffCoeff = 0.0f;
+    float bassSmoothCoeff = 0.0f;
+    float bassEnergyDecay = 1.0f;
+    float cymbalNoiseCoeff = 0.0f;
+    float noiseHoldStep = 1.0f;     // New noise values per output sample
+    std::array<float, NUM_DRUM_MODELS> drumDecayGain{};
+    std::array<float, NUM_DRUM_MODELS> drumPitchGain{};
+    
+    // Per-voice guitar effects (bypassed when the engine bus runs them)
+    AmpEffect amp;
+    WahEffect wah;
+    ReverbEffect reverb;
+    bool busInserts = false;
+    float ampClean = 0.0f;  // Presence + feedback of the last bus sample (AmpSends::clean)
+    bool reducedHarmonics = false;
+    
+    // Supersaw lanes (Sawtooth only, when more than one voice)
+    UnisonSaw unison;
+    
+    // String model state
     float filterState = 0.0f;
     float filterState2 = 0.0f;  // Second filter for bass
-    bool stringInitialized = false;
     float stringEnergy = 1.0f;  // Tracks remaining energy for sustain
     
     // Drum synthesis state
     float drumPhase2 = 0.0f;    // Second oscillator for FM
     float drumDecay = 1.0f;     // Amplitude decay
     float drumNoiseLevel = 0.0f;  // Noise component level
+    float drumVelocity = 1.0f;  // Hit strength (used when rendering velocity layers)
+    float noiseHoldPhase = 1.0f;  // Sample-and-hold clock for the drum noise
+    float heldNoise = 0.0f;
     
-    // Random generator
-    std::mt19937 rng;
-    std::uniform_real_distribution<float> noiseDist{-1.0f, 1.0f};
+    // Random generator (seeded explicitly so renders are reproducible)
+    static constexpr uint32_t DEFAULT_SEED = 5489u;
+    dsp::NoiseGenerator noiseSource{DEFAULT_SEED};
     
     static constexpr float TWO_PI = 6.283185307179586f;
 };
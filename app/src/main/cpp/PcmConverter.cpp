@@ -0,0 +1,111 @@
+#include "PcmConverter.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Two uniforms in [0, 1) LSB from the halves of one draw; their sum minus
+// one is triangular in (-1, 1) LSB
+constexpr float HALF_SCALE = 1.0f / 65536.0f;
+
+inline uint32_t xorshift(uint32_t x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+inline float scalarDither(uint32_t r) {
+    return static_cast<float>(r & 0xFFFF) * HALF_SCALE +
+           static_cast<float>(r >> 16) * HALF_SCALE - 1.0f;
+}
+
+}
+
+PcmConverter::PcmConverter() {
+    // Distinct non-zero seeds, so the lanes are uncorrelated from the first sample
+    state[0] = 0x9E3779B9u;
+    state[1] = 0x7F4A7C15u;
+    state[2] = 0x85EBCA6Bu;
+    state[3] = 0xC2B2AE35u;
+}
+
+void PcmConverter::process(float *samples, int16_t *pcm, int numFrames, float gain) {
+    int i = 0;
+#if defined(__aarch64__)
+    uint32x4_t s = vld1q_u32(state);
+    const float32x4_t g = vdupq_n_f32(gain);
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    const float32x4_t scale = vdupq_n_f32(PCM16_SCALE);
+    const float32x4_t half = vdupq_n_f32(HALF_SCALE);
+    const uint32x4_t mask = vdupq_n_u32(0xFFFF);
+    for (; i + 8 <= numFrames; i += 8) {
+        float32x4_t x0 = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(samples + i), g), lo), hi);
+        float32x4_t x1 = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(samples + i + 4), g), lo), hi);
+        vst1q_f32(samples + i, x0);
+        vst1q_f32(samples + i + 4, x1);
+
+        s = veorq_u32(s, vshlq_n_u32(s, 13));
+        s = veorq_u32(s, vshrq_n_u32(s, 17));
+        s = veorq_u32(s, vshlq_n_u32(s, 5));
+        float32x4_t d0 = vmulq_f32(vcvtq_f32_u32(vaddq_u32(vandq_u32(s, mask), vshrq_n_u32(s, 16))), half);
+        s = veorq_u32(s, vshlq_n_u32(s, 13));
+        s = veorq_u32(s, vshrq_n_u32(s, 17));
+        s = veorq_u32(s, vshlq_n_u32(s, 5));
+        float32x4_t d1 = vmulq_f32(vcvtq_f32_u32(vaddq_u32(vandq_u32(s, mask), vshrq_n_u32(s, 16))), half);
+
+        // Saturating narrow: full-scale plus dither clips instead of wrapping
+        int32x4_t q0 = vcvtnq_s32_f32(vaddq_f32(vfmaq_f32(d0, x0, scale), lo));
+        int32x4_t q1 = vcvtnq_s32_f32(vaddq_f32(vfmaq_f32(d1, x1, scale), lo));
+        vst1q_s16(pcm + i, vcombine_s16(vqmovn_s32(q0), vqmovn_s32(q1)));
+    }
+    vst1q_u32(state, s);
+#elif defined(__SSE2__)
+    __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(state));
+    const __m128 g = _mm_set1_ps(gain);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(PCM16_SCALE);
+    const __m128 half = _mm_set1_ps(HALF_SCALE);
+    const __m128i mask = _mm_set1_epi32(0xFFFF);
+    for (; i + 8 <= numFrames; i += 8) {
+        __m128 x0 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(samples + i), g), lo), hi);
+        __m128 x1 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(samples + i + 4), g), lo), hi);
+        _mm_storeu_ps(samples + i, x0);
+        _mm_storeu_ps(samples + i + 4, x1);
+
+        // Both halves are below 2^16, so the signed conversion is exact
+        s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+        s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+        s = _mm_xor_si128(s, _mm_slli_epi32(s, 5));
+        __m128 d0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_and_si128(s, mask),
+                                                             _mm_srli_epi32(s, 16))), half);
+        s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+        s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+        s = _mm_xor_si128(s, _mm_slli_epi32(s, 5));
+        __m128 d1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_and_si128(s, mask),
+                                                             _mm_srli_epi32(s, 16))), half);
+
+        // Round to nearest (default MXCSR), then narrow with signed saturation
+        __m128i q0 = _mm_cvtps_epi32(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, scale), d0), lo));
+        __m128i q1 = _mm_cvtps_epi32(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x1, scale), d1), lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pcm + i), _mm_packs_epi32(q0, q1));
+    }
+    _mm_store_si128(reinterpret_cast<__m128i *>(state), s);
+#endif
+    // Tail (and the whole buffer without SIMD), lane by lane like the vector loop
+    for (; i < numFrames; ++i) {
+        uint32_t &lane = state[i & 3];
+        lane = xorshift(lane);
+        const float x = std::clamp(samples[i] * gain, -1.0f, 1.0f);
+        samples[i] = x;
+        const float q = std::nearbyint(x * PCM16_SCALE + scalarDither(lane));
+        pcm[i] = static_cast<int16_t>(std::clamp(q, -32768.0f, 32767.0f));
+    }
+}
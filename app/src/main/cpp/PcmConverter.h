@@ -0,0 +1,33 @@
+#ifndef PCM_CONVERTER_H
+#define PCM_CONVERTER_H
+
+#include <cstdint>
+
+/**
+ * PcmConverter - Master gain, clip and float-to-int16 conversion in one pass
+ *
+ * For streams opened in the device's 16-bit format: the engine renders in
+ * float as usual and this replaces the master volume / clip loop, writing
+ * the int16 samples directly, so Oboe/AAudio needs no conversion stage of
+ * its own. The clipped float is written back for the recorder and meters.
+ *
+ * Requantization uses TPDF dither of +-1 LSB (the sum of two uniform
+ * values, both cut from one 32-bit xorshift draw per sample), so fades and
+ * release tails decay into benign noise instead of correlated distortion.
+ * Four lanes run side by side: NEON on arm64, SSE2 on x86-64 (emulator),
+ * and a scalar loop with the same lane layout elsewhere.
+ */
+class PcmConverter {
+public:
+    PcmConverter();
+
+    // samples: float mix (clipped in place); pcm: numFrames int16 output
+    void process(float *samples, int16_t *pcm, int numFrames, float gain);
+
+private:
+    static constexpr float PCM16_SCALE = 32767.0f;
+
+    alignas(16) uint32_t state[4];  // xorshift32 per lane, never zero
+};
+
+#endif // PCM_CONVERTER_H
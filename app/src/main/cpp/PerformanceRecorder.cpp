@@ -0,0 +1,112 @@
+#include "PerformanceRecorder.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstring>
+
+#define LOG_TAG "PerformanceRecorder"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+PerformanceRecorder::PerformanceRecorder() = default;
+
+PerformanceRecorder::~PerformanceRecorder() {
+    stop();
+}
+
+bool PerformanceRecorder::start(const char *path, int sampleRate, WavWriter::SampleFormat format) {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    if (recording.load()) {
+        return true;
+    }
+
+    if (!writer.open(path, sampleRate, 1, format)) {
+        LOGE("Cannot open recording file: %s", path);
+        return false;
+    }
+
+    readIndex.store(0);
+    writeIndex.store(0);
+    droppedBlocks.store(0);
+    recordedFrames.store(0);
+    writeFailed = false;
+
+    writerRunning.store(true);
+    writerThread = std::thread(&PerformanceRecorder::writerLoop, this);
+    recording.store(true, std::memory_order_release);
+
+    LOGI("Recording started: %s (%d Hz, %s)", path, sampleRate,
+         format == WavWriter::SampleFormat::Pcm16 ? "16-bit" : "float");
+    return true;
+}
+
+void PerformanceRecorder::stop() {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    if (!writerRunning.load()) {
+        return;
+    }
+
+    // Stop accepting blocks, then let the writer drain what is left
+    recording.store(false, std::memory_order_release);
+    writerRunning.store(false);
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+    writer.close();
+
+    LOGI("Recording stopped: %llu frames, %llu dropped blocks",
+         static_cast<unsigned long long>(recordedFrames.load()),
+         static_cast<unsigned long long>(droppedBlocks.load()));
+}
+
+void PerformanceRecorder::push(const float *samples, int numFrames) {
+    if (!recording.load(std::memory_order_acquire) || numFrames <= 0) {
+        return;
+    }
+
+    const uint32_t write = writeIndex.load(std::memory_order_relaxed);
+    const uint32_t read = readIndex.load(std::memory_order_acquire);
+    const auto frames = static_cast<uint32_t>(numFrames);
+    if (frames > RING_FRAMES - (write - read)) {
+        // Writer is behind: drop rather than wait
+        droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // At most two copies, split where the ring wraps
+    const uint32_t start = write & (RING_FRAMES - 1);
+    const uint32_t first = std::min(frames, RING_FRAMES - start);
+    std::memcpy(ring.data() + start, samples, first * sizeof(float));
+    std::memcpy(ring.data(), samples + first, (frames - first) * sizeof(float));
+    writeIndex.store(write + frames, std::memory_order_release);
+}
+
+void PerformanceRecorder::writerLoop() {
+    while (writerRunning.load()) {
+        if (!drain()) {
+            std::this_thread::sleep_for(WRITER_IDLE_SLEEP);
+        }
+    }
+    drain();
+}
+
+// Writes every available frame; returns false if the ring was empty
+bool PerformanceRecorder::drain() {
+    uint32_t read = readIndex.load(std::memory_order_relaxed);
+    const uint32_t write = writeIndex.load(std::memory_order_acquire);
+    if (read == write) {
+        return false;
+    }
+
+    while (read != write) {
+        const uint32_t start = read & (RING_FRAMES - 1);
+        const uint32_t frames = std::min(write - read, RING_FRAMES - start);
+        if (!writer.write(ring.data() + start, static_cast<int>(frames)) && !writeFailed) {
+            LOGE("Write failed, recording may be truncated");
+            writeFailed = true;
+        }
+        read += frames;
+        recordedFrames.fetch_add(frames, std::memory_order_relaxed);
+        readIndex.store(read, std::memory_order_release);
+    }
+    return true;
+}
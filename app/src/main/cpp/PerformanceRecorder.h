@@ -0,0 +1,61 @@
+#ifndef PERFORMANCE_RECORDER_H
+#define PERFORMANCE_RECORDER_H
+
+#include "WavWriter.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/**
+ * PerformanceRecorder - Non-blocking recorder for the master output
+ *
+ * The audio callback copies each block into a fixed single-producer /
+ * single-consumer ring of samples (no locks, no allocation, no I/O), so
+ * callbacks of any size fill it completely. A background writer thread
+ * drains the ring and streams it to a WAV file. If the writer falls
+ * behind, the callback's block is dropped whole and counted instead of
+ * blocking the callback. Memory use is constant regardless of session
+ * length.
+ */
+class PerformanceRecorder {
+public:
+    PerformanceRecorder();
+    ~PerformanceRecorder();
+
+    // Control thread only
+    bool start(const char *path, int sampleRate, WavWriter::SampleFormat format);
+    void stop();
+
+    // Audio thread: copies numFrames mono samples into the ring (all or nothing)
+    void push(const float *samples, int numFrames);
+
+    bool isRecording() const { return recording.load(std::memory_order_acquire); }
+    uint64_t getDroppedBlocks() const { return droppedBlocks.load(std::memory_order_relaxed); }
+    uint64_t getRecordedFrames() const { return recordedFrames.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t RING_FRAMES = 1u << 17;  // 2.7 s at 48 kHz, power of two
+    static constexpr auto WRITER_IDLE_SLEEP = std::chrono::milliseconds(10);
+
+    void writerLoop();
+    bool drain();
+
+    std::array<float, RING_FRAMES> ring;
+    std::atomic<uint32_t> writeIndex{0};  // Frames pushed, producer (audio thread)
+    std::atomic<uint32_t> readIndex{0};   // Frames written, consumer (writer thread)
+
+    std::atomic<bool> recording{false};
+    std::atomic<bool> writerRunning{false};
+    std::atomic<uint64_t> droppedBlocks{0};
+    std::atomic<uint64_t> recordedFrames{0};
+
+    std::mutex controlMutex;  // Serializes start/stop, never taken by the callback
+    std::thread writerThread;
+    WavWriter writer;
+    bool writeFailed = false;  // Writer thread only
+};
+
+#endif // PERFORMANCE_RECORDER_H
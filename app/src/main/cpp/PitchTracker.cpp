@@ -0,0 +1,189 @@
+#include "PitchTracker.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+inline uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bitsFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+}
+
+PitchTracker::PitchTracker()
+        : ring(WINDOW, 0.0f), frame(FFT_SIZE, 0.0f), re(FFT_SIZE / 2 + 1), im(FFT_SIZE / 2 + 1),
+          acf(FFT_SIZE), nsdf(WINDOW) {
+    fft.init(FFT_SIZE);
+    setSampleRate(48000);
+}
+
+void PitchTracker::setSampleRate(int sampleRate) {
+    const float rate = static_cast<float>(std::max(sampleRate, 8000));
+    decimation = std::max(1, static_cast<int>(std::lround(rate / TARGET_RATE)));
+    analysisRate = rate / static_cast<float>(decimation);
+    minLag = std::max(2, static_cast<int>(analysisRate / MAX_FREQUENCY));
+    maxLag = std::min(WINDOW - 2, static_cast<int>(std::ceil(analysisRate / MIN_FREQUENCY)));
+
+    // RBJ low-pass pair with the Q of a 4th-order Butterworth
+    const float cutoff = std::min(LOW_PASS_HZ, 0.4f * analysisRate);
+    const float w0 = 2.0f * static_cast<float>(M_PI) * cutoff / rate;
+    const float cosW0 = std::cos(w0);
+    const float q[2] = {0.5412f, 1.3066f};
+    for (int stage = 0; stage < 2; ++stage) {
+        const float alpha = std::sin(w0) / (2.0f * q[stage]);
+        const float a0 = 1.0f + alpha;
+        Biquad &filter = lowPass[stage];
+        filter.b0 = (1.0f - cosW0) * 0.5f / a0;
+        filter.b1 = (1.0f - cosW0) / a0;
+        filter.b2 = filter.b0;
+        filter.a1 = -2.0f * cosW0 / a0;
+        filter.a2 = (1.0f - alpha) / a0;
+    }
+
+    reset();
+}
+
+void PitchTracker::reset() {
+    for (Biquad &filter : lowPass) {
+        filter.z1 = 0.0f;
+        filter.z2 = 0.0f;
+    }
+    std::fill(ring.begin(), ring.end(), 0.0f);
+    writeIndex = 0;
+    decimationPhase = 0;
+    hopCount = 0;
+    framesIn = 0;
+    publish(0.0f, 0.0f);
+}
+
+void PitchTracker::process(const float *input, int numFrames) {
+    for (int i = 0; i < numFrames; ++i) {
+        const float filtered = lowPass[1].process(lowPass[0].process(input[i]));
+        if (++decimationPhase < decimation) {
+            continue;
+        }
+        decimationPhase = 0;
+        ring[writeIndex] = filtered;
+        writeIndex = (writeIndex + 1) & (WINDOW - 1);
+        ++hopCount;
+    }
+    framesIn += static_cast<uint64_t>(numFrames);
+
+    // One analysis of the newest window, however many hops the block held
+    if (hopCount >= HOP) {
+        hopCount = 0;
+        analyze();
+    }
+}
+
+void PitchTracker::analyze() {
+    // Oldest sample first; the mean is removed so DC does not bias the NSDF
+    float mean = 0.0f;
+    for (int j = 0; j < WINDOW; ++j) {
+        frame[j] = ring[(writeIndex + j) & (WINDOW - 1)];
+        mean += frame[j];
+    }
+    mean /= static_cast<float>(WINDOW);
+    float energy = 0.0f;
+    for (int j = 0; j < WINDOW; ++j) {
+        frame[j] -= mean;
+        energy += frame[j] * frame[j];
+    }
+    std::fill(frame.begin() + WINDOW, frame.end(), 0.0f);
+
+    if (energy < SILENCE_RMS * SILENCE_RMS * static_cast<float>(WINDOW)) {
+        publish(0.0f, 0.0f);
+        return;
+    }
+
+    // r(tau) from the power spectrum (inverse scaled by FFT_SIZE)
+    fft.forward(frame.data(), re.data(), im.data());
+    for (size_t k = 0; k < re.size(); ++k) {
+        re[k] = re[k] * re[k] + im[k] * im[k];
+        im[k] = 0.0f;
+    }
+    fft.inverse(re.data(), im.data(), acf.data());
+
+    // n(tau) = 2 r(tau) / m(tau), m(tau) = sum of x_j^2 + x_{j+tau}^2 over the overlap
+    const float scale = 1.0f / static_cast<float>(FFT_SIZE);
+    float m = 2.0f * energy;
+    nsdf[0] = 1.0f;
+    for (int tau = 1; tau <= maxLag + 1; ++tau) {
+        m -= frame[tau - 1] * frame[tau - 1] + frame[WINDOW - tau] * frame[WINDOW - tau];
+        nsdf[tau] = m > 0.0f ? 2.0f * acf[tau] * scale / m : 0.0f;
+    }
+
+    // Key maxima: the top of each positive lobe after the first zero crossing
+    int peaks[MAX_KEY_MAXIMA];
+    int peakCount = 0;
+    float highest = 0.0f;
+    int tau = 1;
+    while (tau <= maxLag && nsdf[tau] > 0.0f) {
+        ++tau;
+    }
+    while (tau <= maxLag && peakCount < MAX_KEY_MAXIMA) {
+        while (tau <= maxLag && nsdf[tau] <= 0.0f) {
+            ++tau;
+        }
+        int best = -1;
+        while (tau <= maxLag && nsdf[tau] > 0.0f) {
+            if (best < 0 || nsdf[tau] > nsdf[best]) {
+                best = tau;
+            }
+            ++tau;
+        }
+        if (best >= minLag) {
+            peaks[peakCount++] = best;
+            highest = std::max(highest, nsdf[best]);
+        }
+    }
+
+    int period = -1;
+    for (int p = 0; p < peakCount; ++p) {
+        if (nsdf[peaks[p]] >= PEAK_THRESHOLD * highest) {
+            period = peaks[p];
+            break;
+        }
+    }
+    if (period < 0) {
+        publish(0.0f, 0.0f);
+        return;
+    }
+
+    // Parabola through the peak and its neighbours
+    const float left = nsdf[period - 1];
+    const float centre = nsdf[period];
+    const float right = nsdf[period + 1];
+    const float curvature = left - 2.0f * centre + right;
+    float offset = 0.0f;
+    float height = centre;
+    if (curvature < 0.0f) {
+        offset = std::clamp(0.5f * (left - right) / curvature, -0.5f, 0.5f);
+        height = centre - 0.25f * (left - right) * offset;
+    }
+    publish(analysisRate / (static_cast<float>(period) + offset), std::clamp(height, 0.0f, 1.0f));
+}
+
+void PitchTracker::publish(float frequency, float confidence) {
+    estimateFrame.store(framesIn, std::memory_order_relaxed);
+    packed.store(static_cast<uint64_t>(floatBits(frequency)) << 32 | floatBits(confidence),
+                 std::memory_order_release);
+}
+
+PitchTracker::Estimate PitchTracker::getEstimate() const {
+    Estimate estimate;
+    const uint64_t value = packed.load(std::memory_order_acquire);
+    estimate.frequency = bitsFloat(static_cast<uint32_t>(value >> 32));
+    estimate.confidence = bitsFloat(static_cast<uint32_t>(value));
+    estimate.frame = estimateFrame.load(std::memory_order_relaxed);
+    return estimate;
+}
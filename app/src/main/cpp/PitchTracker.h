@@ -0,0 +1,104 @@
+#ifndef PITCH_TRACKER_H
+#define PITCH_TRACKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "RealFFT.h"
+
+/**
+ * PitchTracker - Streaming monophonic pitch detection for the input stream
+ *
+ * McLeod Pitch Method: the normalized square difference function (NSDF) of
+ * the latest window is scanned for key maxima (the highest point of each
+ * positive lobe), and the first one within PEAK_THRESHOLD of the highest
+ * gives the period, refined by parabolic interpolation. Its height (0..1)
+ * is the confidence: close to 1 for a steady string or vowel, low for
+ * noise and chords. The autocorrelation comes from RealFFT, zero-padded to
+ * twice the window, so an analysis costs two FFTs and a linear pass
+ * whatever the period.
+ *
+ * The input is low-passed and decimated to about TARGET_RATE first (the
+ * highest fundamental tracked is MAX_FREQUENCY), which keeps the window at
+ * WINDOW points - over two periods of the lowest note - at any stream rate.
+ *
+ * process() runs on the audio thread: samples go into a ring, and once a
+ * hop has accumulated the latest window is analysed, at most once per call.
+ * A long callback skips stale hops instead of analysing each of them, so
+ * the cost per block is bounded. The estimate is published as one 64-bit
+ * atomic (frequency and confidence together): readers never see a torn
+ * pair and neither side locks.
+ */
+class PitchTracker {
+public:
+    struct Estimate {
+        float frequency = 0.0f;   // Hz, 0 = no pitch (silence or no periodicity)
+        float confidence = 0.0f;  // NSDF peak, 0..1
+        uint64_t frame = 0;       // Input frames consumed when the window ended
+    };
+
+    PitchTracker();
+
+    // Control thread, while process() is not running
+    void setSampleRate(int sampleRate);
+    void reset();
+
+    // Audio thread
+    void process(const float *input, int numFrames);
+
+    // Any thread
+    Estimate getEstimate() const;
+
+private:
+    static constexpr int WINDOW = 1024;          // Decimated samples, power of two
+    static constexpr int FFT_SIZE = 2 * WINDOW;  // Linear (not circular) autocorrelation
+    static constexpr int HOP = 128;              // Decimated samples between analyses
+    static constexpr float TARGET_RATE = 24000.0f;
+    static constexpr float MIN_FREQUENCY = 60.0f;   // Below a drop-D low string
+    static constexpr float MAX_FREQUENCY = 1500.0f; // Top fret of the high E, soprano range
+    static constexpr float LOW_PASS_HZ = 5000.0f;
+    static constexpr float PEAK_THRESHOLD = 0.9f;
+    static constexpr float SILENCE_RMS = 1e-3f;     // -60 dBFS
+    static constexpr int MAX_KEY_MAXIMA = 64;
+
+    // Transposed direct form II, as CabinetEffect
+    struct Biquad {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+        float z1 = 0.0f, z2 = 0.0f;
+
+        float process(float x) {
+            const float y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    void analyze();
+    void publish(float frequency, float confidence);
+
+    int decimation = 2;
+    float analysisRate = TARGET_RATE;
+    int minLag = 16;
+    int maxLag = 400;
+    Biquad lowPass[2];  // 4th-order Butterworth before decimation
+
+    // Audio thread only
+    std::vector<float> ring;  // WINDOW decimated samples
+    int writeIndex = 0;
+    int decimationPhase = 0;
+    int hopCount = 0;
+    uint64_t framesIn = 0;
+
+    RealFFT fft;
+    std::vector<float> frame;  // FFT_SIZE: the window, then zero padding
+    std::vector<float> re, im;
+    std::vector<float> acf;
+    std::vector<float> nsdf;
+
+    std::atomic<uint64_t> packed{0};  // Frequency bits << 32 | confidence bits
+    std::atomic<uint64_t> estimateFrame{0};
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Estimate needs a lock-free 64-bit atomic");
+};
+
+#endif // PITCH_TRACKER_H
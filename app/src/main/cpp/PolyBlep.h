@@ -0,0 +1,50 @@
+#ifndef POLY_BLEP_H
+#define POLY_BLEP_H
+
+/**
+ * PolyBlep - Band-limited saw and pulse shared by the instruments
+ *
+ * A naive waveform computed from the phase has hard edges that fold
+ * harmonics above Nyquist back into the audible range, worst on high notes
+ * and made louder by the guitar's distortion. polyBLEP replaces the edge
+ * with a two-sample polynomial step, which removes most of the aliasing
+ * for a few flops and a rarely taken branch per sample - far cheaper than
+ * oversampling the voice.
+ *
+ * Phases are in cycles: t in [0, 1), dt = frequency / sample rate (< 0.5).
+ * The pulse width is read on every sample, so it can be modulated freely
+ * without resetting the phase.
+ */
+namespace dsp {
+
+// Residual of a unit step of height 2 at t = 0 (subtract it from a falling edge)
+inline float polyBlep(float t, float dt) {
+    if (t < dt) {
+        const float x = t / dt;
+        return x + x - x * x - 1.0f;
+    }
+    if (t > 1.0f - dt) {
+        const float x = (t - 1.0f) / dt;
+        return x * x + x + x + 1.0f;
+    }
+    return 0.0f;
+}
+
+inline float wrapPhase(float t) {
+    return t >= 1.0f ? t - 1.0f : (t < 0.0f ? t + 1.0f : t);
+}
+
+// Rising saw, -1 at t = 0 to +1 at t = 1
+inline float blepSaw(float t, float dt) {
+    return t + t - 1.0f - polyBlep(t, dt);
+}
+
+// +1 for t < width, -1 after; width in (0, 1)
+inline float blepPulse(float t, float dt, float width) {
+    const float naive = t < width ? 1.0f : -1.0f;
+    return naive + polyBlep(t, dt) - polyBlep(wrapPhase(t - width), dt);
+}
+
+} // namespace dsp
+
+#endif // POLY_BLEP_H
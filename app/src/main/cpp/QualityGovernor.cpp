@@ -0,0 +1,42 @@
+#include "QualityGovernor.h"
+#include <algorithm>
+
+void QualityGovernor::setEnabled(bool enable) {
+    enabled.store(enable, std::memory_order_relaxed);
+    if (!enable) {
+        tier.store(static_cast<int>(Tier::Full), std::memory_order_relaxed);
+    }
+}
+
+void QualityGovernor::setSyntheticLoad(float load) {
+    syntheticLoad.store(load, std::memory_order_relaxed);
+}
+
+QualityGovernor::Tier QualityGovernor::update(double renderSeconds, double deadlineSeconds) {
+    if (!enabled.load(std::memory_order_relaxed) || deadlineSeconds <= 0.0) {
+        return getTier();
+    }
+
+    float load = syntheticLoad.load(std::memory_order_relaxed);
+    if (load < 0.0f) {
+        load = static_cast<float>(renderSeconds / deadlineSeconds);
+    }
+    float smoothed = smoothedLoad.load(std::memory_order_relaxed);
+    smoothed += LOAD_SMOOTHING * (load - smoothed);
+    smoothedLoad.store(smoothed, std::memory_order_relaxed);
+
+    // Time spent on each side of the hysteresis band, measured in audio time
+    overloadSeconds = smoothed > STEP_DOWN_LOAD ? overloadSeconds + deadlineSeconds : 0.0;
+    headroomSeconds = smoothed < STEP_UP_LOAD ? headroomSeconds + deadlineSeconds : 0.0;
+
+    int current = tier.load(std::memory_order_relaxed);
+    if (overloadSeconds >= STEP_DOWN_SECONDS && current < NUM_TIERS - 1) {
+        ++current;
+        overloadSeconds = 0.0;
+    } else if (headroomSeconds >= STEP_UP_SECONDS && current > 0) {
+        --current;
+        headroomSeconds = 0.0;
+    }
+    tier.store(current, std::memory_order_relaxed);
+    return static_cast<Tier>(current);
+}
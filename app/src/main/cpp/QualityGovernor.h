@@ -0,0 +1,57 @@
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include <atomic>
+
+/**
+ * QualityGovernor - Load-adaptive quality tiers for the audio callback
+ *
+ * Compares the time spent rendering each callback with the buffer deadline
+ * (numFrames / sampleRate). When the smoothed load stays above
+ * STEP_DOWN_LOAD the governor drops one tier; it climbs back one tier only
+ * after the load has stayed below STEP_UP_LOAD for much longer, so it
+ * doesn't oscillate around a threshold. Tiers are cumulative: each one keeps
+ * the savings of the tiers above it.
+ *
+ * For tests the measured time can be replaced by a synthetic load, which
+ * makes tier changes depend only on the injected values and frame counts.
+ */
+class QualityGovernor {
+public:
+    enum class Tier {
+        Full = 0,
+        ReducedHarmonics,  // Upper organ drawbars / guitar overtones dropped
+        ReducedReverb,     // Single comb in every reverb
+        CappedPolyphony    // Oldest held notes released above the voice cap
+    };
+    static constexpr int NUM_TIERS = 4;
+
+    // Control thread
+    void setEnabled(bool enabled);  // Disabling returns to Tier::Full
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    void setSyntheticLoad(float load);  // Fraction of the deadline, < 0 = measure
+
+    // Audio thread: accounts one callback, returns the tier to render with
+    Tier update(double renderSeconds, double deadlineSeconds);
+
+    Tier getTier() const { return static_cast<Tier>(tier.load(std::memory_order_relaxed)); }
+    float getLoad() const { return smoothedLoad.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr float STEP_DOWN_LOAD = 0.75f;     // Less than 25% headroom
+    static constexpr float STEP_UP_LOAD = 0.45f;
+    static constexpr double STEP_DOWN_SECONDS = 0.05;  // Sustained overload before degrading
+    static constexpr double STEP_UP_SECONDS = 3.0;     // Sustained headroom before recovering
+    static constexpr float LOAD_SMOOTHING = 0.2f;      // One-pole weight of the newest callback
+
+    std::atomic<bool> enabled{true};
+    std::atomic<float> syntheticLoad{-1.0f};
+    std::atomic<int> tier{0};
+    std::atomic<float> smoothedLoad{0.0f};
+
+    // Audio thread only
+    double overloadSeconds = 0.0;
+    double headroomSeconds = 0.0;
+};
+
+#endif // QUALITY_GOVERNOR_H
@@ -0,0 +1,118 @@
+#include "RealFFT.h"
+#include <cmath>
+#include <utility>
+
+void RealFFT::init(int n) {
+    size = n;
+    half = n / 2;
+    work.assign(2 * half, 0.0f);
+
+    twiddleRe.resize(half / 2);
+    twiddleIm.resize(half / 2);
+    for (int k = 0; k < half / 2; ++k) {
+        double angle = -2.0 * M_PI * k / half;
+        twiddleRe[k] = static_cast<float>(std::cos(angle));
+        twiddleIm[k] = static_cast<float>(std::sin(angle));
+    }
+
+    splitRe.resize(half);
+    splitIm.resize(half);
+    for (int k = 0; k < half; ++k) {
+        double angle = -2.0 * M_PI * k / size;
+        splitRe[k] = static_cast<float>(std::cos(angle));
+        splitIm[k] = static_cast<float>(std::sin(angle));
+    }
+
+    int bits = 0;
+    while ((1 << bits) < half) {
+        ++bits;
+    }
+    bitReverse.resize(half);
+    for (int i = 0; i < half; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        bitReverse[i] = reversed;
+    }
+}
+
+// In-place iterative radix-2 on half interleaved complex values
+void RealFFT::complexTransform(float *data, bool inverse) const {
+    for (int i = 0; i < half; ++i) {
+        int j = bitReverse[i];
+        if (j > i) {
+            std::swap(data[2 * i], data[2 * j]);
+            std::swap(data[2 * i + 1], data[2 * j + 1]);
+        }
+    }
+
+    const float sign = inverse ? -1.0f : 1.0f;
+    for (int length = 2; length <= half; length <<= 1) {
+        const int span = length / 2;
+        const int stride = half / length;
+        for (int start = 0; start < half; start += length) {
+            for (int k = 0; k < span; ++k) {
+                const float wr = twiddleRe[k * stride];
+                const float wi = sign * twiddleIm[k * stride];
+                float *a = data + 2 * (start + k);
+                float *b = data + 2 * (start + k + span);
+                const float tr = b[0] * wr - b[1] * wi;
+                const float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+void RealFFT::forward(const float *input, float *re, float *im) {
+    float *z = work.data();
+    for (int i = 0; i < 2 * half; ++i) {
+        z[i] = input[i];  // Even samples -> real, odd -> imaginary
+    }
+    complexTransform(z, false);
+
+    // Split the packed spectrum into the spectra of the even and odd samples
+    for (int k = 0; k <= half; ++k) {
+        const int a = k % half;
+        const int b = (half - k) % half;
+        const float zr = z[2 * a], zi = z[2 * a + 1];
+        const float cr = z[2 * b], ci = -z[2 * b + 1];  // conj(Z[half - k])
+
+        const float evenRe = 0.5f * (zr + cr);
+        const float evenIm = 0.5f * (zi + ci);
+        const float oddRe = 0.5f * (zi - ci);   // (Z - conj) / 2i
+        const float oddIm = -0.5f * (zr - cr);
+
+        const float wr = k < half ? splitRe[k] : -1.0f;
+        const float wi = k < half ? splitIm[k] : 0.0f;
+        re[k] = evenRe + wr * oddRe - wi * oddIm;
+        im[k] = evenIm + wr * oddIm + wi * oddRe;
+    }
+}
+
+void RealFFT::inverse(const float *re, const float *im, float *output) {
+    float *z = work.data();
+    for (int k = 0; k < half; ++k) {
+        const float xr = re[k], xi = im[k];
+        const float cr = re[half - k], ci = -im[half - k];  // conj(X[half - k])
+
+        const float evenRe = xr + cr;
+        const float evenIm = xi + ci;
+        const float diffRe = xr - cr;
+        const float diffIm = xi - ci;
+        // Odd spectrum = difference * conj(W^k)
+        const float oddRe = diffRe * splitRe[k] + diffIm * splitIm[k];
+        const float oddIm = diffIm * splitRe[k] - diffRe * splitIm[k];
+
+        z[2 * k] = evenRe - oddIm;      // even + i * odd
+        z[2 * k + 1] = evenIm + oddRe;
+    }
+    complexTransform(z, true);
+    for (int i = 0; i < 2 * half; ++i) {
+        output[i] = z[i];
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef REAL_FFT_H
+#define REAL_FFT_H
+
+#include <vector>
+
+/**
+ * RealFFT - Radix-2 FFT of real signals
+ *
+ * A real sequence of size N is transformed through a complex FFT of size
+ * N/2 (even samples as real part, odd samples as imaginary part) plus a
+ * split step. Spectra are kept as separate real/imaginary arrays of
+ * N/2 + 1 bins, which is the layout the convolution kernels multiply in.
+ * All tables are built in init(); forward/inverse never allocate.
+ */
+class RealFFT {
+public:
+    RealFFT() = default;
+    explicit RealFFT(int size) { init(size); }
+
+    void init(int size);  // Power of two, >= 4
+    int getSize() const { return size; }
+    int getBins() const { return size / 2 + 1; }
+
+    void forward(const float *input, float *re, float *im);
+    // Unnormalized: the output is scaled by getSize()
+    void inverse(const float *re, const float *im, float *output);
+
+private:
+    void complexTransform(float *data, bool inverse) const;
+
+    int size = 0;
+    int half = 0;
+    std::vector<float> work;                 // half interleaved complex values
+    std::vector<float> twiddleRe, twiddleIm; // exp(-2 pi i k / half), k < half / 2
+    std::vector<float> splitRe, splitIm;     // exp(-2 pi i k / size), k < half
+    std::vector<int> bitReverse;
+};
+
+#endif // REAL_FFT_H
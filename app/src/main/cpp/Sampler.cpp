@@ -0,0 +1,458 @@
+#include "Sampler.h"
+#include "DspUtils.h"
+#include <android/log.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#define LOG_TAG "Sampler"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr uint64_t NO_ZONE = 0xFFFF;
+constexpr float KERNEL_CUTOFF = 0.9f;  // Of the source Nyquist
+constexpr double KAISER_BETA = 6.0;
+constexpr int MIX_BLOCK = 256;
+constexpr auto PREFETCH_INTERVAL = std::chrono::milliseconds(2);
+constexpr auto IDLE_INTERVAL = std::chrono::milliseconds(100);
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+} // namespace
+
+Sampler::Library::~Library() {
+    for (Zone &zone : zones) {
+        if (zone.mapping != nullptr) {
+            munmap(zone.mapping, zone.mappedBytes);
+        }
+    }
+}
+
+Sampler::Sampler() {
+    // Windowed-sinc table: row p holds the 8 taps for fraction p / PHASES,
+    // tap k sits at source offset k - TAPS/2 + 1 from the integer position
+    kernel.resize((PHASES + 1) * TAPS);
+    const double halfWidth = TAPS / 2;
+    for (int p = 0; p <= PHASES; ++p) {
+        const double fraction = static_cast<double>(p) / PHASES;
+        double sum = 0.0;
+        for (int k = 0; k < TAPS; ++k) {
+            const double distance = (k - TAPS / 2 + 1) - fraction;
+            const double x = dsp::PI * KERNEL_CUTOFF * distance;
+            const double sinc = std::fabs(x) < 1.0e-9 ? 1.0 : std::sin(x) / x;
+            const double ratio = distance / halfWidth;
+            const double window = std::fabs(ratio) >= 1.0 ? 0.0
+                    : besselI0(KAISER_BETA * std::sqrt(1.0 - ratio * ratio)) / besselI0(KAISER_BETA);
+            kernel[p * TAPS + k] = static_cast<float>(sinc * window);
+            sum += sinc * window;
+        }
+        // Unity gain at DC for every phase, so slow bends don't ripple the level
+        for (int k = 0; k < TAPS; ++k) {
+            kernel[p * TAPS + k] = static_cast<float>(kernel[p * TAPS + k] / sum);
+        }
+    }
+
+    for (Voice &voice : voices) {
+        voice.envelope.setAttackTime(0.002f);
+        voice.envelope.setDecayTime(0.001f);
+        voice.envelope.setSustainLevel(1.0f);
+        voice.envelope.setReleaseTime(0.15f);
+        voice.request.store(pack(0, NO_ZONE));
+    }
+}
+
+Sampler::~Sampler() {
+    if (prefetchThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(streamMutex);
+            prefetchRunning.store(false);
+        }
+        wakeCondition.notify_one();
+        prefetchThread.join();
+    }
+}
+
+std::unique_ptr<Sampler::Library> Sampler::loadLibrary(const ZoneSpec *specs, int count) {
+    if (count < 1 || count > MAX_ZONES) {
+        LOGE("Invalid sampler zone count: %d", count);
+        return nullptr;
+    }
+
+    auto library = std::make_unique<Library>();
+    library->zones.resize(count);
+    for (int i = 0; i < count; ++i) {
+        const ZoneSpec &spec = specs[i];
+        Library::Zone &zone = library->zones[i];
+        if (spec.path == nullptr || !(spec.rootHz > 0.0f)) {
+            LOGE("Invalid sampler zone %d", i);
+            return nullptr;
+        }
+
+        int fd = ::open(spec.path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            LOGE("Cannot open %s", spec.path);
+            return nullptr;
+        }
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            LOGE("Cannot read %s", spec.path);
+            return nullptr;
+        }
+        const auto bytes = static_cast<size_t>(info.st_size);
+        void *memory = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED) {
+            LOGE("Cannot map %s", spec.path);
+            return nullptr;
+        }
+        zone.mapping = memory;
+        zone.mappedBytes = bytes;
+
+        const auto *base = static_cast<const uint8_t *>(memory);
+        if (!WavReader::parseLayout(base, bytes, zone.layout) || zone.layout.frames == 0) {
+            LOGE("Unsupported WAV %s", spec.path);
+            return nullptr;
+        }
+        zone.data = base + zone.layout.dataOffset;
+        zone.frames = static_cast<int64_t>(zone.layout.frames);
+        zone.rootHz = spec.rootHz;
+        zone.lowHz = spec.lowHz;
+        zone.highHz = spec.highHz;
+
+        // The attack is decoded now and stays in RAM; the body is only read ahead
+        zone.attackFrames = std::min<int64_t>(
+                zone.frames, static_cast<int64_t>(std::ceil(ATTACK_SECONDS * zone.layout.sampleRate)));
+        zone.attack.resize(static_cast<size_t>(zone.attackFrames));
+        WavReader::decodeMono(zone.data, zone.layout, zone.attack.data(),
+                              static_cast<int>(zone.attackFrames));
+        madvise(memory, bytes, MADV_SEQUENTIAL);
+    }
+    library->rings.assign(static_cast<size_t>(MAX_VOICES) * RING_FRAMES, 0.0f);
+
+    LOGI("Sampler library: %d zones", count);
+    return library;
+}
+
+void Sampler::swapLibraryLocked(std::unique_ptr<Library> &replacement) {
+    reset();
+    // New generation with no zone: the prefetch thread lets go of the old rings
+    for (Voice &voice : voices) {
+        ++voice.generation;
+        voice.readFrame.store(pack(voice.generation, 0), std::memory_order_relaxed);
+        voice.request.store(pack(voice.generation, NO_ZONE), std::memory_order_release);
+    }
+    std::swap(library, replacement);
+    if (library && !prefetchThread.joinable()) {
+        prefetchRunning.store(true);
+        prefetchThread = std::thread(&Sampler::prefetchLoop, this);
+    }
+}
+
+size_t Sampler::getResidentBytes() const {
+    if (!library) {
+        return 0;
+    }
+    size_t bytes = library->rings.size() * sizeof(float);
+    for (const Library::Zone &zone : library->zones) {
+        bytes += zone.attack.size() * sizeof(float);
+    }
+    return bytes;
+}
+
+void Sampler::setSampleRate(float rate) {
+    sampleRate = rate;
+    for (Voice &voice : voices) {
+        voice.envelope.setSampleRate(rate);
+    }
+}
+
+void Sampler::setCurve(ADSREnvelope::Curve curve) {
+    for (Voice &voice : voices) {
+        voice.envelope.setCurve(curve);
+    }
+}
+
+int Sampler::findZone(float frequency) const {
+    int nearest = 0;
+    float nearestDistance = INFINITY;
+    for (size_t i = 0; i < library->zones.size(); ++i) {
+        const Library::Zone &zone = library->zones[i];
+        if (zone.lowHz < zone.highHz && frequency >= zone.lowHz && frequency < zone.highHz) {
+            return static_cast<int>(i);
+        }
+        const float distance = std::fabs(std::log2(frequency / zone.rootHz));
+        if (distance < nearestDistance) {
+            nearest = static_cast<int>(i);
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+void Sampler::noteOn(int voiceIndex, float frequency, float amplitude) {
+    if (!library || voiceIndex < 0 || voiceIndex >= MAX_VOICES || !(frequency > 0.0f)) {
+        return;
+    }
+    Voice &voice = voices[voiceIndex];
+    const int zoneIndex = findZone(frequency);
+    const Library::Zone &zone = library->zones[zoneIndex];
+
+    voice.zone = zoneIndex;
+    voice.position = 0.0;
+    voice.baseIncrement = (frequency / zone.rootHz) *
+            (static_cast<float>(zone.layout.sampleRate) / sampleRate);
+    voice.bendRatio = 1.0f;
+    voice.targetBendRatio = 1.0f;
+    voice.amplitude = amplitude;
+    voice.envelope.noteOn();
+    voice.active = true;
+
+    // Read position first: the prefetch thread sees it once it sees the request
+    ++voice.generation;
+    voice.readFrame.store(pack(voice.generation, 0), std::memory_order_relaxed);
+    voice.request.store(pack(voice.generation, static_cast<uint64_t>(zoneIndex)),
+                        std::memory_order_release);
+    wakeCondition.notify_one();
+}
+
+void Sampler::noteOff(int voiceIndex) {
+    if (voiceIndex >= 0 && voiceIndex < MAX_VOICES) {
+        voices[voiceIndex].envelope.noteOff();
+    }
+}
+
+void Sampler::allOff() {
+    for (Voice &voice : voices) {
+        voice.envelope.noteOff();
+    }
+}
+
+void Sampler::reset() {
+    for (Voice &voice : voices) {
+        voice.active = false;
+        voice.envelope.reset();
+    }
+}
+
+void Sampler::setPitchBend(int voiceIndex, float semitones) {
+    if (voiceIndex >= 0 && voiceIndex < MAX_VOICES) {
+        Voice &voice = voices[voiceIndex];
+        voice.targetBendRatio = std::exp2(semitones / 12.0f);
+        voice.bendRatio = voice.targetBendRatio;
+    }
+}
+
+void Sampler::glidePitchBend(int voiceIndex, float semitones, float glideSeconds) {
+    if (voiceIndex < 0 || voiceIndex >= MAX_VOICES) {
+        return;
+    }
+    if (glideSeconds <= 0.0f) {
+        setPitchBend(voiceIndex, semitones);
+        return;
+    }
+    Voice &voice = voices[voiceIndex];
+    voice.targetBendRatio = std::exp2(semitones / 12.0f);
+    voice.glideGain = dsp::timeConstantGain(glideSeconds, sampleRate);
+}
+
+bool Sampler::isActive() const {
+    return std::any_of(voices.begin(), voices.end(), [](const Voice &voice) { return voice.active; });
+}
+
+void Sampler::setSynchronous(bool enabled) {
+    synchronous.store(enabled);
+    // Let a running prefetch pass finish before the caller fills inline
+    while (enabled && prefetchBusy.load()) {
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * One output sample at source position frame + fraction. Taps come from the
+ * resident attack, the ring (up to filled) or are zero past either end of
+ * the file; a tap that is not streamed yet is an underrun.
+ */
+float Sampler::interpolate(const Voice &voice, int64_t frame, float fraction, int64_t filled,
+                           bool &underrun) const {
+    const Library::Zone &zone = library->zones[voice.zone];
+    const float *ring = library->rings.data() + static_cast<size_t>(&voice - voices.data()) * RING_FRAMES;
+
+    const float phase = fraction * PHASES;
+    const int row = std::min(static_cast<int>(phase), PHASES - 1);
+    const float blend = phase - static_cast<float>(row);
+    const float *k0 = kernel.data() + row * TAPS;
+    const float *k1 = k0 + TAPS;
+
+    const int64_t first = frame - TAPS / 2 + 1;
+    float taps[TAPS];
+    if (first >= 0 && first + TAPS <= zone.attackFrames) {
+        std::copy_n(zone.attack.data() + first, TAPS, taps);
+    } else {
+        for (int k = 0; k < TAPS; ++k) {
+            const int64_t f = first + k;
+            if (f < 0 || f >= zone.frames) {
+                taps[k] = 0.0f;
+            } else if (f < zone.attackFrames) {
+                taps[k] = zone.attack[static_cast<size_t>(f)];
+            } else if (f < filled) {
+                taps[k] = ring[f & (RING_FRAMES - 1)];
+            } else {
+                taps[k] = 0.0f;
+                underrun = true;
+            }
+        }
+    }
+
+    float sum = 0.0f;
+    for (int k = 0; k < TAPS; ++k) {
+        sum += taps[k] * (k0[k] + blend * (k1[k] - k0[k]));
+    }
+    return sum;
+}
+
+void Sampler::mixInto(float *output, int numFrames, uint32_t voiceMask) {
+    if (!library) {
+        return;
+    }
+    if (synchronous.load(std::memory_order_relaxed)) {
+        fillAll();
+    }
+
+    float gain[MIX_BLOCK];
+    for (int index = 0; index < MAX_VOICES; ++index) {
+        Voice &voice = voices[index];
+        if (!voice.active || (voiceMask & (1u << index)) == 0) {
+            continue;
+        }
+        const Library::Zone &zone = library->zones[voice.zone];
+        const uint64_t filledPacked = voice.filledFrame.load(std::memory_order_acquire);
+        const int64_t filled = generationOf(filledPacked) == voice.generation
+                ? static_cast<int64_t>(frameOf(filledPacked)) : zone.attackFrames;
+        const int64_t end = zone.frames + TAPS / 2;
+        bool underrun = false;
+
+        for (int offset = 0; offset < numFrames && voice.active; offset += MIX_BLOCK) {
+            const int frames = std::min(MIX_BLOCK, numFrames - offset);
+            const int audible = voice.envelope.process(gain, frames);
+            for (int i = 0; i < audible; ++i) {
+                const auto frame = static_cast<int64_t>(voice.position);
+                const auto fraction = static_cast<float>(voice.position - static_cast<double>(frame));
+                const float sample = interpolate(voice, frame, fraction, filled, underrun);
+                output[offset + i] += sample * gain[i] * voice.amplitude;
+
+                voice.bendRatio = voice.targetBendRatio +
+                        (voice.bendRatio - voice.targetBendRatio) * voice.glideGain;
+                voice.position += static_cast<double>(voice.baseIncrement * voice.bendRatio);
+                if (voice.position >= static_cast<double>(end)) {
+                    voice.active = false;
+                    break;
+                }
+            }
+            if (audible < frames) {
+                voice.active = false;
+            }
+        }
+        if (!voice.active) {
+            voice.envelope.reset();
+        }
+
+        // Everything before the leftmost tap of the next sample can be overwritten
+        const int64_t oldest = std::max<int64_t>(0, static_cast<int64_t>(voice.position) - TAPS / 2 + 1);
+        voice.readFrame.store(pack(voice.generation, static_cast<uint64_t>(oldest)),
+                              std::memory_order_release);
+        if (underrun) {
+            underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Decodes from the mapping into the ring until it is RING_FRAMES ahead of
+ * the voice. Prefetch thread, or the render thread in synchronous mode.
+ * Returns true while the note still has frames left to stream.
+ */
+bool Sampler::fillVoice(int index) {
+    Voice &voice = voices[index];
+    const uint64_t request = voice.request.load(std::memory_order_acquire);
+    const uint16_t generation = generationOf(request);
+    if (generation != voice.streamGeneration) {
+        // New note: the ring restarts right after the resident attack
+        voice.streamGeneration = generation;
+        voice.streamZone = static_cast<int>(frameOf(request));
+        if (frameOf(request) != NO_ZONE) {
+            voice.filledFrame.store(pack(generation, library->zones[voice.streamZone].attackFrames),
+                                    std::memory_order_release);
+        }
+    }
+    if (frameOf(request) == NO_ZONE) {
+        return false;
+    }
+
+    const Library::Zone &zone = library->zones[voice.streamZone];
+    const uint64_t readPacked = voice.readFrame.load(std::memory_order_acquire);
+    if (generationOf(readPacked) != generation) {
+        return true;
+    }
+    auto filled = static_cast<int64_t>(frameOf(voice.filledFrame.load(std::memory_order_relaxed)));
+    const int64_t limit = std::min(zone.frames, static_cast<int64_t>(frameOf(readPacked)) + RING_FRAMES);
+    float *ring = library->rings.data() + static_cast<size_t>(index) * RING_FRAMES;
+
+    while (filled < limit) {
+        // Up to the end of the ring, so each chunk is one contiguous decode
+        const int64_t slot = filled & (RING_FRAMES - 1);
+        const int count = static_cast<int>(std::min({limit - filled, int64_t{RING_FRAMES} - slot,
+                                                     int64_t{PREFETCH_CHUNK}}));
+        WavReader::decodeMono(zone.data + filled * zone.layout.frameBytes, zone.layout,
+                              ring + slot, count);
+        filled += count;
+        voice.filledFrame.store(pack(generation, static_cast<uint64_t>(filled)), std::memory_order_release);
+    }
+
+    // Ask the kernel to page in what the next pass will decode
+    if (filled < zone.frames) {
+        const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const auto start = reinterpret_cast<uintptr_t>(zone.data + filled * zone.layout.frameBytes);
+        const uintptr_t aligned = start & ~(pageSize - 1);
+        const size_t ahead = static_cast<size_t>(PREFETCH_CHUNK) * zone.layout.frameBytes * 2;
+        const auto mappingEnd = reinterpret_cast<uintptr_t>(zone.mapping) + zone.mappedBytes;
+        madvise(reinterpret_cast<void *>(aligned), std::min<uintptr_t>(ahead + (start - aligned), mappingEnd - aligned),
+                MADV_WILLNEED);
+    }
+    return filled < zone.frames;
+}
+
+bool Sampler::fillAll() {
+    bool streaming = false;
+    for (int i = 0; i < MAX_VOICES; ++i) {
+        streaming |= fillVoice(i);
+    }
+    return streaming;
+}
+
+void Sampler::prefetchLoop() {
+    std::unique_lock<std::mutex> lock(streamMutex);
+    while (prefetchRunning.load()) {
+        bool streaming = false;
+        prefetchBusy.store(true);
+        if (library && !synchronous.load()) {
+            streaming = fillAll();
+        }
+        prefetchBusy.store(false);
+        wakeCondition.wait_for(lock, streaming ? PREFETCH_INTERVAL : IDLE_INTERVAL);
+    }
+}
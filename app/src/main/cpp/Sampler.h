@@ -0,0 +1,175 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ADSREnvelope.h"
+#include "WavReader.h"
+
+/**
+ * Sampler - Multisample instrument streamed from memory-mapped WAV files
+ *
+ * Each zone is one WAV file recorded at rootHz and played for notes in
+ * [lowHz, highHz). Loaded zones keep only their first ATTACK_SECONDS
+ * decoded in RAM; the rest of the file stays memory-mapped and is never
+ * touched by the audio thread:
+ *
+ *  - The attack plays straight from the resident copy, so a note starts
+ *    with no disk access at all.
+ *  - Meanwhile a prefetch thread decodes the rest of the file from the
+ *    mapping into a per-voice ring buffer (RING_FRAMES), staying ahead of
+ *    the read position. Page faults happen on that thread only.
+ *  - The ring is single-producer/single-consumer: the prefetch thread
+ *    publishes how far it has filled, the voice publishes the oldest frame
+ *    it still needs. Both positions carry the note's generation, so a
+ *    retrigger never reads data streamed for the previous note.
+ *
+ * Playback is resampled by (note / root) * (file rate / output rate) * bend
+ * with an 8-tap Kaiser-windowed sinc interpolator (256 phases, linearly
+ * interpolated), flat to about 0.8 of the source Nyquist. Zones should be
+ * spaced so notes are shifted by a few semitones at most: the kernel does
+ * not narrow its band when pitching up.
+ *
+ * If the prefetch thread falls behind, the missing frames play as silence
+ * and are counted (getUnderruns); the note keeps its timing. For offline
+ * rendering, setSynchronous(true) fills the rings inline instead.
+ */
+class Sampler {
+public:
+    static constexpr int MAX_VOICES = 8;
+    static constexpr int MAX_ZONES = 32;
+    static constexpr float ATTACK_SECONDS = 0.25f;  // Resident head of every zone
+    static constexpr int RING_FRAMES = 16384;        // Per voice, power of two
+
+    struct ZoneSpec {
+        const char *path = nullptr;
+        float rootHz = 261.63f;
+        float lowHz = 0.0f;
+        float highHz = 0.0f;  // <= lowHz: the zone's notes are chosen by nearest root
+    };
+
+    // Mapped files, their resident attacks and the voice rings; built off
+    // the audio thread
+    class Library {
+    public:
+        struct Zone {
+            void *mapping = nullptr;
+            size_t mappedBytes = 0;
+            WavReader::Layout layout;
+            const uint8_t *data = nullptr;  // First frame in the mapping
+            float rootHz = 0.0f;
+            float lowHz = 0.0f;
+            float highHz = 0.0f;
+            int64_t frames = 0;
+            int64_t attackFrames = 0;
+            std::vector<float> attack;
+        };
+
+        Library() = default;
+        ~Library();  // Unmaps the files
+        Library(const Library &) = delete;
+        Library &operator=(const Library &) = delete;
+
+        std::vector<Zone> zones;
+        std::vector<float> rings;  // MAX_VOICES * RING_FRAMES
+    };
+
+    Sampler();
+    ~Sampler();
+
+    // Control thread: maps and validates every file, decodes the attacks.
+    // nullptr if a file cannot be used.
+    static std::unique_ptr<Library> loadLibrary(const ZoneSpec *zones, int count);
+
+    // Control thread. Pauses the prefetch thread for a library swap: hold
+    // the returned lock while calling swapLibraryLocked (with the voice lock).
+    std::unique_lock<std::mutex> lockStreams() { return std::unique_lock<std::mutex>(streamMutex); }
+    // Stops all voices and installs library; the old one comes back in it
+    void swapLibraryLocked(std::unique_ptr<Library> &library);
+    bool isLoaded() const { return library != nullptr; }
+    size_t getResidentBytes() const;
+
+    // Voice control (serialized with render by the engine's voice lock)
+    void setSampleRate(float rate);
+    void noteOn(int voice, float frequency, float amplitude);
+    void noteOff(int voice);
+    void allOff();     // Release
+    void reset();      // Immediate silence
+    void setPitchBend(int voice, float semitones);
+    void glidePitchBend(int voice, float semitones, float glideSeconds);
+    bool isActive() const;
+    void setCurve(ADSREnvelope::Curve curve);
+
+    // Audio thread: adds numFrames of the active voices in voiceMask (bit per voice) to output
+    static constexpr uint32_t ALL_VOICES = (1u << MAX_VOICES) - 1;
+    void mixInto(float *output, int numFrames, uint32_t voiceMask = ALL_VOICES);
+
+    void setSynchronous(bool synchronous);  // Offline: rings filled inline
+    uint64_t getUnderruns() const { return underruns.load(std::memory_order_relaxed); }
+
+private:
+    struct Voice {
+        // Audio side (voice lock)
+        bool active = false;
+        int zone = 0;
+        double position = 0.0;     // Source frame
+        float baseIncrement = 0.0f;
+        float bendRatio = 1.0f;
+        float targetBendRatio = 1.0f;
+        float glideGain = 1.0f;
+        float amplitude = 0.0f;
+        uint16_t generation = 0;
+        ADSREnvelope envelope;
+
+        // Shared with the prefetch thread: (generation << 48) | frame
+        std::atomic<uint64_t> request{0};   // Zone of the note in the frame field
+        std::atomic<uint64_t> readFrame{0};
+        std::atomic<uint64_t> filledFrame{0};
+
+        // Prefetch side
+        uint16_t streamGeneration = 0;
+        int streamZone = 0;
+    };
+
+    static constexpr int TAPS = 8;
+    static constexpr int PHASES = 256;
+    static constexpr uint64_t FRAME_MASK = (uint64_t{1} << 48) - 1;
+    static constexpr int PREFETCH_CHUNK = 4096;  // Frames decoded per voice per pass
+
+    static uint64_t pack(uint16_t generation, uint64_t frame) {
+        return (static_cast<uint64_t>(generation) << 48) | (frame & FRAME_MASK);
+    }
+    static uint16_t generationOf(uint64_t packed) { return static_cast<uint16_t>(packed >> 48); }
+    static uint64_t frameOf(uint64_t packed) { return packed & FRAME_MASK; }
+
+    int findZone(float frequency) const;
+    float interpolate(const Voice &voice, int64_t frame, float fraction, int64_t filled,
+                      bool &underrun) const;
+    bool fillVoice(int index);
+    bool fillAll();
+    void prefetchLoop();
+
+    std::unique_ptr<Library> library;
+    std::array<Voice, MAX_VOICES> voices;
+    std::vector<float> kernel;  // (PHASES + 1) * TAPS
+    float sampleRate = 48000.0f;
+    std::atomic<uint64_t> underruns{0};
+
+    // The prefetch thread fills the rings under streamMutex; a library swap
+    // takes it before the voice lock. In synchronous mode the thread skips
+    // its passes (prefetchBusy tells when one is still running).
+    std::mutex streamMutex;
+    std::condition_variable wakeCondition;
+    std::thread prefetchThread;
+    std::atomic<bool> prefetchRunning{false};
+    std::atomic<bool> synchronous{false};
+    std::atomic<bool> prefetchBusy{false};
+};
+
+#endif // SAMPLER_H
@@ -0,0 +1,75 @@
+#include "ScaleQuantizer.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+
+// C minor blues from octave 3, the app's default key
+constexpr int DEFAULT_ROOT = 0;
+constexpr int DEFAULT_INTERVALS[] = {0, 3, 5, 6, 7, 10};
+constexpr int DEFAULT_BASE_OCTAVE = 3;
+
+} // namespace
+
+ScaleQuantizer::ScaleQuantizer() {
+    setScale(DEFAULT_ROOT, DEFAULT_INTERVALS, static_cast<int>(std::size(DEFAULT_INTERVALS)),
+             DEFAULT_BASE_OCTAVE);
+}
+
+bool ScaleQuantizer::setScale(int root, const int *intervals, int count, int baseOctave) {
+    if (root < 0 || root > 11 || count < 1 || count > MAX_INTERVALS || intervals[0] != 0 ||
+        baseOctave < -1 || baseOctave > 8) {
+        return false;
+    }
+    for (int i = 1; i < count; ++i) {
+        if (intervals[i] <= intervals[i - 1] || intervals[i] > 11) {
+            return false;
+        }
+    }
+
+    pitchClasses.fill(false);
+    for (int i = 0; i < count; ++i) {
+        pitchClasses[(root + intervals[i]) % 12] = true;
+    }
+
+    const int rootMidi = (baseOctave + 1) * 12 + root;
+    for (int degree = 0; degree < MAX_DEGREES; ++degree) {
+        const int midi = rootMidi + intervals[degree % count] + 12 * (degree / count);
+        midiNotes[degree] = static_cast<float>(midi);
+        frequencies[degree] = A4_FREQUENCY *
+                static_cast<float>(std::pow(2.0, (midi - A4_MIDI_NOTE) / 12.0));
+    }
+    return true;
+}
+
+float ScaleQuantizer::getFrequency(int degree) const {
+    return frequencies[std::clamp(degree, 0, MAX_DEGREES - 1)];
+}
+
+float ScaleQuantizer::getMidiNote(int degree) const {
+    return midiNotes[std::clamp(degree, 0, MAX_DEGREES - 1)];
+}
+
+float ScaleQuantizer::snap(float midiNote) const {
+    // Every octave has at least one scale tone, so the search ends within 6 steps
+    const int nearest = static_cast<int>(std::lround(midiNote));
+    float best = static_cast<float>(nearest);
+    float bestDistance = 13.0f;
+    for (int offset = -6; offset <= 6; ++offset) {
+        const int candidate = nearest + offset;
+        if (!pitchClasses[((candidate % 12) + 12) % 12]) {
+            continue;
+        }
+        const float distance = std::fabs(static_cast<float>(candidate) - midiNote);
+        if (distance < bestDistance || (distance == bestDistance && candidate > best)) {
+            best = static_cast<float>(candidate);
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+float ScaleQuantizer::frequencyToMidi(float frequency) {
+    return static_cast<float>(A4_MIDI_NOTE) + 12.0f * std::log2(std::max(frequency, 1.0f) / A4_FREQUENCY);
+}
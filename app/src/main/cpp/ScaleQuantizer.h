@@ -0,0 +1,46 @@
+#ifndef SCALE_QUANTIZER_H
+#define SCALE_QUANTIZER_H
+
+#include <array>
+
+/**
+ * ScaleQuantizer - Key/scale frequency table and in-scale snapping
+ *
+ * Holds the notes of one key and scale (root + semitone intervals per
+ * octave) as a precomputed table indexed by scale degree, starting at the
+ * root of baseOctave, so a note-on by degree is a lookup. The same scale
+ * answers "nearest in-scale pitch" for bend targets, in fractional MIDI
+ * note numbers. Degree frequencies use the same formula as the Kotlin
+ * PentatonicScale (A4 = 440 Hz, equal temperament), so both agree to the
+ * last bit.
+ */
+class ScaleQuantizer {
+public:
+    static constexpr int MAX_INTERVALS = 12;
+    static constexpr int MAX_DEGREES = 64;
+
+    ScaleQuantizer();
+
+    // root: 0 = C ... 11 = B; intervals: ascending semitones from the root
+    // within one octave (0 first). Returns false and keeps the old scale if
+    // the intervals are not valid.
+    bool setScale(int root, const int *intervals, int count, int baseOctave);
+
+    float getFrequency(int degree) const;  // Degree 0 = root of baseOctave (clamped)
+    float getMidiNote(int degree) const;
+
+    // In-scale MIDI note closest to a (fractional) MIDI note; ties go up
+    float snap(float midiNote) const;
+
+    static float frequencyToMidi(float frequency);
+
+private:
+    static constexpr float A4_FREQUENCY = 440.0f;
+    static constexpr int A4_MIDI_NOTE = 69;
+
+    std::array<float, MAX_DEGREES> frequencies{};
+    std::array<float, MAX_DEGREES> midiNotes{};
+    std::array<bool, 12> pitchClasses{};
+};
+
+#endif // SCALE_QUANTIZER_H
@@ -0,0 +1,194 @@
+#include "StepSequencer.h"
+#include <algorithm>
+#include <cmath>
+
+StepSequencer::StepSequencer() = default;
+
+bool StepSequencer::setPattern(const Pattern &pattern) {
+    if (pattern.stepCount < 1 || pattern.stepCount > MAX_STEPS ||
+        pattern.stepsPerBeat < 1 || pattern.stepsPerBeat > 8 ||
+        pattern.trackCount < 0 || pattern.trackCount > MAX_TRACKS) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(writerMutex);
+    Pattern &slot = patterns[writeIndex];
+    slot = pattern;
+    slot.swing = std::clamp(pattern.swing, 0.0f, MAX_SWING);
+    for (int t = 0; t < slot.trackCount; ++t) {
+        Track &track = slot.tracks[t];
+        track.frequency = std::clamp(track.frequency, 20.0f, 20000.0f);
+        track.gate = std::clamp(track.gate, 0.05f, static_cast<float>(MAX_STEPS));
+        for (float &velocity : track.velocities) {
+            velocity = std::clamp(velocity, 0.0f, 1.0f);
+        }
+    }
+    // Publish: the filled slot becomes the middle one, the old middle is ours to write
+    writeIndex = middle.exchange(writeIndex | DIRTY, std::memory_order_acq_rel) & (DIRTY - 1);
+    return true;
+}
+
+void StepSequencer::setTempo(float bpm) {
+    tempo.store(std::clamp(bpm, MIN_TEMPO, MAX_TEMPO), std::memory_order_relaxed);
+}
+
+void StepSequencer::start() {
+    running.store(true, std::memory_order_relaxed);
+}
+
+void StepSequencer::stop() {
+    running.store(false, std::memory_order_relaxed);
+}
+
+void StepSequencer::setTrackLock(bool enabled, float offsetMs) {
+    trackOffsetMs.store(offsetMs, std::memory_order_relaxed);
+    trackLock.store(enabled, std::memory_order_relaxed);
+}
+
+void StepSequencer::syncToTrack(double trackPositionMs, int64_t sampleTimeNs) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    const uint32_t sequence = syncSequence.load(std::memory_order_relaxed);
+    syncSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    syncPositionMs.store(trackPositionMs, std::memory_order_relaxed);
+    syncTimeNs.store(sampleTimeNs, std::memory_order_relaxed);
+    syncSequence.store(sequence + 2, std::memory_order_release);
+}
+
+void StepSequencer::setSampleRate(float rate) {
+    sampleRate = rate;
+}
+
+void StepSequencer::beginCallback(int64_t presentationNs) {
+    if (middle.load(std::memory_order_relaxed) & DIRTY) {
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & (DIRTY - 1);
+        nextStep %= patterns[readIndex].stepCount;
+    }
+
+    const bool wantRunning = running.load(std::memory_order_relaxed);
+    if (wantRunning && !playing) {
+        playing = true;
+        nextStep = 0;
+        framesToStep = 0.0;
+    } else if (!wantRunning && playing) {
+        playing = false;
+        // The held bass note is released by the next poll
+        if (framesToRelease > 0.0) {
+            framesToRelease = 0.0;
+        }
+    }
+
+    if (playing && trackLock.load(std::memory_order_relaxed)) {
+        applyTrackSync(presentationNs);
+    }
+}
+
+double StepSequencer::stepFrames() const {
+    const double beats = tempo.load(std::memory_order_relaxed) / 60.0;
+    return sampleRate / (beats * patterns[readIndex].stepsPerBeat);
+}
+
+double StepSequencer::swingOffset(int step) const {
+    return (step & 1) ? patterns[readIndex].swing * stepFrames() : 0.0;
+}
+
+int StepSequencer::poll(Event *events, int &frames) {
+    int count = 0;
+
+    // Release first, so a note ending on a step boundary doesn't cut the next one
+    if (framesToRelease >= 0.0 && framesToRelease < 0.5) {
+        events[count++] = {Target::Bass, 0.0f, 0.0f};
+        framesToRelease = -1.0;
+    }
+    if (playing && framesToStep < 0.5) {
+        fireStep(events, count);
+    }
+
+    // End the block on the frame of the next event
+    double nextEvent = playing ? framesToStep : static_cast<double>(frames);
+    if (framesToRelease >= 0.0) {
+        nextEvent = std::min(nextEvent, framesToRelease);
+    }
+    const int framesToEvent = std::max(1, static_cast<int>(std::ceil(nextEvent - 0.5)));
+    frames = std::min(frames, framesToEvent);
+    return count;
+}
+
+void StepSequencer::fireStep(Event *events, int &count) {
+    const Pattern &pattern = patterns[readIndex];
+    const int step = nextStep;
+    const double length = stepFrames();
+
+    for (int t = 0; t < pattern.trackCount; ++t) {
+        const Track &track = pattern.tracks[t];
+        const float velocity = track.velocities[step];
+        if (velocity <= 0.0f) {
+            continue;
+        }
+        if (track.target == Target::Drum) {
+            events[count++] = {Target::Drum, track.frequency, velocity};
+        } else {
+            const float frequency = track.frequency * std::exp2(track.semitones[step] / 12.0f);
+            events[count++] = {Target::Bass, frequency, velocity};
+            framesToRelease = framesToStep + track.gate * length;
+        }
+    }
+
+    // Step boundaries stay on the unswung grid; swing only moves the odd steps
+    nextStep = (step + 1) % pattern.stepCount;
+    framesToStep += length - swingOffset(step) + swingOffset(nextStep);
+}
+
+void StepSequencer::advance(int frames) {
+    if (playing) {
+        framesToStep -= frames;
+    }
+    if (framesToRelease >= 0.0) {
+        framesToRelease = std::max(0.0, framesToRelease - frames);
+    }
+}
+
+/**
+ * Compares where the track will be when this callback is heard with where
+ * the sequencer is, both in steps of the pattern, and corrects the phase.
+ */
+void StepSequencer::applyTrackSync(int64_t presentationNs) {
+    const uint32_t before = syncSequence.load(std::memory_order_acquire);
+    if (before == appliedSequence || (before & 1u)) {
+        return;
+    }
+    const double positionMs = syncPositionMs.load(std::memory_order_relaxed);
+    const int64_t timeNs = syncTimeNs.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (syncSequence.load(std::memory_order_relaxed) != before) {
+        return;  // Torn read, take the next sample
+    }
+    appliedSequence = before;
+
+    const Pattern &pattern = patterns[readIndex];
+    const double stepMs = 60000.0 / (tempo.load(std::memory_order_relaxed) * pattern.stepsPerBeat);
+    const double trackMs = positionMs + static_cast<double>(presentationNs - timeNs) * 1.0e-6 -
+                           trackOffsetMs.load(std::memory_order_relaxed);
+    const double steps = static_cast<double>(pattern.stepCount);
+    const double expected = std::fmod(std::fmod(trackMs / stepMs, steps) + steps, steps);
+
+    // Position of the sequencer on the unswung grid
+    const double length = stepFrames();
+    const double gridFrames = framesToStep - swingOffset(nextStep);
+    double current = static_cast<double>(nextStep) - gridFrames / length;
+    current = std::fmod(current + steps, steps);
+
+    double error = expected - current;  // > 0: the sequencer is late
+    error -= steps * std::round(error / steps);
+
+    if (std::fabs(error) > JUMP_THRESHOLD_STEPS) {
+        // Seek or loop in the track: restart from the step that is due next
+        const double next = std::floor(expected) + 1.0;
+        nextStep = static_cast<int>(next) % pattern.stepCount;
+        framesToStep = (next - expected) * length + swingOffset(nextStep);
+        return;
+    }
+    const double nudge = std::clamp(error * PLL_GAIN, -static_cast<double>(MAX_NUDGE_STEPS),
+                                    static_cast<double>(MAX_NUDGE_STEPS));
+    framesToStep -= nudge * length;
+}
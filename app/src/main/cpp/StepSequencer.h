@@ -0,0 +1,126 @@
+#ifndef STEP_SEQUENCER_H
+#define STEP_SEQUENCER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * StepSequencer - Sample-accurate pattern clock for drums and bass
+ *
+ * Runs inside the audio callback: the clock is counted in output frames,
+ * and the engine splits its render blocks at the exact frame where the next
+ * step (or bass release) is due, so hits land on the sample no matter what
+ * the UI thread or the GC are doing.
+ *
+ * Patterns are edited on the control thread and handed over through a
+ * triple buffer: the audio thread picks up the newest complete pattern with
+ * one atomic exchange and never waits. Tempo and transport are atomics.
+ *
+ * Swing delays every odd step by swing * step length (0.33 = triplet feel).
+ * The clock can also follow the backing track: the control thread reports
+ * the track position with its monotonic timestamp, and every callback
+ * compares it with the sequencer position at the callback's presentation
+ * time. Small errors are pulled in gradually (a phase-locked loop), large
+ * ones (seeks, loops) make the clock jump to the track position.
+ */
+class StepSequencer {
+public:
+    static constexpr int MAX_TRACKS = 8;
+    static constexpr int MAX_STEPS = 64;
+
+    enum class Target {
+        Drum,  // One-shot on the drum kit (frequency picks the drum class)
+        Bass   // Note on the sequencer's bass voice, released after the gate
+    };
+
+    struct Track {
+        Target target = Target::Drum;
+        float frequency = 60.0f;   // Drum pad / bass root in Hz
+        float gate = 0.5f;         // Bass note length in steps
+        std::array<float, MAX_STEPS> velocities{};  // 0 = rest
+        std::array<float, MAX_STEPS> semitones{};   // Per-step transposition (bass)
+    };
+
+    struct Pattern {
+        int stepCount = 16;
+        int stepsPerBeat = 4;      // 4 = sixteenth notes
+        float swing = 0.0f;        // 0 - MAX_SWING
+        int trackCount = 0;
+        std::array<Track, MAX_TRACKS> tracks{};
+    };
+
+    struct Event {
+        Target target;
+        float frequency;
+        float velocity;            // 0 = release (bass)
+    };
+    static constexpr int MAX_EVENTS = MAX_TRACKS + 1;  // One step plus a release
+
+    static constexpr float MIN_TEMPO = 20.0f;
+    static constexpr float MAX_TEMPO = 300.0f;
+    static constexpr float MAX_SWING = 0.5f;
+
+    StepSequencer();
+
+    // Control thread
+    bool setPattern(const Pattern &pattern);
+    void setTempo(float bpm);
+    float getTempo() const { return tempo.load(std::memory_order_relaxed); }
+    void start();  // From step 0 at the next callback
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    // Backing-track lock: offsetMs = track time of step 0 of the first bar
+    void setTrackLock(bool enabled, float offsetMs);
+    bool isTrackLocked() const { return trackLock.load(std::memory_order_relaxed); }
+    void syncToTrack(double trackPositionMs, int64_t sampleTimeNs);
+
+    // Audio thread (stream stopped for setSampleRate)
+    void setSampleRate(float rate);
+    void beginCallback(int64_t presentationNs);  // Transport, new pattern, track sync
+    // Events due at the current frame; shortens frames to end where the next one is due
+    int poll(Event *events, int &frames);
+    void advance(int frames);
+    bool isPlaying() const { return playing; }
+
+private:
+    double stepFrames() const;                // Unswung step length at the current tempo
+    double swingOffset(int step) const;       // Extra delay of a step in frames
+    void fireStep(Event *events, int &count);
+    void applyTrackSync(int64_t presentationNs);
+
+    static constexpr float PLL_GAIN = 0.1f;            // Fraction of the phase error corrected per sync
+    static constexpr float MAX_NUDGE_STEPS = 0.02f;    // Largest correction per sync
+    static constexpr float JUMP_THRESHOLD_STEPS = 0.5f;
+
+    // Triple buffer: control writes patterns[writeIndex], the audio thread
+    // reads patterns[readIndex], the third slot is exchanged through `middle`
+    static constexpr int DIRTY = 4;
+    std::array<Pattern, 3> patterns{};
+    std::mutex writerMutex;  // Control threads only
+    int writeIndex = 0;
+    std::atomic<int> middle{1};
+    int readIndex = 2;
+
+    std::atomic<float> tempo{120.0f};
+    std::atomic<bool> running{false};
+    std::atomic<bool> trackLock{false};
+    std::atomic<float> trackOffsetMs{0.0f};
+
+    // Track sync sample, published with a sequence counter (odd = being written)
+    std::atomic<uint32_t> syncSequence{0};
+    std::atomic<double> syncPositionMs{0.0};
+    std::atomic<int64_t> syncTimeNs{0};
+    uint32_t appliedSequence = 0;
+
+    // Audio thread state
+    float sampleRate = 48000.0f;
+    bool playing = false;
+    int nextStep = 0;              // Step fired when framesToStep reaches 0
+    double framesToStep = 0.0;
+    double framesToRelease = -1.0; // Bass gate, < 0 = no note held
+};
+
+#endif // STEP_SEQUENCER_H
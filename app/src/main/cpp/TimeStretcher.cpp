@@ -0,0 +1,304 @@
+#include "TimeStretcher.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Dot product and energy of b in one pass (the inner loop of the seek)
+inline void correlate(const float *a, const float *b, int n, float &dot, float &energy) {
+    int i = 0;
+#if defined(__aarch64__)
+    float32x4_t dotAcc = vdupq_n_f32(0.0f);
+    float32x4_t energyAcc = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t va = vld1q_f32(a + i);
+        float32x4_t vb = vld1q_f32(b + i);
+        dotAcc = vfmaq_f32(dotAcc, va, vb);
+        energyAcc = vfmaq_f32(energyAcc, vb, vb);
+    }
+    float d = vaddvq_f32(dotAcc);
+    float e = vaddvq_f32(energyAcc);
+#else
+    // Four independent accumulators so the compiler can vectorize
+    float d0 = 0.0f, d1 = 0.0f, d2 = 0.0f, d3 = 0.0f;
+    float e0 = 0.0f, e1 = 0.0f, e2 = 0.0f, e3 = 0.0f;
+    for (; i + 4 <= n; i += 4) {
+        d0 += a[i] * b[i];         e0 += b[i] * b[i];
+        d1 += a[i + 1] * b[i + 1]; e1 += b[i + 1] * b[i + 1];
+        d2 += a[i + 2] * b[i + 2]; e2 += b[i + 2] * b[i + 2];
+        d3 += a[i + 3] * b[i + 3]; e3 += b[i + 3] * b[i + 3];
+    }
+    float d = (d0 + d1) + (d2 + d3);
+    float e = (e0 + e1) + (e2 + e3);
+#endif
+    for (; i < n; ++i) {
+        d += a[i] * b[i];
+        e += b[i] * b[i];
+    }
+    dot = d;
+    energy = e;
+}
+
+inline float score(float dot, float energy) {
+    return dot / std::sqrt(energy + 1e-9f);
+}
+
+} // namespace
+
+TimeStretcher::TimeStretcher(int rate, int channelCount)
+        : sampleRate(rate),
+          channels(std::clamp(channelCount, 1, MAX_CHANNELS)) {
+    hop = std::max(32, static_cast<int>(FRAME_MS * 0.001f * rate) / 2);
+    frameLength = 2 * hop;
+    seekRange = static_cast<int>(SEEK_MS * 0.001f * rate);
+
+    // Periodic Hann: two windows at 50% overlap sum to exactly one
+    window.resize(frameLength);
+    for (int n = 0; n < frameLength; ++n) {
+        window[n] = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * n / frameLength);
+    }
+
+    accumulator.assign(static_cast<size_t>(frameLength) * channels, 0.0f);
+    coarseReference.resize(hop / DECIMATION + 1);
+    coarseCandidates.resize((hop + 2 * seekRange) / DECIMATION + 2);
+
+    // Room for a few large decoder buffers without reallocating
+    const size_t reserveFrames = static_cast<size_t>(rate);
+    input.reserve(reserveFrames * channels);
+    mono.reserve(reserveFrames);
+    stretched.reserve(reserveFrames * channels);
+    output.reserve(reserveFrames * channels);
+}
+
+void TimeStretcher::setTempo(float value) {
+    tempo.store(std::clamp(value, MIN_TEMPO, MAX_TEMPO), std::memory_order_relaxed);
+}
+
+void TimeStretcher::setPitchSemitones(float semitones) {
+    semitones = std::clamp(semitones, -MAX_SEMITONES, MAX_SEMITONES);
+    pitchRatio.store(std::pow(2.0f, semitones / 12.0f), std::memory_order_relaxed);
+}
+
+void TimeStretcher::reset() {
+    input.clear();
+    mono.clear();
+    inputBase = 0;
+    inputEnd = 0;
+    analysisPosition = 0.0;
+    previousPosition = -1;
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+    stretched.clear();
+    stretchedRead = 0;
+    resamplePosition = 0.0;
+    output.clear();
+    outputRead = 0;
+}
+
+void TimeStretcher::putSamples(const float *interleaved, int frames) {
+    input.insert(input.end(), interleaved, interleaved + static_cast<size_t>(frames) * channels);
+    const float scale = 1.0f / static_cast<float>(channels);
+    for (int i = 0; i < frames; ++i) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            sum += interleaved[i * channels + c];
+        }
+        mono.push_back(sum * scale);
+    }
+    inputEnd += frames;
+    process();
+}
+
+void TimeStretcher::putSamples(const int16_t *interleaved, int frames) {
+    conversion.resize(static_cast<size_t>(frames) * channels);
+    for (size_t i = 0; i < conversion.size(); ++i) {
+        conversion[i] = static_cast<float>(interleaved[i]) * (1.0f / 32768.0f);
+    }
+    putSamples(conversion.data(), frames);
+}
+
+int TimeStretcher::receiveSamples(float *interleaved, int maxFrames) {
+    const int frames = std::min(maxFrames, availableFrames());
+    const float *source = output.data() + static_cast<size_t>(outputRead) * channels;
+    std::copy(source, source + static_cast<size_t>(frames) * channels, interleaved);
+    outputRead += frames;
+    if (availableFrames() == 0) {
+        output.clear();
+        outputRead = 0;
+    }
+    return frames;
+}
+
+int TimeStretcher::receiveSamples(int16_t *interleaved, int maxFrames) {
+    const int frames = std::min(maxFrames, availableFrames());
+    const float *source = output.data() + static_cast<size_t>(outputRead) * channels;
+    for (size_t i = 0; i < static_cast<size_t>(frames) * channels; ++i) {
+        const float sample = std::clamp(source[i], -1.0f, 1.0f) * 32767.0f;
+        interleaved[i] = static_cast<int16_t>(std::lrint(sample));
+    }
+    outputRead += frames;
+    if (availableFrames() == 0) {
+        output.clear();
+        outputRead = 0;
+    }
+    return frames;
+}
+
+void TimeStretcher::drain() {
+    // Enough silence to push the last real frame through the overlap-add
+    std::vector<float> silence(static_cast<size_t>(frameLength + seekRange + hop) * channels, 0.0f);
+    putSamples(silence.data(), frameLength + seekRange + hop);
+}
+
+int64_t TimeStretcher::getPendingInputFrames() const {
+    return std::max<int64_t>(0, inputEnd - static_cast<int64_t>(analysisPosition));
+}
+
+/**
+ * Offset in [nominal - seekRange, nominal + seekRange] whose first hop
+ * frames best match the natural continuation of the previous frame.
+ */
+int TimeStretcher::findBestOffset(int64_t nominal, int64_t reference) {
+    const int64_t lowest = std::max(inputBase, nominal - seekRange);
+    const int span = static_cast<int>(nominal + seekRange - lowest);
+    if (span <= 0) {
+        return static_cast<int>(lowest - nominal);
+    }
+
+    // Coarse pass on a 4x decimated (box-averaged) mono mix
+    const float *ref = mono.data() + (reference - inputBase);
+    const int coarseLength = hop / DECIMATION;
+    for (int i = 0; i < coarseLength; ++i) {
+        const float *p = ref + i * DECIMATION;
+        coarseReference[i] = p[0] + p[1] + p[2] + p[3];
+    }
+    const float *candidates = mono.data() + (lowest - inputBase);
+    const int coarseCount = (span + hop) / DECIMATION;
+    for (int i = 0; i < coarseCount; ++i) {
+        const float *p = candidates + i * DECIMATION;
+        coarseCandidates[i] = p[0] + p[1] + p[2] + p[3];
+    }
+
+    int best = 0;
+    float bestScore = -1e30f;
+    for (int offset = 0; offset * DECIMATION <= span && offset + coarseLength <= coarseCount; ++offset) {
+        float dot, energy;
+        correlate(coarseReference.data(), coarseCandidates.data() + offset, coarseLength, dot, energy);
+        const float s = score(dot, energy);
+        if (s > bestScore) {
+            bestScore = s;
+            best = offset * DECIMATION;
+        }
+    }
+
+    // Refine around the coarse winner at full resolution
+    int refined = best;
+    bestScore = -1e30f;
+    for (int offset = std::max(0, best - DECIMATION + 1);
+         offset <= std::min(span, best + DECIMATION - 1); ++offset) {
+        float dot, energy;
+        correlate(ref, candidates + offset, hop, dot, energy);
+        const float s = score(dot, energy);
+        if (s > bestScore) {
+            bestScore = s;
+            refined = offset;
+        }
+    }
+    return static_cast<int>(lowest + refined - nominal);
+}
+
+void TimeStretcher::process() {
+    const float ratio = pitchRatio.load(std::memory_order_relaxed);
+
+    while (true) {
+        const auto nominal = static_cast<int64_t>(analysisPosition);
+        // Needs the whole seek window plus a frame, and the reference continuation
+        int64_t needed = nominal + seekRange + frameLength;
+        if (previousPosition >= 0) {
+            needed = std::max(needed, previousPosition + hop + hop);
+        }
+        if (needed > inputEnd) {
+            break;
+        }
+
+        int64_t position = nominal;
+        if (previousPosition >= 0) {
+            position += findBestOffset(nominal, previousPosition + hop);
+        }
+
+        // Overlap-add the windowed frame
+        const float *frame = input.data() + (position - inputBase) * channels;
+        for (int n = 0; n < frameLength; ++n) {
+            const float w = window[n];
+            for (int c = 0; c < channels; ++c) {
+                accumulator[n * channels + c] += w * frame[n * channels + c];
+            }
+        }
+
+        // The first hop frames are now complete
+        const size_t hopSamples = static_cast<size_t>(hop) * channels;
+        stretched.insert(stretched.end(), accumulator.begin(), accumulator.begin() + hopSamples);
+        std::copy(accumulator.begin() + hopSamples, accumulator.end(), accumulator.begin());
+        std::fill(accumulator.end() - hopSamples, accumulator.end(), 0.0f);
+
+        previousPosition = position;
+        analysisPosition += hop * tempo.load(std::memory_order_relaxed) / ratio;
+    }
+
+    resample(ratio);
+    compact();
+}
+
+// Cubic Hermite resampling of stretched into output by the pitch ratio
+void TimeStretcher::resample(float ratio) {
+    const int available = static_cast<int>(stretched.size() / channels);
+    if (ratio == 1.0f && resamplePosition == static_cast<double>(stretchedRead)) {
+        output.insert(output.end(), stretched.begin() + static_cast<size_t>(stretchedRead) * channels,
+                      stretched.end());
+        stretchedRead = available;
+        resamplePosition = available;
+        return;
+    }
+
+    while (true) {
+        const auto index = static_cast<int>(resamplePosition);
+        if (index + 2 >= available) {
+            break;
+        }
+        const float t = static_cast<float>(resamplePosition - index);
+        for (int c = 0; c < channels; ++c) {
+            const float y0 = stretched[std::max(0, index - 1) * channels + c];
+            const float y1 = stretched[index * channels + c];
+            const float y2 = stretched[(index + 1) * channels + c];
+            const float y3 = stretched[(index + 2) * channels + c];
+            const float c1 = 0.5f * (y2 - y0);
+            const float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+            const float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+            output.push_back(((c3 * t + c2) * t + c1) * t + y1);
+        }
+        resamplePosition += ratio;
+    }
+    stretchedRead = std::max(0, static_cast<int>(resamplePosition) - 1);
+}
+
+// Drops consumed input and stretched frames once they make up half the buffer
+void TimeStretcher::compact() {
+    int64_t keepFrom = static_cast<int64_t>(analysisPosition) - seekRange;
+    if (previousPosition >= 0) {
+        keepFrom = std::min(keepFrom, previousPosition + hop);
+    }
+    const int64_t drop = std::min(keepFrom, inputEnd) - inputBase;
+    if (drop > 0 && drop * 2 >= inputEnd - inputBase) {
+        input.erase(input.begin(), input.begin() + drop * channels);
+        mono.erase(mono.begin(), mono.begin() + drop);
+        inputBase += drop;
+    }
+
+    if (stretchedRead > 0 && static_cast<size_t>(stretchedRead) * channels * 2 >= stretched.size()) {
+        stretched.erase(stretched.begin(), stretched.begin() + static_cast<size_t>(stretchedRead) * channels);
+        resamplePosition -= stretchedRead;
+        stretchedRead = 0;
+    }
+}
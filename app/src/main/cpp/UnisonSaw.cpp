@@ -0,0 +1,58 @@
+#include "UnisonSaw.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+UnisonSaw::UnisonSaw() {
+    std::fill(std::begin(phases), std::end(phases), 0.0f);
+    std::fill(std::begin(ratios), std::end(ratios), 1.0f);
+    std::fill(std::begin(gains), std::end(gains), 0.0f);
+    gains[0] = 1.0f;
+}
+
+void UnisonSaw::configure(int count, float detuneCents, float mix) {
+    voices = std::clamp(count, 1, MAX_VOICES);
+    detuneCents = std::clamp(detuneCents, 0.0f, MAX_DETUNE_CENTS);
+    mix = std::clamp(mix, 0.0f, 1.0f);
+
+    // Detuned lanes in pairs, innermost first: -1/k, +1/k, -2/k, ... of the
+    // full detune, k = number of pairs (an odd lane out takes the lower side)
+    const int detuned = voices - 1;
+    const int pairs = (detuned + 1) / 2;
+    ratios[0] = 1.0f;
+    gains[0] = voices > 1 ? 1.0f - 0.5f * mix : 1.0f;
+    for (int lane = 1; lane < MAX_VOICES; ++lane) {
+        if (lane > detuned) {
+            ratios[lane] = 1.0f;
+            gains[lane] = 0.0f;
+            continue;
+        }
+        const int index = lane - 1;
+        const float sign = (index & 1) ? 1.0f : -1.0f;
+        const float offset = sign * static_cast<float>(index / 2 + 1) / static_cast<float>(pairs);
+        ratios[lane] = std::exp2(offset * detuneCents / 1200.0f);
+        gains[lane] = mix;
+    }
+
+    float power = 0.0f;
+    for (float gain : gains) {
+        power += gain * gain;
+    }
+    const float norm = power > 0.0f ? 1.0f / std::sqrt(power) : 0.0f;
+    gainSum = 0.0f;
+    for (float &gain : gains) {
+        gain *= norm;
+        gainSum += gain;
+    }
+}
+
+void UnisonSaw::randomizePhases(dsp::NoiseGenerator &noise) {
+    for (int lane = 0; lane < voices; ++lane) {
+        float phase = 0.5f * (noise.next() + 1.0f);
+        phases[lane] = phase < 1.0f ? phase : 0.0f;
+    }
+    // Unused lanes follow lane 0 (same ratio), so they add no edges of their own
+    for (int lane = voices; lane < MAX_VOICES; ++lane) {
+        phases[lane] = phases[0];
+    }
+}
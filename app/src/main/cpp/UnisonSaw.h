@@ -0,0 +1,248 @@
+#ifndef UNISON_SAW_H
+#define UNISON_SAW_H
+
+#include "DspUtils.h"
+#include "PolyBlep.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+
+/**
+ * UnisonSaw - Detuned sawtooth stack ("supersaw") for the synth lead
+ *
+ * Up to MAX_VOICES saws per note, processed as one lane group: the phases,
+ * detune ratios and gains live in two 4-float vectors, so advancing and
+ * mixing all of them is a handful of NEON/SSE2 instructions per sample,
+ * whatever the voice count (unused lanes have zero gain). Each lane is a
+ * polyBLEP saw, like the single-voice synth lead.
+ *
+ * Lane 0 plays the note itself; the others are spread symmetrically up to
+ * +-detuneCents around it. mix balances the detuned lanes against the
+ * centre (0 = centre only, 1 = detuned lanes at full level, centre at
+ * half), and the gains are normalized to constant power, since the lanes
+ * start at random phases and add incoherently.
+ */
+class UnisonSaw {
+public:
+    static constexpr int MAX_VOICES = 8;
+    static constexpr float MAX_DETUNE_CENTS = 100.0f;
+
+    UnisonSaw();
+
+    // voices = 1 turns the stack off (the oscillator's own saw plays)
+    void configure(int voices, float detuneCents, float mix);
+    int getVoices() const { return voices; }
+
+    // Note start: random phases, so retriggers don't all sound the same
+    void randomizePhases(dsp::NoiseGenerator &noise);
+
+    // Sum of the lanes, then every lane advances by increment (cycles per
+    // sample at the note's pitch, < 1) times its detune ratio
+    inline float next(float increment);
+    // next() for numFrames samples at a fixed increment, with the lanes
+    // kept in registers for the whole block
+    inline void render(float *output, int numFrames, float increment);
+
+private:
+    alignas(16) float phases[MAX_VOICES];  // [0, 1)
+    alignas(16) float ratios[MAX_VOICES];
+    alignas(16) float gains[MAX_VOICES];
+    float gainSum = 1.0f;
+    int voices = 1;
+
+    static constexpr float MIN_INCREMENT = 1.0e-5f;  // Keeps 1 / dt finite
+};
+
+/**
+ * Each lane is 2p - 1 minus its polyBLEP residual (see PolyBlep.h), in the
+ * branch-free form (c2^2 - c1^2, with c1 = min(p / dt - 1, 0) and
+ * c2 = max((p - 1) / dt + 1, 0)), so the sum over the lanes is
+ * dot(gains, 2p - blep) - gainSum.
+ */
+inline float UnisonSaw::next(float increment) {
+    increment = std::max(increment, MIN_INCREMENT);
+#if defined(__aarch64__)
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t i0 = vmulq_n_f32(vld1q_f32(ratios), increment);
+    const float32x4_t i1 = vmulq_n_f32(vld1q_f32(ratios + 4), increment);
+    auto saw = [&](float32x4_t p, float32x4_t inc) {
+        const float32x4_t inv = vdivq_f32(one, inc);
+        const float32x4_t c1 = vminq_f32(vsubq_f32(vmulq_f32(p, inv), one), zero);
+        const float32x4_t c2 = vmaxq_f32(vfmaq_f32(one, vsubq_f32(p, one), inv), zero);
+        return vfmaq_f32(vfmsq_f32(vaddq_f32(p, p), c2, c2), c1, c1);
+    };
+    float32x4_t p0 = vld1q_f32(phases);
+    float32x4_t p1 = vld1q_f32(phases + 4);
+    const float dot = vaddvq_f32(vfmaq_f32(vmulq_f32(vld1q_f32(gains), saw(p0, i0)),
+                                           vld1q_f32(gains + 4), saw(p1, i1)));
+    p0 = vaddq_f32(p0, i0);
+    p1 = vaddq_f32(p1, i1);
+    vst1q_f32(phases, vsubq_f32(p0, vrndmq_f32(p0)));
+    vst1q_f32(phases + 4, vsubq_f32(p1, vrndmq_f32(p1)));
+#elif defined(__SSE2__)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 inc = _mm_set1_ps(increment);
+    const __m128 i0 = _mm_mul_ps(_mm_load_ps(ratios), inc);
+    const __m128 i1 = _mm_mul_ps(_mm_load_ps(ratios + 4), inc);
+    auto saw = [&](__m128 p, __m128 laneIncrement) {
+        const __m128 inv = _mm_div_ps(one, laneIncrement);
+        const __m128 c1 = _mm_min_ps(_mm_sub_ps(_mm_mul_ps(p, inv), one), zero);
+        const __m128 c2 = _mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(p, one), inv), one), zero);
+        return _mm_add_ps(_mm_sub_ps(_mm_add_ps(p, p), _mm_mul_ps(c2, c2)), _mm_mul_ps(c1, c1));
+    };
+    __m128 p0 = _mm_load_ps(phases);
+    __m128 p1 = _mm_load_ps(phases + 4);
+    __m128 sum = _mm_add_ps(_mm_mul_ps(_mm_load_ps(gains), saw(p0, i0)),
+                            _mm_mul_ps(_mm_load_ps(gains + 4), saw(p1, i1)));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    const float dot = _mm_cvtss_f32(sum);
+    // Phases are never negative, so truncation is floor (SSE2 has no round)
+    p0 = _mm_add_ps(p0, i0);
+    p1 = _mm_add_ps(p1, i1);
+    _mm_store_ps(phases, _mm_sub_ps(p0, _mm_cvtepi32_ps(_mm_cvttps_epi32(p0))));
+    _mm_store_ps(phases + 4, _mm_sub_ps(p1, _mm_cvtepi32_ps(_mm_cvttps_epi32(p1))));
+#else
+    float dot = 0.0f;
+    for (int i = 0; i < MAX_VOICES; ++i) {
+        const float laneIncrement = ratios[i] * increment;
+        dot += gains[i] * (2.0f * phases[i] - dsp::polyBlep(phases[i], laneIncrement));
+        const float phase = phases[i] + laneIncrement;
+        phases[i] = phase - std::floor(phase);
+    }
+#endif
+    return dot - gainSum;
+}
+
+/**
+ * Four samples per pass: the phases of samples 1-3 are taken from the
+ * first one (frac(p + k * increment)) instead of from each other, so the
+ * only loop-carried dependency is one step of 4 * increment, and the four
+ * lane sums are reduced together with a transpose. 1 / dt is computed once.
+ * Most groups have no edge in any lane; those are straight ramps and skip
+ * the polyBLEP and the wrap entirely.
+ */
+inline void UnisonSaw::render(float *output, int numFrames, float increment) {
+    increment = std::max(increment, MIN_INCREMENT);
+    int i = 0;
+#if defined(__aarch64__)
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t g0 = vld1q_f32(gains);
+    const float32x4_t g1 = vld1q_f32(gains + 4);
+    const float32x4_t i0 = vmulq_n_f32(vld1q_f32(ratios), increment);
+    const float32x4_t i1 = vmulq_n_f32(vld1q_f32(ratios + 4), increment);
+    const float32x4_t inv0 = vdivq_f32(one, i0);
+    const float32x4_t inv1 = vdivq_f32(one, i1);
+    const float32x4_t offset = vdupq_n_f32(gainSum);
+    float32x4_t p0 = vld1q_f32(phases);
+    float32x4_t p1 = vld1q_f32(phases + 4);
+    auto wrap = [](float32x4_t p) { return vsubq_f32(p, vrndmq_f32(p)); };
+    auto saw = [&](float32x4_t p, float32x4_t inv) {
+        const float32x4_t c1 = vminq_f32(vsubq_f32(vmulq_f32(p, inv), one), zero);
+        const float32x4_t c2 = vmaxq_f32(vfmaq_f32(one, vsubq_f32(p, one), inv), zero);
+        return vfmaq_f32(vfmsq_f32(vaddq_f32(p, p), c2, c2), c1, c1);
+    };
+    auto lanes = [&](float32x4_t q0, float32x4_t q1) {
+        return vfmaq_f32(vmulq_f32(g0, saw(q0, inv0)), g1, saw(q1, inv1));
+    };
+    // No lane within dt of its edge during the group: plain ramps, no wrap
+    const float32x4_t near0 = vmlsq_n_f32(one, i0, 4.0f);
+    const float32x4_t near1 = vmlsq_n_f32(one, i1, 4.0f);
+    const float slope = 2.0f * vaddvq_f32(vfmaq_f32(vmulq_f32(g0, i0), g1, i1));
+    const float32x4_t steps = {0.0f, slope, 2.0f * slope, 3.0f * slope};
+    for (; i + 4 <= numFrames; i += 4) {
+        const uint32x4_t edge = vorrq_u32(vorrq_u32(vcgtq_f32(p0, near0), vcltq_f32(p0, i0)),
+                                          vorrq_u32(vcgtq_f32(p1, near1), vcltq_f32(p1, i1)));
+        if (vmaxvq_u32(edge) == 0) {
+            const float start = 2.0f * vaddvq_f32(vfmaq_f32(vmulq_f32(g0, p0), g1, p1)) - gainSum;
+            vst1q_f32(output + i, vaddq_f32(vdupq_n_f32(start), steps));
+            p0 = vfmaq_n_f32(p0, i0, 4.0f);
+            p1 = vfmaq_n_f32(p1, i1, 4.0f);
+            continue;
+        }
+        const float32x4_t s0 = lanes(p0, p1);
+        const float32x4_t s1 = lanes(wrap(vaddq_f32(p0, i0)), wrap(vaddq_f32(p1, i1)));
+        const float32x4_t s2 = lanes(wrap(vfmaq_n_f32(p0, i0, 2.0f)), wrap(vfmaq_n_f32(p1, i1, 2.0f)));
+        const float32x4_t s3 = lanes(wrap(vfmaq_n_f32(p0, i0, 3.0f)), wrap(vfmaq_n_f32(p1, i1, 3.0f)));
+        const float32x4_t sums = vpaddq_f32(vpaddq_f32(s0, s1), vpaddq_f32(s2, s3));
+        vst1q_f32(output + i, vsubq_f32(sums, offset));
+        p0 = wrap(vfmaq_n_f32(p0, i0, 4.0f));
+        p1 = wrap(vfmaq_n_f32(p1, i1, 4.0f));
+    }
+    vst1q_f32(phases, p0);
+    vst1q_f32(phases + 4, p1);
+#elif defined(__SSE2__)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 g0 = _mm_load_ps(gains);
+    const __m128 g1 = _mm_load_ps(gains + 4);
+    const __m128 inc = _mm_set1_ps(increment);
+    const __m128 i0 = _mm_mul_ps(_mm_load_ps(ratios), inc);
+    const __m128 i1 = _mm_mul_ps(_mm_load_ps(ratios + 4), inc);
+    const __m128 inv0 = _mm_div_ps(one, i0);
+    const __m128 inv1 = _mm_div_ps(one, i1);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 three = _mm_set1_ps(3.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 offset = _mm_set1_ps(gainSum);
+    __m128 p0 = _mm_load_ps(phases);
+    __m128 p1 = _mm_load_ps(phases + 4);
+    auto wrap = [](__m128 p) { return _mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvttps_epi32(p))); };
+    auto saw = [&](__m128 p, __m128 inv) {
+        const __m128 c1 = _mm_min_ps(_mm_sub_ps(_mm_mul_ps(p, inv), one), zero);
+        const __m128 c2 = _mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(p, one), inv), one), zero);
+        return _mm_add_ps(_mm_sub_ps(_mm_add_ps(p, p), _mm_mul_ps(c2, c2)), _mm_mul_ps(c1, c1));
+    };
+    auto lanes = [&](__m128 q0, __m128 q1) {
+        return _mm_add_ps(_mm_mul_ps(g0, saw(q0, inv0)), _mm_mul_ps(g1, saw(q1, inv1)));
+    };
+    // No lane within dt of its edge during the group: plain ramps, no wrap
+    const __m128 near0 = _mm_sub_ps(one, _mm_mul_ps(i0, four));
+    const __m128 near1 = _mm_sub_ps(one, _mm_mul_ps(i1, four));
+    __m128 slope = _mm_add_ps(_mm_mul_ps(g0, i0), _mm_mul_ps(g1, i1));
+    slope = _mm_add_ps(slope, _mm_movehl_ps(slope, slope));
+    slope = _mm_add_ss(slope, _mm_shuffle_ps(slope, slope, 1));
+    const float step = 2.0f * _mm_cvtss_f32(slope);
+    const __m128 steps = _mm_setr_ps(0.0f, step, 2.0f * step, 3.0f * step);
+    for (; i + 4 <= numFrames; i += 4) {
+        const __m128 edge = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(p0, near0), _mm_cmplt_ps(p0, i0)),
+                                      _mm_or_ps(_mm_cmpgt_ps(p1, near1), _mm_cmplt_ps(p1, i1)));
+        if (_mm_movemask_ps(edge) == 0) {
+            __m128 sum = _mm_add_ps(_mm_mul_ps(g0, p0), _mm_mul_ps(g1, p1));
+            sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+            sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+            const float start = 2.0f * _mm_cvtss_f32(sum) - gainSum;
+            _mm_storeu_ps(output + i, _mm_add_ps(_mm_set1_ps(start), steps));
+            p0 = _mm_add_ps(p0, _mm_mul_ps(i0, four));
+            p1 = _mm_add_ps(p1, _mm_mul_ps(i1, four));
+            continue;
+        }
+        __m128 s0 = lanes(p0, p1);
+        __m128 s1 = lanes(wrap(_mm_add_ps(p0, i0)), wrap(_mm_add_ps(p1, i1)));
+        __m128 s2 = lanes(wrap(_mm_add_ps(p0, _mm_mul_ps(i0, two))),
+                          wrap(_mm_add_ps(p1, _mm_mul_ps(i1, two))));
+        __m128 s3 = lanes(wrap(_mm_add_ps(p0, _mm_mul_ps(i0, three))),
+                          wrap(_mm_add_ps(p1, _mm_mul_ps(i1, three))));
+        _MM_TRANSPOSE4_PS(s0, s1, s2, s3);
+        const __m128 sums = _mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3));
+        _mm_storeu_ps(output + i, _mm_sub_ps(sums, offset));
+        p0 = wrap(_mm_add_ps(p0, _mm_mul_ps(i0, four)));
+        p1 = wrap(_mm_add_ps(p1, _mm_mul_ps(i1, four)));
+    }
+    _mm_store_ps(phases, p0);
+    _mm_store_ps(phases + 4, p1);
+#endif
+    for (; i < numFrames; ++i) {
+        output[i] = next(increment);
+    }
+}
+
+#endif // UNISON_SAW_H
@@ -0,0 +1,161 @@
+#include "WavReader.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#define LOG_TAG "WavReader"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr uint16_t FORMAT_PCM = 1;
+constexpr uint16_t FORMAT_FLOAT = 3;
+constexpr uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+constexpr size_t READ_CHUNK_BYTES = 64 * 1024;
+
+uint16_t getU16(const uint8_t *p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t getU32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+float decodeSample(const uint8_t *p, uint16_t format, int bits) {
+    if (format == FORMAT_FLOAT) {
+        if (bits == 64) {
+            double value;
+            std::memcpy(&value, p, sizeof(value));
+            return static_cast<float>(value);
+        }
+        float value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    switch (bits) {
+        case 8:  return (static_cast<float>(p[0]) - 128.0f) / 128.0f;
+        case 16: return static_cast<float>(static_cast<int16_t>(getU16(p))) / 32768.0f;
+        case 24: {
+            // Into the top three bytes so the sign comes along
+            uint32_t bits32 = (static_cast<uint32_t>(p[0]) << 8) | (static_cast<uint32_t>(p[1]) << 16) |
+                              (static_cast<uint32_t>(p[2]) << 24);
+            int32_t value = static_cast<int32_t>(bits32);
+            return static_cast<float>(value) / 2147483648.0f;
+        }
+        default: return static_cast<float>(static_cast<int32_t>(getU32(p))) / 2147483648.0f;
+    }
+}
+
+} // namespace
+
+bool WavReader::readMono(const char *path, std::vector<float> &samples, int &sampleRate,
+                         int maxFrames) {
+    FILE *file = std::fopen(path, "rb");
+    if (file == nullptr) {
+        LOGE("Cannot open %s", path);
+        return false;
+    }
+
+    // Only as much of the file as the header and the first maxFrames need
+    std::vector<uint8_t> bytes;
+    bool endOfFile = false;
+    auto readTo = [&](size_t total) {
+        while (!endOfFile && bytes.size() < total) {
+            const size_t start = bytes.size();
+            bytes.resize(std::min(total, start + READ_CHUNK_BYTES));
+            const size_t read = std::fread(bytes.data() + start, 1, bytes.size() - start, file);
+            bytes.resize(start + read);
+            endOfFile = read == 0;
+        }
+    };
+
+    // The header grows until it reaches the data chunk (metadata chunks can come first)
+    Layout layout;
+    bool parsed = false;
+    for (size_t headerBytes = READ_CHUNK_BYTES; !parsed; headerBytes *= 2) {
+        readTo(headerBytes);
+        parsed = parseLayout(bytes.data(), bytes.size(), layout);
+        if (endOfFile) {
+            break;
+        }
+    }
+    if (parsed) {
+        const size_t declared = getU32(bytes.data() + layout.dataOffset - 4);
+        const size_t wanted = static_cast<size_t>(std::max(maxFrames, 0)) * layout.frameBytes;
+        readTo(layout.dataOffset + std::min(declared, wanted));
+        parsed = parseLayout(bytes.data(), bytes.size(), layout);
+    }
+    std::fclose(file);
+
+    if (!parsed) {
+        LOGE("Unsupported WAV %s (format %u, %d bits, %d channels)", path, layout.format,
+             layout.bits, layout.channels);
+        return false;
+    }
+    sampleRate = layout.sampleRate;
+
+    const size_t frames = std::min(layout.frames, static_cast<size_t>(std::max(maxFrames, 0)));
+    samples.assign(frames, 0.0f);
+    decodeMono(bytes.data() + layout.dataOffset, layout, samples.data(), static_cast<int>(frames));
+    return frames > 0;
+}
+
+bool WavReader::parseLayout(const uint8_t *bytes, size_t size, Layout &layout) {
+    layout = Layout{};
+    if (size < 12 || std::memcmp(bytes, "RIFF", 4) != 0 || std::memcmp(bytes + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool hasData = false;
+    size_t dataBytes = 0;
+    size_t offset = 12;
+    while (offset + 8 <= size) {
+        const uint8_t *header = bytes + offset;
+        const size_t chunkBytes = getU32(header + 4);
+        const size_t available = std::min(chunkBytes, size - offset - 8);
+        if (std::memcmp(header, "fmt ", 4) == 0 && available >= 16) {
+            layout.format = getU16(header + 8);
+            layout.channels = getU16(header + 10);
+            layout.sampleRate = static_cast<int>(getU32(header + 12));
+            layout.bits = getU16(header + 22);
+            if (layout.format == FORMAT_EXTENSIBLE && available >= 26) {
+                layout.format = getU16(header + 32);  // First two bytes of the sub-format GUID
+            }
+        } else if (std::memcmp(header, "data", 4) == 0) {
+            layout.dataOffset = offset + 8;
+            dataBytes = available;  // Truncated files keep what is there
+            hasData = true;
+        }
+        // A size past the end (truncated or corrupt) ends the walk before the advance can wrap
+        if (chunkBytes >= size - offset - 8) {
+            break;
+        }
+        offset += 8 + chunkBytes + (chunkBytes & 1);  // Chunks are word aligned
+    }
+
+    const int bits = layout.bits;
+    const bool supported = (layout.format == FORMAT_PCM && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) ||
+                           (layout.format == FORMAT_FLOAT && (bits == 32 || bits == 64));
+    if (!supported || layout.channels <= 0 || layout.sampleRate <= 0 || !hasData) {
+        return false;
+    }
+    layout.frameBytes = static_cast<size_t>(bits / 8) * layout.channels;
+    layout.frames = dataBytes / layout.frameBytes;
+    return true;
+}
+
+void WavReader::decodeMono(const uint8_t *frames, const Layout &layout, float *output, int count) {
+    const int bytesPerSample = layout.bits / 8;
+    const float scale = 1.0f / static_cast<float>(layout.channels);
+    for (int i = 0; i < count; ++i) {
+        const uint8_t *frame = frames + i * layout.frameBytes;
+        float sum = 0.0f;
+        for (int c = 0; c < layout.channels; ++c) {
+            sum += decodeSample(frame + c * bytesPerSample, layout.format, layout.bits);
+        }
+        output[i] = sum * scale;
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef WAV_READER_H
+#define WAV_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * WavReader - Loads short WAV files (impulse responses) into memory
+ *
+ * Reads RIFF/WAVE files with 8/16/24/32-bit integer PCM or 32/64-bit
+ * float samples, including WAVE_FORMAT_EXTENSIBLE. Multichannel files are
+ * downmixed to mono by averaging. readMono is meant for the control
+ * thread: it reads the header and the first maxFrames frames, never the
+ * rest of the file. parseLayout and decodeMono work on a file that is
+ * already in memory (e.g. memory-mapped), so a caller can decode any range
+ * of frames without reading the rest.
+ */
+class WavReader {
+public:
+    static bool readMono(const char *path, std::vector<float> &samples, int &sampleRate,
+                         int maxFrames = MAX_FRAMES);
+
+    static constexpr int MAX_FRAMES = 30 * 192000;  // Refuse anything longer than 30 s at 192 kHz
+
+    struct Layout {
+        uint16_t format = 0;
+        int channels = 0;
+        int bits = 0;
+        int sampleRate = 0;
+        size_t dataOffset = 0;  // Bytes from the start of the file
+        size_t frames = 0;      // Complete frames in the data chunk
+        size_t frameBytes = 0;
+    };
+
+    // Finds the fmt and data chunks; false if the format is not supported.
+    // Chunk sizes are checked against size, so a corrupt header cannot run past it.
+    static bool parseLayout(const uint8_t *bytes, size_t size, Layout &layout);
+
+    // Mono mix of count frames starting at the first frame pointer
+    static void decodeMono(const uint8_t *frames, const Layout &layout, float *output, int count);
+};
+
+#endif // WAV_READER_H
@@ -0,0 +1,169 @@
+#include "WavWriter.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+void putU16(uint8_t *&p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+    p += 2;
+}
+
+void putU32(uint8_t *&p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    p += 4;
+}
+
+void putU64(uint8_t *&p, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    p += 8;
+}
+
+void putTag(uint8_t *&p, const char *tag) {
+    std::memcpy(p, tag, 4);
+    p += 4;
+}
+
+// RIFF/WAVE + JUNK(28, becomes ds64) + fmt(16) + data header
+constexpr int HEADER_BYTES = 12 + 36 + 24 + 8;
+constexpr uint64_t MAX_RIFF_DATA_BYTES = 0xFFFFFFFFull - (HEADER_BYTES - 8);
+
+} // namespace
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+bool WavWriter::open(const char *path, int rate, int channels, SampleFormat sampleFormat) {
+    close();
+
+    file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    format = sampleFormat;
+    sampleRate = rate;
+    channelCount = channels;
+    dataBytes = 0;
+    staging.resize(STAGING_BYTES);
+    stagingUsed = 0;
+    if (format == SampleFormat::Pcm16) {
+        convertFloat.resize(CONVERT_SAMPLES);
+        convertPcm.resize(CONVERT_SAMPLES);
+    }
+
+    if (!writeHeader(false)) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool WavWriter::write(const float *samples, int numSamples) {
+    if (file == nullptr) {
+        return false;
+    }
+
+    const size_t bytesPerSample = format == SampleFormat::Pcm16 ? 2 : 4;
+    while (numSamples > 0) {
+        size_t room = (staging.size() - stagingUsed) / bytesPerSample;
+        if (room == 0) {
+            if (!flush()) return false;
+            continue;
+        }
+
+        int count = static_cast<int>(std::min(room, static_cast<size_t>(numSamples)));
+        uint8_t *out = staging.data() + stagingUsed;
+        if (format == SampleFormat::Pcm16) {
+            count = std::min(count, CONVERT_SAMPLES);
+            std::copy_n(samples, count, convertFloat.data());
+            converter.process(convertFloat.data(), convertPcm.data(), count, 1.0f);
+            for (int i = 0; i < count; ++i) {
+                putU16(out, static_cast<uint16_t>(convertPcm[i]));
+            }
+        } else {
+            std::memcpy(out, samples, count * sizeof(float));
+        }
+
+        stagingUsed += count * bytesPerSample;
+        dataBytes += count * bytesPerSample;
+        samples += count;
+        numSamples -= count;
+    }
+    return true;
+}
+
+bool WavWriter::flush() {
+    if (stagingUsed == 0) {
+        return true;
+    }
+    bool ok = std::fwrite(staging.data(), 1, stagingUsed, file) == stagingUsed;
+    stagingUsed = 0;
+    return ok;
+}
+
+bool WavWriter::close() {
+    if (file == nullptr) {
+        return true;
+    }
+
+    bool ok = flush();
+    ok = writeHeader(true) && ok;
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
+
+/**
+ * Writes the header at the start of the file. While recording the sizes
+ * are placeholders; on finalize they are patched, switching RIFF -> RF64
+ * and JUNK -> ds64 if the data no longer fits 32-bit sizes.
+ */
+bool WavWriter::writeHeader(bool finalize) {
+    uint8_t header[HEADER_BYTES] = {};
+    uint8_t *p = header;
+
+    const bool rf64 = finalize && dataBytes > MAX_RIFF_DATA_BYTES;
+    const uint16_t bytesPerSample = format == SampleFormat::Pcm16 ? 2 : 4;
+    const uint64_t riffSize = HEADER_BYTES - 8 + dataBytes;
+
+    putTag(p, rf64 ? "RF64" : "RIFF");
+    putU32(p, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(finalize ? riffSize : 0));
+    putTag(p, "WAVE");
+
+    putTag(p, rf64 ? "ds64" : "JUNK");
+    putU32(p, 28);
+    if (rf64) {
+        putU64(p, riffSize);
+        putU64(p, dataBytes);
+        putU64(p, dataBytes / (bytesPerSample * channelCount));
+        putU32(p, 0);  // No extra table entries
+    } else {
+        p += 28;
+    }
+
+    putTag(p, "fmt ");
+    putU32(p, 16);
+    putU16(p, format == SampleFormat::Pcm16 ? 1 : 3);  // PCM / IEEE float
+    putU16(p, static_cast<uint16_t>(channelCount));
+    putU32(p, static_cast<uint32_t>(sampleRate));
+    putU32(p, static_cast<uint32_t>(sampleRate * channelCount * bytesPerSample));
+    putU16(p, static_cast<uint16_t>(channelCount * bytesPerSample));
+    putU16(p, static_cast<uint16_t>(bytesPerSample * 8));
+
+    putTag(p, "data");
+    putU32(p, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(finalize ? dataBytes : 0));
+
+    // Only called on open (file empty) and on close, so no need to restore the position
+    if (std::fseek(file, 0, SEEK_SET) != 0) {
+        return false;
+    }
+    return std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
@@ -0,0 +1,61 @@
+#ifndef WAV_WRITER_H
+#define WAV_WRITER_H
+
+#include "PcmConverter.h"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/**
+ * WavWriter - Streaming WAV file writer
+ *
+ * Writes sample data sequentially through a large staging buffer and
+ * patches the header on close. A JUNK chunk is reserved after the RIFF
+ * header so recordings larger than 4 GB are promoted to RF64 in place,
+ * which keeps hours-long sessions valid.
+ *
+ * 16-bit files go through PcmConverter, the same TPDF-dithered, rounding
+ * conversion as the 16-bit output stream.
+ */
+class WavWriter {
+public:
+    enum class SampleFormat {
+        Pcm16,
+        Float32
+    };
+
+    WavWriter() = default;
+    ~WavWriter();
+
+    WavWriter(const WavWriter &) = delete;
+    WavWriter &operator=(const WavWriter &) = delete;
+
+    bool open(const char *path, int sampleRate, int channelCount, SampleFormat format);
+    bool write(const float *samples, int numSamples);  // Interleaved samples
+    bool close();
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t getDataBytes() const { return dataBytes; }
+
+private:
+    bool flush();
+    bool writeHeader(bool finalize);
+
+    static constexpr size_t STAGING_BYTES = 256 * 1024;  // Large sequential writes
+    static constexpr int CONVERT_SAMPLES = 1024;
+
+    FILE *file = nullptr;
+    SampleFormat format = SampleFormat::Pcm16;
+    int sampleRate = 48000;
+    int channelCount = 1;
+    uint64_t dataBytes = 0;
+    std::vector<uint8_t> staging;
+    size_t stagingUsed = 0;
+
+    // 16-bit path: the converter clips in place, so it works on a copy
+    PcmConverter converter;
+    std::vector<float> convertFloat;
+    std::vector<int16_t> convertPcm;
+};
+
+#endif // WAV_WRITER_H
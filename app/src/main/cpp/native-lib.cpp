@@ -1,26 +1,59 @@
 #include <jni.h>
 #include <memory>
+#include <string>
+#include <vector>
 #include "AudioEngine.h"
+#include "TimeStretcher.h"
 
 // Istanza globale dell'AudioEngine
 static std::unique_ptr<AudioEngine> audioEngine;
 
+// Copia UTF-8 di una jstring, rilasciata a fine scope
+class ScopedUtfChars {
+public:
+    ScopedUtfChars(JNIEnv *env, jstring string)
+            : env(env), string(string),
+              chars(string != nullptr ? env->GetStringUTFChars(string, nullptr) : nullptr) {}
+    ~ScopedUtfChars() {
+        if (chars != nullptr) {
+            env->ReleaseStringUTFChars(string, chars);
+        }
+    }
+    const char *get() const { return chars; }
+
+private:
+    JNIEnv *env;
+    jstring string;
+    const char *chars;
+};
+
 extern "C" {
 
 /**
- * Inizializza l'AudioEngine
+ * Inizializza l'AudioEngine (ritorna subito, le tabelle DSP arrivano in background)
+ * @param cacheDir Directory per la cache delle tabelle DSP (null = nessuna cache)
  * @return true se l'inizializzazione ha successo
  */
 JNIEXPORT jboolean JNICALL
-Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeCreate(JNIEnv *env, jobject thiz) {
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeCreate(JNIEnv *env, jobject thiz,
+                                                                  jstring cacheDir) {
     if (audioEngine) {
         return JNI_TRUE; // Già creato
     }
     
-    audioEngine = std::make_unique<AudioEngine>();
+    ScopedUtfChars directory(env, cacheDir);
+    audioEngine = std::make_unique<AudioEngine>(directory.get() != nullptr ? directory.get() : "");
     return audioEngine != nullptr ? JNI_TRUE : JNI_FALSE;
 }
 
+/**
+ * Indica se arena e one-shot di batteria sono stati pubblicati
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeAreTablesReady(JNIEnv *env, jobject thiz) {
+    return audioEngine && audioEngine->areTablesReady() ? JNI_TRUE : JNI_FALSE;
+}
+
 /**
  * Avvia lo stream audio
  * @return true se l'avvio ha successo
@@ -113,6 +146,39 @@ Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetWaveType(
     }
 }
 
+/**
+ * Imposta le zone strumento (layer e split della tastiera)
+ * @param types Tipo di ogni zona (come nativeSetWaveType)
+ * @param lowHz Frequenza minima della zona (inclusa)
+ * @param highHz Frequenza massima della zona (esclusa)
+ * @param levels Volume relativo della zona (0.0 - 1.0)
+ * @return true se le zone sono valide (1 - MAX_ZONES, array della stessa lunghezza)
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetInstrumentZones(
+        JNIEnv *env, jobject thiz, jintArray types, jfloatArray lowHz, jfloatArray highHz,
+        jfloatArray levels) {
+    if (!audioEngine || !types || !lowHz || !highHz || !levels) {
+        return JNI_FALSE;
+    }
+    
+    const jsize count = env->GetArrayLength(types);
+    if (count < 1 || count > AudioEngine::MAX_ZONES || env->GetArrayLength(lowHz) != count ||
+        env->GetArrayLength(highHz) != count || env->GetArrayLength(levels) != count) {
+        return JNI_FALSE;
+    }
+    jint zoneTypes[AudioEngine::MAX_ZONES];
+    jfloat zoneLow[AudioEngine::MAX_ZONES];
+    jfloat zoneHigh[AudioEngine::MAX_ZONES];
+    jfloat zoneLevels[AudioEngine::MAX_ZONES];
+    env->GetIntArrayRegion(types, 0, count, zoneTypes);
+    env->GetFloatArrayRegion(lowHz, 0, count, zoneLow);
+    env->GetFloatArrayRegion(highHz, 0, count, zoneHigh);
+    env->GetFloatArrayRegion(levels, 0, count, zoneLevels);
+    return audioEngine->setInstrumentZones(zoneTypes, zoneLow, zoneHigh, zoneLevels, count)
+           ? JNI_TRUE : JNI_FALSE;
+}
+
 /**
  * Imposta il pitch bend per una voce
  * @param voiceIndex Indice della voce (0-7)
@@ -126,6 +192,221 @@ Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetPitchBend(
     }
 }
 
+/**
+ * Imposta la scala nativa (tabella di frequenze per grado)
+ * @param root Nota fondamentale (0 = C ... 11 = B)
+ * @param intervals Semitoni dalla fondamentale, crescenti, il primo 0
+ * @param baseOctave Ottava del grado 0
+ * @return true se la scala è valida
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetScale(
+        JNIEnv *env, jobject thiz, jint root, jintArray intervals, jint baseOctave) {
+    if (!audioEngine || !intervals) {
+        return JNI_FALSE;
+    }
+    
+    const jsize count = env->GetArrayLength(intervals);
+    if (count < 1 || count > ScaleQuantizer::MAX_INTERVALS) {
+        return JNI_FALSE;
+    }
+    jint steps[ScaleQuantizer::MAX_INTERVALS];
+    env->GetIntArrayRegion(intervals, 0, count, steps);
+    return audioEngine->setScale(root, steps, count, baseOctave) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Suona il grado della scala corrente su una voce
+ * @param voiceIndex Indice della voce (0-7)
+ * @param degree Grado della scala (0 = fondamentale dell'ottava base)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeNoteOnDegree(
+        JNIEnv *env, jobject thiz, jint voiceIndex, jint degree) {
+    if (audioEngine) {
+        audioEngine->noteOnDegree(voiceIndex, degree);
+    }
+}
+
+/**
+ * Configura il bend nativo
+ * @param snapToScale Aggancia il bend alla nota della scala più vicina
+ * @param glideMs Costante di tempo del glide in ms (0 = salto immediato)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetBendMode(
+        JNIEnv *env, jobject thiz, jboolean snapToScale, jfloat glideMs) {
+    if (audioEngine) {
+        audioEngine->setBendMode(snapToScale == JNI_TRUE, glideMs);
+    }
+}
+
+/**
+ * Aggiunge il delta di un gesto al bend di una voce
+ * @param voiceIndex Indice della voce (0-7)
+ * @param deltaSemitones Variazione del bend in semitoni
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeBendBy(
+        JNIEnv *env, jobject thiz, jint voiceIndex, jfloat deltaSemitones) {
+    if (audioEngine) {
+        audioEngine->bendBy(voiceIndex, deltaSemitones);
+    }
+}
+
+/**
+ * Porta il bend di una voce a un valore assoluto, con glide e snap
+ * @param voiceIndex Indice della voce (0-7)
+ * @param semitones Bend in semitoni
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeBendTo(
+        JNIEnv *env, jobject thiz, jint voiceIndex, jfloat semitones) {
+    if (audioEngine) {
+        audioEngine->bendTo(voiceIndex, semitones);
+    }
+}
+
+/**
+ * Suona un one-shot di batteria con velocity
+ * @param frequency Frequenza del pad (seleziona kick/tom/snare/piatti/hi-hat)
+ * @param velocity Intensità del colpo da 0.0 a 1.0
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeTriggerDrum(
+        JNIEnv *env, jobject thiz, jfloat frequency, jfloat velocity) {
+    if (audioEngine) {
+        audioEngine->triggerDrum(frequency, velocity);
+    }
+}
+
+/**
+ * Imposta il pattern dello step sequencer (preso al prossimo callback)
+ * @param stepCount Numero di step (1-64)
+ * @param stepsPerBeat Step per battuta di metronomo (4 = sedicesimi)
+ * @param swing Ritardo degli step dispari in frazioni di step (0.0 - 0.5)
+ * @param targets Destinazione di ogni traccia (0 = batteria, 1 = basso)
+ * @param frequencies Pad di batteria o fondamentale del basso, in Hz
+ * @param gates Durata delle note di basso in step
+ * @param velocities Velocity per traccia e step (track * stepCount + step, 0 = pausa)
+ * @param semitones Trasposizione del basso per traccia e step, stesso ordine
+ * @return true se il pattern è valido
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetSequencerPattern(
+        JNIEnv *env, jobject thiz, jint stepCount, jint stepsPerBeat, jfloat swing,
+        jintArray targets, jfloatArray frequencies, jfloatArray gates,
+        jfloatArray velocities, jfloatArray semitones) {
+    if (!audioEngine || !targets || !frequencies || !gates || !velocities || !semitones) {
+        return JNI_FALSE;
+    }
+    
+    const jsize trackCount = env->GetArrayLength(targets);
+    if (trackCount > StepSequencer::MAX_TRACKS || stepCount < 1 ||
+        stepCount > StepSequencer::MAX_STEPS ||
+        env->GetArrayLength(frequencies) != trackCount || env->GetArrayLength(gates) != trackCount ||
+        env->GetArrayLength(velocities) != trackCount * stepCount ||
+        env->GetArrayLength(semitones) != trackCount * stepCount) {
+        return JNI_FALSE;
+    }
+    
+    StepSequencer::Pattern pattern;
+    pattern.stepCount = stepCount;
+    pattern.stepsPerBeat = stepsPerBeat;
+    pattern.swing = swing;
+    pattern.trackCount = trackCount;
+    for (jsize t = 0; t < trackCount; ++t) {
+        StepSequencer::Track &track = pattern.tracks[t];
+        jint target;
+        env->GetIntArrayRegion(targets, t, 1, &target);
+        track.target = target == 1 ? StepSequencer::Target::Bass : StepSequencer::Target::Drum;
+        env->GetFloatArrayRegion(frequencies, t, 1, &track.frequency);
+        env->GetFloatArrayRegion(gates, t, 1, &track.gate);
+        env->GetFloatArrayRegion(velocities, t * stepCount, stepCount, track.velocities.data());
+        env->GetFloatArrayRegion(semitones, t * stepCount, stepCount, track.semitones.data());
+    }
+    return audioEngine->setSequencerPattern(pattern) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Imposta il tempo dello step sequencer
+ * @param bpm Battiti al minuto (20 - 300)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetSequencerTempo(
+        JNIEnv *env, jobject thiz, jfloat bpm) {
+    if (audioEngine) {
+        audioEngine->setSequencerTempo(bpm);
+    }
+}
+
+/**
+ * Avvia (dallo step 0) o ferma lo step sequencer
+ * @param running true per avviare
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetSequencerRunning(
+        JNIEnv *env, jobject thiz, jboolean running) {
+    if (!audioEngine) {
+        return;
+    }
+    if (running) {
+        audioEngine->startSequencer();
+    } else {
+        audioEngine->stopSequencer();
+    }
+}
+
+/**
+ * Aggancia il clock del sequencer alla posizione della base
+ * @param enabled true per seguire la base
+ * @param offsetMs Posizione della base (ms) sul primo step della prima battuta
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetSequencerTrackLock(
+        JNIEnv *env, jobject thiz, jboolean enabled, jfloat offsetMs) {
+    if (audioEngine) {
+        audioEngine->setSequencerTrackLock(enabled, offsetMs);
+    }
+}
+
+/**
+ * Comunica la posizione corrente della base al sequencer agganciato
+ * @param positionMs Posizione della base in millisecondi
+ * @param timeNs Istante della lettura (System.nanoTime, CLOCK_MONOTONIC)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSyncSequencerToTrack(
+        JNIEnv *env, jobject thiz, jdouble positionMs, jlong timeNs) {
+    if (audioEngine) {
+        audioEngine->syncSequencerToTrack(positionMs, timeNs);
+    }
+}
+
+/**
+ * Imposta il numero di velocity layer pre-renderizzati per la batteria
+ * @param layers Numero di layer (1-4)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetDrumVelocityLayers(
+        JNIEnv *env, jobject thiz, jint layers) {
+    if (audioEngine) {
+        audioEngine->setDrumVelocityLayers(layers);
+    }
+}
+
+/**
+ * Batteria intonata sul pad (one-shot ricampionati); disattivata di default
+ * @param enabled true per seguire l'altezza del pad
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetDrumPitchTracking(
+        JNIEnv *env, jobject thiz, jboolean enabled) {
+    if (audioEngine) {
+        audioEngine->setDrumPitchTracking(enabled);
+    }
+}
+
 /**
  * Imposta i parametri della chitarra elettrica
  * @param sustain 0.0-1.0 quanto dura la nota
@@ -141,6 +422,309 @@ Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetGuitarParams(
     }
 }
 
+/**
+ * Attiva/disattiva il calcolo di meter e forma d'onda per la UI
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetAnalysisEnabled(
+        JNIEnv *env, jobject thiz, jboolean enabled) {
+    if (audioEngine) {
+        audioEngine->setAnalysisEnabled(enabled);
+    }
+}
+
+/**
+ * Restituisce il blocco condiviso di analisi come ByteBuffer diretto.
+ * La memoria appartiene all'engine: non usarlo dopo nativeDestroy.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeGetAnalysisBuffer(
+        JNIEnv *env, jobject thiz) {
+    if (audioEngine) {
+        return env->NewDirectByteBuffer(audioEngine->getAnalysisBuffer(),
+                                        static_cast<jlong>(AudioEngine::getAnalysisBufferSize()));
+    }
+    return nullptr;
+}
+
+/**
+ * Avvia (azzerando la traccia precedente) o ferma il tracing della latenza tocco-suono
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetLatencyTracingEnabled(
+        JNIEnv *env, jobject thiz, jboolean enabled) {
+    if (audioEngine) {
+        audioEngine->setLatencyTracingEnabled(enabled);
+    }
+}
+
+/**
+ * Esporta la traccia come timeline JSON (chrome://tracing, ui.perfetto.dev)
+ * @param path File di destinazione
+ * @return true se il file è stato scritto
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeExportLatencyTrace(
+        JNIEnv *env, jobject thiz, jstring path) {
+    ScopedUtfChars pathChars(env, path);
+    if (!audioEngine || pathChars.get() == nullptr) {
+        return JNI_FALSE;
+    }
+    return audioEngine->exportLatencyTrace(pathChars.get()) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Politica di affinità del thread audio: 0 = scheduler, 1 = core veloci,
+ * 2 = maschera esplicita (bit n = CPU n)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetAffinityPolicy(
+        JNIEnv *env, jobject thiz, jint policy, jlong cpuMask) {
+    if (audioEngine) {
+        audioEngine->setAffinityPolicy(policy, static_cast<uint64_t>(cpuMask));
+    }
+}
+
+/**
+ * Attiva/disattiva i performance hint di sistema (Android 13+)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetPerformanceHintEnabled(
+        JNIEnv *env, jobject thiz, jboolean enabled) {
+    if (audioEngine) {
+        audioEngine->setPerformanceHintEnabled(enabled);
+    }
+}
+
+/**
+ * CPU su cui è girato l'ultimo callback (-1 se lo stream non è mai partito)
+ */
+JNIEXPORT jint JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeGetAudioThreadCpu(
+        JNIEnv *env, jobject thiz) {
+    if (audioEngine) {
+        return audioEngine->getAudioThreadCpu();
+    }
+    return -1;
+}
+
+/**
+ * true se il thread audio ha una sessione di performance hint aperta
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeIsPerformanceHintActive(
+        JNIEnv *env, jobject thiz) {
+    if (audioEngine) {
+        return audioEngine->isPerformanceHintActive();
+    }
+    return false;
+}
+
+/**
+ * Memoria DSP totale dell'engine in byte (arena, voci, cache batteria)
+ */
+JNIEXPORT jlong JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeGetDspMemoryBytes(
+        JNIEnv *env, jobject thiz) {
+    if (audioEngine) {
+        return static_cast<jlong>(audioEngine->getDspMemoryBytes());
+    }
+    return 0;
+}
+
+/**
+ * Formato delle delay line del riverbero (solo a stream fermo)
+ * @param format 0=float, 1=half (fp16), 2=fisso 16 bit
+ * @return true se applicato
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetDelayStorage(
+        JNIEnv *env, jobject thiz, jint format) {
+    if (audioEngine) {
+        return audioEngine->setDelayStorage(format) ? JNI_TRUE : JNI_FALSE;
+    }
+    return JNI_FALSE;
+}
+
+/**
+ * Formato dello stream di uscita; se lo stream è aperto viene riaperto
+ * @param format 0=preferito dal dispositivo, 1=float, 2=PCM 16 bit
+ * @return true se il formato è valido
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetOutputFormat(
+        JNIEnv *env, jobject thiz, jint format) {
+    if (audioEngine) {
+        return audioEngine->setOutputFormat(format) ? JNI_TRUE : JNI_FALSE;
+    }
+    return JNI_FALSE;
+}
+
+/**
+ * Formato effettivo dello stream
+ * @return 1=float, 2=PCM 16 bit, 0=stream chiuso
+ */
+JNIEXPORT jint JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeGetOutputFormat(
+        JNIEnv *env, jobject thiz) {
+    if (audioEngine) {
+        return audioEngine->getOutputFormat();
+    }
+    return 0;
+}
+
+/**
+ * Latenza di uscita stimata da Oboe
+ * @return Millisecondi, negativo se non disponibile
+ */
+JNIEXPORT jdouble JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeGetOutputLatencyMs(
+        JNIEnv *env, jobject thiz) {
+    if (audioEngine) {
+        return audioEngine->getOutputLatencyMs();
+    }
+    return -1.0;
+}
+
+/**
+ * Ingresso full-duplex con pitch tracking; se lo stream è aperto viene riaperto
+ * @param enabled true per leggere l'ingresso (serve il permesso RECORD_AUDIO)
+ * @return true se applicato (a stream avviato: se l'ingresso si è aperto)
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetInputEnabled(
+        JNIEnv *env, jobject thiz, jboolean enabled) {
+    if (audioEngine) {
+        return audioEngine->setInputEnabled(enabled) ? JNI_TRUE : JNI_FALSE;
+    }
+    return JNI_FALSE;
+}
+
+/**
+ * File WAV letto al posto del dispositivo di ingresso (solo a stream fermo)
+ * @param path File WAV, oppure null per tornare al dispositivo
+ * @return true se il file è stato caricato
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetInputFile(
+        JNIEnv *env, jobject thiz, jstring path) {
+    ScopedUtfChars pathChars(env, path);
+    if (!audioEngine || (path != nullptr && pathChars.get() == nullptr)) {
+        return JNI_FALSE;
+    }
+    return audioEngine->setInputFile(pathChars.get()) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Ultima stima del pitch tracker, letta senza lock
+ * @return {frequenza in Hz (0 = nessuna nota), confidenza 0..1, frame di
+ *         ingresso a fine finestra}, oppure null senza ingresso attivo
+ */
+JNIEXPORT jdoubleArray JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeGetInputPitch(
+        JNIEnv *env, jobject thiz) {
+    if (!audioEngine || !audioEngine->isInputActive()) {
+        return nullptr;
+    }
+    
+    const PitchTracker::Estimate estimate = audioEngine->getInputPitch();
+    const jdouble values[] = {
+        static_cast<jdouble>(estimate.frequency),
+        static_cast<jdouble>(estimate.confidence),
+        static_cast<jdouble>(estimate.frame)
+    };
+    jdoubleArray result = env->NewDoubleArray(3);
+    if (result) {
+        env->SetDoubleArrayRegion(result, 0, 3, values);
+    }
+    return result;
+}
+
+/**
+ * @return Callback in cui l'ingresso non aveva abbastanza frame (riempiti di silenzio)
+ */
+JNIEXPORT jlong JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeGetInputUnderruns(
+        JNIEnv *env, jobject thiz) {
+    if (!audioEngine) {
+        return 0;
+    }
+    return static_cast<jlong>(audioEngine->getInputUnderruns());
+}
+
+/**
+ * Attiva/disattiva la riduzione automatica della qualità sotto carico CPU
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetQualityGovernorEnabled(
+        JNIEnv *env, jobject thiz, jboolean enabled) {
+    if (audioEngine) {
+        audioEngine->setQualityGovernorEnabled(enabled);
+    }
+}
+
+/**
+ * Modalità test: sostituisce il carico misurato con un valore sintetico
+ * @param load Frazione della deadline del buffer (< 0 = torna al carico misurato)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetSyntheticLoad(
+        JNIEnv *env, jobject thiz, jfloat load) {
+    if (audioEngine) {
+        audioEngine->setSyntheticLoad(load);
+    }
+}
+
+/**
+ * Tier di qualità corrente (0 = piena qualità)
+ */
+JNIEXPORT jint JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeGetQualityTier(
+        JNIEnv *env, jobject thiz) {
+    if (audioEngine) {
+        return audioEngine->getQualityTier();
+    }
+    return 0;
+}
+
+/**
+ * Imposta dopo quanto silenzio lo stream si sospende per risparmiare batteria
+ * @param milliseconds Timeout di inattività (0 = stream sempre attivo)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetIdleTimeout(
+        JNIEnv *env, jobject thiz, jint milliseconds) {
+    if (audioEngine) {
+        audioEngine->setIdleTimeout(milliseconds);
+    }
+}
+
+/**
+ * Sceglie la forma delle rampe ADSR di tutte le voci
+ * @param exponential true per curve esponenziali, false per rampe lineari
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetEnvelopeCurve(
+        JNIEnv *env, jobject thiz, jboolean exponential) {
+    if (audioEngine) {
+        audioEngine->setEnvelopeCurve(exponential);
+    }
+}
+
+/**
+ * Unison del synth lead (supersaw)
+ * @param voices Seghe per nota (1 = disattivato, massimo 8)
+ * @param detuneCents Desintonia delle voci più esterne (0-100 cent)
+ * @param mix Livello delle voci desintonizzate rispetto alla centrale (0-1)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetUnison(
+        JNIEnv *env, jobject thiz, jint voices, jfloat detuneCents, jfloat mix) {
+    if (audioEngine) {
+        audioEngine->setUnison(voices, detuneCents, mix);
+    }
+}
+
 /**
  * Attiva/disattiva il Wah pedal
  * @param enabled true per attivare, false per disattivare
@@ -165,4 +749,365 @@ Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetWahPosition(
     }
 }
 
+/**
+ * Sceglie dove girano gli effetti insert di uno strumento
+ * @param waveType Tipo di strumento (WAVE_*)
+ * @param placement 0 = per voce, 1 = bus insert condiviso
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetInsertPlacement(
+        JNIEnv *env, jobject thiz, jint waveType, jint placement) {
+    if (audioEngine) {
+        audioEngine->setInsertPlacement(waveType, placement);
+    }
+}
+
+/**
+ * Riordina gli slot della catena insert sul bus
+ * @param slots Permutazione di 0=Wah, 1=Amp, 2=Cabinet, 3=Reverb
+ * @return true se l'ordine è valido
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetInsertOrder(
+        JNIEnv *env, jobject thiz, jintArray slots) {
+    if (!audioEngine || slots == nullptr) {
+        return JNI_FALSE;
+    }
+    
+    jint order[InsertChain::NUM_SLOTS];
+    jsize count = env->GetArrayLength(slots);
+    if (count != InsertChain::NUM_SLOTS) {
+        return JNI_FALSE;
+    }
+    env->GetIntArrayRegion(slots, 0, count, order);
+    return audioEngine->setInsertOrder(order, count) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Attiva/disattiva il bypass di uno slot della catena insert
+ * @param slot 0=Wah, 1=Amp, 2=Cabinet, 3=Reverb
+ * @param bypass true per escludere lo slot
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetInsertBypass(
+        JNIEnv *env, jobject thiz, jint slot, jboolean bypass) {
+    if (audioEngine) {
+        audioEngine->setInsertBypass(slot, bypass == JNI_TRUE);
+    }
+}
+
+/**
+ * Carica una risposta all'impulso (WAV) per lo slot Cabinet o Reverb del
+ * bus insert, ricampionata al rate dello stream
+ * @param slot 2=Cabinet, 3=Reverb
+ * @param path File WAV, oppure null per tornare all'effetto interno
+ * @return true se l'IR è stata caricata
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeLoadImpulseResponse(
+        JNIEnv *env, jobject thiz, jint slot, jstring path) {
+    ScopedUtfChars pathChars(env, path);
+    if (!audioEngine || (path != nullptr && pathChars.get() == nullptr)) {
+        return JNI_FALSE;
+    }
+    return audioEngine->loadImpulseResponse(slot, pathChars.get()) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Carica lo strumento campionato: un WAV per zona, mappato in memoria
+ * @param paths File WAV delle zone (array vuoto = scarica lo strumento)
+ * @param rootHz Frequenza della nota registrata in ogni file
+ * @param lowHz Frequenza minima della zona (inclusa)
+ * @param highHz Frequenza massima della zona (esclusa; <= lowHz = nota più vicina)
+ * @return true se tutti i file sono stati mappati
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeLoadSampler(
+        JNIEnv *env, jobject thiz, jobjectArray paths, jfloatArray rootHz, jfloatArray lowHz,
+        jfloatArray highHz) {
+    if (!audioEngine || !paths || !rootHz || !lowHz || !highHz) {
+        return JNI_FALSE;
+    }
+    
+    const jsize count = env->GetArrayLength(paths);
+    if (count > Sampler::MAX_ZONES || env->GetArrayLength(rootHz) != count ||
+        env->GetArrayLength(lowHz) != count || env->GetArrayLength(highHz) != count) {
+        return JNI_FALSE;
+    }
+    std::vector<std::string> names(count);
+    std::vector<Sampler::ZoneSpec> zones(count);
+    for (jsize i = 0; i < count; ++i) {
+        auto path = static_cast<jstring>(env->GetObjectArrayElement(paths, i));
+        {
+            ScopedUtfChars pathChars(env, path);
+            if (pathChars.get() == nullptr) {
+                return JNI_FALSE;
+            }
+            names[i] = pathChars.get();
+        }
+        env->DeleteLocalRef(path);
+        zones[i].path = names[i].c_str();
+        env->GetFloatArrayRegion(rootHz, i, 1, &zones[i].rootHz);
+        env->GetFloatArrayRegion(lowHz, i, 1, &zones[i].lowHz);
+        env->GetFloatArrayRegion(highHz, i, 1, &zones[i].highHz);
+    }
+    return audioEngine->loadSampler(zones.data(), count) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * @return Blocchi in cui il prefetch del campionatore è arrivato in ritardo
+ */
+JNIEXPORT jlong JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeGetSamplerUnderruns(
+        JNIEnv *env, jobject thiz) {
+    if (!audioEngine) {
+        return 0;
+    }
+    return static_cast<jlong>(audioEngine->getSamplerUnderruns());
+}
+
+/**
+ * Avvia la registrazione dell'uscita master su file WAV
+ * @param path Percorso del file di destinazione
+ * @param format 0 = PCM 16 bit, 1 = float 32 bit
+ * @return true se il file è stato aperto
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeStartRecording(
+        JNIEnv *env, jobject thiz, jstring path, jint format) {
+    ScopedUtfChars pathChars(env, path);
+    if (!audioEngine || pathChars.get() == nullptr) {
+        return JNI_FALSE;
+    }
+    return audioEngine->startRecording(pathChars.get(), format) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Ferma la registrazione e finalizza il file
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeStopRecording(JNIEnv *env, jobject thiz) {
+    if (audioEngine) {
+        audioEngine->stopRecording();
+    }
+}
+
+/**
+ * @return Numero di blocchi persi perché il writer era in ritardo
+ */
+JNIEXPORT jlong JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeGetRecordingDroppedBlocks(
+        JNIEnv *env, jobject thiz) {
+    if (!audioEngine) {
+        return 0;
+    }
+    return static_cast<jlong>(audioEngine->getRecordingDroppedBlocks());
+}
+
+/**
+ * Avvia il log binario degli eventi di controllo
+ * @param path Percorso del file di log
+ * @return true se il log è partito
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeStartEventLog(
+        JNIEnv *env, jobject thiz, jstring path) {
+    ScopedUtfChars pathChars(env, path);
+    if (!audioEngine || pathChars.get() == nullptr) {
+        return JNI_FALSE;
+    }
+    return audioEngine->startEventLog(pathChars.get()) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Ferma il log degli eventi
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeStopEventLog(JNIEnv *env, jobject thiz) {
+    if (audioEngine) {
+        audioEngine->stopEventLog();
+    }
+}
+
+/**
+ * Renderizza offline un log di eventi su file WAV (lo stream deve essere fermo)
+ * @param logPath Log registrato con nativeStartEventLog
+ * @param wavPath File WAV di uscita
+ * @return true se il render è completo
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeRenderEventLog(
+        JNIEnv *env, jobject thiz, jstring logPath, jstring wavPath) {
+    ScopedUtfChars logChars(env, logPath);
+    ScopedUtfChars wavChars(env, wavPath);
+    if (!audioEngine || logChars.get() == nullptr || wavChars.get() == nullptr) {
+        return JNI_FALSE;
+    }
+    return audioEngine->renderEventLog(logChars.get(), wavChars.get()) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Riproduce un log di eventi in tempo reale sull'engine in esecuzione
+ * @param logPath Log registrato con nativeStartEventLog
+ * @return true se il replay è partito
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeStartEventReplay(
+        JNIEnv *env, jobject thiz, jstring logPath) {
+    ScopedUtfChars logChars(env, logPath);
+    if (!audioEngine || logChars.get() == nullptr) {
+        return JNI_FALSE;
+    }
+    return audioEngine->startEventReplay(logChars.get()) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Interrompe il replay in tempo reale
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeStopEventReplay(JNIEnv *env, jobject thiz) {
+    if (audioEngine) {
+        audioEngine->stopEventReplay();
+    }
+}
+
+/**
+ * Imposta il seed dei generatori di rumore (voci e batteria)
+ * @param seed Seed a 32 bit
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_NativeAudioEngine_nativeSetRandomSeed(
+        JNIEnv *env, jobject thiz, jint seed) {
+    if (audioEngine) {
+        audioEngine->setRandomSeed(static_cast<uint32_t>(seed));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Time-stretch delle basi (TimeStretchAudioProcessor): un'istanza per handle,
+// indipendente dall'AudioEngine, usata dal thread di riproduzione di ExoPlayer
+// ---------------------------------------------------------------------------
+
+static TimeStretcher *toStretcher(jlong handle) {
+    return reinterpret_cast<TimeStretcher *>(handle);
+}
+
+/**
+ * Crea uno stretcher per il formato PCM della base
+ * @param sampleRate Sample rate del PCM decodificato
+ * @param channels Numero di canali (interleaved)
+ * @return Handle da passare alle altre funzioni (0 se non valido)
+ */
+JNIEXPORT jlong JNICALL
+Java_com_smartinstrument_app_audio_TimeStretchAudioProcessor_nativeCreate(
+        JNIEnv *env, jobject thiz, jint sampleRate, jint channels) {
+    if (sampleRate <= 0 || channels <= 0 || channels > TimeStretcher::MAX_CHANNELS) {
+        return 0;
+    }
+    return reinterpret_cast<jlong>(new TimeStretcher(sampleRate, channels));
+}
+
+/**
+ * Distrugge lo stretcher
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_TimeStretchAudioProcessor_nativeDestroy(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    delete toStretcher(handle);
+}
+
+/**
+ * Imposta tempo e tonalità (applicati al prossimo hop, anche in riproduzione)
+ * @param tempo Velocità relativa (0.25 - 2.0)
+ * @param semitones Trasposizione in semitoni (-12 - +12)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_TimeStretchAudioProcessor_nativeSetParams(
+        JNIEnv *env, jobject thiz, jlong handle, jfloat tempo, jfloat semitones) {
+    if (TimeStretcher *stretcher = toStretcher(handle)) {
+        stretcher->setTempo(tempo);
+        stretcher->setPitchSemitones(semitones);
+    }
+}
+
+/**
+ * Svuota lo stretcher (seek)
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_TimeStretchAudioProcessor_nativeReset(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    if (TimeStretcher *stretcher = toStretcher(handle)) {
+        stretcher->reset();
+    }
+}
+
+/**
+ * Accoda PCM decodificato da un ByteBuffer diretto
+ * @param offset Offset in byte dal quale leggere
+ * @param frames Frame da accodare
+ * @param isFloat true = float 32 bit, false = PCM 16 bit
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_TimeStretchAudioProcessor_nativeQueueInput(
+        JNIEnv *env, jobject thiz, jlong handle, jobject buffer, jint offset, jint frames,
+        jboolean isFloat) {
+    TimeStretcher *stretcher = toStretcher(handle);
+    auto *data = static_cast<uint8_t *>(env->GetDirectBufferAddress(buffer));
+    if (!stretcher || !data || frames <= 0) {
+        return;
+    }
+    if (isFloat) {
+        stretcher->putSamples(reinterpret_cast<const float *>(data + offset), frames);
+    } else {
+        stretcher->putSamples(reinterpret_cast<const int16_t *>(data + offset), frames);
+    }
+}
+
+/**
+ * Frame già elaborati in attesa di essere letti
+ */
+JNIEXPORT jint JNICALL
+Java_com_smartinstrument_app_audio_TimeStretchAudioProcessor_nativeAvailableFrames(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    TimeStretcher *stretcher = toStretcher(handle);
+    return stretcher ? stretcher->availableFrames() : 0;
+}
+
+/**
+ * Legge i frame elaborati in un ByteBuffer diretto (dalla posizione 0)
+ * @return Frame scritti
+ */
+JNIEXPORT jint JNICALL
+Java_com_smartinstrument_app_audio_TimeStretchAudioProcessor_nativeReadOutput(
+        JNIEnv *env, jobject thiz, jlong handle, jobject buffer, jint maxFrames, jboolean isFloat) {
+    TimeStretcher *stretcher = toStretcher(handle);
+    void *data = env->GetDirectBufferAddress(buffer);
+    if (!stretcher || !data) {
+        return 0;
+    }
+    return isFloat ? stretcher->receiveSamples(static_cast<float *>(data), maxFrames)
+                   : stretcher->receiveSamples(static_cast<int16_t *>(data), maxFrames);
+}
+
+/**
+ * Fine dell'input: spinge fuori l'audio ancora nella finestra di overlap
+ */
+JNIEXPORT void JNICALL
+Java_com_smartinstrument_app_audio_TimeStretchAudioProcessor_nativeDrain(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    if (TimeStretcher *stretcher = toStretcher(handle)) {
+        stretcher->drain();
+    }
+}
+
+/**
+ * Frame accodati ma non ancora elaborati (per la durata media di ExoPlayer)
+ */
+JNIEXPORT jlong JNICALL
+Java_com_smartinstrument_app_audio_TimeStretchAudioProcessor_nativePendingInputFrames(
+        JNIEnv *env, jobject thiz, jlong handle) {
+    TimeStretcher *stretcher = toStretcher(handle);
+    return stretcher ? static_cast<jlong>(stretcher->getPendingInputFrames()) : 0;
+}
+
 } // extern "C"
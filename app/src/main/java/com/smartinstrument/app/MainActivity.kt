@@ -32,7 +32,7 @@ class MainActivity : ComponentActivity() {
         enableEdgeToEdge()
         
         // Initialize audio engine
-        audioEngine.create()
+        audioEngine.create(cacheDir)
         audioEngine.start()
         
         // Initialize track player and key detector
@@ -107,6 +107,10 @@ fun MainScreenWithPlayer(
     LaunchedEffect(Unit) {
         while (true) {
             trackPlayer.updatePosition()
+            // Keeps a track-locked step sequencer in phase with the backing track
+            if (trackPlayer.isPlaying.value) {
+                audioEngine.syncSequencerToTrack(trackPlayer.currentPosition.value.toDouble())
+            }
             delay(100)
         }
     }
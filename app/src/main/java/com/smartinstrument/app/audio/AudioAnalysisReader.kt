@@ -0,0 +1,108 @@
+package com.smartinstrument.app.audio
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * AudioAnalysisReader - Reads level meters and the oscilloscope waveform
+ * published by the native AnalysisTap.
+ *
+ * The buffer comes from [NativeAudioEngine.getAnalysisBuffer] and is shared
+ * with the audio thread: [poll] copies the latest complete snapshot into the
+ * preallocated arrays below without locking or allocating, so it can run
+ * every UI frame. Discard the reader when the engine is destroyed.
+ */
+class AudioAnalysisReader(buffer: ByteBuffer) {
+    
+    companion object {
+        private const val MAGIC = 0x54415341  // "ASAT" little-endian
+        private const val VERSION = 1
+        private const val MAX_RETRIES = 3
+        
+        // Header field offsets (see AnalysisTap::Header)
+        private const val OFFSET_VERSION = 4
+        private const val OFFSET_NUM_VOICES = 8
+        private const val OFFSET_WAVEFORM_POINTS = 12
+        private const val OFFSET_SLOT_BYTES = 20
+        private const val OFFSET_SLOTS = 24
+        private const val OFFSET_LATEST_SLOT = 28
+        
+        // Snapshot field offsets (see AnalysisTap::Snapshot)
+        private const val SLOT_SEQUENCE = 0
+        private const val SLOT_FRAME = 8
+        private const val SLOT_MASTER_PEAK = 16
+        private const val SLOT_MASTER_RMS = 20
+        private const val SLOT_VOICE_LEVELS = 24
+    }
+    
+    private val shared: ByteBuffer = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+    
+    val numVoices: Int
+    val waveformPoints: Int
+    private val slotBytes: Int
+    private val slotsOffset: Int
+    
+    /** Engine frame at the end of the last snapshot read */
+    var frame: Long = 0L
+        private set
+    var masterPeak: Float = 0f
+        private set
+    var masterRms: Float = 0f
+        private set
+    
+    /** Per-voice levels before master volume */
+    val voicePeak: FloatArray
+    val voiceRms: FloatArray
+    
+    /** Decimated master output, oldest sample first */
+    val waveform: FloatArray
+    
+    init {
+        require(shared.getInt(0) == MAGIC && shared.getInt(OFFSET_VERSION) == VERSION) {
+            "Unsupported analysis buffer"
+        }
+        numVoices = shared.getInt(OFFSET_NUM_VOICES)
+        waveformPoints = shared.getInt(OFFSET_WAVEFORM_POINTS)
+        slotBytes = shared.getInt(OFFSET_SLOT_BYTES)
+        slotsOffset = shared.getInt(OFFSET_SLOTS)
+        voicePeak = FloatArray(numVoices)
+        voiceRms = FloatArray(numVoices)
+        waveform = FloatArray(waveformPoints)
+    }
+    
+    /**
+     * Copies the latest snapshot into the public fields.
+     * @return true if a consistent snapshot was read, false if the writer
+     *         kept overwriting it (the previous values are left in place)
+     */
+    fun poll(): Boolean {
+        repeat(MAX_RETRIES) {
+            val slot = slotsOffset + shared.getInt(OFFSET_LATEST_SLOT) * slotBytes
+            val sequence = shared.getInt(slot + SLOT_SEQUENCE)
+            if (sequence and 1 != 0) return@repeat
+            
+            frame = shared.getLong(slot + SLOT_FRAME)
+            masterPeak = shared.getFloat(slot + SLOT_MASTER_PEAK)
+            masterRms = shared.getFloat(slot + SLOT_MASTER_RMS)
+            
+            var offset = slot + SLOT_VOICE_LEVELS
+            for (i in 0 until numVoices) {
+                voicePeak[i] = shared.getFloat(offset)
+                offset += 4
+            }
+            for (i in 0 until numVoices) {
+                voiceRms[i] = shared.getFloat(offset)
+                offset += 4
+            }
+            for (i in 0 until waveformPoints) {
+                waveform[i] = shared.getFloat(offset)
+                offset += 4
+            }
+            
+            if (shared.getInt(slot + SLOT_SEQUENCE) == sequence) {
+                return true
+            }
+        }
+        return false
+    }
+}
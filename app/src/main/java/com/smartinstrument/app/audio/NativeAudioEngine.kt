@@ -1,5 +1,10 @@
 package com.smartinstrument.app.audio
 
+import com.smartinstrument.app.music.MusicalKey
+import com.smartinstrument.app.music.PentatonicScale
+import java.io.File
+import java.nio.ByteBuffer
+
 /**
  * NativeAudioEngine - Wrapper Kotlin per l'AudioEngine C++/Oboe
  * 
@@ -21,21 +26,83 @@ class NativeAudioEngine {
         const val WAVE_DRUMS = 2     // Electronic drums
         const val WAVE_BASS = 3      // Electric Bass with slap
         const val WAVE_GUITAR = 4    // Electric Guitar with distortion
+        const val WAVE_SAMPLER = 5   // Multisample loaded with loadSampler
+        
+        // Zone strumento (layer/split)
+        const val MAX_ZONES = 4
+        const val MAX_SAMPLE_ZONES = 32
+        
+        // Unison del synth lead (setUnison)
+        const val MAX_UNISON_VOICES = 8
+        
+        // Bend nativo: glide interpolato a sample rate, spento di default (bend immediato)
+        const val DEFAULT_BEND_GLIDE_MS = 0f
+        
+        // Step sequencer nativo
+        const val SEQ_TARGET_DRUM = 0
+        const val SEQ_TARGET_BASS = 1
+        const val SEQ_MAX_TRACKS = 8
+        const val SEQ_MAX_STEPS = 64
+        
+        // Posizione degli effetti insert
+        const val INSERT_PER_VOICE = 0
+        const val INSERT_BUS = 1
+        
+        // Slot della catena insert sul bus
+        const val SLOT_WAH = 0
+        const val SLOT_AMP = 1
+        const val SLOT_CABINET = 2
+        const val SLOT_REVERB = 3
+        
+        // Formati di registrazione
+        const val RECORD_PCM16 = 0
+        const val RECORD_FLOAT = 1
+        
+        // Tier di qualità (QualityGovernor), cumulativi
+        const val QUALITY_FULL = 0
+        const val QUALITY_REDUCED_HARMONICS = 1
+        const val QUALITY_REDUCED_REVERB = 2
+        const val QUALITY_CAPPED_POLYPHONY = 3
+        
+        // Politiche di affinità del thread audio
+        const val AFFINITY_NONE = 0
+        const val AFFINITY_PERFORMANCE_CORES = 1
+        const val AFFINITY_CUSTOM = 2
+        
+        // Formato delle delay line del riverbero (setDelayStorage)
+        const val DELAY_STORAGE_FLOAT = 0
+        const val DELAY_STORAGE_HALF = 1
+        const val DELAY_STORAGE_FIXED16 = 2
+        
+        // Formato dello stream di uscita (setOutputFormat)
+        const val OUTPUT_FORMAT_AUTO = 0     // Quello preferito dal dispositivo
+        const val OUTPUT_FORMAT_FLOAT = 1
+        const val OUTPUT_FORMAT_PCM16 = 2
     }
     
     private var isCreated = false
     private var isStarted = false
     
     /**
-     * Inizializza l'engine audio nativo
+     * Inizializza l'engine audio nativo. Ritorna subito: le tabelle DSP
+     * (one-shot di batteria, delay line) vengono costruite in background e,
+     * con una cacheDir, salvate per rendere immediato l'avvio successivo.
+     * @param cacheDir Directory della cache su disco (es. context.cacheDir)
      * @return true se l'inizializzazione ha successo
      */
-    fun create(): Boolean {
+    fun create(cacheDir: File? = null): Boolean {
         if (isCreated) return true
-        isCreated = nativeCreate()
+        isCreated = nativeCreate(cacheDir?.absolutePath)
         return isCreated
     }
     
+    /**
+     * true quando le tabelle in background sono pronte (prima le batterie sono mute)
+     */
+    fun areTablesReady(): Boolean {
+        return isCreated && nativeAreTablesReady()
+    }
+    
     /**
      * Avvia lo stream audio
      * @return true se l'avvio ha successo
@@ -120,6 +187,46 @@ class NativeAudioEngine {
         }
     }
     
+    /**
+     * Imposta le zone strumento: ogni nota suona gli strumenti delle zone che
+     * contengono la sua frequenza. Zone sovrapposte = layer (al massimo 2
+     * strumenti melodici per nota), zone disgiunte = split della tastiera.
+     * setWaveType torna a una sola zona su tutta la tastiera.
+     * @param zones Da 1 a MAX_ZONES zone
+     * @return true se le zone sono state accettate
+     */
+    fun setInstrumentZones(zones: List<InstrumentZone>): Boolean {
+        if (!isCreated || zones.isEmpty() || zones.size > MAX_ZONES) {
+            return false
+        }
+        return nativeSetInstrumentZones(
+            IntArray(zones.size) { zones[it].waveType },
+            FloatArray(zones.size) { zones[it].lowHz },
+            FloatArray(zones.size) { zones[it].highHz },
+            FloatArray(zones.size) { zones[it].level }
+        )
+    }
+    
+    /**
+     * Due strumenti sovrapposti su tutta la tastiera (es. organo sotto la chitarra)
+     */
+    fun setLayer(mainType: Int, layerType: Int, layerLevel: Float = 0.6f): Boolean {
+        return setInstrumentZones(listOf(
+            InstrumentZone(mainType),
+            InstrumentZone(layerType, level = layerLevel)
+        ))
+    }
+    
+    /**
+     * Split: lowType sotto splitHz (es. basso sulle righe basse), highType sopra
+     */
+    fun setSplit(lowType: Int, highType: Int, splitHz: Float): Boolean {
+        return setInstrumentZones(listOf(
+            InstrumentZone(lowType, highHz = splitHz),
+            InstrumentZone(highType, lowHz = splitHz)
+        ))
+    }
+    
     /**
      * Imposta il pitch bend per una voce (bending della nota)
      * @param voiceIndex Indice della voce
@@ -131,6 +238,167 @@ class NativeAudioEngine {
         }
     }
     
+    /**
+     * Carica nel motore nativo la scala blues della tonalità: da qui in poi
+     * le note si suonano per grado e il bend può agganciarsi alla scala
+     * @param key Tonalità (fondamentale + maggiore/minore)
+     * @param baseOctave Ottava del grado 0 (come PentatonicScale.generateGridFrequencies)
+     */
+    fun setScale(key: MusicalKey, baseOctave: Int = 3): Boolean {
+        if (!isCreated) return false
+        return nativeSetScale(key.root.semitone, PentatonicScale.getIntervals(key.scaleType), baseOctave)
+    }
+    
+    /**
+     * Attiva il grado della scala corrente (la frequenza viene dalla tabella nativa)
+     * @param voiceIndex Indice della voce
+     * @param degree Grado (0 = fondamentale, corrisponde alla riga della griglia)
+     */
+    fun noteOnDegree(voiceIndex: Int, degree: Int) {
+        if (isStarted && voiceIndex in 0 until MAX_VOICES) {
+            nativeNoteOnDegree(voiceIndex, degree)
+        }
+    }
+    
+    /**
+     * Configura il bend nativo
+     * @param snapToScale Il bend scivola sulla nota della scala più vicina (bend "a bersaglio")
+     * @param glideMs Costante di tempo del glide, interpolato a sample rate (0 = salto)
+     */
+    fun setBendMode(snapToScale: Boolean, glideMs: Float = DEFAULT_BEND_GLIDE_MS) {
+        if (isCreated) {
+            nativeSetBendMode(snapToScale, glideMs)
+        }
+    }
+    
+    /**
+     * Aggiunge al bend di una voce il delta del gesto (il bend assoluto resta nativo)
+     * @param voiceIndex Indice della voce
+     * @param deltaSemitones Variazione in semitoni dall'ultimo evento del gesto
+     */
+    fun bendBy(voiceIndex: Int, deltaSemitones: Float) {
+        if (isStarted && voiceIndex in 0 until MAX_VOICES && deltaSemitones != 0f) {
+            nativeBendBy(voiceIndex, deltaSemitones)
+        }
+    }
+    
+    /**
+     * Porta il bend di una voce a un valore assoluto, con glide e snap
+     * @param voiceIndex Indice della voce
+     * @param semitones Bend in semitoni
+     */
+    fun bendTo(voiceIndex: Int, semitones: Float) {
+        if (isStarted && voiceIndex in 0 until MAX_VOICES) {
+            nativeBendTo(voiceIndex, semitones)
+        }
+    }
+    
+    /**
+     * Suona un one-shot di batteria con una velocity specifica
+     * @param frequency Frequenza del pad (vedi DrumSound.baseFreq)
+     * @param velocity Intensità del colpo da 0.0 a 1.0
+     */
+    fun triggerDrum(frequency: Float, velocity: Float) {
+        if (isStarted) {
+            nativeTriggerDrum(frequency, velocity.coerceIn(0f, 1f))
+        }
+    }
+    
+    /**
+     * Imposta il pattern dello step sequencer nativo. Il cambio avviene senza
+     * lock al prossimo callback, anche a sequencer avviato.
+     * @return true se il pattern è valido
+     */
+    fun setSequencerPattern(pattern: SequencerPattern): Boolean {
+        val steps = pattern.stepCount
+        val tracks = pattern.tracks
+        if (!isCreated || steps !in 1..SEQ_MAX_STEPS || tracks.size > SEQ_MAX_TRACKS) {
+            return false
+        }
+        return nativeSetSequencerPattern(
+            steps,
+            pattern.stepsPerBeat,
+            pattern.swing,
+            IntArray(tracks.size) { tracks[it].target },
+            FloatArray(tracks.size) { tracks[it].frequency },
+            FloatArray(tracks.size) { tracks[it].gateSteps },
+            FloatArray(tracks.size * steps) { tracks[it / steps].velocities.getOrElse(it % steps) { 0f } },
+            FloatArray(tracks.size * steps) { tracks[it / steps].semitones.getOrElse(it % steps) { 0f } }
+        )
+    }
+    
+    /**
+     * Imposta il tempo dello step sequencer
+     * @param bpm Battiti al minuto (20 - 300)
+     */
+    fun setSequencerTempo(bpm: Float) {
+        if (isCreated) {
+            nativeSetSequencerTempo(bpm)
+        }
+    }
+    
+    /**
+     * Avvia il sequencer dallo step 0 (al frame esatto del prossimo callback)
+     */
+    fun startSequencer() {
+        if (isStarted) {
+            nativeSetSequencerRunning(true)
+        }
+    }
+    
+    /**
+     * Ferma il sequencer (la nota di basso in corso viene rilasciata)
+     */
+    fun stopSequencer() {
+        if (isCreated) {
+            nativeSetSequencerRunning(false)
+        }
+    }
+    
+    /**
+     * Aggancia il clock del sequencer alla base: la posizione va poi
+     * comunicata con syncSequencerToTrack mentre la base suona
+     * @param offsetMs Posizione della base sul primo step della prima battuta
+     */
+    fun setSequencerTrackLock(enabled: Boolean, offsetMs: Float = 0f) {
+        if (isCreated) {
+            nativeSetSequencerTrackLock(enabled, offsetMs)
+        }
+    }
+    
+    /**
+     * Posizione corrente della base per il sequencer agganciato
+     * @param positionMs Posizione della base in millisecondi
+     * @param timeNs Istante della lettura della posizione (System.nanoTime)
+     */
+    fun syncSequencerToTrack(positionMs: Double, timeNs: Long = System.nanoTime()) {
+        if (isStarted) {
+            nativeSyncSequencerToTrack(positionMs, timeNs)
+        }
+    }
+    
+    /**
+     * Imposta il numero di velocity layer pre-renderizzati per la batteria
+     * @param layers Numero di layer (1-4)
+     */
+    fun setDrumVelocityLayers(layers: Int) {
+        if (isCreated) {
+            nativeSetDrumVelocityLayers(layers.coerceIn(1, 4))
+        }
+    }
+    
+    /**
+     * Batteria intonata sulla frequenza del colpo: il one-shot del pad più
+     * vicino viene ricampionato, quindi cambiano anche decadimento e colore
+     * del rumore. Disattivata di default (ogni pad di DrumSound è già
+     * renderizzato alla sua altezza)
+     */
+    fun setDrumPitchTracking(enabled: Boolean) {
+        if (isCreated) {
+            nativeSetDrumPitchTracking(enabled)
+        }
+    }
+    
     /**
      * Imposta i parametri della chitarra elettrica
      * @param sustain 0.0-1.0 durata della nota
@@ -149,6 +417,221 @@ class NativeAudioEngine {
         }
     }
     
+    /**
+     * Attiva/disattiva il calcolo di meter e forma d'onda (AudioAnalysisReader)
+     */
+    fun setAnalysisEnabled(enabled: Boolean) {
+        if (isCreated) {
+            nativeSetAnalysisEnabled(enabled)
+        }
+    }
+    
+    /**
+     * Blocco condiviso di analisi da passare ad AudioAnalysisReader.
+     * Valido finché l'engine non viene distrutto.
+     */
+    fun getAnalysisBuffer(): ByteBuffer? {
+        return if (isCreated) nativeGetAnalysisBuffer() else null
+    }
+    
+    /**
+     * Avvia (azzerando la traccia precedente) o ferma il tracing della
+     * latenza tocco-suono
+     */
+    fun setLatencyTracingEnabled(enabled: Boolean) {
+        if (isCreated) {
+            nativeSetLatencyTracingEnabled(enabled)
+        }
+    }
+    
+    /**
+     * Esporta la traccia come timeline JSON da aprire in ui.perfetto.dev
+     * o chrome://tracing
+     * @param path File di destinazione
+     * @return true se il file è stato scritto
+     */
+    fun exportLatencyTrace(path: String): Boolean {
+        return isCreated && nativeExportLatencyTrace(path)
+    }
+    
+    /**
+     * Su quali core gira il thread audio (AFFINITY_*). Con AFFINITY_CUSTOM
+     * cpuMask indica le CPU ammesse (bit n = CPU n).
+     */
+    fun setAffinityPolicy(policy: Int, cpuMask: Long = 0L) {
+        if (isCreated) {
+            nativeSetAffinityPolicy(policy, cpuMask)
+        }
+    }
+    
+    /**
+     * Attiva/disattiva i performance hint di sistema per il thread audio
+     */
+    fun setPerformanceHintEnabled(enabled: Boolean) {
+        if (isCreated) {
+            nativeSetPerformanceHintEnabled(enabled)
+        }
+    }
+    
+    /**
+     * CPU dell'ultimo callback audio (-1 se non disponibile)
+     */
+    fun getAudioThreadCpu(): Int {
+        return if (isCreated) nativeGetAudioThreadCpu() else -1
+    }
+    
+    /**
+     * true se il sistema riceve le durate di lavoro del thread audio
+     */
+    fun isPerformanceHintActive(): Boolean {
+        return isCreated && nativeIsPerformanceHintActive()
+    }
+    
+    /**
+     * Memoria DSP totale dell'engine in byte (per diagnostica)
+     */
+    fun getDspMemoryBytes(): Long {
+        return if (isCreated) nativeGetDspMemoryBytes() else 0L
+    }
+    
+    /**
+     * Formato dei campioni nelle delay line del riverbero (DELAY_STORAGE_*).
+     * I formati a 16 bit dimezzano il traffico di memoria delle 8 voci;
+     * il riverbero riparte da zero. Solo a stream fermo (prima di start()).
+     * @return true se applicato
+     */
+    fun setDelayStorage(format: Int): Boolean {
+        return isCreated && !isStarted && nativeSetDelayStorage(format)
+    }
+    
+    /**
+     * Formato dello stream di uscita (OUTPUT_FORMAT_*). In auto lo stream si
+     * apre nel formato nativo del dispositivo: se è PCM 16 bit la conversione
+     * (con dither) avviene nel callback invece che nel mixer. Il mix interno
+     * resta in float. Se lo stream è avviato viene riaperto.
+     * @return true se il formato è valido
+     */
+    fun setOutputFormat(format: Int): Boolean {
+        return isCreated && nativeSetOutputFormat(format)
+    }
+    
+    /**
+     * Formato effettivo dello stream: OUTPUT_FORMAT_FLOAT o OUTPUT_FORMAT_PCM16,
+     * 0 se lo stream non è aperto
+     */
+    fun getOutputFormat(): Int {
+        return if (isStarted) nativeGetOutputFormat() else 0
+    }
+    
+    /**
+     * Latenza di uscita stimata dai timestamp dello stream, in millisecondi
+     * (negativa se non ancora disponibile), per confrontare i formati
+     */
+    fun getOutputLatencyMs(): Double {
+        return if (isStarted) nativeGetOutputLatencyMs() else -1.0
+    }
+    
+    /**
+     * Ingresso full-duplex (chitarra o voce) letto nel callback di uscita con
+     * un pitch tracker in streaming: accordatore, tonalità di quello che si
+     * suona, armonizzazione. Per il microfono serve il permesso RECORD_AUDIO
+     * già concesso. Se lo stream è avviato viene riaperto.
+     * @return true se applicato; a stream avviato, se l'ingresso si è aperto
+     */
+    fun setInputEnabled(enabled: Boolean): Boolean {
+        return isCreated && nativeSetInputEnabled(enabled)
+    }
+    
+    /**
+     * File WAV al posto del dispositivo di ingresso, letto dallo stesso
+     * percorso del callback (prove senza microfono). Solo a stream fermo.
+     * @param path File WAV, oppure null per tornare al dispositivo
+     * @return true se il file è stato caricato
+     */
+    fun setInputFile(path: String?): Boolean {
+        return isCreated && !isStarted && nativeSetInputFile(path)
+    }
+    
+    /**
+     * Ultima stima del pitch dell'ingresso (aggiornata ogni ~5 ms)
+     * @return null se l'ingresso non è attivo
+     */
+    fun getInputPitch(): InputPitch? {
+        if (!isCreated) return null
+        val values = nativeGetInputPitch() ?: return null
+        return InputPitch(
+            frequencyHz = values[0].toFloat(),
+            confidence = values[1].toFloat(),
+            frame = values[2].toLong()
+        )
+    }
+    
+    /**
+     * @return Letture in cui l'ingresso non aveva abbastanza frame (riempite di silenzio)
+     */
+    fun getInputUnderruns(): Long {
+        return if (isCreated) nativeGetInputUnderruns() else 0
+    }
+    
+    /**
+     * Attiva/disattiva la riduzione automatica della qualità sotto carico CPU
+     */
+    fun setQualityGovernorEnabled(enabled: Boolean) {
+        if (isCreated) {
+            nativeSetQualityGovernorEnabled(enabled)
+        }
+    }
+    
+    /**
+     * Modalità test deterministica: carico sintetico come frazione della
+     * deadline del buffer (negativo = torna al carico misurato)
+     */
+    fun setSyntheticLoad(load: Float) {
+        if (isCreated) {
+            nativeSetSyntheticLoad(load)
+        }
+    }
+    
+    /**
+     * Tier di qualità corrente (QUALITY_*)
+     */
+    fun getQualityTier(): Int {
+        return if (isCreated) nativeGetQualityTier() else QUALITY_FULL
+    }
+    
+    /**
+     * Dopo quanti millisecondi di silenzio lo stream si ferma per risparmiare
+     * batteria (riparte da solo alla prossima nota). 0 = sempre attivo.
+     */
+    fun setIdleTimeout(milliseconds: Int) {
+        if (isCreated) {
+            nativeSetIdleTimeout(milliseconds.coerceAtLeast(0))
+        }
+    }
+    
+    /**
+     * Sceglie rampe ADSR esponenziali (più naturali) o lineari
+     */
+    fun setEnvelopeCurve(exponential: Boolean) {
+        if (isCreated) {
+            nativeSetEnvelopeCurve(exponential)
+        }
+    }
+    
+    /**
+     * Unison del synth lead (WAVE_SAWTOOTH): voices seghe per nota,
+     * desintonizzate fino a ±detuneCents, con fasi casuali a ogni nota.
+     * Costa circa come una voce sola, quindi non toglie polifonia.
+     * @param voices 1 (disattivato) - MAX_UNISON_VOICES
+     * @param detuneCents Desintonia delle voci più esterne, 0-100 cent
+     * @param mix Livello delle voci desintonizzate rispetto alla centrale, 0-1
+     */
+    fun setUnison(voices: Int, detuneCents: Float = 25f, mix: Float = 0.7f) {
+        if (isCreated) {
+            nativeSetUnison(voices.coerceIn(1, MAX_UNISON_VOICES), detuneCents, mix)
+        }
+    }
+    
     /**
      * Attiva/disattiva il Wah pedal
      */
@@ -168,8 +651,160 @@ class NativeAudioEngine {
         }
     }
     
+    /**
+     * Sceglie se gli effetti di uno strumento girano per voce o sul bus condiviso
+     * @param waveType Una delle costanti WAVE_* tranne WAVE_SAMPLER (rifiutato dal nativo)
+     * @param placement INSERT_PER_VOICE o INSERT_BUS
+     */
+    fun setInsertPlacement(waveType: Int, placement: Int) {
+        if (isCreated) {
+            nativeSetInsertPlacement(waveType, placement)
+        }
+    }
+    
+    /**
+     * Riordina la catena insert sul bus
+     * @param slots Permutazione delle costanti SLOT_*
+     * @return true se l'ordine è stato accettato
+     */
+    fun setInsertOrder(slots: IntArray): Boolean {
+        return isCreated && nativeSetInsertOrder(slots)
+    }
+    
+    /**
+     * Esclude/include uno slot della catena insert. SLOT_CABINET parte escluso
+     * (le chitarre per voce non hanno cassa): va incluso anche per usare l'IR
+     * @param slot Una delle costanti SLOT_*
+     */
+    fun setInsertBypass(slot: Int, bypass: Boolean) {
+        if (isCreated) {
+            nativeSetInsertBypass(slot, bypass)
+        }
+    }
+    
+    /**
+     * Carica una risposta all'impulso da file WAV per lo slot SLOT_CABINET
+     * (cassa, max ~2048 campioni) o SLOT_REVERB (stanza, fino a 10 s).
+     * Agisce sul bus insert: lo strumento deve usare INSERT_BUS.
+     * Lento (lettura e FFT): non chiamarlo dal main thread.
+     * @param path File WAV, oppure null per tornare all'effetto interno
+     * @return true se l'IR è stata caricata
+     */
+    fun loadImpulseResponse(slot: Int, path: String?): Boolean {
+        return isCreated && nativeLoadImpulseResponse(slot, path)
+    }
+    
+    /**
+     * Carica lo strumento campionato (WAVE_SAMPLER): ogni zona è un WAV
+     * mappato in memoria, di cui solo l'attacco resta in RAM; il resto
+     * viene letto in anticipo da un thread dedicato mentre la nota suona.
+     * Lento (mappatura e decodifica degli attacchi): non dal main thread.
+     * @param zones Zone del multisample (lista vuota = scarica)
+     * @return true se tutti i file sono stati caricati
+     */
+    fun loadSampler(zones: List<SampleZone>): Boolean {
+        if (!isCreated || zones.size > MAX_SAMPLE_ZONES) {
+            return false
+        }
+        return nativeLoadSampler(
+            Array(zones.size) { zones[it].path },
+            FloatArray(zones.size) { zones[it].rootHz },
+            FloatArray(zones.size) { zones[it].lowHz },
+            FloatArray(zones.size) { zones[it].highHz }
+        )
+    }
+    
+    /**
+     * @return Blocchi audio in cui lo streaming dei campioni era in ritardo
+     */
+    fun getSamplerUnderruns(): Long {
+        return if (isCreated) nativeGetSamplerUnderruns() else 0
+    }
+    
+    /**
+     * Avvia la registrazione dell'uscita su file WAV
+     * @param path Percorso del file (es. nella cartella dell'app)
+     * @param format RECORD_PCM16 o RECORD_FLOAT
+     * @return true se la registrazione è partita
+     */
+    fun startRecording(path: String, format: Int = RECORD_PCM16): Boolean {
+        return isCreated && nativeStartRecording(path, format)
+    }
+    
+    /**
+     * Ferma la registrazione e chiude il file
+     */
+    fun stopRecording() {
+        if (isCreated) {
+            nativeStopRecording()
+        }
+    }
+    
+    /**
+     * Blocchi audio persi durante la registrazione (writer in ritardo)
+     */
+    fun getRecordingDroppedBlocks(): Long {
+        return if (isCreated) nativeGetRecordingDroppedBlocks() else 0L
+    }
+    
+    /**
+     * Avvia il log binario degli eventi (note, bend, parametri) per il replay
+     * @param path Percorso del file di log
+     * @return true se il log è partito
+     */
+    fun startEventLog(path: String): Boolean {
+        return isCreated && nativeStartEventLog(path)
+    }
+    
+    /**
+     * Ferma il log degli eventi
+     */
+    fun stopEventLog() {
+        if (isCreated) {
+            nativeStopEventLog()
+        }
+    }
+    
+    /**
+     * Renderizza offline un log di eventi su WAV. Richiede lo stream fermo (stop()).
+     * @param logPath File registrato con startEventLog
+     * @param wavPath File WAV di uscita
+     * @return true se il render è completo
+     */
+    fun renderEventLog(logPath: String, wavPath: String): Boolean {
+        return isCreated && !isStarted && nativeRenderEventLog(logPath, wavPath)
+    }
+    
+    /**
+     * Riproduce un log di eventi in tempo reale
+     * @param logPath File registrato con startEventLog
+     * @return true se il replay è partito
+     */
+    fun startEventReplay(logPath: String): Boolean {
+        return isStarted && nativeStartEventReplay(logPath)
+    }
+    
+    /**
+     * Interrompe il replay in tempo reale
+     */
+    fun stopEventReplay() {
+        if (isCreated) {
+            nativeStopEventReplay()
+        }
+    }
+    
+    /**
+     * Imposta il seed dei generatori di rumore (rende il suono riproducibile)
+     */
+    fun setRandomSeed(seed: Int) {
+        if (isCreated) {
+            nativeSetRandomSeed(seed)
+        }
+    }
+    
     // Metodi JNI nativi
-    private external fun nativeCreate(): Boolean
+    private external fun nativeCreate(cacheDir: String?): Boolean
+    private external fun nativeAreTablesReady(): Boolean
     private external fun nativeStart(): Boolean
     private external fun nativeStop()
     private external fun nativeDestroy()
@@ -178,8 +813,126 @@ class NativeAudioEngine {
     private external fun nativeAllNotesOff()
     private external fun nativeSetMasterVolume(volume: Float)
     private external fun nativeSetWaveType(waveType: Int)
+    private external fun nativeSetInstrumentZones(
+        types: IntArray, lowHz: FloatArray, highHz: FloatArray, levels: FloatArray
+    ): Boolean
     private external fun nativeSetPitchBend(voiceIndex: Int, semitones: Float)
+    private external fun nativeSetScale(root: Int, intervals: IntArray, baseOctave: Int): Boolean
+    private external fun nativeNoteOnDegree(voiceIndex: Int, degree: Int)
+    private external fun nativeSetBendMode(snapToScale: Boolean, glideMs: Float)
+    private external fun nativeBendBy(voiceIndex: Int, deltaSemitones: Float)
+    private external fun nativeBendTo(voiceIndex: Int, semitones: Float)
+    private external fun nativeTriggerDrum(frequency: Float, velocity: Float)
+    private external fun nativeSetSequencerPattern(
+        stepCount: Int, stepsPerBeat: Int, swing: Float, targets: IntArray,
+        frequencies: FloatArray, gates: FloatArray, velocities: FloatArray, semitones: FloatArray
+    ): Boolean
+    private external fun nativeSetSequencerTempo(bpm: Float)
+    private external fun nativeSetSequencerRunning(running: Boolean)
+    private external fun nativeSetSequencerTrackLock(enabled: Boolean, offsetMs: Float)
+    private external fun nativeSyncSequencerToTrack(positionMs: Double, timeNs: Long)
+    private external fun nativeSetDrumVelocityLayers(layers: Int)
+    private external fun nativeSetDrumPitchTracking(enabled: Boolean)
     private external fun nativeSetGuitarParams(sustain: Float, gain: Float, distortion: Float, reverb: Float)
+    private external fun nativeSetAnalysisEnabled(enabled: Boolean)
+    private external fun nativeGetAnalysisBuffer(): ByteBuffer?
+    private external fun nativeGetDspMemoryBytes(): Long
+    private external fun nativeSetDelayStorage(format: Int): Boolean
+    private external fun nativeSetOutputFormat(format: Int): Boolean
+    private external fun nativeGetOutputFormat(): Int
+    private external fun nativeGetOutputLatencyMs(): Double
+    private external fun nativeSetInputEnabled(enabled: Boolean): Boolean
+    private external fun nativeSetInputFile(path: String?): Boolean
+    private external fun nativeGetInputPitch(): DoubleArray?
+    private external fun nativeGetInputUnderruns(): Long
+    private external fun nativeSetLatencyTracingEnabled(enabled: Boolean)
+    private external fun nativeExportLatencyTrace(path: String): Boolean
+    private external fun nativeSetAffinityPolicy(policy: Int, cpuMask: Long)
+    private external fun nativeSetPerformanceHintEnabled(enabled: Boolean)
+    private external fun nativeGetAudioThreadCpu(): Int
+    private external fun nativeIsPerformanceHintActive(): Boolean
+    private external fun nativeSetQualityGovernorEnabled(enabled: Boolean)
+    private external fun nativeSetSyntheticLoad(load: Float)
+    private external fun nativeGetQualityTier(): Int
+    private external fun nativeSetIdleTimeout(milliseconds: Int)
+    private external fun nativeSetEnvelopeCurve(exponential: Boolean)
+    private external fun nativeSetUnison(voices: Int, detuneCents: Float, mix: Float)
     private external fun nativeSetWahEnabled(enabled: Boolean)
     private external fun nativeSetWahPosition(position: Float)
+    private external fun nativeSetInsertPlacement(waveType: Int, placement: Int)
+    private external fun nativeSetInsertOrder(slots: IntArray): Boolean
+    private external fun nativeLoadImpulseResponse(slot: Int, path: String?): Boolean
+    private external fun nativeLoadSampler(
+        paths: Array<String>, rootHz: FloatArray, lowHz: FloatArray, highHz: FloatArray
+    ): Boolean
+    private external fun nativeGetSamplerUnderruns(): Long
+    private external fun nativeSetInsertBypass(slot: Int, bypass: Boolean)
+    private external fun nativeStartRecording(path: String, format: Int): Boolean
+    private external fun nativeStopRecording()
+    private external fun nativeGetRecordingDroppedBlocks(): Long
+    private external fun nativeStartEventLog(path: String): Boolean
+    private external fun nativeStopEventLog()
+    private external fun nativeRenderEventLog(logPath: String, wavPath: String): Boolean
+    private external fun nativeStartEventReplay(logPath: String): Boolean
+    private external fun nativeStopEventReplay()
+    private external fun nativeSetRandomSeed(seed: Int)
 }
+
+/**
+ * Zona strumento per NativeAudioEngine.setInstrumentZones: le note con
+ * frequenza in [lowHz, highHz) suonano waveType a volume level
+ */
+data class InstrumentZone(
+    val waveType: Int,
+    val lowHz: Float = 0f,
+    val highHz: Float = Float.POSITIVE_INFINITY,
+    val level: Float = 1f
+)
+
+/**
+ * Zona di NativeAudioEngine.loadSampler: il file WAV path, registrato alla
+ * nota rootHz, suona le note in [lowHz, highHz). Se highHz <= lowHz la zona
+ * viene scelta per la radice più vicina alla nota.
+ */
+data class SampleZone(
+    val path: String,
+    val rootHz: Float,
+    val lowHz: Float = 0f,
+    val highHz: Float = 0f
+)
+
+/**
+ * Traccia dello step sequencer: un pad di batteria o il basso del sequencer.
+ * velocities/semitones hanno un valore per step (0 = pausa, mancanti = 0).
+ */
+data class SequencerTrack(
+    val target: Int,
+    val frequency: Float,
+    val velocities: List<Float>,
+    val semitones: List<Float> = emptyList(),
+    val gateSteps: Float = 0.5f
+)
+
+/**
+ * Pattern per NativeAudioEngine.setSequencerPattern
+ * @param stepsPerBeat 4 = sedicesimi
+ * @param swing Ritardo degli step dispari in frazioni di step (0.0 - 0.5)
+ */
+data class SequencerPattern(
+    val tracks: List<SequencerTrack>,
+    val stepCount: Int = 16,
+    val stepsPerBeat: Int = 4,
+    val swing: Float = 0f
+)
+
+/**
+ * Stima del pitch dell'ingresso (NativeAudioEngine.getInputPitch).
+ * frequencyHz è 0 in silenzio o senza periodicità; confidence (0..1) è
+ * vicina a 1 per una nota stabile e bassa per rumore e accordi.
+ * frame = frame di ingresso letti alla fine della finestra di analisi.
+ */
+data class InputPitch(
+    val frequencyHz: Float,
+    val confidence: Float,
+    val frame: Long
+)
@@ -0,0 +1,219 @@
+package com.smartinstrument.app.audio
+
+import androidx.annotation.OptIn
+import androidx.media3.common.C
+import androidx.media3.common.PlaybackParameters
+import androidx.media3.common.audio.AudioProcessor
+import androidx.media3.common.audio.AudioProcessorChain
+import androidx.media3.common.audio.BaseAudioProcessor
+import androidx.media3.common.util.UnstableApi
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import kotlin.math.abs
+
+/**
+ * TimeStretchAudioProcessor - Native WSOLA time-stretch and pitch-shift for backing tracks
+ *
+ * Sits in ExoPlayer's audio sink, so decoded PCM is slowed down or transposed
+ * before it reaches the AudioTrack. Tempo and pitch can change while playing;
+ * the native side applies them at the next hop (about 15 ms). Latency added by
+ * the processor is bounded at roughly 40 ms.
+ *
+ * At tempo 1.0 and pitch 0 the processor is inactive, like ExoPlayer's Sonic
+ * processor at normal speed: the pipeline passes the PCM through untouched and
+ * no native stretcher exists. Activity is decided at each flush, so moving
+ * from or to unity needs one: TrackPlayer then pushes the settings as
+ * PlaybackParameters, which makes the sink drain and flush the pipeline.
+ */
+@OptIn(UnstableApi::class)
+class TimeStretchAudioProcessor : BaseAudioProcessor() {
+
+    companion object {
+        private const val MIN_FRAMES_FOR_SCALING = 1024L
+        private const val UNITY_TOLERANCE = 1e-3f
+
+        /**
+         * True when the settings leave the audio unchanged (processor inactive)
+         */
+        fun isUnity(tempo: Float, semitones: Float): Boolean =
+            abs(tempo - 1.0f) < UNITY_TOLERANCE && abs(semitones) < UNITY_TOLERANCE
+
+        init {
+            System.loadLibrary("smartinstrument")
+        }
+    }
+
+    // Written from the UI thread, handed to the native side on the playback thread
+    @Volatile private var currentTempo = 1.0f
+    @Volatile private var currentSemitones = 0.0f
+
+    // Decided at configure/flush time from the settings of that moment
+    private var stretching = false
+
+    private var handle = 0L
+    private var handleFormat = AudioProcessor.AudioFormat.NOT_SET
+    private var isFloat = false
+    private var bytesPerFrame = 0
+
+    // Heap input buffers are copied here, the native side needs a direct buffer
+    private var stagingBuffer: ByteBuffer = ByteBuffer.allocateDirect(0)
+
+    // Media time vs. playout time, for getMediaDuration
+    private var inputFrames = 0L
+    private var outputFrames = 0L
+
+    /**
+     * Set the playback speed (0.25 - 2.0, 1.0 = original)
+     */
+    fun setTempo(value: Float) {
+        currentTempo = value.coerceIn(0.25f, 2.0f)
+    }
+
+    /**
+     * Transpose by semitones (-12 - +12) without changing the tempo
+     */
+    fun setPitchSemitones(value: Float) {
+        currentSemitones = value.coerceIn(-12f, 12f)
+    }
+
+    /**
+     * Media duration corresponding to a playout duration, used by ExoPlayer
+     * to keep the reported position in track time.
+     */
+    fun getMediaDuration(playoutDurationUs: Long): Long {
+        return if (outputFrames >= MIN_FRAMES_FOR_SCALING) {
+            val processedInput = inputFrames - nativePendingInputFrames(handle)
+            (playoutDurationUs.toDouble() * processedInput / outputFrames).toLong()
+        } else {
+            (playoutDurationUs * currentTempo.toDouble()).toLong()
+        }
+    }
+
+    override fun onConfigure(inputAudioFormat: AudioProcessor.AudioFormat): AudioProcessor.AudioFormat {
+        if (inputAudioFormat.encoding != C.ENCODING_PCM_16BIT &&
+            inputAudioFormat.encoding != C.ENCODING_PCM_FLOAT) {
+            throw AudioProcessor.UnhandledAudioFormatException(inputAudioFormat)
+        }
+        // Same format out, so the processor can become active at a later flush
+        stretching = !isUnity(currentTempo, currentSemitones)
+        return inputAudioFormat
+    }
+
+    override fun isActive(): Boolean = super.isActive() && stretching
+
+    override fun queueInput(inputBuffer: ByteBuffer) {
+        val frames = inputBuffer.remaining() / bytesPerFrame
+        if (frames > 0 && handle != 0L) {
+            applyParams()
+            if (inputBuffer.isDirect) {
+                nativeQueueInput(handle, inputBuffer, inputBuffer.position(), frames, isFloat)
+            } else {
+                if (stagingBuffer.capacity() < inputBuffer.remaining()) {
+                    stagingBuffer = ByteBuffer.allocateDirect(inputBuffer.remaining())
+                        .order(ByteOrder.nativeOrder())
+                }
+                stagingBuffer.clear()
+                stagingBuffer.put(inputBuffer.duplicate())
+                nativeQueueInput(handle, stagingBuffer, 0, frames, isFloat)
+            }
+            inputFrames += frames
+        }
+        inputBuffer.position(inputBuffer.limit())
+        readOutput()
+    }
+
+    override fun onQueueEndOfStream() {
+        if (handle != 0L) {
+            nativeDrain(handle)
+            readOutput()
+        }
+    }
+
+    override fun onFlush() {
+        // The pipeline asks isActive() right after this: at unity it skips the processor
+        stretching = !isUnity(currentTempo, currentSemitones)
+        inputFrames = 0L
+        outputFrames = 0L
+        if (!stretching) {
+            releaseNative()
+            handleFormat = AudioProcessor.AudioFormat.NOT_SET
+            return
+        }
+
+        val format = inputAudioFormat
+        if (handle == 0L || format != handleFormat) {
+            releaseNative()
+            handle = nativeCreate(format.sampleRate, format.channelCount)
+            handleFormat = format
+        } else {
+            nativeReset(handle)
+        }
+        isFloat = format.encoding == C.ENCODING_PCM_FLOAT
+        bytesPerFrame = format.bytesPerFrame
+    }
+
+    override fun onReset() {
+        releaseNative()
+        stretching = false
+        handleFormat = AudioProcessor.AudioFormat.NOT_SET
+        inputFrames = 0L
+        outputFrames = 0L
+    }
+
+    private fun readOutput() {
+        val available = nativeAvailableFrames(handle)
+        if (available <= 0) {
+            return
+        }
+        val output = replaceOutputBuffer(available * bytesPerFrame)
+        val written = nativeReadOutput(handle, output, available, isFloat)
+        output.position(written * bytesPerFrame)
+        output.flip()
+        outputFrames += written
+    }
+
+    private fun applyParams() {
+        if (handle != 0L) {
+            nativeSetParams(handle, currentTempo, currentSemitones)
+        }
+    }
+
+    private fun releaseNative() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    /**
+     * Audio processor chain for DefaultAudioSink: only this processor. The
+     * parameters TrackPlayer pushes are returned as applied, so while the
+     * stretcher is active the sink maps positions through getMediaDuration;
+     * at unity they are DEFAULT and positions map one to one.
+     */
+    @OptIn(UnstableApi::class)
+    class Chain(private val processor: TimeStretchAudioProcessor) : AudioProcessorChain {
+        override fun getAudioProcessors(): Array<AudioProcessor> = arrayOf(processor)
+
+        override fun applyPlaybackParameters(playbackParameters: PlaybackParameters): PlaybackParameters =
+            playbackParameters
+
+        override fun applySkipSilenceEnabled(skipSilenceEnabled: Boolean): Boolean = false
+
+        override fun getMediaDuration(playoutDuration: Long): Long =
+            processor.getMediaDuration(playoutDuration)
+
+        override fun getSkippedOutputFrameCount(): Long = 0L
+    }
+
+    // Native methods
+    private external fun nativeCreate(sampleRate: Int, channels: Int): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeSetParams(handle: Long, tempo: Float, semitones: Float)
+    private external fun nativeReset(handle: Long)
+    private external fun nativeQueueInput(handle: Long, buffer: ByteBuffer, offset: Int, frames: Int, isFloat: Boolean)
+    private external fun nativeAvailableFrames(handle: Long): Int
+    private external fun nativeReadOutput(handle: Long, buffer: ByteBuffer, maxFrames: Int, isFloat: Boolean): Int
+    private external fun nativeDrain(handle: Long)
+    private external fun nativePendingInputFrames(handle: Long): Long
+}
@@ -2,12 +2,19 @@ package com.smartinstrument.app.audio
 
 import android.content.Context
 import android.net.Uri
+import androidx.annotation.OptIn
 import androidx.media3.common.MediaItem
+import androidx.media3.common.PlaybackParameters
 import androidx.media3.common.Player
+import androidx.media3.common.util.UnstableApi
+import androidx.media3.exoplayer.DefaultRenderersFactory
 import androidx.media3.exoplayer.ExoPlayer
+import androidx.media3.exoplayer.audio.AudioSink
+import androidx.media3.exoplayer.audio.DefaultAudioSink
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
+import kotlin.math.pow
 
 /**
  * TrackPlayer - Manages playback of backing tracks using ExoPlayer (Media3)
@@ -32,14 +39,41 @@ class TrackPlayer(private val context: Context) {
     private val _trackName = MutableStateFlow<String?>(null)
     val trackName: StateFlow<String?> = _trackName.asStateFlow()
     
+    private val _tempo = MutableStateFlow(1.0f)
+    val tempo: StateFlow<Float> = _tempo.asStateFlow()
+    
+    private val _pitchSemitones = MutableStateFlow(0.0f)
+    val pitchSemitones: StateFlow<Float> = _pitchSemitones.asStateFlow()
+    
     private var _volume = 1.0f
     
+    // Native time-stretch in the audio sink (practice tempo and transposition)
+    private val timeStretch = TimeStretchAudioProcessor()
+    
+    // Whether the sink was last told to stretch (see applyTimeStretch)
+    private var stretchRequested = false
+    
     init {
         initializePlayer()
     }
     
+    @OptIn(UnstableApi::class)
     private fun initializePlayer() {
-        exoPlayer = ExoPlayer.Builder(context).build().apply {
+        val renderersFactory = object : DefaultRenderersFactory(context) {
+            override fun buildAudioSink(
+                context: Context,
+                enableFloatOutput: Boolean,
+                enableAudioTrackPlaybackParams: Boolean
+            ): AudioSink {
+                // Speed goes through the stretcher, never through AudioTrack's own resampling
+                return DefaultAudioSink.Builder(context)
+                    .setEnableFloatOutput(enableFloatOutput)
+                    .setEnableAudioTrackPlaybackParams(false)
+                    .setAudioProcessorChain(TimeStretchAudioProcessor.Chain(timeStretch))
+                    .build()
+            }
+        }
+        exoPlayer = ExoPlayer.Builder(context, renderersFactory).build().apply {
             addListener(object : Player.Listener {
                 override fun onPlaybackStateChanged(playbackState: Int) {
                     when (playbackState) {
@@ -157,6 +191,44 @@ class TrackPlayer(private val context: Context) {
      */
     fun getVolume(): Float = _volume
     
+    /**
+     * Set practice tempo (0.25 to 2.0, 1.0 = original) without changing pitch.
+     * Takes effect while playing.
+     */
+    fun setTempo(tempo: Float) {
+        _tempo.value = tempo.coerceIn(0.25f, 2.0f)
+        applyTimeStretch()
+    }
+    
+    /**
+     * Transpose the track by semitones (-12 to +12) without changing tempo
+     */
+    fun setPitchSemitones(semitones: Float) {
+        _pitchSemitones.value = semitones.coerceIn(-12f, 12f)
+        applyTimeStretch()
+    }
+    
+    /**
+     * Hands the settings to the stretcher, which picks them up at its next hop.
+     * Leaving or returning to unity switches the processor on or off, which
+     * takes a pipeline flush: only then are the settings pushed to ExoPlayer
+     * as PlaybackParameters (a drain and flush in the sink), so dragging a
+     * slider between two non-unity values stays seamless.
+     */
+    private fun applyTimeStretch() {
+        timeStretch.setTempo(_tempo.value)
+        timeStretch.setPitchSemitones(_pitchSemitones.value)
+        val stretch = !TimeStretchAudioProcessor.isUnity(_tempo.value, _pitchSemitones.value)
+        if (stretch != stretchRequested) {
+            stretchRequested = stretch
+            exoPlayer?.playbackParameters = if (stretch) {
+                PlaybackParameters(_tempo.value, 2.0f.pow(_pitchSemitones.value / 12.0f))
+            } else {
+                PlaybackParameters.DEFAULT
+            }
+        }
+    }
+    
     /**
      * Update current position (call from a coroutine loop)
      */
@@ -32,13 +32,16 @@ import kotlin.math.sin
  * A grid of horizontal rows where each row represents a note in the blues scale.
  * Supports multitouch for playing chords, horizontal drag for pitch bending,
  * and automatic vibrato after holding a note for 1 second.
+ *
+ * Notes are reported by row (the scale degree in [notes]) and bends as deltas
+ * from the last reported bend; the native engine keeps the absolute pitch.
  */
 @Composable
 fun InstrumentGrid(
     notes: List<NoteInfo>,
-    onNoteOn: (voiceIndex: Int, frequency: Float) -> Unit,
+    onNoteOn: (voiceIndex: Int, noteIndex: Int) -> Unit,
     onNoteOff: (voiceIndex: Int) -> Unit,
-    onPitchBend: (voiceIndex: Int, semitones: Float) -> Unit = { _, _ -> },
+    onPitchBend: (voiceIndex: Int, deltaSemitones: Float) -> Unit = { _, _ -> },
     modifier: Modifier = Modifier,
     showNoteLabels: Boolean = true
 ) {
@@ -105,7 +108,7 @@ fun InstrumentGrid(
                     
                     if (kotlin.math.abs(totalBend - state.currentBend) > 0.02f) {
                         activeTouches[pointerId] = state.copy(currentBend = totalBend)
-                        onPitchBend(state.voiceIndex, totalBend)
+                        onPitchBend(state.voiceIndex, totalBend - state.currentBend)
                     }
                 }
             }
@@ -140,7 +143,7 @@ fun InstrumentGrid(
                         )
                         
                         vibratoPhases[voiceIndex] = 0f
-                        onNoteOn(voiceIndex, notes[touchedRow].frequency)
+                        onNoteOn(voiceIndex, touchedRow)
                     }
                     
                     // Continue tracking all pointers
@@ -169,14 +172,14 @@ fun InstrumentGrid(
                                         )
                                         
                                         vibratoPhases[voiceIndex] = 0f
-                                        onNoteOn(voiceIndex, notes[touchedRow].frequency)
+                                        onNoteOn(voiceIndex, touchedRow)
                                     }
                                 }
                                 
                                 // Touch up
                                 !change.pressed && change.previousPressed -> {
                                     activeTouches[pointerId]?.let { state ->
-                                        onPitchBend(state.voiceIndex, 0f)
+                                        onPitchBend(state.voiceIndex, -state.currentBend)
                                         onNoteOff(state.voiceIndex)
                                         vibratoPhases.remove(state.voiceIndex)
                                     }
@@ -209,7 +212,7 @@ fun InstrumentGrid(
                                                     currentBend = manualBend,
                                                     isVibrating = false
                                                 )
-                                                onPitchBend(state.voiceIndex, manualBend)
+                                                onPitchBend(state.voiceIndex, manualBend - state.currentBend)
                                             }
                                         } else if (!state.isVibrating) {
                                             // Not bending and not vibrating yet
@@ -221,8 +224,7 @@ fun InstrumentGrid(
                                             .coerceIn(0, notes.lastIndex)
                                         
                                         if (currentRow != state.rowIndex) {
-                                            // Reset bend and switch note
-                                            onPitchBend(state.voiceIndex, 0f)
+                                            // Switch note (a new note starts unbent)
                                             activeTouches[pointerId] = TouchState(
                                                 rowIndex = currentRow,
                                                 voiceIndex = state.voiceIndex,
@@ -230,7 +232,7 @@ fun InstrumentGrid(
                                                 startTime = System.currentTimeMillis()  // Reset timer on row change
                                             )
                                             vibratoPhases[state.voiceIndex] = 0f
-                                            onNoteOn(state.voiceIndex, notes[currentRow].frequency)
+                                            onNoteOn(state.voiceIndex, currentRow)
                                         }
                                     }
                                 }
@@ -242,7 +244,7 @@ fun InstrumentGrid(
                     // All touches released - clean up
                     activeTouches.keys.toList().forEach { pointerId ->
                         activeTouches[pointerId]?.let { state ->
-                            onPitchBend(state.voiceIndex, 0f)
+                            onPitchBend(state.voiceIndex, -state.currentBend)
                             onNoteOff(state.voiceIndex)
                             vibratoPhases.remove(state.voiceIndex)
                         }
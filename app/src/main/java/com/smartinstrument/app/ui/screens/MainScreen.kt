@@ -49,6 +49,7 @@ import com.smartinstrument.app.ui.theme.AccentPink
 import com.smartinstrument.app.ui.theme.DarkBackground
 import com.smartinstrument.app.ui.theme.DarkSurface
 import kotlinx.coroutines.launch
+import kotlin.math.roundToInt
 
 /**
  * MainScreen - The main instrument playing screen with track player
@@ -87,6 +88,8 @@ fun MainScreen(
     val trackName by trackPlayer.trackName.collectAsState()
     val currentPosition by trackPlayer.currentPosition.collectAsState()
     val duration by trackPlayer.duration.collectAsState()
+    val trackTempo by trackPlayer.tempo.collectAsState()
+    val trackPitch by trackPlayer.pitchSemitones.collectAsState()
     
     // Auto-hide panels when playback starts
     LaunchedEffect(isPlaying) {
@@ -110,6 +113,11 @@ fun MainScreen(
         PentatonicScale.generateGridFrequencies(currentKey, numRows, baseOctave = 3)
     }
     
+    // Same scale in the native engine: the grid plays degrees, not Hz
+    LaunchedEffect(currentKey) {
+        audioEngine.setScale(currentKey, baseOctave = 3)
+    }
+    
     // Update audio engine when settings change
     LaunchedEffect(waveType) {
         audioEngine.setWaveType(waveType)
@@ -322,6 +330,8 @@ fun MainScreen(
                         duration = duration,
                         trackVolume = trackVolume,
                         synthVolume = synthVolume,
+                        trackTempo = trackTempo,
+                        trackPitch = trackPitch,
                         detectedKey = detectedKey,
                         builtInTracks = trackPlayer.getBuiltInTracks(),
                         onSelectTrack = onSelectTrack,
@@ -334,6 +344,8 @@ fun MainScreen(
                         onSeek = { trackPlayer.seekTo(it) },
                         onTrackVolumeChange = { trackVolume = it },
                         onSynthVolumeChange = { synthVolume = it },
+                        onTempoChange = { trackPlayer.setTempo(it) },
+                        onPitchChange = { trackPlayer.setPitchSemitones(it) },
                         modifier = Modifier
                             .fillMaxWidth()
                             .padding(horizontal = 16.dp, vertical = 8.dp)
@@ -399,14 +411,14 @@ fun MainScreen(
                     // Show normal instrument grid
                     InstrumentGrid(
                         notes = scaleNotes,
-                        onNoteOn = { voiceIndex, frequency ->
-                            audioEngine.noteOn(voiceIndex, frequency)
+                        onNoteOn = { voiceIndex, noteIndex ->
+                            audioEngine.noteOnDegree(voiceIndex, noteIndex)
                         },
                         onNoteOff = { voiceIndex ->
                             audioEngine.noteOff(voiceIndex)
                         },
-                        onPitchBend = { voiceIndex, semitones ->
-                            audioEngine.setPitchBend(voiceIndex, semitones)
+                        onPitchBend = { voiceIndex, deltaSemitones ->
+                            audioEngine.bendBy(voiceIndex, deltaSemitones)
                         },
                         showNoteLabels = showNoteLabels,
                         modifier = Modifier.fillMaxSize()
@@ -432,6 +444,8 @@ private fun TrackPlayerPanel(
     duration: Long,
     trackVolume: Float,
     synthVolume: Float,
+    trackTempo: Float,
+    trackPitch: Float,
     detectedKey: MusicalKey?,
     builtInTracks: List<String>,
     onSelectTrack: () -> Unit,
@@ -441,6 +455,8 @@ private fun TrackPlayerPanel(
     onSeek: (Long) -> Unit,
     onTrackVolumeChange: (Float) -> Unit,
     onSynthVolumeChange: (Float) -> Unit,
+    onTempoChange: (Float) -> Unit,
+    onPitchChange: (Float) -> Unit,
     modifier: Modifier = Modifier
 ) {
     var showTrackMenu by remember { mutableStateOf(false) }
@@ -786,6 +802,53 @@ private fun TrackPlayerPanel(
                 )
             }
         }
+        
+        // Tempo di studio e trasposizione del brano (time-stretch nel sink di ExoPlayer)
+        Row(
+            modifier = Modifier.fillMaxWidth(),
+            horizontalArrangement = Arrangement.spacedBy(16.dp)
+        ) {
+            // Tempo: 50% - 150% a passi del 5%, 100% = originale
+            Column(modifier = Modifier.weight(1f)) {
+                Text(
+                    text = "⏱ Tempo ${(trackTempo * 100).roundToInt()}%",
+                    color = Color.White,
+                    fontSize = 12.sp
+                )
+                Slider(
+                    value = trackTempo,
+                    onValueChange = onTempoChange,
+                    valueRange = 0.5f..1.5f,
+                    steps = 19,
+                    colors = SliderDefaults.colors(
+                        thumbColor = Color.Cyan,
+                        activeTrackColor = Color.Cyan,
+                        inactiveTrackColor = Color.White.copy(alpha = 0.3f)
+                    )
+                )
+            }
+            
+            // Trasposizione: -12 - +12 semitoni
+            Column(modifier = Modifier.weight(1f)) {
+                val semitones = trackPitch.roundToInt()
+                Text(
+                    text = "🎼 Trasposizione ${if (semitones > 0) "+$semitones" else "$semitones"}",
+                    color = Color.White,
+                    fontSize = 12.sp
+                )
+                Slider(
+                    value = trackPitch,
+                    onValueChange = { onPitchChange(it.roundToInt().toFloat()) },
+                    valueRange = -12f..12f,
+                    steps = 23,
+                    colors = SliderDefaults.colors(
+                        thumbColor = AccentPink,
+                        activeTrackColor = AccentPink,
+                        inactiveTrackColor = Color.White.copy(alpha = 0.3f)
+                    )
+                )
+            }
+        }
     }
 }
 
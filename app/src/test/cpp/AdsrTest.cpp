@@ -0,0 +1,230 @@
+#include "ADSREnvelope.h"
+#include "HostTest.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Block ADSR: process() must follow getNextSample() sample for sample, for
+ * linear and exponential curves, in any block size, across note-off during
+ * any stage and sustain changes mid-decay. Also reports what a callback's
+ * worth of envelope costs both ways.
+ *
+ * process() writes each stage in closed form (linear stages as start + rate
+ * * n, exponential ones stepping four lanes by coeff^4), getNextSample()
+ * steps from the previous sample, so the two round apart: up to about half
+ * a linear step by the end of a long ramp.
+ */
+namespace {
+
+constexpr float SAMPLE_RATE = 48000.0f;
+constexpr double TOLERANCE = 1e-4;
+
+const char *curveName(ADSREnvelope::Curve curve) {
+    return curve == ADSREnvelope::Curve::Linear ? "linear" : "exponential";
+}
+
+void configure(ADSREnvelope &envelope, ADSREnvelope::Curve curve) {
+    envelope.setSampleRate(SAMPLE_RATE);
+    envelope.setCurve(curve);
+    envelope.setAttackTime(0.01f);
+    envelope.setDecayTime(0.08f);
+    envelope.setSustainLevel(0.7f);
+    envelope.setReleaseTime(0.12f);
+}
+
+// A control change applied to both envelopes at the same frame
+struct Action {
+    int frame;
+    enum { NoteOn, NoteOff, Sustain } kind;
+    float value;
+};
+
+void apply(ADSREnvelope &envelope, const Action &action) {
+    switch (action.kind) {
+        case Action::NoteOn:  envelope.noteOn(); break;
+        case Action::NoteOff: envelope.noteOff(); break;
+        case Action::Sustain: envelope.setSustainLevel(action.value); break;
+    }
+}
+
+/**
+ * Renders the script with getNextSample() and with process() in blocks of
+ * blockSize (split at each action) and returns the largest difference.
+ * Also checks that the block version goes idle at the same sample, give or
+ * take one.
+ */
+double compare(ADSREnvelope::Curve curve, const std::vector<Action> &script, int totalFrames, int blockSize,
+               std::vector<float> *reference = nullptr) {
+    ADSREnvelope perSample;
+    ADSREnvelope block;
+    configure(perSample, curve);
+    configure(block, curve);
+
+    std::vector<float> expected(totalFrames);
+    std::vector<float> actual(totalFrames);
+    std::vector<bool> expectedActive(totalFrames);
+    size_t next = 0;
+    for (int frame = 0; frame < totalFrames; ++frame) {
+        while (next < script.size() && script[next].frame == frame) {
+            apply(perSample, script[next++]);
+        }
+        expected[frame] = perSample.getNextSample();
+        expectedActive[frame] = perSample.isActive();
+    }
+
+    next = 0;
+    int frame = 0;
+    while (frame < totalFrames) {
+        while (next < script.size() && script[next].frame == frame) {
+            apply(block, script[next++]);
+        }
+        int count = std::min(blockSize, totalFrames - frame);
+        if (next < script.size()) {
+            count = std::min(count, script[next].frame - frame);
+        }
+        block.process(actual.data() + frame, count);
+        frame += count;
+        // Linear getNextSample() accumulates its steps, so the last step of a
+        // stage can land a sample either side of the closed form's
+        const int last = frame - 1;
+        CHECK(block.isActive() == expectedActive[last] ||
+              (last > 0 && block.isActive() == expectedActive[last - 1]) ||
+              (last + 1 < totalFrames && block.isActive() == expectedActive[last + 1]));
+    }
+
+    double maxDiff = 0.0;
+    for (int i = 0; i < totalFrames; ++i) {
+        maxDiff = std::max(maxDiff, static_cast<double>(std::fabs(expected[i] - actual[i])));
+    }
+    if (reference != nullptr) {
+        *reference = expected;
+    }
+    return maxDiff;
+}
+
+void testNotes(ADSREnvelope::Curve curve) {
+    // Full note, note-off during attack, during decay, retrigger during release
+    const std::vector<Action> script = {
+            {0, Action::NoteOn, 0.0f},
+            {12000, Action::NoteOff, 0.0f},
+            {19200, Action::NoteOn, 0.0f},
+            {19400, Action::NoteOff, 0.0f},
+            {28800, Action::NoteOn, 0.0f},
+            {30000, Action::NoteOff, 0.0f},
+            {31000, Action::NoteOn, 0.0f},
+            {40000, Action::NoteOff, 0.0f},
+    };
+    const int blocks[] = {1, 7, 64, 192, 256, 1000};
+    for (int blockSize : blocks) {
+        const double diff = compare(curve, script, 48000, blockSize);
+        std::printf("%-11s notes, block %4d: max difference %.2e\n", curveName(curve), blockSize, diff);
+        CHECK_NEAR(diff, 0.0, TOLERANCE);
+    }
+}
+
+void testSustainChange(ADSREnvelope::Curve curve) {
+    constexpr int ATTACK = 480;
+    constexpr int DECAY = 3840;
+    constexpr int CHANGE = ATTACK + DECAY / 2;
+    constexpr float R = 0.0001f;    // ADSREnvelope::DECAY_TARGET_RATIO
+    constexpr float END = 1e-6f;    // ADSREnvelope::STAGE_END_TOLERANCE
+
+    // Sustain lowered, then raised above the level, halfway through the decay
+    for (float sustain : {0.3f, 0.9f}) {
+        const std::vector<Action> script = {
+                {0, Action::NoteOn, 0.0f},
+                {CHANGE, Action::Sustain, sustain},
+                {24000, Action::NoteOff, 0.0f},
+        };
+        std::vector<float> levels;
+        const double diff = compare(curve, script, 36000, 192, &levels);
+
+        // From the change on, the decay runs at the rate the decay time gives
+        // for the new sustain (full-range slope, or time constant), lands on it
+        // and holds it without crossing (give or take the sample it rounds to)
+        const float from = levels[CHANGE - 1];
+        double expectedSamples = 1.0;
+        if (from > sustain) {
+            if (curve == ADSREnvelope::Curve::Linear) {
+                expectedSamples = (from - sustain) / ((1.0f - sustain) / DECAY);
+            } else {
+                const double coeff = std::exp(std::log(R / (1.0f - sustain + R)) / DECAY);
+                expectedSamples = std::log((R + END) / (from - sustain + R)) / std::log(coeff);
+            }
+        }
+        int landed = CHANGE;
+        while (landed < 24000 && std::fabs(levels[landed] - sustain) > 1e-6f) {
+            ++landed;
+        }
+        double crossing = 0.0;
+        for (int i = landed; i < 24000; ++i) {
+            crossing = std::max(crossing, static_cast<double>(std::fabs(levels[i] - sustain)));
+        }
+        const int samples = landed - CHANGE + 1;
+        std::printf("%-11s sustain 0.7 -> %.1f mid-decay: max difference %.2e, at sustain after %d samples "
+                    "(expected %.1f), held within %.1e\n",
+                    curveName(curve), sustain, diff, samples, expectedSamples, crossing);
+        CHECK_NEAR(diff, 0.0, TOLERANCE);
+        CHECK_NEAR(samples, expectedSamples, 1.5);
+        CHECK(crossing <= 1e-6);
+    }
+}
+
+// One 192-frame callback of envelope for 8 voices, both ways; reported, not checked
+void timeBlocks(ADSREnvelope::Curve curve) {
+    constexpr int FRAMES = 192;
+    constexpr int VOICES = 8;
+    constexpr int CALLBACKS = 20000;
+    std::vector<ADSREnvelope> voices(VOICES);
+    std::vector<float> gain(FRAMES);
+    float sink = 0.0f;
+
+    auto run = [&](bool blockwise) {
+        for (int v = 0; v < VOICES; ++v) {
+            configure(voices[v], curve);
+            voices[v].setDecayTime(2.0f);
+            voices[v].setReleaseTime(2.0f);
+            voices[v].reset();
+        }
+        const auto start = std::chrono::steady_clock::now();
+        for (int callback = 0; callback < CALLBACKS; ++callback) {
+            for (int v = 0; v < VOICES; ++v) {
+                ADSREnvelope &envelope = voices[v];
+                // Notes every 1.6 s, staggered, so every stage gets rendered
+                const int phase = (callback + v * 50) % 400;
+                if (phase == 0) envelope.noteOn();
+                if (phase == 200) envelope.noteOff();
+                if (blockwise) {
+                    envelope.process(gain.data(), FRAMES);
+                } else {
+                    for (int i = 0; i < FRAMES; ++i) {
+                        gain[i] = envelope.getNextSample();
+                    }
+                }
+                sink += gain[FRAMES - 1];
+            }
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    const double perSample = run(false);
+    const double blockwise = run(true);
+    const double samples = static_cast<double>(CALLBACKS) * VOICES * FRAMES;
+    std::printf("%-11s timing: getNextSample %.2f ns/sample, process %.2f ns/sample (%.1fx)%s\n",
+                curveName(curve), perSample * 1e9 / samples, blockwise * 1e9 / samples,
+                perSample / blockwise, sink < 0.0f ? " " : "");
+}
+
+} // namespace
+
+int main() {
+    for (ADSREnvelope::Curve curve : {ADSREnvelope::Curve::Linear, ADSREnvelope::Curve::Exponential}) {
+        testNotes(curve);
+        testSustainChange(curve);
+        timeBlocks(curve);
+    }
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,159 @@
+#include "DelayStorage.h"
+#include "DspArena.h"
+#include "Effects.h"
+#include "HostTest.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/**
+ * 16-bit delay-line storage: the noise each codec adds, on its own (a sine
+ * stored and loaded at several levels) and through the reverb combs that
+ * use it (compared against float storage, with the signal and in the
+ * decaying tail), plus the cost of the reverbs of 8 voices and the bus in
+ * each format.
+ */
+namespace {
+
+constexpr float SAMPLE_RATE = 48000.0f;
+constexpr double TWO_PI = 6.283185307179586;
+
+double toDb(double ratio) {
+    return 20.0 * std::log10(std::max(ratio, 1e-12));
+}
+
+// Signal-to-error ratio of one store/load round trip, in dB
+template <typename Codec>
+double roundTripSnr(double levelDb) {
+    const double amplitude = std::pow(10.0, levelDb / 20.0);
+    double signal = 0.0;
+    double error = 0.0;
+    for (int i = 0; i < 48000; ++i) {
+        const auto x = static_cast<float>(amplitude * std::sin(TWO_PI * 441.3 * i / SAMPLE_RATE));
+        const float y = Codec::load(Codec::store(x));
+        signal += static_cast<double>(x) * x;
+        error += static_cast<double>(y - x) * (y - x);
+    }
+    return 10.0 * std::log10(signal / std::max(error, 1e-30));
+}
+
+// Guitar-like input: a decaying plucked partial set for 0.5 s, then silence
+float pluck(int i) {
+    if (i >= 24000) {
+        return 0.0f;
+    }
+    const double t = i / static_cast<double>(SAMPLE_RATE);
+    double sum = 0.0;
+    for (int h = 1; h <= 6; ++h) {
+        sum += std::sin(TWO_PI * 196.0 * h * t) / h;
+    }
+    return static_cast<float>(0.5 * sum * std::exp(-4.0 * t));
+}
+
+std::vector<float> renderReverb(dsp::DelayFormat format, int frames) {
+    DspArena arena;
+    arena.reserve(ReverbEffect::storageBytes(SAMPLE_RATE, format));
+    ReverbEffect reverb;
+    reverb.attachStorage(arena, SAMPLE_RATE, format);
+    reverb.setSampleRate(SAMPLE_RATE);
+    reverb.setAmount(0.8f);
+    std::vector<float> buffer(frames);
+    for (int i = 0; i < frames; ++i) {
+        buffer[i] = pluck(i);
+    }
+    for (int start = 0; start < frames; start += 256) {
+        reverb.process(buffer.data() + start, std::min(256, frames - start));
+    }
+    return buffer;
+}
+
+// Error against the float reference, relative to the reference's own RMS over the same span
+double relativeErrorDb(const std::vector<float> &reference, const std::vector<float> &test,
+                       int begin, int end) {
+    double signal = 0.0;
+    double error = 0.0;
+    for (int i = begin; i < end; ++i) {
+        signal += static_cast<double>(reference[i]) * reference[i];
+        error += static_cast<double>(test[i] - reference[i]) * (test[i] - reference[i]);
+    }
+    return 10.0 * std::log10(std::max(error, 1e-30) / std::max(signal, 1e-30));
+}
+
+void testNoiseFloor() {
+    std::printf("round trip SNR (dB):   level    half   fixed16\n");
+    for (double level : {0.0, -20.0, -40.0, -60.0}) {
+        const double half = roundTripSnr<dsp::HalfStorage>(level);
+        const double fixed = roundTripSnr<dsp::Fixed16Storage>(level);
+        std::printf("                    %6.0f  %6.1f  %6.1f\n", level, half, fixed);
+        // Relative precision: the same SNR at every level
+        CHECK(half > 70.0);
+        CHECK(level < 0.0 || fixed > 70.0);
+    }
+
+    // Through the combs: the pluck (0.5 s) and the tail after it (0.5 - 2 s)
+    const int frames = 96000;
+    const auto reference = renderReverb(dsp::DelayFormat::Float32, frames);
+    const auto half = renderReverb(dsp::DelayFormat::Half, frames);
+    const auto fixed = renderReverb(dsp::DelayFormat::Fixed16, frames);
+    double tailRms = 0.0;
+    for (int i = 24000; i < frames; ++i) {
+        tailRms += static_cast<double>(reference[i]) * reference[i];
+    }
+    tailRms = std::sqrt(tailRms / (frames - 24000));
+    const double halfSignal = relativeErrorDb(reference, half, 0, 24000);
+    const double halfTail = relativeErrorDb(reference, half, 24000, frames);
+    const double fixedSignal = relativeErrorDb(reference, fixed, 0, 24000);
+    const double fixedTail = relativeErrorDb(reference, fixed, 24000, frames);
+    std::printf("reverb error vs float (dB): half %.1f / tail %.1f, fixed16 %.1f / tail %.1f "
+                "(tail at %.1f dBFS)\n", halfSignal, halfTail, fixedSignal, fixedTail, toDb(tailRms));
+    CHECK(halfSignal < -60.0);
+    CHECK(halfTail < -60.0);
+    CHECK(fixedSignal < -60.0);
+}
+
+void benchmark() {
+    constexpr int VOICES = 9;  // 8 voices and the bus
+    constexpr int FRAMES = 192;
+    constexpr int CALLBACKS = 2500;  // 10 s
+    std::vector<float> input(24000);  // One pluck, synthesized outside the timing
+    for (int i = 0; i < 24000; ++i) {
+        input[i] = pluck(i);
+    }
+    for (auto format : {dsp::DelayFormat::Float32, dsp::DelayFormat::Half, dsp::DelayFormat::Fixed16}) {
+        DspArena arena;
+        arena.reserve(VOICES * ReverbEffect::storageBytes(SAMPLE_RATE, format));
+        std::vector<ReverbEffect> reverbs(VOICES);
+        for (ReverbEffect &reverb : reverbs) {
+            reverb.attachStorage(arena, SAMPLE_RATE, format);
+            reverb.setSampleRate(SAMPLE_RATE);
+            reverb.setAmount(0.5f);
+        }
+        std::vector<float> buffer(FRAMES);
+        float sink = 0.0f;
+        const auto start = std::chrono::steady_clock::now();
+        for (int n = 0; n < CALLBACKS; ++n) {
+            for (ReverbEffect &reverb : reverbs) {
+                for (int i = 0; i < FRAMES; ++i) {
+                    buffer[i] = input[(n * FRAMES + i) % 24000];
+                }
+                reverb.process(buffer.data(), FRAMES);
+                sink += buffer[FRAMES - 1];
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const char *name = format == dsp::DelayFormat::Float32 ? "float32"
+                         : format == dsp::DelayFormat::Half ? "half" : "fixed16";
+        std::printf("%-8s %zu bytes, %.2f ns per reverb sample, %.3f%% of real time (%g)\n", name,
+                    arena.getUsedBytes(), 1e9 * seconds / (static_cast<double>(CALLBACKS) * FRAMES * VOICES),
+                    100.0 * seconds / (CALLBACKS * FRAMES / SAMPLE_RATE), sink);
+    }
+}
+
+} // namespace
+
+int main() {
+    testNoiseFloor();
+    benchmark();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,111 @@
+#include "DrumKit.h"
+#include "RealFFT.h"
+#include "HostTest.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Drum one-shots per pad: every DrumSound pitch of DrumPad.kt must sound
+ * like its own drum, also against the other pads of its class (the toms,
+ * the two hi-hats, crash and ride), and a hit between pads must play the
+ * nearest pad of its class unless pitch tracking resamples it.
+ */
+namespace {
+
+constexpr int SAMPLE_RATE = 48000;
+constexpr int FRAMES = 192;
+
+std::vector<float> renderHit(float frequency, bool pitchTracking = false) {
+    DrumKit kit;
+    kit.setSampleRate(static_cast<float>(SAMPLE_RATE));
+    kit.setPitchTracking(pitchTracking);
+    kit.trigger(frequency, 1.0f);
+    std::vector<float> output(SAMPLE_RATE, 0.0f);
+    for (int offset = 0; offset < SAMPLE_RATE; offset += FRAMES) {
+        kit.mixInto(output.data() + offset, std::min(FRAMES, SAMPLE_RATE - offset));
+    }
+    return output;
+}
+
+double maxDifference(const std::vector<float> &a, const std::vector<float> &b) {
+    double diff = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        diff = std::max(diff, static_cast<double>(std::fabs(a[i] - b[i])));
+    }
+    return diff;
+}
+
+// Strongest spectral line between 40 Hz and 1.5 kHz in the first 20 ms
+// (zero-padded): the FM carrier before the tom pitch drop, i.e. the pitch
+// the pad was rendered at
+double bodyPitch(const std::vector<float> &hit) {
+    constexpr int SIZE = 8192;
+    constexpr int ATTACK = SAMPLE_RATE / 50;
+    std::vector<float> attack(SIZE, 0.0f);
+    std::copy(hit.begin(), hit.begin() + ATTACK, attack.begin());
+    RealFFT fft(SIZE);
+    std::vector<float> re(fft.getBins()), im(fft.getBins());
+    fft.forward(attack.data(), re.data(), im.data());
+    const double binHz = static_cast<double>(SAMPLE_RATE) / SIZE;
+    int peak = 0;
+    float peakPower = 0.0f;
+    for (int k = static_cast<int>(40.0 / binHz); k < static_cast<int>(1500.0 / binHz); ++k) {
+        const float power = re[k] * re[k] + im[k] * im[k];
+        if (power > peakPower) {
+            peakPower = power;
+            peak = k;
+        }
+    }
+    return peak * binHz;
+}
+
+void testPadsDiffer() {
+    // Higher pad first
+    struct Pair {
+        const char *name;
+        float high;
+        float low;
+    };
+    const Pair pairs[] = {
+            {"hi tom / low tom", 180.0f, 100.0f},
+            {"hi tom / mid tom", 180.0f, 150.0f},
+            {"mid tom / low tom", 150.0f, 100.0f},
+            {"closed / open hh", 900.0f, 750.0f},
+            {"ride / crash", 600.0f, 500.0f},
+    };
+    for (const Pair &pair : pairs) {
+        const std::vector<float> high = renderHit(pair.high);
+        const std::vector<float> low = renderHit(pair.low);
+        const double diff = maxDifference(high, low);
+        const double highPitch = bodyPitch(high);
+        const double lowPitch = bodyPitch(low);
+        std::printf("%-18s max difference %.3f, body %.0f / %.0f Hz\n",
+                    pair.name, diff, highPitch, lowPitch);
+        CHECK(diff > 0.05);
+        CHECK(highPitch > lowPitch * 1.1);
+    }
+}
+
+void testBetweenPads() {
+    // 120 Hz is closest to the low tom, 240 Hz to the hi tom (not the 280 Hz snare)
+    CHECK(DrumKit::nearestPad(120.0f) == DrumKit::nearestPad(100.0f));
+    CHECK(DrumKit::nearestPad(240.0f) == DrumKit::nearestPad(180.0f));
+    CHECK_NEAR(maxDifference(renderHit(120.0f), renderHit(100.0f)), 0.0, 0.0);
+    CHECK_NEAR(maxDifference(renderHit(240.0f), renderHit(180.0f)), 0.0, 0.0);
+
+    // Pitch tracking resamples off-pad hits and leaves pads as rendered
+    const double tracked = maxDifference(renderHit(120.0f, true), renderHit(100.0f));
+    std::printf("120 Hz with pitch tracking vs low tom: max difference %.3f\n", tracked);
+    CHECK(tracked > 0.05);
+    CHECK_NEAR(maxDifference(renderHit(150.0f, true), renderHit(150.0f)), 0.0, 0.0);
+}
+
+} // namespace
+
+int main() {
+    testPadsDiffer();
+    testBetweenPads();
+    return HOST_TEST_RESULT();
+}
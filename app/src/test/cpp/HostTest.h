@@ -0,0 +1,47 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <cstdio>
+
+/**
+ * HostTest - Minimal assertions for the host test executables
+ *
+ * A failed CHECK prints the condition and keeps going, so one run reports
+ * every failure; main() returns HOST_TEST_RESULT(), which ctest reads as
+ * the exit status.
+ */
+namespace hosttest {
+
+inline int &failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char *file, int line, const char *message) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, message);
+    ++failures();
+}
+
+} // namespace hosttest
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            hosttest::fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(value, expected, tolerance) \
+    do { \
+        const double checkValue = static_cast<double>(value); \
+        const double checkExpected = static_cast<double>(expected); \
+        if (!(checkValue >= checkExpected - (tolerance) && checkValue <= checkExpected + (tolerance))) { \
+            std::fprintf(stderr, "%s:%d: %s = %g, expected %g +/- %g\n", __FILE__, __LINE__, \
+                         #value, checkValue, checkExpected, static_cast<double>(tolerance)); \
+            ++hosttest::failures(); \
+        } \
+    } while (0)
+
+#define HOST_TEST_RESULT() (hosttest::failures() == 0 ? 0 : 1)
+
+#endif // HOST_TEST_H
@@ -0,0 +1,169 @@
+#include "AudioEngine.h"
+#include "HostTest.h"
+#include <oboe/Oboe.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Insert placement: a single guitar line must sound the same whether its
+ * amp, wah and reverb run per voice or once on the engine bus.
+ *
+ *  - Dry (reverb amount 0): the bus amp treats the one voice exactly as the
+ *    per-voice kernel does, so the outputs match sample for sample.
+ *  - Default reverb: the bus reverb runs on the limited mix, the per-voice
+ *    one before the limiter, so only the 50 ms RMS envelopes are compared,
+ *    while the notes are held (between notes the shared reverb rings on,
+ *    while a per-voice reverb stops with its voice).
+ *  - The cabinet slot is bypassed by default (per-voice guitars have none)
+ *    and changes the bus sound once switched on.
+ *  - Types without an insert placement (the sampler, unknown ones) are
+ *    rejected instead of moving the synth lead to the bus.
+ */
+namespace {
+
+constexpr int SAMPLE_RATE = 48000;
+constexpr int FRAMES = 192;
+constexpr int SYNTH_LEAD = 1;
+constexpr int GUITAR = 4;
+constexpr int HOLD_CALLBACKS = 125;     // 0.5 s per note
+constexpr int RELEASE_CALLBACKS = 25;   // 0.1 s between notes
+constexpr int WINDOW = SAMPLE_RATE / 20;
+
+enum Placement { PerVoice = 0, Bus = 1 };
+
+// Mono output of a G3-B3-D4-G4 line, one note at a time
+std::vector<float> renderLine(Placement placement, bool dry, bool cabinet) {
+    FakeOboe::setDevice(SAMPLE_RATE, FRAMES);
+    AudioEngine engine;
+    const int types[1] = {GUITAR};
+    const float lowHz[1] = {20.0f};
+    const float highHz[1] = {20000.0f};
+    const float levels[1] = {1.0f};
+    CHECK(engine.setInstrumentZones(types, lowHz, highHz, levels, 1));
+    engine.setInsertPlacement(GUITAR, placement);
+    if (dry) {
+        engine.setGuitarParams(0.7f, 0.7f, 0.7f, 0.0f);
+    }
+    if (cabinet) {
+        engine.setInsertBypass(static_cast<int>(InsertChain::Slot::Cabinet), false);
+    }
+    CHECK(engine.start());
+
+    std::vector<float> output;
+    std::vector<float> buffer(FRAMES);
+    auto run = [&](int callbacks) {
+        for (int c = 0; c < callbacks; ++c) {
+            engine.onAudioReady(nullptr, buffer.data(), FRAMES);
+            output.insert(output.end(), buffer.begin(), buffer.end());
+        }
+    };
+    const float notes[] = {196.0f, 246.94f, 293.66f, 392.0f};
+    for (float note : notes) {
+        engine.noteOn(0, note);
+        run(HOLD_CALLBACKS);
+        engine.noteOff(0);
+        run(RELEASE_CALLBACKS);
+    }
+    engine.stop();
+    return output;
+}
+
+double snrDb(const std::vector<float> &reference, const std::vector<float> &other) {
+    double signal = 0.0;
+    double error = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        const double diff = static_cast<double>(other[i]) - reference[i];
+        signal += static_cast<double>(reference[i]) * reference[i];
+        error += diff * diff;
+    }
+    return error > 0.0 ? 10.0 * std::log10(signal / error) : 999.0;
+}
+
+// Largest 50 ms RMS difference over the windows that lie inside a held note
+double heldEnvelopeDiffDb(const std::vector<float> &a, const std::vector<float> &b) {
+    const size_t noteFrames = static_cast<size_t>(HOLD_CALLBACKS + RELEASE_CALLBACKS) * FRAMES;
+    const size_t holdFrames = static_cast<size_t>(HOLD_CALLBACKS) * FRAMES;
+    double worst = 0.0;
+    for (size_t start = 0; start + WINDOW <= a.size(); start += WINDOW) {
+        if (start % noteFrames + WINDOW > holdFrames) {
+            continue;
+        }
+        double energyA = 0.0;
+        double energyB = 0.0;
+        for (size_t i = start; i < start + WINDOW; ++i) {
+            energyA += static_cast<double>(a[i]) * a[i];
+            energyB += static_cast<double>(b[i]) * b[i];
+        }
+        worst = std::max(worst, std::fabs(10.0 * std::log10((energyB + 1e-12) / (energyA + 1e-12))));
+    }
+    return worst;
+}
+
+void testDryLine() {
+    const std::vector<float> perVoice = renderLine(PerVoice, true, false);
+    const std::vector<float> bus = renderLine(Bus, true, false);
+    const double snr = snrDb(perVoice, bus);
+    std::printf("dry line: bus vs per-voice SNR %.1f dB\n", snr);
+    CHECK(snr >= 100.0);
+}
+
+void testReverbLine() {
+    const std::vector<float> perVoice = renderLine(PerVoice, false, false);
+    const std::vector<float> bus = renderLine(Bus, false, false);
+    const double diff = heldEnvelopeDiffDb(perVoice, bus);
+    std::printf("line with reverb: held 50 ms envelopes within %.2f dB\n", diff);
+    CHECK(diff <= 1.5);
+}
+
+void testCabinetOptIn() {
+    const std::vector<float> bus = renderLine(Bus, true, false);
+    const std::vector<float> cabinet = renderLine(Bus, true, true);
+    const double snr = snrDb(bus, cabinet);
+    std::printf("cabinet on: SNR %.1f dB against the default bus\n", snr);
+    CHECK(snr < 40.0);
+}
+
+// One synth lead note, optionally after asking for the bus placement of busType
+std::vector<float> renderLead(bool setPlacement, int busType = 0) {
+    FakeOboe::setDevice(SAMPLE_RATE, FRAMES);
+    AudioEngine engine;
+    const int types[1] = {SYNTH_LEAD};
+    const float lowHz[1] = {20.0f};
+    const float highHz[1] = {20000.0f};
+    const float levels[1] = {1.0f};
+    CHECK(engine.setInstrumentZones(types, lowHz, highHz, levels, 1));
+    if (setPlacement) {
+        engine.setInsertPlacement(busType, Bus);
+    }
+    CHECK(engine.start());
+    std::vector<float> output;
+    std::vector<float> buffer(FRAMES);
+    engine.noteOn(0, 440.0f);
+    for (int c = 0; c < HOLD_CALLBACKS; ++c) {
+        engine.onAudioReady(nullptr, buffer.data(), FRAMES);
+        output.insert(output.end(), buffer.begin(), buffer.end());
+    }
+    engine.stop();
+    return output;
+}
+
+void testInvalidTypes() {
+    const std::vector<float> lead = renderLead(false);
+    CHECK(snrDb(lead, renderLead(true, AudioEngine::SAMPLER_TYPE)) > 900.0);
+    CHECK(snrDb(lead, renderLead(true, 7)) > 900.0);
+    CHECK(snrDb(lead, renderLead(true, -3)) > 900.0);
+    // The valid type does move it
+    CHECK(snrDb(lead, renderLead(true, SYNTH_LEAD)) < 100.0);
+}
+
+} // namespace
+
+int main() {
+    testDryLine();
+    testReverbLine();
+    testCabinetOptIn();
+    testInvalidTypes();
+    return HOST_TEST_RESULT();
+}
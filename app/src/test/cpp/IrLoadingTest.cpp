@@ -0,0 +1,258 @@
+#include "ConvolutionEngine.h"
+#include "AudioThreadTuner.h"
+#include "WavReader.h"
+#include "HostTest.h"
+#include <dirent.h>
+#include <sched.h>
+#include <unistd.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Impulse-response loading: WavReader against corrupt and oversized files,
+ * the convolution tail worker (woken by process()) against the inline
+ * synchronous tail, and the worker following the tuner's CPU policy: pinned
+ * from its start, re-pinned and released as the policy changes.
+ */
+namespace {
+
+void putU16(std::vector<uint8_t> &bytes, uint16_t value) {
+    bytes.push_back(static_cast<uint8_t>(value));
+    bytes.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void putU32(std::vector<uint8_t> &bytes, uint32_t value) {
+    putU16(bytes, static_cast<uint16_t>(value));
+    putU16(bytes, static_cast<uint16_t>(value >> 16));
+}
+
+void putTag(std::vector<uint8_t> &bytes, const char *tag) {
+    for (int i = 0; i < 4; ++i) {
+        bytes.push_back(static_cast<uint8_t>(tag[i]));
+    }
+}
+
+// 16-bit mono WAV; extraChunkBytes inserts a chunk with that (possibly bogus) size before data
+std::vector<uint8_t> makeWav(const std::vector<int16_t> &samples, bool extraChunk, uint32_t extraChunkBytes) {
+    std::vector<uint8_t> bytes;
+    putTag(bytes, "RIFF");
+    putU32(bytes, 0);
+    putTag(bytes, "WAVE");
+    putTag(bytes, "fmt ");
+    putU32(bytes, 16);
+    putU16(bytes, 1);
+    putU16(bytes, 1);
+    putU32(bytes, 48000);
+    putU32(bytes, 96000);
+    putU16(bytes, 2);
+    putU16(bytes, 16);
+    if (extraChunk) {
+        putTag(bytes, "LIST");
+        putU32(bytes, extraChunkBytes);
+        bytes.insert(bytes.end(), 8, 0);
+    }
+    putTag(bytes, "data");
+    putU32(bytes, static_cast<uint32_t>(samples.size() * 2));
+    for (int16_t sample : samples) {
+        putU16(bytes, static_cast<uint16_t>(sample));
+    }
+    return bytes;
+}
+
+std::string writeTemp(const char *name, const std::vector<uint8_t> &bytes) {
+    const std::string path = std::string("/tmp/") + name;
+    FILE *file = std::fopen(path.c_str(), "wb");
+    std::fwrite(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+    return path;
+}
+
+void testWavReader() {
+    std::vector<int16_t> ramp(200000);
+    for (size_t i = 0; i < ramp.size(); ++i) {
+        ramp[i] = static_cast<int16_t>(i % 20000);
+    }
+    const auto valid = makeWav(ramp, false, 0);
+    WavReader::Layout layout;
+    CHECK(WavReader::parseLayout(valid.data(), valid.size(), layout));
+    CHECK(layout.frames == ramp.size());
+
+    // Chunk sizes that would wrap a 32-bit offset: the walk must stop, not spin
+    for (uint32_t bogus : {0xFFFFFFF8u, 0xFFFFFFF7u, 0xFFFFFFFFu, 0x7FFFFFFFu}) {
+        const auto corrupt = makeWav(ramp, true, bogus);
+        CHECK(!WavReader::parseLayout(corrupt.data(), corrupt.size(), layout));
+    }
+    const auto truncatedHeader = makeWav({}, true, 0xFFFFFFF8u);
+    CHECK(!WavReader::parseLayout(truncatedHeader.data(), 20, layout));
+
+    // maxFrames: only the requested frames come back, with the right values
+    const std::string path = writeTemp("ir_loading_test.wav", valid);
+    std::vector<float> samples;
+    int rate = 0;
+    CHECK(WavReader::readMono(path.c_str(), samples, rate, 1000));
+    CHECK(samples.size() == 1000);
+    CHECK(rate == 48000);
+    CHECK_NEAR(samples[999], 999.0 / 32768.0, 1e-7);
+    CHECK(WavReader::readMono(path.c_str(), samples, rate));
+    CHECK(samples.size() == ramp.size());
+    CHECK_NEAR(samples.back(), static_cast<double>(ramp.back()) / 32768.0, 1e-7);
+
+    // Metadata larger than the first read still finds the data chunk
+    std::vector<uint8_t> padded = makeWav(ramp, true, 200000);
+    padded.insert(padded.begin() + 44, 200000 - 8, 0);
+    const std::string paddedPath = writeTemp("ir_loading_padded.wav", padded);
+    CHECK(WavReader::readMono(paddedPath.c_str(), samples, rate, 5000));
+    CHECK(samples.size() == 5000);
+    CHECK_NEAR(samples[4999], 4999.0 / 32768.0, 1e-7);
+
+    const std::string corruptPath = writeTemp("ir_loading_corrupt.wav", makeWav(ramp, true, 0xFFFFFFF8u));
+    CHECK(!WavReader::readMono(corruptPath.c_str(), samples, rate));
+    std::remove(path.c_str());
+    std::remove(paddedPath.c_str());
+    std::remove(corruptPath.c_str());
+}
+
+void testTailWorker() {
+    // Long decaying IR, so most of the energy is in the worker's tail partitions
+    std::vector<float> ir(3 * 48000);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < ir.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+        ir[i] = noise * std::exp(-static_cast<float>(i) / 24000.0f);
+    }
+    ConvolutionEngine threaded;
+    ConvolutionEngine inline_;
+    CHECK(threaded.init(ir));
+    CHECK(inline_.init(ir));
+    inline_.setSynchronousTail(true);
+
+    // Paced like a callback at 4x real time: the worker only runs when woken
+    constexpr int FRAMES = 192;
+    constexpr int CALLBACKS = 1000;
+    std::vector<float> input(FRAMES), a(FRAMES), b(FRAMES);
+    double maxDiff = 0.0;
+    double peak = 0.0;
+    for (int n = 0; n < CALLBACKS; ++n) {
+        for (int i = 0; i < FRAMES; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            input[i] = n < 50 ? static_cast<float>(seed >> 8) / 8388608.0f - 1.0f : 0.0f;
+        }
+        threaded.process(input.data(), a.data(), FRAMES);
+        inline_.process(input.data(), b.data(), FRAMES);
+        for (int i = 0; i < FRAMES; ++i) {
+            maxDiff = std::max(maxDiff, static_cast<double>(std::fabs(a[i] - b[i])));
+            peak = std::max(peak, static_cast<double>(std::fabs(b[i])));
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(1000));
+    }
+    std::printf("tail worker: %llu misses, max diff %.3g (peak %.3g)\n",
+                static_cast<unsigned long long>(threaded.getTailMisses()), maxDiff, peak);
+    CHECK(threaded.getTailMisses() == 0);
+    CHECK(maxDiff <= 1e-5 * peak);
+}
+
+// Cpus_allowed_list of every thread but the main one (here, the tail worker)
+std::vector<std::string> workerAffinities() {
+    std::vector<std::string> lists;
+    DIR *tasks = opendir("/proc/self/task");
+    if (tasks == nullptr) {
+        return lists;
+    }
+    while (dirent *entry = readdir(tasks)) {
+        if (entry->d_name[0] == '.' || std::atoi(entry->d_name) == getpid()) {
+            continue;
+        }
+        std::ifstream status(std::string("/proc/self/task/") + entry->d_name + "/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("Cpus_allowed_list:", 0) == 0) {
+                lists.push_back(line.substr(line.find_first_not_of(" \t", 18)));
+            }
+        }
+    }
+    closedir(tasks);
+    return lists;
+}
+
+// Feeds silence until the worker has applied the tuner's current policy
+bool waitForPolicy(ConvolutionEngine &engine, const AudioThreadTuner &tuner) {
+    constexpr int FRAMES = 192;
+    std::vector<float> buffer(FRAMES, 0.0f);
+    for (int n = 0; n < 500; ++n) {
+        if (engine.getWorkerPolicyGeneration() == tuner.getPolicyGeneration()) {
+            return true;
+        }
+        engine.process(buffer.data(), buffer.data(), FRAMES);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return false;
+}
+
+void testWorkerAffinity() {
+    cpu_set_t allowed;
+    CHECK(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    int first = -1;
+    int last = -1;
+    for (int cpu = 0; cpu < AudioThreadTuner::MAX_CPUS; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            first = first < 0 ? cpu : first;
+            last = cpu;
+        }
+    }
+    const std::string original = [] {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line) && line.rfind("Cpus_allowed_list:", 0) != 0) {
+        }
+        return line.empty() ? line : line.substr(line.find_first_not_of(" \t", 18));
+    }();
+
+    AudioThreadTuner tuner;
+    tuner.setAffinityPolicy(AudioThreadTuner::AffinityPolicy::Custom, 1ull << last);
+    std::vector<float> ir(2 * ConvolutionEngine::HEAD_LENGTH, 0.001f);
+    ConvolutionEngine engine;
+    CHECK(engine.init(ir, &tuner));
+
+    // Pinned as it starts, before any block woke it
+    for (int n = 0; n < 500 && engine.getWorkerPolicyGeneration() != tuner.getPolicyGeneration(); ++n) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    CHECK(engine.getWorkerPolicyGeneration() == tuner.getPolicyGeneration());
+    const std::vector<std::string> started = workerAffinities();
+
+    tuner.setAffinityPolicy(AudioThreadTuner::AffinityPolicy::Custom, 1ull << first);
+    CHECK(waitForPolicy(engine, tuner));
+    const std::vector<std::string> moved = workerAffinities();
+
+    tuner.setAffinityPolicy(AudioThreadTuner::AffinityPolicy::None);
+    CHECK(waitForPolicy(engine, tuner));
+    const std::vector<std::string> released = workerAffinities();
+
+    std::printf("tail worker affinity: %s at start, %s after the change, %s with no policy (process %s)\n",
+                started.empty() ? "?" : started[0].c_str(), moved.empty() ? "?" : moved[0].c_str(),
+                released.empty() ? "?" : released[0].c_str(), original.c_str());
+    CHECK(started.size() == 1 && started[0] == std::to_string(last));
+    CHECK(moved.size() == 1 && moved[0] == std::to_string(first));
+    CHECK(released.size() == 1 && released[0] == original);
+
+    // Without a tuner the worker is left where the scheduler puts it
+    ConvolutionEngine unpinned;
+    CHECK(unpinned.init(ir));
+    CHECK(unpinned.getWorkerPolicyGeneration() == 0);
+}
+
+} // namespace
+
+int main() {
+    testWavReader();
+    testTailWorker();
+    testWorkerAffinity();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,105 @@
+#include "AudioEngine.h"
+#include "WavWriter.h"
+#include "HostTest.h"
+#include <oboe/Oboe.h>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Touch-to-sound traces: every kind of voice must stamp its first audible
+ * sample, so the trace has a "first sample" mark between dequeue and
+ * presentation whatever instrument the note played.
+ */
+namespace {
+
+constexpr int SAMPLE_RATE = 48000;
+constexpr int FRAMES = 192;
+
+std::string readFile(const char *path) {
+    std::string text;
+    FILE *file = std::fopen(path, "r");
+    if (file == nullptr) {
+        return text;
+    }
+    char chunk[4096];
+    size_t read;
+    while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, read);
+    }
+    std::fclose(file);
+    return text;
+}
+
+size_t countOf(const std::string &text, const char *needle) {
+    size_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+// One second of a 220 Hz sine as the only sampler zone
+bool loadSineSampler(AudioEngine &engine, const char *path) {
+    std::vector<float> sine(SAMPLE_RATE);
+    for (size_t i = 0; i < sine.size(); ++i) {
+        sine[i] = 0.4f * static_cast<float>(std::sin(2.0 * M_PI * 220.0 * static_cast<double>(i) / SAMPLE_RATE));
+    }
+    WavWriter writer;
+    if (!writer.open(path, SAMPLE_RATE, 1, WavWriter::SampleFormat::Pcm16) ||
+        !writer.write(sine.data(), static_cast<int>(sine.size())) || !writer.close()) {
+        return false;
+    }
+    const Sampler::ZoneSpec zone{path, 220.0f, 20.0f, 20000.0f};
+    return engine.loadSampler(&zone, 1);
+}
+
+// Plays one note per voice on the given instrument and counts the marks in the trace
+void testFirstSample(int instrumentType, const char *name) {
+    FakeOboe::setDevice(SAMPLE_RATE, FRAMES);
+    AudioEngine engine;
+    const std::string wav = std::string("/tmp/latency_trace_test_") + name + ".wav";
+    if (instrumentType == AudioEngine::SAMPLER_TYPE) {
+        CHECK(loadSineSampler(engine, wav.c_str()));
+    }
+    const int types[1] = {instrumentType};
+    const float lowHz[1] = {20.0f};
+    const float highHz[1] = {20000.0f};
+    const float levels[1] = {1.0f};
+    CHECK(engine.setInstrumentZones(types, lowHz, highHz, levels, 1));
+    engine.setLatencyTracingEnabled(true);
+    CHECK(engine.start());
+
+    constexpr int NOTES = 3;
+    std::vector<float> buffer(FRAMES * 2);
+    float peak = 0.0f;
+    for (int note = 0; note < NOTES; ++note) {
+        engine.noteOn(note, 220.0f * static_cast<float>(note + 1));
+        for (int callback = 0; callback < 20; ++callback) {
+            engine.onAudioReady(nullptr, buffer.data(), FRAMES);
+            for (float sample : buffer) {
+                peak = std::max(peak, std::fabs(sample));
+            }
+        }
+    }
+    engine.stop();
+
+    const std::string trace = std::string("/tmp/latency_trace_test_") + name + ".json";
+    CHECK(engine.exportLatencyTrace(trace.c_str()));
+    const std::string text = readFile(trace.c_str());
+    const size_t marks = countOf(text, "\"first sample\"");
+    std::printf("%s: peak %.3f, %zu of %d notes with a first sample mark\n", name, peak, marks, NOTES);
+    CHECK(peak > 0.01f);
+    CHECK(marks == static_cast<size_t>(NOTES));
+    std::remove(trace.c_str());
+    std::remove(wav.c_str());
+}
+
+} // namespace
+
+int main() {
+    testFirstSample(0, "oscillator");
+    testFirstSample(AudioEngine::SAMPLER_TYPE, "sampler");
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,307 @@
+#include "DuplexInput.h"
+#include "WavReader.h"
+#include "WavWriter.h"
+#include "HostTest.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Input pitch tracking from WAV files: each file goes through
+ * DuplexInput::setFile (resampled to the 48 kHz stream when it is not at
+ * that rate) and is pulled in 192-frame callbacks, as the output callback
+ * does. For every note the test measures:
+ *
+ *  - accuracy: median error of the confident estimates once the window
+ *    holds only the note, in cents, plus octave errors (off by > 50 cents);
+ *  - latency: input frames from the note onset to the first confident
+ *    estimate within LOCK_CENTS.
+ *
+ * The built-in files are synthesized (pure sines, plucked strings with a
+ * weak fundamental on the low notes, a sung vowel with vibrato, noise), so
+ * the truth is known sample by sample. A recording of one steady note can
+ * be checked too:
+ *   pitch_tracker_test note.wav 196.0
+ */
+namespace {
+
+constexpr int STREAM_RATE = 48000;
+constexpr int CALLBACK_FRAMES = 192;
+constexpr float MIN_CONFIDENCE = 0.8f;
+constexpr double LOCK_CENTS = 20.0;
+constexpr double GROSS_CENTS = 50.0;
+constexpr double SETTLE_SECONDS = 0.1;  // After the onset, before accuracy counts
+constexpr double TWO_PI = 6.283185307179586;
+
+struct Note {
+    double onset;   // Seconds into the file
+    double length;  // Seconds
+    double hz;
+};
+
+struct NoteResult {
+    double medianCents = 0.0;  // Absolute error, confident estimates only
+    double lockMs = -1.0;      // -1 = never locked
+    int estimates = 0;
+    int confident = 0;
+    int gross = 0;
+};
+
+double cents(double hz, double reference) {
+    return 1200.0 * std::log2(hz / reference);
+}
+
+std::string writeFixture(const char *name, const std::vector<float> &samples, int rate) {
+    const std::string path = std::string("/tmp/pitch_tracker_test_") + name + ".wav";
+    WavWriter writer;
+    CHECK(writer.open(path.c_str(), rate, 1, WavWriter::SampleFormat::Pcm16));
+    CHECK(writer.write(samples.data(), static_cast<int>(samples.size())));
+    CHECK(writer.close());
+    return path;
+}
+
+// Pulls the whole file (and half a second more) through the input and
+// collects every new estimate
+std::vector<PitchTracker::Estimate> track(const std::string &path, double seconds) {
+    std::vector<PitchTracker::Estimate> estimates;
+    DuplexInput input;
+    CHECK(input.setFile(path.c_str()));
+    input.prepare(STREAM_RATE);
+    const auto frames = static_cast<uint64_t>((seconds + 0.5) * STREAM_RATE);
+    uint64_t last = ~0ull;
+    for (uint64_t done = 0; done < frames; done += CALLBACK_FRAMES) {
+        input.pull(CALLBACK_FRAMES);
+        const PitchTracker::Estimate estimate = input.getPitch();
+        if (estimate.frame != last) {
+            last = estimate.frame;
+            estimates.push_back(estimate);
+        }
+    }
+    return estimates;
+}
+
+// truth(seconds) is the pitch sung at that time (for vibrato), note.hz otherwise
+template <typename Truth>
+NoteResult measure(const std::vector<PitchTracker::Estimate> &estimates, const Note &note, Truth truth) {
+    NoteResult result;
+    std::vector<double> errors;
+    const double windowSeconds = 2048.0 / STREAM_RATE;  // The tracker's window at 48 kHz
+    for (const PitchTracker::Estimate &estimate : estimates) {
+        const double end = static_cast<double>(estimate.frame) / STREAM_RATE;
+        if (end <= note.onset || end > note.onset + note.length) {
+            continue;
+        }
+        const bool confident = estimate.frequency > 0.0f && estimate.confidence >= MIN_CONFIDENCE;
+        // Window centre: the estimate describes the last WINDOW samples
+        const double reference = truth(end - 0.5 * windowSeconds);
+        if (result.lockMs < 0.0 && confident && std::fabs(cents(estimate.frequency, truth(end))) <= LOCK_CENTS) {
+            result.lockMs = 1000.0 * (end - note.onset);
+        }
+        if (end < note.onset + windowSeconds + SETTLE_SECONDS) {
+            continue;
+        }
+        ++result.estimates;
+        if (!confident) {
+            continue;
+        }
+        ++result.confident;
+        const double error = std::fabs(cents(estimate.frequency, reference));
+        if (error > GROSS_CENTS) {
+            ++result.gross;
+        } else {
+            errors.push_back(error);
+        }
+    }
+    if (!errors.empty()) {
+        std::nth_element(errors.begin(), errors.begin() + errors.size() / 2, errors.end());
+        result.medianCents = errors[errors.size() / 2];
+    }
+    return result;
+}
+
+void report(const char *name, const Note &note, const NoteResult &result) {
+    std::printf("%-7s %7.2f Hz: median error %5.2f c, %d/%d confident, %d gross, lock %5.1f ms\n",
+                name, note.hz, result.medianCents, result.confident, result.estimates, result.gross,
+                result.lockMs);
+}
+
+// Requirements shared by the steady notes
+void checkNote(const NoteResult &result, double maxMedianCents, double maxLockMs) {
+    CHECK(result.estimates > 0);
+    CHECK(result.confident >= result.estimates * 9 / 10);
+    CHECK(result.gross == 0);
+    CHECK(result.medianCents <= maxMedianCents);
+    CHECK(result.lockMs >= 0.0);
+    CHECK(result.lockMs <= maxLockMs);
+}
+
+// Open strings and fretted notes of a guitar up to the high register, at 44.1 kHz
+// so the file is resampled on the way in; silence between notes
+void testSines() {
+    const double notes[] = {82.41, 110.0, 196.0, 440.0, 880.0, 1318.51};
+    constexpr int RATE = 44100;
+    std::vector<float> samples;
+    std::vector<Note> truth;
+    for (double hz : notes) {
+        samples.resize(samples.size() + RATE / 4, 0.0f);
+        const Note note{static_cast<double>(samples.size()) / RATE, 0.8, hz};
+        for (int i = 0; i < static_cast<int>(note.length * RATE); ++i) {
+            samples.push_back(static_cast<float>(0.5 * std::sin(TWO_PI * hz * i / RATE)));
+        }
+        truth.push_back(note);
+    }
+    const double seconds = static_cast<double>(samples.size()) / RATE;
+    const std::string path = writeFixture("sines", samples, RATE);
+    const auto estimates = track(path, seconds);
+    std::remove(path.c_str());
+    for (const Note &note : truth) {
+        const NoteResult result = measure(estimates, note, [&](double) { return note.hz; });
+        report("sine", note, result);
+        checkNote(result, 2.0, 60.0);
+    }
+
+    // The silent gaps give no pitch at all
+    for (const PitchTracker::Estimate &estimate : estimates) {
+        const double end = static_cast<double>(estimate.frame) / STREAM_RATE;
+        for (const Note &note : truth) {
+            if (end > note.onset + note.length + 0.05 && end < note.onset + note.length + 0.25) {
+                CHECK(estimate.frequency == 0.0f);
+            }
+        }
+    }
+}
+
+// Plucked strings: decaying harmonics with random phases, the fundamental
+// weak on the low strings (as from a bridge pickup)
+void testPlucks() {
+    const double notes[] = {82.41, 110.0, 146.83, 196.0, 246.94, 329.63, 659.26, 1046.5};
+    constexpr int RATE = 44100;
+    std::mt19937 random(3);
+    std::uniform_real_distribution<double> uniform(0.0, TWO_PI);
+    std::vector<float> samples;
+    std::vector<Note> truth;
+    for (double hz : notes) {
+        const Note note{static_cast<double>(samples.size()) / RATE, 1.0, hz};
+        double phases[40];
+        for (double &phase : phases) {
+            phase = uniform(random);
+        }
+        for (int i = 0; i < static_cast<int>(note.length * RATE); ++i) {
+            const double t = static_cast<double>(i) / RATE;
+            double sample = 0.0;
+            for (int k = 1; k <= 40 && k * hz < 8000.0; ++k) {
+                const double level = (k == 1 && hz < 120.0 ? 0.2 : 1.0) / k;
+                sample += level * std::exp(-t * (1.5 + 0.8 * k)) * std::sin(TWO_PI * k * hz * t + phases[k - 1]);
+            }
+            samples.push_back(static_cast<float>(0.4 * sample));
+        }
+        samples.resize(samples.size() + RATE / 5, 0.0f);
+        truth.push_back(note);
+    }
+    const double seconds = static_cast<double>(samples.size()) / RATE;
+    const std::string path = writeFixture("plucks", samples, RATE);
+    const auto estimates = track(path, seconds);
+    std::remove(path.c_str());
+    for (const Note &note : truth) {
+        const NoteResult result = measure(estimates, note, [&](double) { return note.hz; });
+        report("pluck", note, result);
+        checkNote(result, 5.0, 60.0);
+    }
+}
+
+// A sung vowel: saw through three formants, 5.5 Hz vibrato of +-30 cents,
+// A3 then E4, with breath noise
+void testVoice() {
+    constexpr int RATE = 48000;
+    auto pitch = [](double t) {
+        return 220.0 * std::pow(2.0, ((t < 2.0 ? 0.0 : 7.0) + 0.3 * std::sin(TWO_PI * 5.5 * t)) / 12.0);
+    };
+    std::mt19937 random(5);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    const double formants[3] = {700.0, 1220.0, 2600.0};
+    const double bandwidths[3] = {110.0, 120.0, 160.0};
+    const double levels[3] = {1.0, 0.5, 0.3};
+    double y1[3] = {}, y2[3] = {};
+    std::vector<float> samples(4 * RATE);
+    double phase = 0.0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        phase += pitch(static_cast<double>(i) / RATE) / RATE;
+        phase -= std::floor(phase);
+        const double source = 2.0 * phase - 1.0;
+        double sample = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            const double r = std::exp(-M_PI * bandwidths[k] / RATE);
+            const double y = source + 2.0 * r * std::cos(TWO_PI * formants[k] / RATE) * y1[k] - r * r * y2[k];
+            y2[k] = y1[k];
+            y1[k] = y;
+            sample += levels[k] * (1.0 - r) * y;
+        }
+        samples[i] = static_cast<float>(0.3 * sample + 0.002 * gauss(random));
+    }
+    const std::string path = writeFixture("voice", samples, RATE);
+    const auto estimates = track(path, 4.0);
+    std::remove(path.c_str());
+    const Note notes[] = {{0.0, 2.0, 220.0}, {2.0, 2.0, 329.63}};
+    for (const Note &note : notes) {
+        const NoteResult result = measure(estimates, note, pitch);
+        report("voice", note, result);
+        checkNote(result, 10.0, 60.0);
+    }
+}
+
+// White noise has no pitch to report
+void testNoise() {
+    constexpr int RATE = 48000;
+    std::mt19937 random(7);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    std::vector<float> samples(2 * RATE);
+    for (float &sample : samples) {
+        sample = static_cast<float>(0.1 * gauss(random));
+    }
+    const std::string path = writeFixture("noise", samples, RATE);
+    const auto estimates = track(path, 2.0);
+    std::remove(path.c_str());
+    int confident = 0;
+    for (const PitchTracker::Estimate &estimate : estimates) {
+        confident += estimate.frequency > 0.0f && estimate.confidence >= MIN_CONFIDENCE ? 1 : 0;
+    }
+    std::printf("noise: %d of %zu estimates confident\n", confident, estimates.size());
+    CHECK(confident == 0);
+}
+
+// A recording of one steady note, starting at its first sample above -40 dBFS
+void testRecording(const char *path, double hz) {
+    std::vector<float> samples;
+    int rate = 0;
+    CHECK(WavReader::readMono(path, samples, rate));
+    if (samples.empty() || rate <= 0) {
+        return;
+    }
+    size_t onset = 0;
+    while (onset < samples.size() && std::fabs(samples[onset]) < 0.01f) {
+        ++onset;
+    }
+    const Note note{static_cast<double>(onset) / rate, static_cast<double>(samples.size() - onset) / rate, hz};
+    const auto estimates = track(path, static_cast<double>(samples.size()) / rate);
+    const NoteResult result = measure(estimates, note, [&](double) { return hz; });
+    report("file", note, result);
+    checkNote(result, 10.0, 100.0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc == 3) {
+        testRecording(argv[1], std::atof(argv[2]));
+        return HOST_TEST_RESULT();
+    }
+    testSines();
+    testPlucks();
+    testVoice();
+    testNoise();
+    return HOST_TEST_RESULT();
+}
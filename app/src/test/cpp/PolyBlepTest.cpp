@@ -0,0 +1,119 @@
+#include "PolyBlep.h"
+#include "RealFFT.h"
+#include "HostTest.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/**
+ * polyBLEP spectra: saw and pulse (fixed and modulated width) at high
+ * notes, naive and band-limited, through a Blackman-Harris windowed FFT.
+ * Every bin farther than GUARD_BINS from a true harmonic is alias; the
+ * test checks the strongest alias component below AUDIBLE_HZ (where it is
+ * inharmonic and easy to hear) and the total alias power, both relative to
+ * the fundamental, and that polyBLEP lowers them by the margins below.
+ */
+namespace {
+
+constexpr int SAMPLE_RATE = 48000;
+constexpr int FFT_SIZE = 1 << 16;
+constexpr int GUARD_BINS = 6;  // Blackman-Harris main lobe is 4 bins either side
+constexpr double AUDIBLE_HZ = 5000.0;
+constexpr double TWO_PI = 6.283185307179586;
+
+struct Spectrum {
+    double fundamentalDb = 0.0;
+    double peakAliasDb = 0.0;   // Strongest alias bin below AUDIBLE_HZ, dB re fundamental
+    double totalAliasDb = 0.0;  // All alias bins up to Nyquist, dB re fundamental
+};
+
+template <typename Wave>
+Spectrum analyse(double frequency, Wave wave) {
+    std::vector<float> signal(FFT_SIZE);
+    const auto dt = static_cast<float>(frequency / SAMPLE_RATE);
+    double t = 0.0;
+    for (int n = 0; n < FFT_SIZE; ++n) {
+        // 4-term Blackman-Harris: sidelobes at -92 dB, below any alias measured here
+        const double x = TWO_PI * n / FFT_SIZE;
+        const double window = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2.0 * x) -
+                              0.01168 * std::cos(3.0 * x);
+        signal[n] = static_cast<float>(window * wave(static_cast<float>(t), dt, n));
+        t += frequency / SAMPLE_RATE;
+        t -= std::floor(t);
+    }
+
+    RealFFT fft(FFT_SIZE);
+    std::vector<float> re(fft.getBins()), im(fft.getBins());
+    fft.forward(signal.data(), re.data(), im.data());
+
+    const double binHz = static_cast<double>(SAMPLE_RATE) / FFT_SIZE;
+    double fundamental = 0.0;
+    double peakAlias = 0.0;
+    double totalAlias = 0.0;
+    for (int k = 1; k < fft.getBins(); ++k) {
+        const double power = static_cast<double>(re[k]) * re[k] + static_cast<double>(im[k]) * im[k];
+        const double hz = k * binHz;
+        const double harmonic = std::round(hz / frequency);
+        const bool nearHarmonic = harmonic >= 1.0 && std::fabs(hz - harmonic * frequency) <= GUARD_BINS * binHz;
+        if (nearHarmonic) {
+            if (harmonic == 1.0) {
+                fundamental = std::max(fundamental, power);
+            }
+            continue;
+        }
+        if (hz < GUARD_BINS * binHz) {
+            continue;  // DC lobe
+        }
+        totalAlias += power;
+        if (hz < AUDIBLE_HZ) {
+            peakAlias = std::max(peakAlias, power);
+        }
+    }
+
+    Spectrum spectrum;
+    spectrum.fundamentalDb = 10.0 * std::log10(fundamental);
+    spectrum.peakAliasDb = 10.0 * std::log10(peakAlias + 1e-30) - spectrum.fundamentalDb;
+    spectrum.totalAliasDb = 10.0 * std::log10(totalAlias + 1e-30) - spectrum.fundamentalDb;
+    return spectrum;
+}
+
+// Naive and band-limited versions of one waveform, at each note
+template <typename Naive, typename Blep>
+void checkWave(const char *name, Naive naive, Blep blep, double minPeakGainDb, double maxPeakDb) {
+    const double notes[] = {1318.51, 2093.0, 3135.96};  // E6, C7, G7: the top grid rows and above
+    for (double frequency : notes) {
+        const Spectrum before = analyse(frequency, naive);
+        const Spectrum after = analyse(frequency, blep);
+        std::printf("%-10s %7.1f Hz  alias peak < 5 kHz %6.1f -> %6.1f dB, total %6.1f -> %6.1f dB\n",
+                    name, frequency, before.peakAliasDb, after.peakAliasDb,
+                    before.totalAliasDb, after.totalAliasDb);
+        CHECK(before.peakAliasDb - after.peakAliasDb >= minPeakGainDb);
+        CHECK(after.peakAliasDb <= maxPeakDb);
+        CHECK(after.totalAliasDb < before.totalAliasDb);
+    }
+}
+
+} // namespace
+
+int main() {
+    checkWave("saw",
+              [](float t, float, int) { return t + t - 1.0f; },
+              [](float t, float dt, int) { return dsp::blepSaw(t, dt); },
+              35.0, -60.0);
+    checkWave("pulse",
+              [](float t, float, int) { return t < 0.3f ? 1.0f : -1.0f; },
+              [](float t, float dt, int) { return dsp::blepPulse(t, dt, 0.3f); },
+              35.0, -60.0);
+
+    // Width swept 0.4-0.6 at 0.4 Hz: the edge moves without resetting the phase, and
+    // the modulation sidebands stay inside the guard bins of each harmonic
+    auto width = [](int n) {
+        return 0.5f + 0.1f * static_cast<float>(std::sin(TWO_PI * 0.4 * n / SAMPLE_RATE));
+    };
+    checkWave("pwm",
+              [width](float t, float, int n) { return t < width(n) ? 1.0f : -1.0f; },
+              [width](float t, float dt, int n) { return dsp::blepPulse(t, dt, width(n)); },
+              35.0, -60.0);
+    return HOST_TEST_RESULT();
+}
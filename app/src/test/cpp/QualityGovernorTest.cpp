@@ -0,0 +1,293 @@
+#include "AudioEngine.h"
+#include "HostTest.h"
+#include <oboe/Oboe.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Quality governor through the engine: setSyntheticLoad() replaces the
+ * measured render time, so tier changes depend only on the injected load
+ * and the callback count.
+ *
+ *  - Sustained overload walks Full -> ReducedHarmonics -> ReducedReverb ->
+ *    CappedPolyphony one tier per STEP_DOWN_SECONDS; sustained headroom
+ *    walks back one tier per STEP_UP_SECONDS.
+ *  - A load inside the hysteresis band holds any tier, and a load
+ *    oscillating across either threshold never changes it.
+ *  - Each tier does what it says on the rendered organ: the upper drawbars
+ *    go, the bus reverb keeps only its longest comb, and the oldest held
+ *    notes are released down to the cap; back at Full the drawbars return.
+ */
+namespace {
+
+constexpr int SAMPLE_RATE = 48000;
+constexpr int FRAMES = 192;  // 4 ms deadline
+constexpr int ORGAN = 0;
+constexpr double TWO_PI = 6.283185307179586;
+
+// QualityGovernor thresholds and times, in callbacks of FRAMES
+constexpr float STEP_DOWN_LOAD = 0.75f;
+constexpr float STEP_UP_LOAD = 0.45f;
+constexpr int STEP_DOWN_CALLBACKS = 13;   // 0.05 s
+constexpr int STEP_UP_CALLBACKS = 750;    // 3 s
+constexpr float IN_BAND_LOAD = 0.6f;
+constexpr int REDUCED_POLYPHONY = 4;      // AudioEngine, held notes in CappedPolyphony
+
+class Rig {
+public:
+    explicit Rig(bool organOnBus) {
+        FakeOboe::setDevice(SAMPLE_RATE, FRAMES);
+        const int types[1] = {ORGAN};
+        const float lowHz[1] = {20.0f};
+        const float highHz[1] = {20000.0f};
+        const float levels[1] = {1.0f};
+        CHECK(engine.setInstrumentZones(types, lowHz, highHz, levels, 1));
+        if (organOnBus) {
+            engine.setInsertPlacement(ORGAN, 1);
+        }
+        engine.setSyntheticLoad(IN_BAND_LOAD);
+        CHECK(engine.start());
+    }
+    ~Rig() { engine.stop(); }
+
+    // Renders callbacks at a constant synthetic load, recording the tier after each
+    void run(float load, int callbacks) {
+        engine.setSyntheticLoad(load);
+        for (int c = 0; c < callbacks; ++c) {
+            callback();
+        }
+    }
+
+    void callback() {
+        engine.onAudioReady(nullptr, buffer, FRAMES);
+        output.insert(output.end(), buffer, buffer + FRAMES);
+        tiers.push_back(engine.getQualityTier());
+    }
+
+    // Steps down once from the current tier, then holds the new one
+    void stepDown() {
+        const int from = engine.getQualityTier();
+        engine.setSyntheticLoad(1.0f);
+        for (int c = 0; c < 4 * STEP_DOWN_CALLBACKS && engine.getQualityTier() == from; ++c) {
+            callback();
+        }
+        CHECK(engine.getQualityTier() == from + 1);
+        // The tier is applied at the start of the next callback
+        run(IN_BAND_LOAD, 1);
+    }
+
+    AudioEngine engine;
+    std::vector<float> output;
+    std::vector<int> tiers;
+
+private:
+    float buffer[FRAMES];  // The engine opens a mono stream
+};
+
+// Callback indices at which the tier changed
+std::vector<int> changes(const std::vector<int> &tiers, int from = 0) {
+    std::vector<int> result;
+    for (int i = std::max(from, 1); i < static_cast<int>(tiers.size()); ++i) {
+        if (tiers[i] != tiers[i - 1]) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+// Power at one frequency (Hann-windowed Goertzel) over [start, start + length)
+double powerAt(const std::vector<float> &signal, size_t start, size_t length, double hz) {
+    const double coeff = 2.0 * std::cos(TWO_PI * hz / SAMPLE_RATE);
+    double s1 = 0.0;
+    double s2 = 0.0;
+    for (size_t i = 0; i < length; ++i) {
+        const double window = 0.5 - 0.5 * std::cos(TWO_PI * i / length);
+        const double s0 = window * signal[start + i] + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    return (s1 * s1 + s2 * s2 - coeff * s1 * s2) / (static_cast<double>(length) * length);
+}
+
+double energy(const std::vector<float> &signal, size_t start, size_t length) {
+    double sum = 0.0;
+    for (size_t i = start; i < start + length; ++i) {
+        sum += static_cast<double>(signal[i]) * signal[i];
+    }
+    return sum;
+}
+
+double db(double ratio) { return 10.0 * std::log10(ratio + 1e-30); }
+
+void testTierWalk() {
+    Rig rig(false);
+    rig.engine.noteOn(0, 220.0f);
+    rig.run(IN_BAND_LOAD, 50);
+
+    const int overloadStart = static_cast<int>(rig.tiers.size());
+    rig.run(1.0f, 100);
+    const std::vector<int> down = changes(rig.tiers, overloadStart);
+    std::printf("overload: tier changes at callbacks");
+    for (int c : down) std::printf(" %d", c - overloadStart);
+    std::printf(", tier %d\n", rig.tiers.back());
+    CHECK(down.size() == QualityGovernor::NUM_TIERS - 1);
+    CHECK(rig.tiers.back() == static_cast<int>(QualityGovernor::Tier::CappedPolyphony));
+    for (size_t i = 0; i < down.size(); ++i) {
+        CHECK(rig.tiers[down[i]] == static_cast<int>(i) + 1);
+        const int previous = i == 0 ? overloadStart : down[i - 1];
+        CHECK(down[i] - previous >= STEP_DOWN_CALLBACKS - 1);
+        CHECK(down[i] - previous <= 2 * STEP_DOWN_CALLBACKS);
+    }
+
+    const int headroomStart = static_cast<int>(rig.tiers.size());
+    rig.run(0.1f, 4 * STEP_UP_CALLBACKS);
+    const std::vector<int> up = changes(rig.tiers, headroomStart);
+    std::printf("headroom: tier changes at callbacks");
+    for (int c : up) std::printf(" %d", c - headroomStart);
+    std::printf(", tier %d\n", rig.tiers.back());
+    CHECK(up.size() == QualityGovernor::NUM_TIERS - 1);
+    CHECK(rig.tiers.back() == static_cast<int>(QualityGovernor::Tier::Full));
+    for (size_t i = 0; i < up.size(); ++i) {
+        CHECK(rig.tiers[up[i]] == QualityGovernor::NUM_TIERS - 2 - static_cast<int>(i));
+        const int previous = i == 0 ? headroomStart : up[i - 1];
+        CHECK(up[i] - previous >= STEP_UP_CALLBACKS - 1);
+        CHECK(up[i] - previous <= STEP_UP_CALLBACKS + STEP_DOWN_CALLBACKS);
+    }
+}
+
+void testHysteresis() {
+    Rig rig(false);
+    rig.engine.noteOn(0, 220.0f);
+
+    // Inside the band any tier holds, for longer than either step time
+    rig.run(IN_BAND_LOAD, 2 * STEP_UP_CALLBACKS);
+    CHECK(changes(rig.tiers).empty());
+    rig.stepDown();
+    rig.stepDown();
+    int start = static_cast<int>(rig.tiers.size());
+    rig.run(IN_BAND_LOAD, 2 * STEP_UP_CALLBACKS);
+    CHECK(changes(rig.tiers, start).empty());
+    CHECK(rig.tiers.back() == static_cast<int>(QualityGovernor::Tier::ReducedReverb));
+
+    // A load that dithers across each threshold, or swings across the
+    // step-down one faster than STEP_DOWN_SECONDS, doesn't move the tier
+    struct Pattern {
+        const char *name;
+        float low;
+        float high;
+        int halfPeriod;  // Callbacks at each value
+    };
+    const Pattern patterns[] = {
+            {"dither at step-down", STEP_DOWN_LOAD - 0.02f, STEP_DOWN_LOAD + 0.02f, 1},
+            {"dither at step-up", STEP_UP_LOAD - 0.02f, STEP_UP_LOAD + 0.02f, 1},
+            {"swing across step-down", 0.55f, 0.95f, 6},
+    };
+    for (const Pattern &pattern : patterns) {
+        start = static_cast<int>(rig.tiers.size());
+        for (int c = 0; c < 2 * STEP_UP_CALLBACKS; ++c) {
+            rig.run((c / pattern.halfPeriod) % 2 ? pattern.high : pattern.low, 1);
+        }
+        const size_t flips = changes(rig.tiers, start).size();
+        std::printf("%-22s load %.2f/%.2f: %zu tier changes in %d callbacks\n",
+                    pattern.name, pattern.low, pattern.high, flips, 2 * STEP_UP_CALLBACKS);
+        CHECK(flips == 0);
+    }
+    CHECK(rig.tiers.back() == static_cast<int>(QualityGovernor::Tier::ReducedReverb));
+}
+
+// Upper drawbars (1 1/3' and 1') against the fundamental, over the last WINDOW rendered
+constexpr size_t WINDOW = SAMPLE_RATE / 2;
+constexpr double NOTE = 200.0;
+
+double upperDrawbarsDb(const std::vector<float> &output) {
+    const size_t start = output.size() - WINDOW;
+    return db((powerAt(output, start, WINDOW, 6.0 * NOTE) + powerAt(output, start, WINDOW, 8.0 * NOTE)) /
+              powerAt(output, start, WINDOW, NOTE));
+}
+
+// Tail of a 20 ms blip: energy 90-100 ms after the note-off, where the
+// 100 ms comb's first echo lands, against 70-80 ms, where the 63 and 77 ms
+// combs' do. A lone long comb makes the tail rebound there.
+double echoReboundDb(Rig &rig) {
+    constexpr size_t MS = SAMPLE_RATE / 1000;
+    rig.engine.noteOn(0, static_cast<float>(NOTE));
+    rig.run(IN_BAND_LOAD, 5);
+    rig.engine.noteOff(0);
+    const size_t released = rig.output.size();
+    rig.run(IN_BAND_LOAD, SAMPLE_RATE / FRAMES);
+    return db(energy(rig.output, released + 90 * MS, 10 * MS) / energy(rig.output, released + 70 * MS, 10 * MS));
+}
+
+void testTierEffects() {
+    constexpr int HOLD = SAMPLE_RATE / FRAMES;  // 1 s per measurement
+    Rig rig(true);  // Organ through the bus reverb
+
+    // Tier 1: the upper drawbars go
+    rig.engine.noteOn(0, static_cast<float>(NOTE));
+    rig.run(IN_BAND_LOAD, HOLD);
+    const double fullDrawbars = upperDrawbarsDb(rig.output);
+    rig.stepDown();
+    rig.run(IN_BAND_LOAD, HOLD);
+    const double reducedDrawbars = upperDrawbarsDb(rig.output);
+    std::printf("6th + 8th harmonics re fundamental: %.1f dB full, %.1f dB reduced harmonics\n",
+                fullDrawbars, reducedDrawbars);
+    CHECK(fullDrawbars - reducedDrawbars >= 6.0);
+    rig.engine.noteOff(0);
+    rig.run(IN_BAND_LOAD, HOLD);
+
+    // Tier 2: the bus reverb keeps only its 100 ms comb
+    const double threeCombs = echoReboundDb(rig);
+    rig.stepDown();
+    const double oneComb = echoReboundDb(rig);
+    std::printf("reverb tail at 90-100 ms re 70-80 ms: %.1f dB with three combs, %.1f dB with one\n",
+                threeCombs, oneComb);
+    CHECK(threeCombs < 0.0);
+    CHECK(oneComb - threeCombs >= 4.0);
+
+    // Tier 3: six held notes, the two oldest are released down to the cap
+    // (no harmonic of the others lands on their fundamentals)
+    const float chord[] = {211.0f, 263.0f, 317.0f, 373.0f, 449.0f, 487.0f};
+    for (int i = 0; i < 6; ++i) {
+        rig.engine.noteOn(i, chord[i]);
+    }
+    rig.run(IN_BAND_LOAD, HOLD);
+    std::vector<double> before(6);
+    for (int i = 0; i < 6; ++i) {
+        before[i] = powerAt(rig.output, rig.output.size() - WINDOW, WINDOW, chord[i]);
+    }
+    rig.stepDown();
+    rig.run(IN_BAND_LOAD, HOLD);
+    std::printf("capped polyphony, change per note:");
+    for (int i = 0; i < 6; ++i) {
+        const double change = db(powerAt(rig.output, rig.output.size() - WINDOW, WINDOW, chord[i]) / before[i]);
+        std::printf(" %.0f Hz %.1f dB%s", chord[i], change, i < 5 ? "," : "\n");
+        if (i < 6 - REDUCED_POLYPHONY) {
+            CHECK(change <= -40.0);
+        } else {
+            CHECK(std::fabs(change) <= 3.0);
+        }
+    }
+
+    // And back up: after sustained headroom the drawbars return
+    for (int i = 0; i < 6; ++i) {
+        rig.engine.noteOff(i);
+    }
+    rig.run(0.1f, 4 * STEP_UP_CALLBACKS);
+    CHECK(rig.tiers.back() == static_cast<int>(QualityGovernor::Tier::Full));
+    rig.engine.noteOn(0, static_cast<float>(NOTE));
+    rig.run(IN_BAND_LOAD, HOLD);
+    const double restoredDrawbars = upperDrawbarsDb(rig.output);
+    std::printf("back at full: 6th + 8th harmonics %.1f dB\n", restoredDrawbars);
+    CHECK_NEAR(restoredDrawbars, fullDrawbars, 1.0);
+}
+
+} // namespace
+
+int main() {
+    testTierWalk();
+    testHysteresis();
+    testTierEffects();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,140 @@
+#include "AudioEngine.h"
+#include "HostTest.h"
+#include <oboe/Oboe.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Sample-rate independence: every instrument, rendered through the whole
+ * engine at 44.1, 48 and 96 kHz, must have the same loudness over time.
+ * The test compares 50 ms RMS envelopes with the 48 kHz render, window by
+ * window, and allows MAX_DIFF_DB. Windows more than FLOOR_DB below the
+ * 48 kHz peak are skipped: there the envelope is the tail of a release or
+ * reverb, and a fraction of a dB is a fraction of nothing.
+ *
+ * Snare and hi-hat noise is a different realisation at each rate, and 50 ms
+ * of band-limited noise varies by a few tenths of a dB by itself, so the
+ * drum envelopes are the power average of renders with DRUM_SEEDS engine
+ * seeds.
+ */
+namespace {
+
+constexpr int REFERENCE_RATE = 48000;
+constexpr int RATES[] = {44100, 48000, 96000};
+constexpr double MAX_DIFF_DB = 0.2;
+constexpr double FLOOR_DB = -40.0;
+constexpr int WINDOWS_PER_SECOND = 20;  // 50 ms
+constexpr int DRUM_SEEDS = 8;
+
+struct Instrument {
+    const char *name;
+    int type;
+    float notes[4];
+    int seeds;
+};
+
+const Instrument INSTRUMENTS[] = {
+        {"organ", 0, {220.0f, 277.18f, 329.63f, 440.0f}, 1},
+        {"synth lead", 1, {220.0f, 277.18f, 329.63f, 440.0f}, 1},
+        {"drums", 2, {60.0f, 280.0f, 900.0f, 150.0f}, DRUM_SEEDS},  // Kick, snare, closed hi-hat, mid tom
+        {"bass", 3, {55.0f, 73.42f, 82.41f, 110.0f}, 1},
+        {"guitar", 4, {196.0f, 246.94f, 293.66f, 392.0f}, 1},
+};
+
+// 50 ms mean-square envelope of four notes: 0.4 s held, 0.2 s released each
+std::vector<double> renderPower(const Instrument &instrument, int rate, uint32_t seed) {
+    const int frames = rate / 250;  // 4 ms callbacks
+    AudioEngine engine;
+    const int types[1] = {instrument.type};
+    const float lowHz[1] = {20.0f};
+    const float highHz[1] = {20000.0f};
+    const float levels[1] = {1.0f};
+    CHECK(engine.setInstrumentZones(types, lowHz, highHz, levels, 1));
+    // Seeded tables at the stream rate, so the start reuses them
+    CHECK(engine.prepareForReplay(rate, seed));
+    FakeOboe::setDevice(rate, frames);
+    CHECK(engine.start());
+
+    // Exact durations: at 44.1 kHz the last callback of each segment is shorter
+    std::vector<float> output;
+    std::vector<float> buffer(frames);
+    auto run = [&](double seconds) {
+        for (int remaining = static_cast<int>(std::lround(seconds * rate)); remaining > 0;) {
+            const int count = std::min(frames, remaining);
+            engine.onAudioReady(nullptr, buffer.data(), count);
+            output.insert(output.end(), buffer.begin(), buffer.begin() + count);
+            remaining -= count;
+        }
+    };
+    for (float note : instrument.notes) {
+        engine.noteOn(0, note);
+        run(0.4);
+        engine.noteOff(0);
+        run(0.2);
+    }
+    engine.stop();
+
+    const size_t window = rate / WINDOWS_PER_SECOND;
+    std::vector<double> power;
+    for (size_t start = 0; start + window <= output.size(); start += window) {
+        double sum = 0.0;
+        for (size_t i = start; i < start + window; ++i) {
+            sum += static_cast<double>(output[i]) * output[i];
+        }
+        power.push_back(sum / window);
+    }
+    return power;
+}
+
+// RMS envelope in dB, power-averaged over the seeds
+std::vector<double> renderEnvelope(const Instrument &instrument, int rate) {
+    std::vector<double> envelope = renderPower(instrument, rate, 1);
+    for (int seed = 2; seed <= instrument.seeds; ++seed) {
+        const std::vector<double> power = renderPower(instrument, rate, static_cast<uint32_t>(seed));
+        for (size_t w = 0; w < envelope.size(); ++w) {
+            envelope[w] += power[w];
+        }
+    }
+    for (double &value : envelope) {
+        value = 10.0 * std::log10(value / instrument.seeds + 1e-20);
+    }
+    return envelope;
+}
+
+void testInstrument(const Instrument &instrument) {
+    const std::vector<double> reference = renderEnvelope(instrument, REFERENCE_RATE);
+    const double peak = *std::max_element(reference.begin(), reference.end());
+    for (int rate : RATES) {
+        if (rate == REFERENCE_RATE) {
+            continue;
+        }
+        const std::vector<double> envelope = renderEnvelope(instrument, rate);
+        const size_t windows = std::min(envelope.size(), reference.size());
+        double worst = 0.0;
+        size_t worstWindow = 0;
+        for (size_t w = 0; w < windows; ++w) {
+            if (reference[w] < peak + FLOOR_DB) {
+                continue;
+            }
+            const double diff = std::fabs(envelope[w] - reference[w]);
+            if (diff > worst) {
+                worst = diff;
+                worstWindow = w;
+            }
+        }
+        std::printf("%-10s %5d Hz: 50 ms RMS within %.3f dB of 48 kHz (worst at %.2f s)\n",
+                    instrument.name, rate, worst, static_cast<double>(worstWindow) / WINDOWS_PER_SECOND);
+        CHECK(worst <= MAX_DIFF_DB);
+    }
+}
+
+} // namespace
+
+int main() {
+    for (const Instrument &instrument : INSTRUMENTS) {
+        testInstrument(instrument);
+    }
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,238 @@
+#include "ADSREnvelope.h"
+#include "PcmConverter.h"
+#include "TimeStretcher.h"
+#include "UnisonSaw.h"
+#include "HostTest.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/**
+ * SIMD branches against the scalar lanes: this file is built once per
+ * branch (scalar, SSE2, and NEON through the fake arm_neon.h, see
+ * CMakeLists.txt). The scalar build writes its output as the reference
+ * (--write), the others run the same workloads and compare (--compare):
+ *
+ *  - PcmConverter: gains, clipping and odd lengths; int16 within 1 LSB
+ *    (dither sums rounded in another order can tie-break differently),
+ *    clipped floats exact.
+ *  - UnisonSaw: 1-8 lanes at low and high notes, detune up to 100 cents,
+ *    render() in odd-sized blocks and next() sample by sample; within
+ *    0.01 and 70 dB SNR of the per-lane dsp::polyBlep loop (the vector
+ *    code steps the phases 4 samples at a time, which rounds differently
+ *    and shows up near the edges, where the saw moves fastest).
+ *  - TimeStretcher: a stereo harmonic track stretched and transposed.
+ *  - ADSREnvelope: process() over linear and exponential notes in odd-sized
+ *    blocks, within 1e-6 (the same lanes and recurrences in every branch).
+ *
+ * Every section also reports how many values differ, so a branch that is
+ * bit-exact today stays visible as such.
+ */
+namespace {
+
+constexpr double TWO_PI = 6.283185307179586;
+constexpr int SAMPLE_RATE = 48000;
+
+#if defined(__aarch64__)
+constexpr const char *VARIANT = "neon";
+#elif defined(__SSE2__)
+constexpr const char *VARIANT = "sse2";
+#else
+constexpr const char *VARIANT = "scalar";
+#endif
+
+struct Section {
+    const char *name;
+    std::vector<float> values;
+    double tolerance;  // Max absolute difference from the reference
+    double minSnrDb;   // Reference energy over difference energy
+};
+
+void runPcm(Section &pcm, Section &clipped) {
+    PcmConverter converter;
+    const int lengths[] = {192, 7, 256, 1, 333, 96};
+    const float gains[] = {0.8f, 1.0f, 2.5f, 0.01f, 1.7f, 0.5f};
+    std::vector<float> samples;
+    std::vector<int16_t> out;
+    double t = 0.0;
+    for (int pass = 0; pass < 40; ++pass) {
+        for (size_t k = 0; k < sizeof(lengths) / sizeof(lengths[0]); ++k) {
+            const int frames = lengths[k];
+            samples.resize(frames);
+            out.assign(frames, 0);
+            for (int i = 0; i < frames; ++i, t += 1.0 / SAMPLE_RATE) {
+                samples[i] = static_cast<float>(0.9 * std::sin(TWO_PI * 440.0 * t) +
+                                                0.3 * std::sin(TWO_PI * 3150.0 * t));
+            }
+            converter.process(samples.data(), out.data(), frames, gains[k]);
+            for (int i = 0; i < frames; ++i) {
+                pcm.values.push_back(static_cast<float>(out[i]));
+                clipped.values.push_back(samples[i]);
+            }
+        }
+    }
+}
+
+// Fresh stacks rendering about one callback each: the lanes are free-running
+// phase accumulators, and over longer runs the scalar per-sample steps and
+// the vector 4-sample steps round apart (a timing drift of a fraction of a
+// sample per second, inaudible but larger than any fixed tolerance)
+void runUnison(Section &unison) {
+    dsp::NoiseGenerator noise(7u);
+    const float frequencies[] = {110.0f, 440.0f, 1760.0f, 5000.0f};
+    const int blocks[] = {5, 64, 187};
+    std::vector<float> block;
+    for (int voices = 1; voices <= UnisonSaw::MAX_VOICES; ++voices) {
+        for (float frequency : frequencies) {
+            for (int start = 0; start < 16; ++start) {
+                UnisonSaw saw;
+                saw.configure(voices, 25.0f * static_cast<float>(voices % 5), 0.2f * static_cast<float>(voices % 6));
+                saw.randomizePhases(noise);
+                const float increment = frequency / SAMPLE_RATE;
+                for (int frames : blocks) {
+                    block.resize(frames);
+                    saw.render(block.data(), frames, increment);
+                    unison.values.insert(unison.values.end(), block.begin(), block.end());
+                }
+                for (int i = 0; i < 16; ++i) {
+                    unison.values.push_back(saw.next(increment));
+                }
+            }
+        }
+    }
+}
+
+void runStretch(Section &stretch) {
+    constexpr int CHANNELS = 2;
+    constexpr int INPUT_BLOCK = 1024;
+    constexpr int OUTPUT_BLOCK = 480;
+    TimeStretcher stretcher(SAMPLE_RATE, CHANNELS);
+    stretcher.setTempo(1.25f);
+    stretcher.setPitchSemitones(3.0f);
+    std::vector<float> input(INPUT_BLOCK * CHANNELS);
+    std::vector<float> output(OUTPUT_BLOCK * CHANNELS);
+    size_t frame = 0;
+    for (int block = 0; block < 60; ++block) {
+        for (int i = 0; i < INPUT_BLOCK; ++i, ++frame) {
+            const double t = static_cast<double>(frame) / SAMPLE_RATE;
+            input[i * CHANNELS] = static_cast<float>(0.5 * std::sin(TWO_PI * 196.0 * t) +
+                                                     0.2 * std::sin(TWO_PI * 588.0 * t));
+            input[i * CHANNELS + 1] = static_cast<float>(0.4 * std::sin(TWO_PI * 293.7 * t));
+        }
+        stretcher.putSamples(input.data(), INPUT_BLOCK);
+        int received;
+        while ((received = stretcher.receiveSamples(output.data(), OUTPUT_BLOCK)) > 0) {
+            stretch.values.insert(stretch.values.end(), output.begin(), output.begin() + received * CHANNELS);
+        }
+    }
+}
+
+void runEnvelope(Section &adsr) {
+    const int blocks[] = {192, 5, 64, 1, 333};
+    std::vector<float> gain;
+    for (ADSREnvelope::Curve curve : {ADSREnvelope::Curve::Linear, ADSREnvelope::Curve::Exponential}) {
+        ADSREnvelope envelope;
+        envelope.setSampleRate(static_cast<float>(SAMPLE_RATE));
+        envelope.setCurve(curve);
+        envelope.setAttackTime(0.02f);
+        envelope.setDecayTime(0.15f);
+        envelope.setSustainLevel(0.6f);
+        envelope.setReleaseTime(0.3f);
+        for (int note = 0; note < 4; ++note) {
+            envelope.noteOn();
+            for (int block = 0; block < 40; ++block) {
+                const int frames = blocks[block % 5];
+                gain.resize(frames);
+                envelope.process(gain.data(), frames);
+                adsr.values.insert(adsr.values.end(), gain.begin(), gain.end());
+            }
+            envelope.noteOff();
+            for (int block = 0; block < 80; ++block) {
+                const int frames = blocks[(block + note) % 5];
+                gain.resize(frames);
+                envelope.process(gain.data(), frames);
+                adsr.values.insert(adsr.values.end(), gain.begin(), gain.end());
+            }
+        }
+    }
+}
+
+bool writeSections(const char *path, const std::vector<Section> &sections) {
+    FILE *file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    for (const Section &section : sections) {
+        const auto count = static_cast<uint32_t>(section.values.size());
+        std::fwrite(&count, sizeof(count), 1, file);
+        std::fwrite(section.values.data(), sizeof(float), count, file);
+    }
+    return std::fclose(file) == 0;
+}
+
+void compareSections(const char *path, const std::vector<Section> &sections) {
+    FILE *file = std::fopen(path, "rb");
+    CHECK(file != nullptr);
+    if (file == nullptr) {
+        return;
+    }
+    std::vector<float> reference;
+    for (const Section &section : sections) {
+        uint32_t count = 0;
+        CHECK(std::fread(&count, sizeof(count), 1, file) == 1);
+        reference.resize(count);
+        CHECK(std::fread(reference.data(), sizeof(float), count, file) == count);
+        CHECK(count == section.values.size());
+
+        const size_t n = std::min(reference.size(), section.values.size());
+        double maxDiff = 0.0;
+        double signal = 0.0;
+        double error = 0.0;
+        size_t differing = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const double diff = std::fabs(static_cast<double>(section.values[i]) - reference[i]);
+            maxDiff = std::max(maxDiff, diff);
+            signal += static_cast<double>(reference[i]) * reference[i];
+            error += diff * diff;
+            differing += diff > 0.0 ? 1 : 0;
+        }
+        const double snrDb = error > 0.0 ? 10.0 * std::log10(signal / error) : 999.0;
+        std::printf("%s %-8s %8zu values, %zu differ, max diff %.3g, SNR %.1f dB\n",
+                    VARIANT, section.name, n, differing, maxDiff, snrDb);
+        CHECK_NEAR(maxDiff, 0.0, section.tolerance);
+        CHECK(snrDb >= section.minSnrDb);
+    }
+    std::fclose(file);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 3 || (std::strcmp(argv[1], "--write") != 0 && std::strcmp(argv[1], "--compare") != 0)) {
+        std::fprintf(stderr, "usage: %s --write|--compare <reference file>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Section> sections = {
+            {"pcm16", {}, 1.0, 80.0},
+            {"clipped", {}, 0.0, 0.0},
+            {"unison", {}, 1e-2, 70.0},
+            {"stretch", {}, 1e-4, 100.0},
+            {"adsr", {}, 1e-6, 120.0},
+    };
+    runPcm(sections[0], sections[1]);
+    runUnison(sections[2]);
+    runStretch(sections[3]);
+    runEnvelope(sections[4]);
+
+    if (std::strcmp(argv[1], "--write") == 0) {
+        CHECK(writeSections(argv[2], sections));
+        std::printf("%s reference written to %s\n", VARIANT, argv[2]);
+    } else {
+        compareSections(argv[2], sections);
+    }
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,227 @@
+#include "StressHarness.h"
+#include "AudioEngine.h"
+#include "DspUtils.h"
+#include "TimeStretcher.h"
+#include <android/log.h>
+#include <oboe/Oboe.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#define LOG_TAG "StressHarness"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using Clock = std::chrono::steady_clock;
+
+bool StressHarness::run(AudioEngine &engine, const Config &config, Report &report) {
+    if (config.durationSeconds <= 0.0f || config.framesPerBuffer <= 0 ||
+        config.sampleRate <= 0 || config.controlThreads <= 0 || config.eventsPerSecond < 0) {
+        LOGE("Invalid stress configuration");
+        return false;
+    }
+    if (!engine.prepareForReplay(config.sampleRate, 0)) {
+        LOGE("Stress run requires the stream to be stopped");
+        return false;
+    }
+
+    // Same rate and seed as the tables just built, so the start reuses them
+    FakeOboe::setDevice(config.sampleRate, config.framesPerBuffer);
+    engine.setOutputFormat(config.pcm16Output ? AudioEngine::OUTPUT_FORMAT_PCM16
+                                              : AudioEngine::OUTPUT_FORMAT_FLOAT);
+    engine.setIdleTimeout(0);
+    if (!engine.start()) {
+        LOGE("Cannot start the engine on the fake backend");
+        return false;
+    }
+    engine.setWaveType(config.waveType);
+
+    const double period = static_cast<double>(config.framesPerBuffer) / config.sampleRate;
+    const auto expectedCallbacks = static_cast<size_t>(config.durationSeconds / period) + 1;
+    durations.clear();
+    durations.reserve(expectedCallbacks);
+    missedDeadlines = 0;
+    stretchLoadPercent = 0.0;
+    eventCount.store(0);
+    running.store(true);
+
+    std::vector<std::thread> controls;
+    controls.reserve(config.controlThreads);
+    std::thread callbacks(&StressHarness::callbackLoop, this, &engine, &config);
+    std::thread backingTrack;
+    if (config.backingTrack) {
+        backingTrack = std::thread(&StressHarness::backingTrackLoop, this);
+    }
+    for (int i = 0; i < config.controlThreads; ++i) {
+        controls.emplace_back(&StressHarness::controlLoop, this, &engine, &config, i);
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.durationSeconds));
+    running.store(false);
+    for (auto &thread : controls) {
+        thread.join();
+    }
+    callbacks.join();
+    if (backingTrack.joinable()) {
+        backingTrack.join();
+    }
+    engine.allNotesOff();
+    engine.stop();
+
+    report = Report{};
+    report.callbacks = durations.size();
+    report.missedDeadlines = missedDeadlines;
+    report.events = eventCount.load();
+    report.deadlineMicros = period * 1e6;
+    report.stretchLoadPercent = stretchLoadPercent;
+    if (!durations.empty()) {
+        // Percentiles by selection; the run is over, so sorting cost doesn't matter
+        auto percentile = [this](double fraction) {
+            auto index = static_cast<size_t>(fraction * static_cast<double>(durations.size() - 1));
+            std::nth_element(durations.begin(), durations.begin() + index, durations.end());
+            return static_cast<double>(durations[index]);
+        };
+        report.p50Micros = percentile(0.5);
+        report.p99Micros = percentile(0.99);
+        report.p999Micros = percentile(0.999);
+        report.maxMicros = *std::max_element(durations.begin(), durations.end());
+    }
+
+    LOGI("Stress: %llu callbacks, %llu events, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, "
+         "max %.1f us, deadline %.1f us, missed %llu, stretch load %.2f%%, %s output",
+         static_cast<unsigned long long>(report.callbacks),
+         static_cast<unsigned long long>(report.events),
+         report.p50Micros, report.p99Micros, report.p999Micros, report.maxMicros,
+         report.deadlineMicros, static_cast<unsigned long long>(report.missedDeadlines),
+         report.stretchLoadPercent, config.pcm16Output ? "pcm16" : "float");
+    return true;
+}
+
+/**
+ * Null backend: wakes at each buffer's due time like a real audio driver
+ * and times the whole callback. A callback that ends after the next buffer
+ * was due (late wake-up included) counts as a missed deadline.
+ */
+void StressHarness::callbackLoop(AudioEngine *engine, const Config *config) {
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(config->framesPerBuffer) /
+                                          config->sampleRate));
+    std::vector<float> buffer(config->framesPerBuffer);
+    std::vector<int16_t> pcm(config->pcm16Output ? config->framesPerBuffer : 0);
+    void *audioData = config->pcm16Output ? static_cast<void *>(pcm.data()) : buffer.data();
+    auto due = Clock::now();
+
+    while (running.load(std::memory_order_relaxed) && durations.size() < durations.capacity()) {
+        std::this_thread::sleep_until(due);
+
+        const auto start = Clock::now();
+        engine->onAudioReady(nullptr, audioData, config->framesPerBuffer);
+        const auto end = Clock::now();
+
+        durations.push_back(std::chrono::duration<float, std::micro>(end - start).count());
+        due += period;
+        if (end > due) {
+            ++missedDeadlines;
+        }
+    }
+}
+
+void StressHarness::controlLoop(AudioEngine *engine, const Config *config, int thread) {
+    const int voice = thread % AudioEngine::MAX_VOICES;
+    const double eventsPerThread = static_cast<double>(config->eventsPerSecond) / config->controlThreads;
+    if (eventsPerThread <= 0.0) {
+        return;
+    }
+    const auto interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / eventsPerThread));
+
+    // One finger per thread, spread over two octaves
+    const float frequency = 110.0f * std::pow(2.0f, static_cast<float>(thread * 3 % 24) / 12.0f);
+    engine->noteOn(voice, frequency);
+    uint64_t sent = 1;
+
+    const auto start = Clock::now();
+    auto due = start;
+    for (uint64_t n = 1; running.load(std::memory_order_relaxed); ++n) {
+        due += interval;
+        std::this_thread::sleep_until(due);  // A starved thread catches up in a burst, like queued touches
+
+        if (n % RETRIGGER_INTERVAL == 0) {
+            engine->noteOff(voice);
+            engine->noteOn(voice, frequency);
+            sent += 2;
+        } else if (n % PARAMETER_INTERVAL == PARAMETER_INTERVAL / 2) {
+            const float position = static_cast<float>((n / PARAMETER_INTERVAL) % 32) / 31.0f;
+            if (thread % 2 == 0) {
+                engine->setGuitarParams(0.7f, 0.5f + 0.5f * position, 0.7f, 0.3f);
+            } else {
+                engine->setWahPosition(position);
+            }
+            ++sent;
+        } else {
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            const float bend = BEND_DEPTH_SEMITONES *
+                    std::sin(static_cast<float>(2.0 * dsp::PI * BEND_RATE_HZ * seconds) + thread);
+            engine->setPitchBend(voice, bend);
+            ++sent;
+        }
+    }
+    eventCount.fetch_add(sent);
+}
+
+/**
+ * Backing track: pulls 10 ms of stretched stereo per tick, feeding the
+ * stretcher decoder-sized blocks of a synthetic chord whenever it runs dry,
+ * and measures how long the stretcher itself takes. The chord comes from
+ * wrapped double phases, so it stays clean however long the run, and its
+ * synthesis is outside the measured time.
+ */
+void StressHarness::backingTrackLoop() {
+    constexpr int INPUT_FRAMES = 1024;
+    constexpr int OUTPUT_FRAMES = TRACK_SAMPLE_RATE / 100;
+    constexpr double CHORD_HZ[] = {220.0, 277.2, 329.6};
+    constexpr double TWO_PI = 6.283185307179586;
+    TimeStretcher stretcher(TRACK_SAMPLE_RATE, 2);
+    stretcher.setTempo(TRACK_TEMPO);
+    stretcher.setPitchSemitones(TRACK_SEMITONES);
+
+    std::vector<float> input(INPUT_FRAMES * 2);
+    std::vector<float> output(OUTPUT_FRAMES * 2);
+    double phases[3] = {};
+    uint64_t outputFrames = 0;
+    Clock::duration busy{};
+    const auto period = std::chrono::milliseconds(10);
+    auto due = Clock::now();
+
+    while (running.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_until(due);
+        due += period;
+
+        while (stretcher.availableFrames() < OUTPUT_FRAMES) {
+            for (int i = 0; i < INPUT_FRAMES; ++i) {
+                float chord = 0.0f;
+                for (int n = 0; n < 3; ++n) {
+                    chord += 0.2f * static_cast<float>(std::sin(phases[n]));
+                    phases[n] += TWO_PI * CHORD_HZ[n] / TRACK_SAMPLE_RATE;
+                    if (phases[n] >= TWO_PI) {
+                        phases[n] -= TWO_PI;
+                    }
+                }
+                input[i * 2] = chord;
+                input[i * 2 + 1] = chord;
+            }
+            const auto start = Clock::now();
+            stretcher.putSamples(input.data(), INPUT_FRAMES);
+            busy += Clock::now() - start;
+        }
+        const auto start = Clock::now();
+        outputFrames += stretcher.receiveSamples(output.data(), OUTPUT_FRAMES);
+        busy += Clock::now() - start;
+    }
+
+    if (outputFrames > 0) {
+        const double audioSeconds = static_cast<double>(outputFrames) / TRACK_SAMPLE_RATE;
+        stretchLoadPercent = 100.0 * std::chrono::duration<double>(busy).count() / audioSeconds;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef STRESS_HARNESS_H
+#define STRESS_HARNESS_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class AudioEngine;
+
+/**
+ * StressHarness - End-to-end event storm against a paced null backend
+ *
+ * Host test target only. The engine is started on the fake Oboe backend,
+ * whose streams have no thread of their own, and a dedicated thread calls
+ * the engine's onAudioReady in real time (one buffer every framesPerBuffer / sampleRate
+ * seconds) while several control threads hammer the public API the way
+ * the UI does during an 8-finger bend: pitch bends on every held voice,
+ * retriggered notes and guitar/wah parameter changes. Every callback is
+ * timed, so contention on the engine lock, the event queue or the
+ * allocator shows up in the tail of the distribution rather than in a
+ * microbenchmark average.
+ *
+ * With backingTrack set, another thread time-stretches a synthetic stereo
+ * track in real time (as ExoPlayer's playback thread does for a slowed,
+ * transposed backing track), so the callback timings include that load
+ * and the report gives the stretcher's own cost; synthesizing the track is
+ * not counted. With pcm16Output the stream opens as PCM 16 and the
+ * callbacks fill an int16 buffer, so the cost of the dithered conversion
+ * can be compared against the float path.
+ *
+ * The engine must not be running; it is left stopped at config.sampleRate.
+ */
+class StressHarness {
+public:
+    struct Config {
+        float durationSeconds = 10.0f;
+        int eventsPerSecond = 10000;  // Total over all control threads
+        int controlThreads = 8;       // One finger (voice) per thread, modulo the voice count
+        int framesPerBuffer = 192;
+        int sampleRate = 48000;
+        int waveType = 4;             // Guitar: the heaviest per-voice chain
+        bool backingTrack = false;    // Time-stretch a 44.1 kHz stereo track alongside
+        bool pcm16Output = false;     // Callbacks write int16, as on a PCM 16 stream
+    };
+
+    struct Report {
+        uint64_t callbacks = 0;
+        uint64_t missedDeadlines = 0;  // Finished after the next buffer was due
+        uint64_t events = 0;
+        double deadlineMicros = 0.0;
+        double p50Micros = 0.0;
+        double p99Micros = 0.0;
+        double p999Micros = 0.0;
+        double maxMicros = 0.0;
+        double stretchLoadPercent = 0.0;  // Stretcher busy time per second of track output
+    };
+
+    bool run(AudioEngine &engine, const Config &config, Report &report);
+
+private:
+    void callbackLoop(AudioEngine *engine, const Config *config);
+    void controlLoop(AudioEngine *engine, const Config *config, int thread);
+    void backingTrackLoop();
+
+    static constexpr float BEND_RATE_HZ = 5.5f;      // Vibrato-like finger bend
+    static constexpr float BEND_DEPTH_SEMITONES = 2.0f;
+    static constexpr int RETRIGGER_INTERVAL = 64;    // Events between note retriggers
+    static constexpr int PARAMETER_INTERVAL = 16;    // Events between guitar/wah changes
+    static constexpr int TRACK_SAMPLE_RATE = 44100;
+    static constexpr float TRACK_TEMPO = 0.8f;       // Typical practice settings
+    static constexpr float TRACK_SEMITONES = 2.0f;
+
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> eventCount{0};
+
+    // Written by the callback thread only, read after it has joined
+    std::vector<float> durations;  // Microseconds, preallocated for the whole run
+    uint64_t missedDeadlines = 0;
+    double stretchLoadPercent = 0.0;  // Written by the backing-track thread
+};
+
+#endif // STRESS_HARNESS_H
@@ -0,0 +1,86 @@
+#include "StressHarness.h"
+#include "AudioEngine.h"
+#include "HostTest.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * Stress run on the host. Without arguments (ctest) two short runs check
+ * that the paced backend kept time and the control threads got through;
+ * the numbers are printed, not asserted, since a shared CI machine has no
+ * real-time guarantees. For a measurement run:
+ *
+ *   stress_test --seconds 60 --events 10000 --threads 8 [--backing] [--pcm16]
+ */
+namespace {
+
+void print(const char *name, const StressHarness::Report &report) {
+    std::printf("%s: %llu callbacks, %llu events, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, "
+                "max %.1f us, deadline %.1f us, missed %llu, stretch load %.2f%%\n",
+                name, static_cast<unsigned long long>(report.callbacks),
+                static_cast<unsigned long long>(report.events),
+                report.p50Micros, report.p99Micros, report.p999Micros, report.maxMicros,
+                report.deadlineMicros, static_cast<unsigned long long>(report.missedDeadlines),
+                report.stretchLoadPercent);
+}
+
+void runAndCheck(const char *name, const StressHarness::Config &config) {
+    AudioEngine engine;
+    StressHarness harness;
+    StressHarness::Report report;
+    CHECK(harness.run(engine, config, report));
+    print(name, report);
+
+    const double expected = config.durationSeconds * config.sampleRate / config.framesPerBuffer;
+    CHECK(static_cast<double>(report.callbacks) > 0.9 * expected);
+    CHECK(static_cast<double>(report.events) > 0.5 * config.eventsPerSecond * config.durationSeconds);
+    CHECK(report.p50Micros < report.deadlineMicros);
+    CHECK(!config.backingTrack || report.stretchLoadPercent > 0.0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc == 1) {
+        StressHarness::Config config;
+        config.durationSeconds = 2.0f;
+        config.eventsPerSecond = 2000;
+        runAndCheck("float", config);
+
+        config.backingTrack = true;
+        config.pcm16Output = true;
+        runAndCheck("pcm16+backing", config);
+        return HOST_TEST_RESULT();
+    }
+
+    StressHarness::Config config;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--seconds") == 0 && hasValue) {
+            config.durationSeconds = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--events") == 0 && hasValue) {
+            config.eventsPerSecond = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            config.controlThreads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            config.framesPerBuffer = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--backing") == 0) {
+            config.backingTrack = true;
+        } else if (std::strcmp(argv[i], "--pcm16") == 0) {
+            config.pcm16Output = true;
+        } else {
+            std::fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    AudioEngine engine;
+    StressHarness harness;
+    StressHarness::Report report;
+    if (!harness.run(engine, config, report)) {
+        return 1;
+    }
+    print("stress", report);
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "TimeStretcher.h"
+#include "PitchTracker.h"
+#include "HostTest.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Backing-track time-stretch benchmark: a stereo 44.1 kHz track (a sine plus
+ * a quieter second harmonic) is pushed through the stretcher in
+ * decoder-sized blocks at typical practice settings. Prints the CPU cost as
+ * a percentage of real time and checks, per setting, that the output lasts
+ * input / tempo and that its pitch moved by the semitones asked.
+ */
+namespace {
+
+constexpr int SAMPLE_RATE = 44100;
+constexpr int CHANNELS = 2;
+constexpr int INPUT_BLOCK = 1024;   // Typical decoded buffer
+constexpr int OUTPUT_BLOCK = 441;   // 10 ms pulls, as the sink does
+constexpr double TRACK_SECONDS = 20.0;
+constexpr double FUNDAMENTAL_HZ = 220.0;
+
+struct Setting {
+    float tempo;
+    float semitones;
+};
+
+std::vector<float> makeTrack() {
+    const auto frames = static_cast<size_t>(TRACK_SECONDS * SAMPLE_RATE);
+    std::vector<float> track(frames * CHANNELS);
+    constexpr double TWO_PI = 6.283185307179586;
+    for (size_t i = 0; i < frames; ++i) {
+        const double t = static_cast<double>(i) / SAMPLE_RATE;
+        const auto sample = static_cast<float>(0.5 * std::sin(TWO_PI * FUNDAMENTAL_HZ * t) +
+                                               0.2 * std::sin(TWO_PI * 2.0 * FUNDAMENTAL_HZ * t));
+        track[i * CHANNELS] = sample;
+        track[i * CHANNELS + 1] = sample;
+    }
+    return track;
+}
+
+// Median pitch of the output's left channel, once the tracker has settled
+float medianPitch(const std::vector<float> &output) {
+    PitchTracker tracker;
+    tracker.setSampleRate(SAMPLE_RATE);
+    const size_t frames = output.size() / CHANNELS;
+    std::vector<float> mono(OUTPUT_BLOCK);
+    std::vector<float> estimates;
+    for (size_t start = 0; start + OUTPUT_BLOCK <= frames; start += OUTPUT_BLOCK) {
+        for (int i = 0; i < OUTPUT_BLOCK; ++i) {
+            mono[i] = output[(start + i) * CHANNELS];
+        }
+        tracker.process(mono.data(), OUTPUT_BLOCK);
+        const PitchTracker::Estimate estimate = tracker.getEstimate();
+        if (start > static_cast<size_t>(SAMPLE_RATE) && estimate.frequency > 0.0f) {
+            estimates.push_back(estimate.frequency);
+        }
+    }
+    if (estimates.empty()) {
+        return 0.0f;
+    }
+    std::nth_element(estimates.begin(), estimates.begin() + estimates.size() / 2, estimates.end());
+    return estimates[estimates.size() / 2];
+}
+
+void run(const std::vector<float> &track, const Setting &setting) {
+    TimeStretcher stretcher(SAMPLE_RATE, CHANNELS);
+    stretcher.setTempo(setting.tempo);
+    stretcher.setPitchSemitones(setting.semitones);
+
+    const size_t inputFrames = track.size() / CHANNELS;
+    std::vector<float> output;
+    output.reserve(static_cast<size_t>(inputFrames / setting.tempo + SAMPLE_RATE) * CHANNELS);
+    std::vector<float> block(OUTPUT_BLOCK * CHANNELS);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t position = 0; position < inputFrames; position += INPUT_BLOCK) {
+        const int frames = static_cast<int>(std::min<size_t>(INPUT_BLOCK, inputFrames - position));
+        stretcher.putSamples(track.data() + position * CHANNELS, frames);
+        int received;
+        while ((received = stretcher.receiveSamples(block.data(), OUTPUT_BLOCK)) > 0) {
+            output.insert(output.end(), block.begin(), block.begin() + received * CHANNELS);
+        }
+    }
+    stretcher.drain();
+    int received;
+    while ((received = stretcher.receiveSamples(block.data(), OUTPUT_BLOCK)) > 0) {
+        output.insert(output.end(), block.begin(), block.begin() + received * CHANNELS);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double outputSeconds = static_cast<double>(output.size() / CHANNELS) / SAMPLE_RATE;
+    const double expectedSeconds = TRACK_SECONDS / setting.tempo;
+    const float pitch = medianPitch(output);
+    const double cents = 1200.0 * std::log2(pitch / FUNDAMENTAL_HZ) - 100.0 * setting.semitones;
+    std::printf("tempo %.2f, %+5.1f st: %.3f%% of real time, output %.2f s (expected %.2f), "
+                "pitch %.1f Hz (%+.1f cents)\n",
+                setting.tempo, setting.semitones, 100.0 * seconds / outputSeconds,
+                outputSeconds, expectedSeconds, pitch, cents);
+
+    CHECK_NEAR(outputSeconds, expectedSeconds, 0.01 * expectedSeconds);
+    CHECK_NEAR(cents, 0.0, 10.0);
+}
+
+} // namespace
+
+int main() {
+    const std::vector<float> track = makeTrack();
+    const Setting settings[] = {
+            {1.0f, 0.0f},    // What the sink skips (processor inactive)
+            {0.8f, 0.0f},
+            {0.5f, 0.0f},
+            {1.25f, 0.0f},
+            {1.0f, 2.0f},
+            {0.8f, -3.0f},
+            {0.75f, 5.0f},
+    };
+    for (const Setting &setting : settings) {
+        run(track, setting);
+    }
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,42 @@
+#include <oboe/Oboe.h>
+
+namespace {
+
+int32_t deviceSampleRate = 48000;
+int32_t deviceFramesPerBurst = 192;
+
+}
+
+namespace oboe {
+
+const char *convertToText(Result result) {
+    return result == Result::OK ? "OK" : "Error";
+}
+
+const char *convertToText(AudioFormat format) {
+    switch (format) {
+        case AudioFormat::I16: return "I16";
+        case AudioFormat::Float: return "Float";
+        case AudioFormat::I24: return "I24";
+        case AudioFormat::I32: return "I32";
+        default: return "Unspecified";
+    }
+}
+
+Result AudioStreamBuilder::openStream(std::shared_ptr<AudioStream> &stream) {
+    const AudioFormat opened = format == AudioFormat::Unspecified ? AudioFormat::Float : format;
+    const int32_t rate = sampleRate != 0 ? sampleRate : deviceSampleRate;
+    stream = std::make_shared<AudioStream>(opened, rate, deviceFramesPerBurst);
+    return Result::OK;
+}
+
+} // namespace oboe
+
+namespace FakeOboe {
+
+void setDevice(int32_t sampleRate, int32_t framesPerBurst) {
+    deviceSampleRate = sampleRate;
+    deviceFramesPerBurst = framesPerBurst;
+}
+
+} // namespace FakeOboe
@@ -0,0 +1,28 @@
+#ifndef FAKE_ANDROID_LOG_H
+#define FAKE_ANDROID_LOG_H
+
+#include <cstdarg>
+#include <cstdio>
+
+// Host builds: warnings and errors go to stderr, the rest is dropped
+enum {
+    ANDROID_LOG_DEBUG = 3,
+    ANDROID_LOG_INFO = 4,
+    ANDROID_LOG_WARN = 5,
+    ANDROID_LOG_ERROR = 6
+};
+
+inline int __android_log_print(int priority, const char *tag, const char *format, ...) {
+    if (priority < ANDROID_LOG_WARN) {
+        return 0;
+    }
+    std::fprintf(stderr, "%s: ", tag);
+    va_list args;
+    va_start(args, format);
+    const int written = std::vfprintf(stderr, format, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+    return written;
+}
+
+#endif // FAKE_ANDROID_LOG_H
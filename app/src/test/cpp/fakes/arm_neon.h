@@ -0,0 +1,163 @@
+#ifndef FAKE_ARM_NEON_H
+#define FAKE_ARM_NEON_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Fake arm_neon.h - Scalar model of the NEON intrinsics the engine uses
+ *
+ * Lets the host build compile the __aarch64__ branches (PcmConverter,
+ * UnisonSaw, TimeStretcher) on x86-64 and compare them with the scalar
+ * and SSE2 ones. Each intrinsic follows the ARM definition lane by lane:
+ * vfmaq/vfmsq are fused (std::fma), vmlsq is a separate multiply and
+ * subtract, vcvtnq rounds to nearest even, vqmovn saturates, and the
+ * horizontal adds pair lanes in the same order as FADDP. Only the
+ * arithmetic is modelled, not the timing.
+ *
+ * The types are GCC vector extensions, so brace initialisation and lane
+ * indexing work as with the real header.
+ */
+typedef float float32x4_t __attribute__((vector_size(16)));
+typedef uint32_t uint32x4_t __attribute__((vector_size(16)));
+typedef int32_t int32x4_t __attribute__((vector_size(16)));
+typedef int16_t int16x4_t __attribute__((vector_size(8)));
+typedef int16_t int16x8_t __attribute__((vector_size(16)));
+
+// Lane-wise helpers, so each intrinsic below is one line
+template <typename V, typename F>
+inline V fakeNeonMap(V a, F f) {
+    V r{};
+    for (int i = 0; i < 4; ++i) r[i] = f(a[i]);
+    return r;
+}
+
+template <typename V, typename W, typename F>
+inline V fakeNeonMap2(W a, W b, F f) {
+    V r{};
+    for (int i = 0; i < 4; ++i) r[i] = f(a[i], b[i]);
+    return r;
+}
+
+inline float32x4_t vdupq_n_f32(float value) { return float32x4_t{value, value, value, value}; }
+inline uint32x4_t vdupq_n_u32(uint32_t value) { return uint32x4_t{value, value, value, value}; }
+
+inline float32x4_t vld1q_f32(const float *p) {
+    float32x4_t r{};
+    std::memcpy(&r, p, sizeof(r));
+    return r;
+}
+
+inline uint32x4_t vld1q_u32(const uint32_t *p) {
+    uint32x4_t r{};
+    std::memcpy(&r, p, sizeof(r));
+    return r;
+}
+
+inline void vst1q_f32(float *p, float32x4_t v) { std::memcpy(p, &v, sizeof(v)); }
+inline void vst1q_u32(uint32_t *p, uint32x4_t v) { std::memcpy(p, &v, sizeof(v)); }
+inline void vst1q_s16(int16_t *p, int16x8_t v) { std::memcpy(p, &v, sizeof(v)); }
+
+inline float32x4_t vaddq_f32(float32x4_t a, float32x4_t b) {
+    return fakeNeonMap2<float32x4_t>(a, b, [](float x, float y) { return x + y; });
+}
+
+inline float32x4_t vsubq_f32(float32x4_t a, float32x4_t b) {
+    return fakeNeonMap2<float32x4_t>(a, b, [](float x, float y) { return x - y; });
+}
+
+inline float32x4_t vmulq_f32(float32x4_t a, float32x4_t b) {
+    return fakeNeonMap2<float32x4_t>(a, b, [](float x, float y) { return x * y; });
+}
+
+inline float32x4_t vdivq_f32(float32x4_t a, float32x4_t b) {
+    return fakeNeonMap2<float32x4_t>(a, b, [](float x, float y) { return x / y; });
+}
+
+inline float32x4_t vmulq_n_f32(float32x4_t a, float b) { return vmulq_f32(a, vdupq_n_f32(b)); }
+
+inline float32x4_t vminq_f32(float32x4_t a, float32x4_t b) {
+    return fakeNeonMap2<float32x4_t>(a, b, [](float x, float y) { return std::min(x, y); });
+}
+
+inline float32x4_t vmaxq_f32(float32x4_t a, float32x4_t b) {
+    return fakeNeonMap2<float32x4_t>(a, b, [](float x, float y) { return std::max(x, y); });
+}
+
+// a + b * c and a - b * c, rounded once
+inline float32x4_t vfmaq_f32(float32x4_t a, float32x4_t b, float32x4_t c) {
+    float32x4_t r{};
+    for (int i = 0; i < 4; ++i) r[i] = std::fma(b[i], c[i], a[i]);
+    return r;
+}
+
+inline float32x4_t vfmsq_f32(float32x4_t a, float32x4_t b, float32x4_t c) {
+    float32x4_t r{};
+    for (int i = 0; i < 4; ++i) r[i] = std::fma(-b[i], c[i], a[i]);
+    return r;
+}
+
+inline float32x4_t vfmaq_n_f32(float32x4_t a, float32x4_t b, float c) { return vfmaq_f32(a, b, vdupq_n_f32(c)); }
+
+// Not fused: FMUL then FSUB
+inline float32x4_t vmlsq_n_f32(float32x4_t a, float32x4_t b, float c) { return vsubq_f32(a, vmulq_n_f32(b, c)); }
+
+inline float32x4_t vrndmq_f32(float32x4_t a) {
+    return fakeNeonMap(a, [](float x) { return std::floor(x); });
+}
+
+// FADDP pairs: (a0 + a1) + (a2 + a3)
+inline float vaddvq_f32(float32x4_t a) { return (a[0] + a[1]) + (a[2] + a[3]); }
+
+inline float32x4_t vpaddq_f32(float32x4_t a, float32x4_t b) {
+    return float32x4_t{a[0] + a[1], a[2] + a[3], b[0] + b[1], b[2] + b[3]};
+}
+
+inline uint32x4_t vcgtq_f32(float32x4_t a, float32x4_t b) {
+    return fakeNeonMap2<uint32x4_t>(a, b, [](float x, float y) { return x > y ? 0xFFFFFFFFu : 0u; });
+}
+
+inline uint32x4_t vcltq_f32(float32x4_t a, float32x4_t b) {
+    return fakeNeonMap2<uint32x4_t>(a, b, [](float x, float y) { return x < y ? 0xFFFFFFFFu : 0u; });
+}
+
+inline uint32_t vmaxvq_u32(uint32x4_t a) { return std::max(std::max(a[0], a[1]), std::max(a[2], a[3])); }
+
+inline uint32x4_t vaddq_u32(uint32x4_t a, uint32x4_t b) { return a + b; }
+inline uint32x4_t vandq_u32(uint32x4_t a, uint32x4_t b) { return a & b; }
+inline uint32x4_t vorrq_u32(uint32x4_t a, uint32x4_t b) { return a | b; }
+inline uint32x4_t veorq_u32(uint32x4_t a, uint32x4_t b) { return a ^ b; }
+
+// Shift counts are immediates on ARM; any constant works here
+#define vshlq_n_u32(a, n) ((a) << (n))
+#define vshrq_n_u32(a, n) ((a) >> (n))
+
+inline float32x4_t vcvtq_f32_u32(uint32x4_t a) {
+    float32x4_t r{};
+    for (int i = 0; i < 4; ++i) r[i] = static_cast<float>(a[i]);
+    return r;
+}
+
+// FCVTNS: nearest, ties to even, saturated to int32
+inline int32x4_t vcvtnq_s32_f32(float32x4_t a) {
+    int32x4_t r{};
+    for (int i = 0; i < 4; ++i) {
+        const float nearest = a[i] - std::remainder(a[i], 1.0f);
+        r[i] = static_cast<int32_t>(std::clamp(nearest, -2147483648.0f, 2147483520.0f));
+    }
+    return r;
+}
+
+inline int16x4_t vqmovn_s32(int32x4_t a) {
+    int16x4_t r{};
+    for (int i = 0; i < 4; ++i) r[i] = static_cast<int16_t>(std::clamp(a[i], -32768, 32767));
+    return r;
+}
+
+inline int16x8_t vcombine_s16(int16x4_t low, int16x4_t high) {
+    return int16x8_t{low[0], low[1], low[2], low[3], high[0], high[1], high[2], high[3]};
+}
+
+#endif // FAKE_ARM_NEON_H
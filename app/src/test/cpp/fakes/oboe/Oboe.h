@@ -0,0 +1,125 @@
+#ifndef FAKE_OBOE_H
+#define FAKE_OBOE_H
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+
+/**
+ * Fake Oboe - The subset of the Oboe API the engine uses, for host builds
+ *
+ * Streams open at the device rate and burst set with FakeOboe::setDevice,
+ * in the format the builder asked for (float if unspecified). They have no
+ * thread of their own: a test drives AudioEngine::onAudioReady itself, the
+ * way the stress harness paces a null backend. Input streams read nothing,
+ * so DuplexInput falls back to its file source or to silence.
+ */
+namespace oboe {
+
+enum class Direction { Output, Input };
+enum class PerformanceMode { None, PowerSaving, LowLatency };
+enum class SharingMode { Exclusive, Shared };
+enum class AudioFormat { Invalid, Unspecified, I16, Float, I24, I32 };
+enum class SampleRateConversionQuality { None, Fastest, Low, Medium, High, Best };
+enum class InputPreset { Generic, Camcorder, VoiceRecognition, VoiceCommunication, Unprocessed,
+                         VoicePerformance };
+enum class Result { OK, ErrorBase, ErrorDisconnected, ErrorIllegalArgument, ErrorInvalidState };
+enum class DataCallbackResult { Continue, Stop };
+
+namespace ChannelCount {
+constexpr int Unspecified = 0;
+constexpr int Mono = 1;
+constexpr int Stereo = 2;
+}
+
+const char *convertToText(Result result);
+const char *convertToText(AudioFormat format);
+
+template <typename T>
+class ResultWithValue {
+public:
+    ResultWithValue(T value) : mValue(value), mError(Result::OK) {}  // NOLINT: implicit like Oboe
+    ResultWithValue(Result error) : mValue(), mError(error) {}       // NOLINT
+
+    T value() const { return mValue; }
+    Result error() const { return mError; }
+    explicit operator bool() const { return mError == Result::OK; }
+
+private:
+    T mValue;
+    Result mError;
+};
+
+struct FrameTimestamp {
+    int64_t position;
+    int64_t timestamp;
+};
+
+class AudioStream;
+
+class AudioStreamCallback {
+public:
+    virtual ~AudioStreamCallback() = default;
+    virtual DataCallbackResult onAudioReady(AudioStream *audioStream, void *audioData,
+                                            int32_t numFrames) = 0;
+    virtual void onErrorBeforeClose(AudioStream *, Result) {}
+    virtual void onErrorAfterClose(AudioStream *, Result) {}
+};
+
+class AudioStream {
+public:
+    AudioStream(AudioFormat format, int32_t sampleRate, int32_t framesPerBurst)
+            : format(format), sampleRate(sampleRate), framesPerBurst(framesPerBurst) {}
+
+    Result requestStart() { return Result::OK; }
+    Result stop() { return Result::OK; }
+    Result close() { return Result::OK; }
+
+    int32_t getSampleRate() const { return sampleRate; }
+    int32_t getFramesPerBurst() const { return framesPerBurst; }
+    int32_t getChannelCount() const { return ChannelCount::Mono; }
+    AudioFormat getFormat() const { return format; }
+    int32_t getBufferCapacityInFrames() const { return framesPerBurst * 16; }
+
+    ResultWithValue<double> calculateLatencyMillis() { return Result::ErrorInvalidState; }
+    ResultWithValue<FrameTimestamp> getTimestamp(clockid_t) { return Result::ErrorInvalidState; }
+    int64_t getFramesWritten() { return 0; }
+    ResultWithValue<int32_t> read(void *, int32_t, int64_t) { return 0; }
+
+private:
+    AudioFormat format;
+    int32_t sampleRate;
+    int32_t framesPerBurst;
+};
+
+class AudioStreamBuilder {
+public:
+    AudioStreamBuilder *setDirection(Direction) { return this; }
+    AudioStreamBuilder *setPerformanceMode(PerformanceMode) { return this; }
+    AudioStreamBuilder *setSharingMode(SharingMode) { return this; }
+    AudioStreamBuilder *setFormat(AudioFormat value) { format = value; return this; }
+    AudioStreamBuilder *setChannelCount(int) { return this; }
+    AudioStreamBuilder *setSampleRate(int32_t value) { sampleRate = value; return this; }
+    AudioStreamBuilder *setCallback(AudioStreamCallback *) { return this; }
+    AudioStreamBuilder *setSampleRateConversionQuality(SampleRateConversionQuality) { return this; }
+    AudioStreamBuilder *setFormatConversionAllowed(bool) { return this; }
+    AudioStreamBuilder *setChannelConversionAllowed(bool) { return this; }
+    AudioStreamBuilder *setInputPreset(InputPreset) { return this; }
+
+    Result openStream(std::shared_ptr<AudioStream> &stream);
+
+private:
+    AudioFormat format = AudioFormat::Unspecified;
+    int32_t sampleRate = 0;
+};
+
+} // namespace oboe
+
+namespace FakeOboe {
+
+// Native rate and burst of the fake device (default 48 kHz, 192 frames)
+void setDevice(int32_t sampleRate, int32_t framesPerBurst);
+
+} // namespace FakeOboe
+
+#endif // FAKE_OBOE_H